@@ -2,10 +2,10 @@
 
 namespace Clustering 
 {
-  Eigen::Matrix<dtype, 1, Eigen::Dynamic> AverageLinkage::dist(idxT idxA, idxT idxB)
+  // Lance-Williams coefficients for UPGMA: the size-weighted mean of the
+  // distances from each half of the merged cluster.
+  dtype AverageLinkage::dist(dtype distAK, dtype distBK, idxT sizeA, idxT sizeB, idxT sizeK)
   {
-    idxT sizeA = currStg[idxA]->size();
-    idxT sizeB = currStg[idxB]->size();
-    return (sizeA * clusterDists.row(idxA) + sizeB * clusterDists.row(idxB)) / (sizeA + sizeB);
+    return (sizeA * distAK + sizeB * distBK) / (sizeA + sizeB);
   }
-}
\ No newline at end of file
+}
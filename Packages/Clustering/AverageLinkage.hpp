@@ -11,9 +11,9 @@ namespace Clustering
 class AverageLinkage : public HAC
 {
 public:
-  AverageLinkage(const Eigen::Ref<Eigen::Matrix<dtype, Eigen::Dynamic, Eigen::Dynamic>> &e) : HAC(e) {}
+  AverageLinkage(const SymmetricMatrix<dtype> &e) : HAC(e) {}
   // this should be a terminal definition
-  Eigen::Matrix<dtype, 1, Eigen::Dynamic> dist(idxT idxA, idxT idxB);
+  dtype dist(dtype distAK, dtype distBK, idxT sizeA, idxT sizeB, idxT sizeK);
 };
 } // namespace Clustering
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #define LOOS_CLUSTER_HPP
 // include this header if you want the entire NS, for tools.
 #include "ClusteringTypedefs.hpp"
+#include "SymmetricMatrix.hpp"
 #include "ClusteringUtils.hpp"
 #include "HAC.hpp"
 #include "AverageLinkage.hpp"
@@ -7,7 +7,9 @@ namespace Clustering{
   void ClusteringOptions::addGeneric(po::options_description & opts){
     opts.add_options()
     ("score-file,f", po::value<std::string>(&similarity_filename), "File containing whitespace-delimited pairwise similarities.")
-    ("stream,s", po::bool_switch(&stream_mode), "Read similarities from stdin.");
+    ("stream,s", po::bool_switch(&stream_mode), "Read similarities from stdin.")
+    ("binary,b", po::bool_switch(&binary), "Score file is a raw square matrix of native-endian floats.")
+    ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)");
   }
 
   bool ClusteringOptions::postConditions(po::variables_map& vm) {
@@ -15,10 +17,16 @@ namespace Clustering{
       std::cerr << "Usage Error:\nYou've asked that the tool both reads a file: \n  \"" << similarity_filename << "\"\nand that it read from stdin. \n";
       return false;
     }
+    if (stream_mode && binary){
+      std::cerr << "Usage Error:\nBinary similarities must be read from a file with --score-file.\n";
+      return false;
+    }
+    if (nthreads == 0)
+      nthreads = boost::thread::hardware_concurrency();
       
   	if (stream_mode) {
       try {
-        similarityScores = readMatrixFromStream<dtype>(std::cin);
+        similarityScores = readSymmetricMatrixFromStream<dtype>(std::cin);
       }
       catch(const loos::LOOSError &e) {
         std::cerr << e.what() << '\n';
@@ -27,9 +35,15 @@ namespace Clustering{
     }
     else if (!similarity_filename.empty()){
       std::ifstream stream;
-      stream.open(similarity_filename);
+      if (binary)
+        stream.open(similarity_filename, std::ios::binary);
+      else
+        stream.open(similarity_filename);
       try{
-        similarityScores = readMatrixFromStream<dtype>(stream);
+        if (binary)
+          similarityScores = readSymmetricMatrixFromBinary<dtype>(stream);
+        else
+          similarityScores = readSymmetricMatrixFromStream<dtype>(stream);
       }
       catch(const loos::LOOSError &e) {
         std::cerr << e.what() << '\n';
@@ -2,6 +2,7 @@
 #define LOOS_CLUSTERING_OPTIONS
 
 #include "ClusteringTypedefs.hpp"
+#include "SymmetricMatrix.hpp"
 // #include <loos.hpp>
 #include <OptionsFramework.hpp>
 
@@ -11,13 +12,16 @@ namespace opts = loos::OptionsFramework;
 namespace po = boost::program_options;
 class ClusteringOptions : public opts::OptionsPackage {
 public:
-  ClusteringOptions() : similarity_filename(""), stream_mode(true) {}
+  ClusteringOptions() : similarity_filename(""), stream_mode(true), binary(false), nthreads(1) {}
   ClusteringOptions(std::string &similarityFN)
-      : similarity_filename(similarityFN), stream_mode(false) {}
+      : similarity_filename(similarityFN), stream_mode(false), binary(false), nthreads(1) {}
 
   std::string similarity_filename;
   bool stream_mode;
-  Eigen::Matrix<dtype, Eigen::Dynamic, Eigen::Dynamic> similarityScores;
+  bool binary;
+  uint nthreads;
+  // only the upper triangle of the input is kept.
+  SymmetricMatrix<dtype> similarityScores;
 
 private:
   void addGeneric(po::options_description &opts);
@@ -3,7 +3,12 @@
 #define LOOS_CLUSTERING_UTILS
 #include <eigen3/Eigen/Dense>
 #include "ClusteringTypedefs.hpp"
+#include "SymmetricMatrix.hpp"
 #include "loos.hpp"
+#include <atomic>
+#include <boost/thread/thread.hpp>
+#include <cmath>
+#include <cstdlib>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -66,6 +71,123 @@ readMatrixFromStream(std::istream &input,
 
   return result;
 }
+// Streaming version of readMatrixFromStream that keeps only the upper
+// triangle, packed, so the full square matrix is never held in memory.
+// Every line is still checked for the same number of elements as the first.
+template <typename Numeric>
+SymmetricMatrix<Numeric>
+readSymmetricMatrixFromStream(std::istream &input,
+                              const char commentChar = '#')
+{
+  SymmetricMatrix<Numeric> result;
+  string line;
+  idxT n = 0;
+  idxT row = 0;
+  uint lineno = 0;
+  while (getline(input, line))
+  {
+    // skip commets. Only permits comments at the beginning of lines.
+    if (line[0] == commentChar)
+      continue;
+    lineno++;
+    const char *p = line.c_str();
+    if (row == 0)
+    {
+      // the first row fixes the dimension of the matrix.
+      vector<Numeric> firstRow;
+      char *end;
+      while (true)
+      {
+        Numeric elt = static_cast<Numeric>(std::strtod(p, &end));
+        if (end == p)
+          break;
+        firstRow.push_back(elt);
+        p = end;
+      }
+      n = firstRow.size();
+      result = SymmetricMatrix<Numeric>(n);
+      std::copy(firstRow.begin(), firstRow.end(), result.upperRow(0));
+    }
+    else
+    {
+      // values left of the diagonal are counted but not converted.
+      Numeric *dest = row < n ? result.upperRow(row) : nullptr;
+      idxT count = 0;
+      while (true)
+      {
+        while (std::isspace(static_cast<unsigned char>(*p)))
+          p++;
+        if (!*p)
+          break;
+        if (dest && count >= row && count < n)
+        {
+          char *end;
+          Numeric elt = static_cast<Numeric>(std::strtod(p, &end));
+          if (end == p)
+            break;
+          dest[count - row] = elt;
+          p = end;
+        }
+        else
+          while (*p && !std::isspace(static_cast<unsigned char>(*p)))
+            p++;
+        count++;
+      }
+      if (count != n)
+      {
+        std::stringstream errstream;
+        errstream << "Line " << lineno << " has " << count << " elements, while the first noncomment line has "
+                  << n << ".\nAll lines must have the same number of elements.\n";
+        throw(loos::LOOSError(errstream.str()));
+      }
+    }
+    row++;
+  }
+  if (row == 0)
+    throw(loos::LOOSError("No matrix rows were read.\n"));
+  if (row != n)
+  {
+    std::stringstream errstream;
+    errstream << "Matrix has " << row << " rows, but " << n << " columns."
+              << "\nThese should be the same because the matrix needs to be square\n";
+    throw(loos::LOOSError(errstream.str()));
+  }
+  return result;
+}
+
+// Reads a square matrix stored as raw, native-endian Numeric values in
+// row-major order (e.g. numpy's tofile()). The dimension is deduced from the
+// size of the stream, so it must be seekable. Only the upper triangle of
+// each row is read.
+template <typename Numeric>
+SymmetricMatrix<Numeric>
+readSymmetricMatrixFromBinary(std::istream &input)
+{
+  input.seekg(0, std::ios::end);
+  std::streamoff bytes = input.tellg();
+  if (bytes < 0)
+    throw(loos::LOOSError("Binary similarity matrices must be read from a file.\n"));
+  idxT count = bytes / sizeof(Numeric);
+  idxT n = static_cast<idxT>(std::llround(std::sqrt(static_cast<double>(count))));
+  if (count == 0 || n * n != count || count * static_cast<std::streamoff>(sizeof(Numeric)) != bytes)
+  {
+    std::stringstream errstream;
+    errstream << "Binary matrix has " << bytes << " bytes, which is not a square matrix of "
+              << sizeof(Numeric) << "-byte values.\n";
+    throw(loos::LOOSError(errstream.str()));
+  }
+
+  SymmetricMatrix<Numeric> result(n);
+  for (idxT i = 0; i < n; i++)
+  {
+    input.seekg((i * n + i) * sizeof(Numeric));
+    input.read(reinterpret_cast<char *>(result.upperRow(i)), (n - i) * sizeof(Numeric));
+    if (!input)
+      throw(loos::LOOSError("Error while reading binary similarity matrix.\n"));
+  }
+  return result;
+}
+
 // takes a nxd data matrix (where d is the dimensionality of the data),
 // returns an nxn matrix containing pairwise distances
 template <typename Derived, typename DataDerived>
@@ -100,30 +222,56 @@ sort_permutation(const Eigen::PlainObjectBase<Derived> &v)
 }
 // for exemplars defined as having the minimum average distance within cluster
 // Takes a vector of vectors of idxTs which are the cluster indexes, and a
-// corresponding (full) distance matrix Returns a vector of indexes to the
-// minimum average distance element from each cluster.
-template <typename Derived>
+// corresponding distance matrix (anything indexable as distances(i, j)).
+// Returns a vector of indexes to the minimum average distance element from
+// each cluster. The row sums are spread over nthreads threads (0 = all cores)
+// one member at a time, so a single large cluster still parallelizes.
+template <typename Distances>
 std::vector<idxT>
 getExemplars(std::vector<std::vector<idxT>> &clusters,
-             const Eigen::MatrixBase<Derived> &distances)
+             const Distances &distances, const uint nthreads = 0)
 {
-  using namespace Eigen;
-  vector<idxT> exemplars(clusters.size());
+  vector<std::pair<idxT, idxT>> work;
   for (idxT cdx = 0; cdx < clusters.size(); cdx++)
-  {
-    Derived clusterDists;
-    clusterDists = MatrixBase<Derived>::Zero(clusters[cdx].size(), clusters[cdx].size());
     for (idxT i = 0; i < clusters[cdx].size(); i++)
+      work.push_back(std::make_pair(cdx, i));
+
+  // every member of a cluster shares the denominator, so sums will do.
+  vector<double> sums(work.size());
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    size_t w;
+    while ((w = next++) < work.size())
     {
-      for (idxT j = 0; j < i; j++)
-      {
-        clusterDists(i, j) = distances(clusters[cdx][i], clusters[cdx][j]);
-      }
+      const vector<idxT> &members = clusters[work[w].first];
+      idxT elt = members[work[w].second];
+      double sum = 0;
+      for (auto other : members)
+        sum += distances(elt, other);
+      sums[w] = sum;
     }
-    idxT centeridx;
-    clusterDists = clusterDists.template selfadjointView<Upper>();
-    clusterDists.colwise().mean().minCoeff(&centeridx);
-    exemplars[cdx] = clusters[cdx][centeridx];
+  };
+
+  const uint nworkers =
+      nthreads ? nthreads : std::max(1u, boost::thread::hardware_concurrency());
+  if (nworkers > 1)
+  {
+    boost::thread_group threads;
+    for (uint t = 0; t < nworkers; t++)
+      threads.create_thread(worker);
+    threads.join_all();
+  }
+  else
+    worker();
+
+  vector<idxT> exemplars(clusters.size());
+  for (size_t w = 0, cdx = 0; cdx < clusters.size(); cdx++)
+  {
+    size_t best = w;
+    for (; w < work.size() && work[w].first == cdx; w++)
+      if (sums[w] < sums[best])
+        best = w;
+    exemplars[cdx] = clusters[cdx][work[best].second];
   }
   return exemplars;
 }
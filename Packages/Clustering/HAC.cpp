@@ -1,121 +1,183 @@
 #include "HAC.hpp"
 #include "ClusteringUtils.hpp"
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 
 using std::cout;
 using std::endl;
-using std::unique_ptr;
 using std::vector;
 using namespace Eigen;
 
-// Merge two clusters into whichever is larger.
-// Return true if new composite cluster is minRow, else return false
-// In the case where clusters are of equal size, merge into minRow.
 namespace Clustering
 {
-bool HAC::merge()
+// Run through the clustering cycle, populating the dendrogram.
+// Merges are found with the nearest-neighbor chain algorithm, which only
+// ever merges reciprocal nearest neighbors and so needs O(n^2) time overall
+// for reducible linkages such as average linkage. The chain does not produce
+// merges in order of distance, so they are sorted afterwards and replayed
+// to assign stages.
+void HAC::cluster()
 {
-  bool ret;
-  idxT sizeA = currStg[minRow]->size();
-  idxT sizeB = currStg[minCol]->size();
-  if (sizeA < sizeB)
-  {
-    currStg[minCol]->insert(currStg[minCol]->end(),
-                            currStg[minRow]->begin(),
-                            currStg[minRow]->end());
-    currStg.erase(currStg.begin() + minRow);
+  vector<idxT> sizes(eltCount, 1);
+  // linkage distance at which the cluster held in each slot was formed.
+  vector<dtype> heights(eltCount, 0);
+  vector<bool> active(eltCount, true);
+  vector<idxT> chain;
+  chain.reserve(eltCount);
 
-    ret = false;
-  }
-  else
+  // while the chain runs, left and right hold the slots (original element
+  // indices) of the two clusters. These become node ids after sorting.
+  dendrogram.clear();
+  dendrogram.reserve(eltCount > 0 ? eltCount - 1 : 0);
+
+  idxT nextStart = 0;
+  while (static_cast<idxT>(dendrogram.size()) < eltCount - 1)
   {
-    currStg[minRow]->insert(currStg[minRow]->end(),
-                            currStg[minCol]->begin(),
-                            currStg[minCol]->end());
-    currStg.erase(currStg.begin() + minCol);
+    if (chain.empty())
+    {
+      while (!active[nextStart])
+        nextStart++;
+      chain.push_back(nextStart);
+    }
+
+    idxT a = chain.back();
+    // prefer the previous link of the chain on ties, so the chain terminates.
+    idxT b = -1;
+    dtype minDist = 0;
+    if (chain.size() > 1)
+    {
+      b = chain[chain.size() - 2];
+      minDist = clusterDists(a, b);
+    }
+    // row a lives in column a of the earlier rows, then contiguously.
+    for (idxT k = 0; k < a; k++)
+    {
+      if (!active[k])
+        continue;
+      dtype d = clusterDists.upperRow(k)[a - k];
+      if (b < 0 || d < minDist)
+      {
+        minDist = d;
+        b = k;
+      }
+    }
+    const dtype *row = clusterDists.upperRow(a) - a;
+    for (idxT k = a + 1; k < eltCount; k++)
+    {
+      if (!active[k])
+        continue;
+      if (b < 0 || row[k] < minDist)
+      {
+        minDist = row[k];
+        b = k;
+      }
+    }
 
-    ret = true;
+    if (chain.size() < 2 || b != chain[chain.size() - 2])
+    {
+      chain.push_back(b);
+      continue;
+    }
+
+    // a and b are reciprocal nearest neighbors: merge them.
+    chain.pop_back();
+    chain.pop_back();
+
+    idxT into = std::min(a, b);
+    idxT from = std::max(a, b);
+    // guard monotonicity against rounding so that sorting by distance
+    // always places a merge after the merges that built its children.
+    dtype height = std::max(minDist, std::max(heights[a], heights[b]));
+    dendrogram.push_back(MergeStep{into, from, height, sizes[a] + sizes[b]});
+#ifdef DEBUG
+    cout << "merge " << into << " <- " << from << " at " << height << endl;
+#endif
+
+    active[from] = false;
+    for (idxT k = 0; k < eltCount; k++)
+    {
+      if (k == into || !active[k])
+        continue;
+      // storage is shared between (into, k) and (k, into).
+      clusterDists(into, k) = dist(clusterDists(into, k), clusterDists(from, k),
+                                   sizes[into], sizes[from], sizes[k]);
+    }
+    sizes[into] += sizes[from];
+    heights[into] = height;
   }
 
-  // append new assortment of clusters to Cluster Trajectory
-  vector<vector<idxT>> recordAtStg(currStg.size());
-  for (idxT i = 0; i < currStg.size(); i++)
+  // order the merges by distance. Stable, so ties keep the order in which
+  // the chain found them (children before parents).
+  std::stable_sort(dendrogram.begin(), dendrogram.end(),
+                   [](const MergeStep &x, const MergeStep &y) { return x.dist < y.dist; });
+
+  // relabel slots as dendrogram nodes using a union-find over the slots.
+  vector<idxT> parent(eltCount);
+  vector<idxT> nodeOf(eltCount);
+  std::iota(parent.begin(), parent.end(), 0);
+  std::iota(nodeOf.begin(), nodeOf.end(), 0);
+  auto find = [&parent](idxT x) {
+    while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  };
+
+  distOfMerge.setZero(eltCount);
+  for (stage = 1; stage < eltCount; stage++)
   {
-    recordAtStg[i] = *(currStg[i]);
+    MergeStep &step = dendrogram[stage - 1];
+    idxT ra = find(step.left);
+    idxT rb = find(step.right);
+    idxT na = nodeOf[ra];
+    idxT nb = nodeOf[rb];
+    step.left = std::min(na, nb);
+    step.right = std::max(na, nb);
+    step.size = nodeSize(na) + nodeSize(nb);
+    parent[rb] = ra;
+    nodeOf[ra] = eltCount + stage - 1;
+    distOfMerge(stage) = step.dist;
+    // compute the penalty, if such is needed.
+    penalty();
   }
-  clusterTraj.push_back(recordAtStg);
-  return ret;
+  stage--;
 }
 
-// Run through the clustering cycle, populating the 'trajectory' vectors.
-void HAC::cluster()
+// Replay the first stg merges to recover the clusters at that stage.
+vector<vector<idxT>> HAC::clustersAtStage(idxT stg) const
 {
-  // initialize the list of cluster indices with one index per cluster
-  vector<vector<idxT>> recordCurrStg(eltCount);
-  for (idxT i = 0; i < eltCount; i++)
+  vector<idxT> parent(eltCount + stg);
+  std::iota(parent.begin(), parent.end(), 0);
+  for (idxT s = 0; s < stg; s++)
   {
-    unique_ptr<vector<idxT>> cluster_ptr(new vector<idxT>{i});
-    currStg.push_back(std::move(cluster_ptr));
-    vector<idxT> clusterRecord{i};
-    recordCurrStg[i] = clusterRecord;
+    parent[dendrogram[s].left] = eltCount + s;
+    parent[dendrogram[s].right] = eltCount + s;
   }
-  clusterTraj.push_back(recordCurrStg);
 
-  // Get the max value to make the diagonal never the minCoeff (see distOfMerge[stage] below)
-  dtype maxDist = clusterDists.maxCoeff() + 1;
-  for (stage = 1; stage < eltCount; stage++)
+  vector<vector<idxT>> clusters;
+  vector<idxT> label(eltCount + stg, -1);
+  for (idxT i = 0; i < eltCount; i++)
   {
-#ifdef DEBUG
-    cout << "stage:  " << stage << endl;
-#endif
-    // bind the minimum distance found for dendrogram construction
-    distOfMerge(stage) = (clusterDists + maxDist * Matrix<dtype, Dynamic, Dynamic>::Identity(
-                                                       clusterDists.rows(), clusterDists.rows()))
-                             .minCoeff(&minRow, &minCol);
-    // build merged row. Must happen before clusterTraj merge is performed.
-    Matrix<dtype, Dynamic, 1> mergedRow = dist(minRow, minCol);
-    // merge the clusters into whichever of the two is larger. Erase the other.
-    merged = merge();
-#ifdef DEBUG
-    cout << "clusters:" << endl;
-    vectorVectorsAsJSONArr(clusterTraj[stage], cout);
-#endif
-    // compute the penalty, if such is needed. Needs cluster merged into.
-    penalty();
-    // update the matrix of clusterDists
-    if (merged)
-    { // minRow was the cluster merged into
-      // update clusterDists to zero out minCol column & row
-      // removeRow<Matrix<double, -1, -1, 1>>(clusterDists, minCol);
-      // removeCol<Matrix<double, -1, -1, 1>>(clusterDists, minCol);
-      removeRow(clusterDists, minCol);
-      removeCol(clusterDists, minCol);
-      // remove the column we eliminated from our merged row of distances.
-      removeRow(mergedRow, minCol);
-      // recalculate minRow column and row
-      if (minCol < minRow)
-        minRow--;
-      // Note that the dist matrix will not have a zero at this row/col after doing this.
-      // because of how we have increased the values of the diagonal anyway for the mincoeff
-      // this should not interfere with anything. But if you're relying on the diagonal to be zero...
-      clusterDists.row(minRow) = mergedRow;
-      clusterDists.col(minRow) = mergedRow.transpose();
+    idxT root = i;
+    while (parent[root] != root)
+      root = parent[root];
+    // compress so later members of the same cluster stop early.
+    for (idxT x = i; parent[x] != root;)
+    {
+      idxT next = parent[x];
+      parent[x] = root;
+      x = next;
     }
-    else
-    { // minCol was the cluster merged into
-      // update clusterDists to delete minRow column & row
-      removeRow(clusterDists, minRow);
-      removeCol(clusterDists, minRow);
-      // remove the column we eliminated from our merged row of distances.
-      removeRow(mergedRow, minRow);
-      // recalculate minCol column and row
-      if (minRow < minCol)
-        minCol--;
-
-      clusterDists.row(minCol) = mergedRow;
-      clusterDists.col(minCol) = mergedRow.transpose();
+    if (label[root] < 0)
+    {
+      label[root] = clusters.size();
+      clusters.emplace_back();
     }
+    clusters[label[root]].push_back(i);
   }
-  stage--;
+  return clusters;
 }
 } // namespace Clustering
@@ -1,53 +1,71 @@
 #ifndef LOOS_HAC_HPP
 #define LOOS_HAC_HPP
 #include "ClusteringTypedefs.hpp"
+#include "SymmetricMatrix.hpp"
 #include <eigen3/Eigen/Dense>
-#include <memory>
 #include <vector>
 // Abstract class for hierarchical agglomerative clustering.
 // Specific comparison methods inherit from here.
 namespace Clustering
 {
+// One agglomeration step of the dendrogram. Nodes are numbered as in
+// scipy's linkage matrices: 0..eltCount-1 are the input elements, and the
+// cluster created at stage s (counting from 1) is node eltCount + s - 1.
+struct MergeStep
+{
+  idxT left;
+  idxT right;
+  dtype dist;
+  idxT size;
+};
+
 class HAC
 {
   // no private data, since this class exists to provide inheritance.
 public:
-  HAC(const Eigen::Ref<Eigen::Matrix<dtype, Eigen::Dynamic, Eigen::Dynamic>> &e) : clusterDists(e.selfadjointView<Eigen::Upper>()),
-                                              eltCount{e.cols()},
-                                              distOfMerge(e.cols()) {}
+  HAC(const SymmetricMatrix<dtype> &e) : clusterDists(e),
+                                         eltCount{e.cols()},
+                                         distOfMerge(e.cols()) {}
 
-  Eigen::Matrix<dtype, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> clusterDists;
+  // Working copy of the distances (upper triangle only). Rows and columns of
+  // clusters that have been merged away are left in place but never read
+  // again; the row of the surviving cluster is updated in place with the
+  // linkage rule.
+  SymmetricMatrix<dtype> clusterDists;
 
   /// holds total number of elements to be clustered (and thus number of steps)
   idxT eltCount;
 
   // record a trajectory of the clustering so that you can write dendrograms or similar if desired.
-  // These will all be of length matching clustering steps (Nelts-1)
+  // distOfMerge(stage) is the linkage distance of the merge made at stage (stage 0 is undefined).
   Eigen::Matrix<dtype, Eigen::Dynamic, 1> distOfMerge;
-  // These members change each step.
-  // these will store the indexes of the coefficients sought.
-  idxT minRow, minCol, stage;
-  // this bool stores outcome of 'merge'
-  bool merged;
-  // track the 'trajectory' of the clustering process
-  std::vector<std::vector<std::vector<idxT>>> clusterTraj;
-  // the vector of pointers to each cluster at the current stage.
-  // each element of cluster list will be currStg at stage == index.
-  std::vector<std::unique_ptr<std::vector<idxT>>> currStg;
-
-  // Merge two clusters into whichever is larger.
-  // Return true if new composite cluster is minRow, else return false
-  // In the case where clusters are of equal size, merge into minRow.
-  bool merge();
-
-  // Run through the clustering cycle, populating the 'trajectory' vectors.
+  // the compact dendrogram, in order of ascending merge distance.
+  // dendrogram[stage - 1] is the merge performed at stage.
+  std::vector<MergeStep> dendrogram;
+  // the stage currently being scored by penalty().
+  idxT stage;
+
+  // Run the nearest-neighbor chain over clusterDists, then sort the merges
+  // into stages and call penalty() once per stage.
   void cluster();
 
-  // need to fill this in for each type of clustering. 
-  // Equivalent to Eigen::RowVectorXx where x is typedtype 
-  virtual Eigen::Matrix<dtype, 1, Eigen::Dynamic> dist(idxT A, idxT B)=0;
+  // Reconstruct the cluster membership after 'stg' merges have been made.
+  // Clusters are ordered by their smallest member, and members ascend.
+  std::vector<std::vector<idxT>> clustersAtStage(idxT stg) const;
+
+  // number of elements beneath a node of the dendrogram.
+  idxT nodeSize(idxT node) const
+  {
+    return node < eltCount ? 1 : dendrogram[node - eltCount].size;
+  }
+
+  // Lance-Williams update: given the distances from clusters A and B to a
+  // third cluster K, return the distance from the merged cluster AB to K.
+  // Must describe a reducible linkage for the chain algorithm to be exact.
+  virtual dtype dist(dtype distAK, dtype distBK, idxT sizeA, idxT sizeB, idxT sizeK) = 0;
   // define a penalty function to score each level of the hierarchy.
-  virtual void penalty()=0;
+  // Called with stage set, in ascending order of stage.
+  virtual void penalty() = 0;
 };
 } // namespace Clustering
 #endif
@@ -42,8 +42,9 @@ idxT KGS::cutoff()
 void KGS::penalty()
 {
   // look up merged clustersize so we can assess change in spread.
-  idxT sizeA = (clusterTraj[stage - 1][minRow]).size();
-  idxT sizeB = (clusterTraj[stage - 1][minCol]).size();
+  const MergeStep &step = dendrogram[stage - 1];
+  idxT sizeA = nodeSize(step.left);
+  idxT sizeB = nodeSize(step.right);
   idxT sizeAB = sizeA + sizeB;
 #ifdef DEBUG
   cout << "sizeA:  " << sizeA << endl;
@@ -51,55 +52,27 @@ void KGS::penalty()
 #endif
   dtype normSpA{0};
   dtype normSpB{0};
-  dtype sumCrossDists = sizeA * sizeB * distOfMerge(stage);
+  dtype sumCrossDists = sizeA * sizeB * step.dist;
   // spread of A will be sum of distances of elts in a divided by (N*(N-1)/2)
   // This is for both A and B, hence two goes to the numerator of their sum.
   // nClusters goes up to record addition of one merged (nontrivial cluster)
-  if (merged)
-  {
-    // determine if the merge created a nontrivial cluster
-    if (sizeA == 1)
-      currentClusterCount++;
-    else
-      normSpA = 0.5 * (sizeA * (sizeA - 1)) * spreads(minRow);
-    // account for the case where the merged cluster was nontrivial
-    if (sizeB > 1)
-    {
-      currentClusterCount--;
-      normSpB = 0.5 * (sizeB * (sizeB - 1)) * spreads(minCol);
-    }
-    // spreads(minRow) = 2*(2*(normSpA + normSpB) + sumCrossDists)/(sizeAB*(sizeAB-1));
-    // remove spreads[minCol]
-    removeRow(spreads, minCol);
-    if (minCol < minRow)
-      spreads(minRow - 1) = 2 * (2 * (normSpA + normSpB) + sumCrossDists) / (sizeAB * (sizeAB - 1));
-    else
-      spreads(minRow) = 2 * (2 * (normSpA + normSpB) + sumCrossDists) / (sizeAB * (sizeAB - 1));
-  }
-  else
-  {
-    // determine if the merge created a nontrivial cluster
-    if (sizeB == 1)
-      currentClusterCount++;
-    else
-      normSpB = 0.5 * (sizeB * (sizeB - 1)) * spreads(minCol);
-    // account for the case where the merged cluster was nontrivial
-    if (sizeA > 1)
-    {
-      currentClusterCount--;
-      normSpA = 0.5 * (sizeA * (sizeA - 1)) * spreads(minCol);
-    }
-    // spreads(minCol) = 2*(2*(normSpA + normSpB) + sumCrossDists)/(sizeAB*(sizeAB-1));
-    // remove spreads[minRow]
-    removeRow(spreads, minRow);
-    if (minRow < minCol)
-      spreads(minCol - 1) = 2 * (2 * (normSpA + normSpB) + sumCrossDists) / (sizeAB * (sizeAB - 1));
-    else
-      spreads(minCol) = 2 * (2 * (normSpA + normSpB) + sumCrossDists) / (sizeAB * (sizeAB - 1));
-  }
+  // determine if the merge created a nontrivial cluster
+  if (sizeA == 1 && sizeB == 1)
+    currentClusterCount++;
+  // account for the case where the merged clusters were both nontrivial
+  if (sizeA > 1)
+    normSpA = 0.5 * (sizeA * (sizeA - 1)) * spreads(step.left);
+  if (sizeB > 1)
+    normSpB = 0.5 * (sizeB * (sizeB - 1)) * spreads(step.right);
+  if (sizeA > 1 && sizeB > 1)
+    currentClusterCount--;
+  // the children no longer exist as clusters at this stage.
+  dtype spreadAB = 2 * (2 * (normSpA + normSpB) + sumCrossDists) / (sizeAB * (sizeAB - 1));
+  spreads(eltCount + stage - 1) = spreadAB;
+  spreadSum += spreadAB - spreads(step.left) - spreads(step.right);
   // from paper, divide only by number of nontrivial clusters.
-  avgSpread(stage - 1) = spreads.sum() / currentClusterCount;
+  avgSpread(stage - 1) = spreadSum / currentClusterCount;
   // set penalties at the number of clusters, which is the same as eltCount - stage
   penalties(stage - 1) = eltCount - stage;
 }
-} // namespace Clustering
\ No newline at end of file
+} // namespace Clustering
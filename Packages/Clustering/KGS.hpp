@@ -8,10 +8,11 @@ namespace Clustering
 class KGS : public AverageLinkage
 {
 public:
-  KGS(const Eigen::Ref<Eigen::Matrix<dtype, Eigen::Dynamic, Eigen::Dynamic>> &e) : AverageLinkage(e),
-                                                                                   penalties(e.rows() - 1),
-                                                                                   avgSpread(e.rows() - 1),
-                                                                                   currentClusterCount{0} {}
+  KGS(const SymmetricMatrix<dtype> &e) : AverageLinkage(e),
+                                         penalties(e.rows() - 1),
+                                         avgSpread(e.rows() - 1),
+                                         currentClusterCount{0},
+                                         spreadSum{0} {}
 
   // compute penalties for each step
   Eigen::Matrix<dtype, Eigen::Dynamic, 1> penalties; // = VectorXd::Zero(eltCount-1);
@@ -20,16 +21,20 @@ public:
   Eigen::Matrix<dtype, Eigen::Dynamic, 1> avgSpread;
 
   // need to track the number of NONTRIVIAL clusters at each stage
-  // => nClusters != currStg.size() except in cases where all
-  // clusters are composite, which is not guaranteed until the very last stage.
+  // => this is less than the number of clusters present (eltCount - stage)
+  // unless all of them are composite, which is not guaranteed until the very
+  // last stage.
   idxT currentClusterCount;
 
   // call this to search for a cutoff stage in clustering.
   idxT cutoff();
 
 private:
-  // this will change per round of clustering
-  Eigen::Matrix<dtype, Eigen::Dynamic, 1> spreads = Eigen::Matrix<dtype, Eigen::Dynamic, 1>::Zero(eltCount);
+  // spread of each dendrogram node, indexed by node id. Only the merged
+  // cluster's spread changes at each stage, so the sum over the clusters
+  // present at the current stage is kept as a running total.
+  Eigen::Matrix<dtype, Eigen::Dynamic, 1> spreads = Eigen::Matrix<dtype, Eigen::Dynamic, 1>::Zero(2 * eltCount);
+  double spreadSum;
   void penalty();
 };
 } // namespace Clustering
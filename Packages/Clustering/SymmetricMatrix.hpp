@@ -0,0 +1,56 @@
+#if !defined(LOOS_SYMMETRIC_MATRIX_HPP)
+#define LOOS_SYMMETRIC_MATRIX_HPP
+#include "ClusteringTypedefs.hpp"
+#include <iostream>
+#include <vector>
+
+namespace Clustering
+{
+// Symmetric matrix that stores only its upper triangle (diagonal included),
+// packed row by row. Element (i, j) and (j, i) are the same storage, so
+// this takes half the memory of a dense square matrix.
+template <typename Numeric>
+class SymmetricMatrix
+{
+public:
+  SymmetricMatrix() : n{0} {}
+  explicit SymmetricMatrix(idxT dim) : n{dim}, packed(dim * (dim + 1) / 2, 0) {}
+
+  idxT rows() const { return n; }
+  idxT cols() const { return n; }
+
+  // offset of the diagonal element of row i in the packed storage.
+  idxT rowStart(idxT i) const { return i * n - i * (i - 1) / 2; }
+
+  Numeric &operator()(idxT i, idxT j)
+  {
+    return i <= j ? packed[rowStart(i) + j - i] : packed[rowStart(j) + i - j];
+  }
+  const Numeric &operator()(idxT i, idxT j) const
+  {
+    return i <= j ? packed[rowStart(i) + j - i] : packed[rowStart(j) + i - j];
+  }
+
+  // elements (i, i) through (i, n-1) are contiguous starting here.
+  Numeric *upperRow(idxT i) { return packed.data() + rowStart(i); }
+  const Numeric *upperRow(idxT i) const { return packed.data() + rowStart(i); }
+
+private:
+  idxT n;
+  std::vector<Numeric> packed;
+};
+
+// writes the full square matrix, whitespace delimited, one row per line.
+template <typename Numeric>
+std::ostream &operator<<(std::ostream &os, const SymmetricMatrix<Numeric> &m)
+{
+  for (idxT i = 0; i < m.rows(); i++)
+  {
+    for (idxT j = 0; j < m.cols(); j++)
+      os << (j ? " " : "") << m(i, j);
+    os << "\n";
+  }
+  return os;
+}
+} // namespace Clustering
+#endif
@@ -86,6 +86,13 @@ std::string fullHelpMessage(void) {
 "that, it will not be emitted to stderr, and you would write: \n"
 "cluster-kgs -f distances.asc > clustering_results.json \n"
 " \n"
+"Large matrices can instead be given as a raw binary file of native-endian \n"
+"32-bit floats holding the full square matrix in row-major order (as written \n"
+"by numpy's tofile()), using the -b flag together with -f. Only the upper \n"
+"triangle of the input is kept in memory, whichever format is used. The \n"
+"--threads option parallelizes the choice of exemplars, which needs the \n"
+"mean distance of every member to the rest of its cluster.\n"
+" \n"
 "Note: the output of multi-rmsds is also compatible with cluster-kgs; \n"
 "this is useful when you want to do all-to-all frame comparison across\n"
 "2 or more trajectories.\n"
@@ -124,11 +131,11 @@ int main(int argc, char *argv[]) {
 
   KGS clusterer(copts->similarityScores);
   if (copts->stream_mode)
-    std::cerr << copts->similarityScores; // Eigen objects stringify.
+    std::cerr << copts->similarityScores; // written as the full square matrix.
   clusterer.cluster();
   idxT optStg = clusterer.cutoff();
-  vector<idxT> exemplars =
-      getExemplars(clusterer.clusterTraj[optStg], copts->similarityScores);
+  vector<vector<idxT>> clusters = clusterer.clustersAtStage(optStg);
+  vector<idxT> exemplars = getExemplars(clusters, copts->similarityScores, copts->nthreads);
 
   // below here is output stuff. All quantities of interest have been obtained.
   cout << "{\n";
@@ -139,7 +146,7 @@ int main(int argc, char *argv[]) {
       clusterer.penalties, cout);
   cout << ",\n";
   cout << indent + "\"clusters\": ";
-  vectorVectorsAsJSONArr<idxT>((clusterer.clusterTraj)[optStg], cout, "  ");
+  vectorVectorsAsJSONArr<idxT>(clusters, cout, "  ");
   cout << ",\n";
   cout << indent + "\"exemplars\": ";
   containerAsJSONArr<vector<idxT>>(exemplars, cout, "  ");
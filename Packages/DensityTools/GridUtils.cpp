@@ -50,6 +50,28 @@ namespace loos {
     }
 
 
+    std::vector<double> gaussianKernel(const double sigma, const double cutoff) {
+      if (sigma <= 0.0)
+        return(std::vector<double>(1, 1.0));
+
+      int half = static_cast<int>(ceil(cutoff * sigma));
+      std::vector<double> kernel(2*half+1);
+
+      double sum = 0.0;
+      for (int i=-half; i<=half; ++i) {
+        double x = i / sigma;
+        double f = exp(-0.5*x*x);
+        kernel[i+half] = f;
+        sum += f;
+      }
+
+      for (std::vector<double>::iterator i = kernel.begin(); i != kernel.end(); ++i)
+        *i /= sum;
+
+      return(kernel);
+    }
+
+
   };
 };
 
@@ -31,12 +31,27 @@
 #define LOOS_GRID_UTILS_HPP
 
 #include <DensityGrid.hpp>
+#include <algorithm>
+#include <limits>
+#include <boost/thread/thread.hpp>
 
 namespace loos {
 
   namespace DensityTools {
 
 
+    //! Construct a 1D gaussian
+    std::vector<double> gaussian1d(const int, const double);
+
+    //! Construct a normalized 1D gaussian kernel
+    /**
+     * sigma is in grid units.  The kernel has an odd number of points,
+     * reaching out to cutoff*sigma on either side of the center, and
+     * sums to one.
+     */
+    std::vector<double> gaussianKernel(const double sigma, const double cutoff = 3.0);
+
+
     // Functors for grid operations
   
     //! Functor that is true if value is greater than or equal to threshold
@@ -67,6 +82,66 @@ namespace loos {
     };
 
 
+    namespace internal {
+
+      //! Number of blocks of planes to split n planes into
+      /**
+       * Zero threads means use all available cores.  There are never
+       * more blocks than planes, so every block is non-empty.
+       */
+      inline uint planeBlockCount(const int n, uint nthreads) {
+        if (nthreads == 0)
+          nthreads = boost::thread::hardware_concurrency();
+        if (nthreads > static_cast<uint>(n))
+          nthreads = n;
+        return(nthreads == 0 ? 1 : nthreads);
+      }
+
+      //! First plane of block b when n planes are split into nblocks
+      inline int planeBlockStart(const int n, const uint nblocks, const uint b) {
+        return(static_cast<long>(n) * b / nblocks);
+      }
+
+      //! Call f(block, first, last) for each block of planes, one thread per block
+      template<class Func>
+      void forEachPlaneBlock(const int n, const uint nblocks, const Func& f) {
+        if (nblocks <= 1) {
+          f(0, 0, n);
+          return;
+        }
+
+        boost::thread_group threads;
+        for (uint b=0; b<nblocks; ++b) {
+          int first = planeBlockStart(n, nblocks, b);
+          int last = planeBlockStart(n, nblocks, b+1);
+          threads.create_thread([&f, b, first, last]() { f(b, first, last); });
+        }
+        threads.join_all();
+      }
+
+
+      //! Root of x in a union-find forest (with path halving)
+      inline int findLabel(std::vector<int>& parent, int x) {
+        while (parent[x] != x) {
+          parent[x] = parent[parent[x]];
+          x = parent[x];
+        }
+        return(x);
+      }
+
+      //! Join the sets containing a and b, keeping the smaller label as the root
+      inline void joinLabels(std::vector<int>& parent, int a, int b) {
+        a = findLabel(parent, a);
+        b = findLabel(parent, b);
+        if (a < b)
+          parent[b] = a;
+        else if (b < a)
+          parent[a] = b;
+      }
+
+    };
+
+
     //! Flood-fill a grid
     /**
      * Requires a seed-point to start the grid at.
@@ -120,56 +195,295 @@ namespace loos {
     }
 
 
+    //! Summary of one blob (connected set of voxels) in a grid
+    struct BlobInfo {
+      BlobInfo() : voxels(0), mass(0.0), centroid(0,0,0), center(0,0,0),
+                   bbox_min(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()),
+                   bbox_max(-1, -1, -1) { }
+
+      long voxels;                  //!< Number of voxels in the blob
+      double mass;                  //!< Total density in the blob
+      loos::GCoord centroid;        //!< Geometric center (real-space, NaN if there are no voxels)
+      loos::GCoord center;          //!< Density-weighted center (real-space)
+      DensityGridpoint bbox_min;    //!< Lower corner of the bounding box (grid coords, inclusive)
+      DensityGridpoint bbox_max;    //!< Upper corner of the bounding box (grid coords, inclusive)
+    };
+
+
+    namespace internal {
+
+      //! Tally per-blob statistics for a labelled grid in one sweep
+      /**
+       * Each block of planes is summed into its own table by its own
+       * thread, and the tables are combined at the end.  relabel(block,
+       * label) maps the label stored in the grid to the final blob id;
+       * if out is non-null, the final id is written back there.
+       * weight(index) gives the density at a voxel.
+       */
+      template<class Grid, class Relabel, class Weight>
+      std::vector<BlobInfo> sweepBlobs(const Grid& grid, const int* labels, int* out, const int nblobs,
+                                       const uint nblocks, const Relabel& relabel, const Weight& weight) {
+        const DensityGridpoint dims = grid.gridDims();
+        const long plane = static_cast<long>(dims.x()) * dims.y();
+        std::vector< std::vector<BlobInfo> > tables(nblocks);
+
+        forEachPlaneBlock(dims.z(), nblocks, [&](const uint b, const int first, const int last) {
+            std::vector<BlobInfo> table(nblobs+1);
+            for (int k=first; k<last; ++k)
+              for (int j=0; j<dims.y(); ++j) {
+                long idx = k * plane + static_cast<long>(j) * dims.x();
+                for (int i=0; i<dims.x(); ++i, ++idx) {
+                  int id = relabel(b, labels[idx]);
+                  if (out)
+                    out[idx] = id;
+
+                  DensityGridpoint p(i, j, k);
+                  loos::GCoord u = grid.gridToWorld(p);
+                  double m = weight(idx);
+                  BlobInfo& blob = table[id];
+                  ++blob.voxels;
+                  blob.mass += m;
+                  blob.centroid += u;
+                  blob.center += m * u;
+                  for (int c=0; c<3; ++c) {
+                    if (p[c] < blob.bbox_min[c])
+                      blob.bbox_min[c] = p[c];
+                    if (p[c] > blob.bbox_max[c])
+                      blob.bbox_max[c] = p[c];
+                  }
+                }
+              }
+            tables[b].swap(table);
+          });
+
+        std::vector<BlobInfo> blobs;
+        blobs.swap(tables[0]);
+        for (uint b=1; b<nblocks; ++b)
+          for (int id=0; id<=nblobs; ++id) {
+            const BlobInfo& src = tables[b][id];
+            BlobInfo& dst = blobs[id];
+            dst.voxels += src.voxels;
+            dst.mass += src.mass;
+            dst.centroid += src.centroid;
+            dst.center += src.center;
+            for (int c=0; c<3; ++c) {
+              dst.bbox_min[c] = std::min(dst.bbox_min[c], src.bbox_min[c]);
+              dst.bbox_max[c] = std::max(dst.bbox_max[c], src.bbox_max[c]);
+            }
+          }
+
+        for (std::vector<BlobInfo>::iterator i = blobs.begin(); i != blobs.end(); ++i) {
+          i->centroid /= i->voxels;     // NaN for an empty id
+          if (i->mass != 0.0)
+            i->center /= i->mass;
+        }
+
+        return(blobs);
+      }
+
+    };
+
+
+    //! Label the connected blobs in a grid
+    /**
+     * Voxels of data_grid for which op is true are grouped into blobs
+     * of face-, edge- and corner-connected voxels (using the same
+     * neighborhood as floodFill()).  Each voxel of blob_grid is set to
+     * the id of the blob it belongs to, or 0.  Ids start at 1 and are
+     * numbered in the order the blobs are first met scanning the grid
+     * (x fastest), so the result is the same as flood-filling from
+     * each unlabelled voxel in turn.
+     *
+     * Rather than flood-filling, this is a two-pass union-find
+     * labeller.  The grid is split into slabs of z-planes and each
+     * slab is given provisional labels by its own thread.  Labels that
+     * meet across slab boundaries are then joined, and a second
+     * parallel sweep writes the final ids while tallying the blob
+     * statistics.  Memory use is bounded by the grid itself, so there
+     * is no stack or queue to overflow on large blobs.
+     *
+     * Returns one BlobInfo per id, where entry 0 describes the voxels
+     * that are in no blob.  Zero threads means use all available
+     * cores.
+     */
+    template<typename T, class Functor>
+    std::vector<BlobInfo> labelBlobs(const DensityGrid<T>& data_grid, DensityGrid<int>& blob_grid,
+                                     const Functor& op, const uint nthreads = 0) {
+      const DensityGridpoint dims = data_grid.gridDims();
+      const DensityGridpoint bdims = blob_grid.gridDims();
+      if (bdims.x() != dims.x() || bdims.y() != dims.y() || bdims.z() != dims.z())
+        blob_grid.resize(data_grid.minCoord(), data_grid.maxCoord(), dims);
+      else
+        blob_grid.zero();
+
+      if (data_grid.empty())
+        return(std::vector<BlobInfo>(1));
+
+      const int nx = dims.x();
+      const int ny = dims.y();
+      const int nz = dims.z();
+      const long plane = static_cast<long>(nx) * ny;
+      int* labels = &blob_grid(0L);
+      const uint nblocks = internal::planeBlockCount(nz, nthreads);
+
+      // The already-visited half of the neighborhood, i.e. neighbors
+      // that come earlier in the scan.  Like floodFill(), the (-1,-1,-1)
+      // and (1,1,1) corners are not considered neighbors.
+      std::vector<DensityGridpoint> behind;
+      for (int k=-1; k<=0; ++k)
+        for (int j=-1; j<=1; ++j)
+          for (int i=-1; i<=1; ++i) {
+            if (k == 0 && (j > 0 || (j == 0 && i >= 0)))
+              continue;
+            if (i == j && j == k)
+              continue;
+            behind.push_back(DensityGridpoint(i, j, k));
+          }
+
+      // First pass: provisional labels, local to each slab.  Neighbors
+      // in the plane before a slab belong to another thread and are
+      // left for the merge.
+      std::vector< std::vector<int> > parents(nblocks);
+      internal::forEachPlaneBlock(nz, nblocks, [&](const uint b, const int first, const int last) {
+          std::vector<int>& parent = parents[b];
+          parent.push_back(0);
+          for (int k=first; k<last; ++k)
+            for (int j=0; j<ny; ++j) {
+              long idx = k * plane + static_cast<long>(j) * nx;
+              for (int i=0; i<nx; ++i, ++idx) {
+                if (!op(data_grid(idx)))
+                  continue;
+
+                int label = 0;
+                for (std::vector<DensityGridpoint>::const_iterator n = behind.begin(); n != behind.end(); ++n) {
+                  int ni = i + n->x();
+                  int nj = j + n->y();
+                  if (ni < 0 || ni >= nx || nj < 0 || nj >= ny || (n->z() < 0 && k == first))
+                    continue;
+                  int neighbor = labels[idx + n->z() * plane + n->y() * nx + n->x()];
+                  if (!neighbor)
+                    continue;
+                  if (!label)
+                    label = neighbor;
+                  else if (neighbor != label)
+                    internal::joinLabels(parent, label, neighbor);
+                }
+
+                if (!label) {
+                  label = parent.size();
+                  parent.push_back(label);
+                }
+                labels[idx] = label;
+              }
+            }
+        });
+
+      // Gather the slab forests into one, offsetting each slab's labels
+      std::vector<int> offsets(nblocks, 0);
+      for (uint b=1; b<nblocks; ++b)
+        offsets[b] = offsets[b-1] + parents[b-1].size() - 1;
+      std::vector<int> parent(1, 0);
+      parent.reserve(offsets[nblocks-1] + parents[nblocks-1].size());
+      for (uint b=0; b<nblocks; ++b) {
+        for (uint l=1; l<parents[b].size(); ++l)
+          parent.push_back(parents[b][l] + offsets[b]);
+        std::vector<int>().swap(parents[b]);
+      }
+
+      // Join labels that touch across slab boundaries
+      for (uint b=1; b<nblocks; ++b) {
+        int k = internal::planeBlockStart(nz, nblocks, b);
+        for (int j=0; j<ny; ++j) {
+          long idx = k * plane + static_cast<long>(j) * nx;
+          for (int i=0; i<nx; ++i, ++idx) {
+            if (!labels[idx])
+              continue;
+            for (std::vector<DensityGridpoint>::const_iterator n = behind.begin(); n != behind.end(); ++n) {
+              if (n->z() == 0)
+                continue;
+              int ni = i + n->x();
+              int nj = j + n->y();
+              if (ni < 0 || ni >= nx || nj < 0 || nj >= ny)
+                continue;
+              int neighbor = labels[idx - plane + n->y() * nx + n->x()];
+              if (neighbor)
+                internal::joinLabels(parent, labels[idx] + offsets[b], neighbor + offsets[b-1]);
+            }
+          }
+        }
+      }
+
+      // Since the root of each set is its smallest label, and labels
+      // were handed out in scan order, numbering the roots in order
+      // numbers the blobs in the order they are first met.
+      std::vector<int> ids(parent.size(), 0);
+      int nblobs = 0;
+      for (uint l=1; l<parent.size(); ++l) {
+        int root = internal::findLabel(parent, l);
+        ids[l] = (root == static_cast<int>(l)) ? ++nblobs : ids[root];
+      }
+
+      // Second pass: final ids and statistics
+      return(internal::sweepBlobs(data_grid, labels, labels, nblobs, nblocks,
+                                  [&](const uint b, const int label) { return(label ? ids[label + offsets[b]] : 0); },
+                                  [&](const long idx) { return(static_cast<double>(data_grid(idx))); }));
+    }
+
+
+    //! Statistics for the blobs in an already labelled grid
+    /**
+     * The grid holds a blob id for each voxel (as written by blobid or
+     * labelBlobs()).  Returns one BlobInfo per id from 0 through the
+     * largest id in the grid; the mass of a blob is its voxel count.
+     */
+    inline std::vector<BlobInfo> blobStatistics(const DensityGrid<int>& blob_grid, const uint nthreads = 0) {
+      if (blob_grid.empty())
+        return(std::vector<BlobInfo>(1));
+
+      int nblobs = 0;
+      for (long i=0; i<blob_grid.size(); ++i)
+        if (blob_grid(i) > nblobs)
+          nblobs = blob_grid(i);
+      const int* labels = &blob_grid(0L);
+      uint nblocks = internal::planeBlockCount(blob_grid.gridDims().z(), nthreads);
+      return(internal::sweepBlobs(blob_grid, labels, 0, nblobs, nblocks,
+                                  [](const uint, const int label) { return(label < 0 ? 0 : label); },
+                                  [](const long) { return(1.0); }));
+    }
+
+
     //! Find peaks in a grid given the criteria defined by the passed functor
     /**
-     * Requires a data-grid, a grid to contain the flood-filled
+     * Requires a data-grid, a grid to contain the blob
      * assignments, and a functor that determines what points in the
      * data-grid to operate on.
      *
      * This function segments the grid into a blobs based on the
-     * functor.  For each unique blob, it returns the center of mass
+     * functor (see labelBlobs()).  For each unique blob, it returns the center of mass
      * of the blob as a vector of GCoords.  The vector index
      * corresponds to the blob_id - 1 in the blobs grid.
      */
     
     template<typename T, class Functor>
-    std::vector<loos::GCoord> findPeaks(const DensityGrid<T>& grid, DensityGrid<int>& blobs, const Functor& op) {
-      std::vector<loos::GCoord> peaks;
+    std::vector<loos::GCoord> findPeaks(const DensityGrid<T>& grid, DensityGrid<int>& blobs, const Functor& op,
+                                        const uint nthreads = 0) {
+      std::vector<BlobInfo> info = labelBlobs(grid, blobs, op, nthreads);
 
-      DensityGridpoint dims = grid.gridDims();
+      std::vector<loos::GCoord> peaks;
+      for (uint i=1; i<info.size(); ++i)
+        peaks.push_back(info[i].center);
 
-      int id = 0;
-      for (int k=0; k<dims.z(); ++k)
-        for (int j=0; j<dims.y(); ++j)
-          for (int i=0; i<dims.x(); ++i) {
-            DensityGridpoint p (i, j, k);
-            if (!blobs(p) && op(grid(p))) {
-              std::vector<DensityGridpoint> points = floodFill(p, grid, ++id, blobs, op);
-              if (!points.empty()) {
-                loos::GCoord center(0,0,0);
-                double mass = 0.0;
-                for (std::vector<DensityGridpoint>::iterator i = points.begin(); i != points.end(); ++i) {
-                  double m = grid(*i);
-                  center += m * grid.gridToWorld(*i);
-                  mass += m;
-                }
-                center /= mass;
-                peaks.push_back(center);
-              }
-            }
-          }
-    
       return(peaks);
     }
 
 
     //! Find peaks in a grid based on the functor
     template<typename T, class Functor>
-    std::vector<loos::GCoord> findPeaks(const DensityGrid<T>& grid, const Functor& op) {
+    std::vector<loos::GCoord> findPeaks(const DensityGrid<T>& grid, const Functor& op, const uint nthreads = 0) {
 
       DensityGridpoint dims = grid.gridDims();
       DensityGrid<int> blobs(grid.minCoord(), grid.maxCoord(), dims);
-      return(findPeaks(grid, blobs, op));
+      return(findPeaks(grid, blobs, op, nthreads));
     }
 
 
@@ -238,65 +552,132 @@ namespace loos {
     }
 
 
-    //! Convolve a grid with a 1D kernel stored in a vector
+    //! Convolve a grid with a separate 1D kernel along each axis
+    /**
+     * This is a separable convolution, i.e. three 1D passes (along
+     * z, then y, then x) rather than a full 3D kernel.  Each kernel
+     * is centered at index size/2 and the grid is treated as zero
+     * outside its bounds.
+     *
+     * The z and y passes accumulate whole rows at a time (kernel
+     * weight times a contiguous row of the source), so the innermost
+     * loop always walks memory in order.  The x pass works on one row
+     * at a time out of a small per-thread buffer.  Each pass is split
+     * across threads by z-plane; a zero thread count uses all
+     * available cores.
+     */
     template<class T>
-    void gridConvolve(DensityGrid<T>& grid, std::vector<T>& kernel) {
-      DensityGridpoint gdim = grid.gridDims();
-      int kn = kernel.size();
-      int kc = kn / 2;
-
-      DensityGrid<T> tmp(grid.minCoord(), grid.maxCoord(), grid.gridDims());
-      tmp.metadata(grid.metadata());
-
-      // First convolve along the k axis...
-      for (int j=0; j<gdim.y(); ++j)
-        for (int i=0; i<gdim.x(); ++i)
-          for (int k = 0; k<gdim.z(); ++k) {
-            T sum = 0;
-            for (int ii = 0; ii<kn; ++ii) {
-              int idx = k + ii - kc;
-              if (idx < 0 || idx >= gdim.z())
-                continue;
-              sum += grid(idx, j, i) * kernel[ii];
+    void gridConvolveSeparable(DensityGrid<T>& grid, const std::vector<T>& kx, const std::vector<T>& ky,
+                               const std::vector<T>& kz, const uint nthreads = 0) {
+      if (grid.empty())
+        return;
+
+      const DensityGridpoint gdim = grid.gridDims();
+      const int nx = gdim.x();
+      const int ny = gdim.y();
+      const int nz = gdim.z();
+      const long plane = static_cast<long>(nx) * ny;
+
+      T* data = &grid(0L);
+      std::vector<T> tmp(grid.size());
+      T* work = &tmp[0];
+      const uint nblocks = internal::planeBlockCount(nz, nthreads);
+
+      // Along z: output plane k is a weighted sum of neighboring planes
+      // of the original grid, built up one row at a time
+      internal::forEachPlaneBlock(nz, nblocks, [&](const uint, const int first, const int last) {
+          const int kn = kz.size();
+          const int kc = kn / 2;
+          for (int k=first; k<last; ++k)
+            for (int j=0; j<ny; ++j) {
+              T* out = work + k * plane + static_cast<long>(j) * nx;
+              std::fill(out, out + nx, T(0));
+              for (int ii=0; ii<kn; ++ii) {
+                int idx = k + ii - kc;
+                if (idx < 0 || idx >= nz)
+                  continue;
+                const T* in = data + idx * plane + static_cast<long>(j) * nx;
+                const T w = kz[ii];
+                for (int i=0; i<nx; ++i)
+                  out[i] += in[i] * w;
+              }
             }
-            tmp(k, j, i) = sum;
-          }
-
-      // Convolve along the j axis
-      DensityGrid<T> tmp2(grid.minCoord(), grid.maxCoord(), grid.gridDims());
-      tmp2.metadata(grid.metadata());
-      for (int k=0; k<gdim.z(); ++k)
-        for (int i=0; i<gdim.x(); ++i)
-          for (int j=0; j<gdim.y(); ++j) {
-            T sum = 0;
-            for (int ii=0; ii<kn; ++ii) {
-              int idx = j + ii - kc;
-              if (idx < 0 || idx >= gdim.y())
-                continue;
-              sum += tmp(k, idx, i) * kernel[ii];
+        });
+
+      // Along y: planes are independent, so write straight back into the grid
+      internal::forEachPlaneBlock(nz, nblocks, [&](const uint, const int first, const int last) {
+          const int kn = ky.size();
+          const int kc = kn / 2;
+          for (int k=first; k<last; ++k) {
+            const T* src = work + k * plane;
+            T* dst = data + k * plane;
+            for (int j=0; j<ny; ++j) {
+              T* out = dst + static_cast<long>(j) * nx;
+              std::fill(out, out + nx, T(0));
+              for (int ii=0; ii<kn; ++ii) {
+                int idx = j + ii - kc;
+                if (idx < 0 || idx >= ny)
+                  continue;
+                const T* in = src + static_cast<long>(idx) * nx;
+                const T w = ky[ii];
+                for (int i=0; i<nx; ++i)
+                  out[i] += in[i] * w;
+              }
             }
-            tmp2(k, j, i) = sum;
           }
-
-      // Finally, convolve along the i axis
-      for (int k=0; k<gdim.z(); ++k)
-        for (int j=0; j<gdim.y(); ++j)
-          for (int i=0; i<gdim.x(); ++i) {
-            T sum = 0;
-            for (int ii=0; ii<kn; ++ii) {
-              int idx = i + ii - kc;
-              if (idx < 0 || idx >= gdim.x())
-                continue;
-              sum += tmp2(k, j, idx) * kernel[ii];
+        });
+
+      // Along x: rows are independent, so work in place from a copy of each row
+      internal::forEachPlaneBlock(nz, nblocks, [&](const uint, const int first, const int last) {
+          const int kn = kx.size();
+          const int kc = kn / 2;
+          std::vector<T> row(nx);
+          for (int k=first; k<last; ++k)
+            for (int j=0; j<ny; ++j) {
+              T* out = data + k * plane + static_cast<long>(j) * nx;
+              std::copy(out, out + nx, row.begin());
+              for (int i=0; i<nx; ++i) {
+                int lo = std::max(0, kc - i);
+                int hi = std::min(kn, nx + kc - i);
+                T sum = 0;
+                for (int ii=lo; ii<hi; ++ii)
+                  sum += row[i + ii - kc] * kx[ii];
+                out[i] = sum;
+              }
             }
-            tmp(k, j, i) = sum;
-          }
+        });
+    }
 
-      grid = tmp;
+
+    //! Convolve a grid with a 1D kernel stored in a vector
+    /**
+     * The same kernel is applied along each axis.  See
+     * gridConvolveSeparable() for details.
+     */
+    template<class T>
+    void gridConvolve(DensityGrid<T>& grid, const std::vector<T>& kernel, const uint nthreads = 0) {
+      gridConvolveSeparable(grid, kernel, kernel, kernel, nthreads);
+    }
+
+
+    //! Smooth a grid with a gaussian of width sigma (in real-space units)
+    /**
+     * The kernel for each axis is built from that axis' grid spacing,
+     * extends out to cutoff*sigma, and is normalized to sum to one, so
+     * the total density in the grid is preserved (away from the edges).
+     */
+    template<class T>
+    void gridGaussianSmooth(DensityGrid<T>& grid, const double sigma, const uint nthreads = 0, const double cutoff = 3.0) {
+      loos::GCoord delta = grid.gridDelta();
+      std::vector<T> kernels[3];
+      for (int i=0; i<3; ++i) {
+        std::vector<double> k = gaussianKernel(sigma * delta[i], cutoff);
+        kernels[i].assign(k.begin(), k.end());
+      }
+
+      gridConvolveSeparable(grid, kernels[0], kernels[1], kernels[2], nthreads);
     }
 
-    //! Construct a 1D gaussian
-    std::vector<double> gaussian1d(const int, const double);
 
   };
 
@@ -0,0 +1,434 @@
+/*
+  Sparse, tiled Density Grid Class for LOOS
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008 Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_TILEDDENSITYGRID_HPP)
+#define LOOS_TILEDDENSITYGRID_HPP
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <loos.hpp>
+#include <Coord.hpp>
+
+#include <DensityGrid.hpp>
+#include <SimpleMeta.hpp>
+
+namespace loos {
+
+  namespace DensityTools {
+
+
+    //! A sparse 3D grid that only stores the regions that have been touched
+    /**
+     * The grid is broken into cubic tiles of TILE_EDGE voxels per side.
+     * A tile is only allocated once one of its voxels is written to, so
+     * a large box at fine resolution that is mostly empty (e.g. internal
+     * water) costs little more than the occupied region.  Unallocated
+     * voxels read as zero.
+     *
+     * The mapping between real-space and grid-space is exactly that of
+     * DensityGrid, and the grid reads and writes the same
+     * "DensityGrid-1.1" format, one row at a time, so the dense grid is
+     * never materialized.  Use dense() to convert when a tool needs the
+     * full DensityGrid interface.
+     *
+     * Tiles can be merged with operator+=, which is how per-thread
+     * private grids are combined without locking (see GridAccumulator).
+     */
+    template<class T>
+    class TiledDensityGrid {
+    public:
+      typedef T                      value_type;
+      static const int TILE_EDGE = 16;
+      static const long TILE_VOXELS = TILE_EDGE * TILE_EDGE * TILE_EDGE;
+
+      TiledDensityGrid() : _gridmin(0,0,0), _gridmax(0,0,0), dims(0,0,0) { init(); }
+
+      //! Create a grid with explicit location in realspace and dimensions
+      TiledDensityGrid(const loos::GCoord& gmin, const loos::GCoord& gmax, const DensityGridpoint& griddims) :
+        _gridmin(gmin), _gridmax(gmax), dims(griddims) { init(); }
+
+      //! Create an empty grid with the same geometry (and metadata) as \a g
+      template<typename S>
+      explicit TiledDensityGrid(const DensityGrid<S>& g) :
+        _gridmin(g.minCoord()), _gridmax(g.maxCoord()), dims(g.gridDims()), meta_(g.metadata()) { init(); }
+
+      TiledDensityGrid(const TiledDensityGrid<T>& g) :
+        _gridmin(g._gridmin), _gridmax(g._gridmax), dims(g.dims), meta_(g.meta_)
+      {
+        init();
+        for (long t=0; t<ntiles; ++t)
+          if (g.tiles[t]) {
+            tiles[t].reset(new T[TILE_VOXELS]);
+            memcpy(tiles[t].get(), g.tiles[t].get(), TILE_VOXELS * sizeof(T));
+          }
+      }
+
+      const TiledDensityGrid<T>& operator=(const TiledDensityGrid<T>& g) {
+        if (this != &g) {
+          TiledDensityGrid<T> tmp(g);
+          swap(tmp);
+        }
+        return(*this);
+      }
+
+      void swap(TiledDensityGrid<T>& g) {
+        std::swap(_gridmin, g._gridmin);
+        std::swap(_gridmax, g._gridmax);
+        std::swap(delta, g.delta);
+        std::swap(dims, g.dims);
+        std::swap(tdims, g.tdims);
+        std::swap(ntiles, g.ntiles);
+        std::swap(dimabc, g.dimabc);
+        tiles.swap(g.tiles);
+        std::swap(meta_, g.meta_);
+      }
+
+      void resize(const loos::GCoord& gmin, const loos::GCoord& gmax, const DensityGridpoint& griddims) {
+        _gridmin = gmin;
+        _gridmax = gmax;
+        dims = griddims;
+        init();
+      }
+
+
+      //! Converts a real-space coordinate into grid coords (same as DensityGrid)
+      DensityGridpoint gridpoint(const loos::GCoord& x) const {
+        DensityGridpoint v;
+        for (int i=0; i<3; i++)
+          v[i] = static_cast<long>(floor( (x[i] - _gridmin[i]) * delta[i] + 0.5 ));
+        return(v);
+      }
+
+      //! Converts grid coords to real-space (world) coords
+      loos::GCoord gridToWorld(const DensityGridpoint& v) const {
+        loos::GCoord c;
+        for (int i=0; i<3; i++)
+          c[i] = static_cast<loos::greal>(v[i]) / delta[i] + _gridmin[i];
+        return(c);
+      }
+
+      bool inRange(const DensityGridpoint& g) const {
+        for (int i=0; i<3; i++)
+          if (g[i] < 0 || g[i] >= dims[i])
+            return(false);
+        return(true);
+      }
+
+
+      //! Read the element indexed by k, j, i (zero if its tile is absent)
+      T operator()(const int k, const int j, const int i) const {
+        const T* tile = tiles[tileIndex(k, j, i)].get();
+        return(tile ? tile[voxelIndex(k, j, i)] : T(0));
+      }
+
+      T operator()(const DensityGridpoint& v) const {
+        return(operator()(v.z(), v.y(), v.x()));
+      }
+
+      //! Writable access to the element indexed by k, j, i, allocating its tile
+      T& operator()(const int k, const int j, const int i) {
+        return(tile(tileIndex(k, j, i))[voxelIndex(k, j, i)]);
+      }
+
+      T& operator()(const DensityGridpoint& v) {
+        return(operator()(v.z(), v.y(), v.x()));
+      }
+
+      //! Converts \a x into grid coords, then accesses that element
+      T& operator()(const loos::GCoord& x) {
+        return(operator()(gridpoint(x)));
+      }
+
+
+      //! Adds all voxels of \a g (which must have the same dimensions) into this grid
+      /**
+       * Tiles that only exist in \a g are copied over; tiles that exist
+       * in both are summed.
+       */
+      TiledDensityGrid<T>& operator+=(const TiledDensityGrid<T>& g) {
+        checkCompatible(g);
+        for (long t=0; t<ntiles; ++t) {
+          const T* src = g.tiles[t].get();
+          if (!src)
+            continue;
+          if (!tiles[t]) {
+            tiles[t].reset(new T[TILE_VOXELS]);
+            memcpy(tiles[t].get(), src, TILE_VOXELS * sizeof(T));
+          } else {
+            T* dst = tiles[t].get();
+            for (long i=0; i<TILE_VOXELS; ++i)
+              dst[i] += src[i];
+          }
+        }
+        return(*this);
+      }
+
+      //! Like operator+=, but steals tiles from \a g rather than copying them
+      void mergeFrom(TiledDensityGrid<T>& g) {
+        checkCompatible(g);
+        for (long t=0; t<ntiles; ++t) {
+          if (!g.tiles[t])
+            continue;
+          if (!tiles[t])
+            tiles[t] = std::move(g.tiles[t]);
+          else {
+            T* dst = tiles[t].get();
+            const T* src = g.tiles[t].get();
+            for (long i=0; i<TILE_VOXELS; ++i)
+              dst[i] += src[i];
+            g.tiles[t].reset();
+          }
+        }
+      }
+
+
+      void scale(const T val) {
+        for (long t=0; t<ntiles; ++t)
+          if (tiles[t]) {
+            T* p = tiles[t].get();
+            for (long i=0; i<TILE_VOXELS; ++i)
+              p[i] *= val;
+          }
+      }
+
+      //! Release all tiles, returning the grid to all zeros
+      void clear() {
+        for (long t=0; t<ntiles; ++t)
+          tiles[t].reset();
+      }
+
+      //! Expand into a dense DensityGrid
+      DensityGrid<T> dense() const {
+        DensityGrid<T> g(_gridmin, _gridmax, dims);
+        for (int k=0; k<dims.z(); ++k)
+          for (int j=0; j<dims.y(); ++j)
+            for (int i=0; i<dims.x(); ++i)
+              g(k, j, i) = operator()(k, j, i);
+        g.metadata(meta_);
+        return(g);
+      }
+
+
+      DensityGridpoint gridDims(void) const { return(dims); }
+      loos::GCoord minCoord(void) const { return(_gridmin); }
+      loos::GCoord maxCoord(void) const { return(_gridmax); }
+      loos::GCoord gridDelta(void) const { return(delta); }
+      long size() const { return(dimabc); }
+      bool empty() const { return(dimabc == 0); }
+
+      //! Number of tiles that have been allocated
+      long allocatedTiles() const {
+        long n = 0;
+        for (long t=0; t<ntiles; ++t)
+          if (tiles[t])
+            ++n;
+        return(n);
+      }
+
+      //! Approximate memory used by the voxel data, in bytes
+      long memoryUsed() const {
+        return(allocatedTiles() * TILE_VOXELS * sizeof(T) + ntiles * sizeof(typename TileList::value_type));
+      }
+
+      void setMetadata(const std::string& s) { meta_.set(s); }
+      void addMetadata(const std::string& s) { meta_.add(s); }
+
+      SimpleMeta metadata() const { return(meta_); }
+      void metadata(const SimpleMeta& m) { meta_ = m; }
+
+
+      //! Write out the grid in DensityGrid format, one row at a time
+      friend std::ostream& operator<<(std::ostream& os, const TiledDensityGrid<T>& grid) {
+        os << "# DensityGrid-1.1\n";
+        os << grid.meta_;
+        os << grid.dims << std::endl;
+        os << grid._gridmin << std::endl;
+        os << grid._gridmax << std::endl;
+
+        std::vector<T> row(grid.dims.x());
+        for (int k=0; k<grid.dims.z(); ++k)
+          for (int j=0; j<grid.dims.y(); ++j) {
+            grid.fetchRow(k, j, row.data());
+            os.write(reinterpret_cast<char*>(row.data()), sizeof(T) * row.size());
+          }
+        return(os);
+      }
+
+      //! Read a grid in DensityGrid format, only keeping tiles with non-zero voxels
+      friend std::istream& operator>>(std::istream& is, TiledDensityGrid<T>& grid) {
+        std::string s;
+
+        std::getline(is, s);
+        if (s != "# DensityGrid-1.1")
+          throw(std::runtime_error("Bad input format for DensityGrid  - " + s));
+
+        is >> grid.meta_;
+        is >> grid.dims;
+        is >> grid._gridmin;
+        is >> grid._gridmax;
+        if (is.get() != '\n')  // Pull trailing newline off of input...
+          throw(std::runtime_error("Grid parse error in header"));
+
+        grid.init();
+        std::vector<T> row(grid.dims.x());
+        for (int k=0; k<grid.dims.z(); ++k)
+          for (int j=0; j<grid.dims.y(); ++j) {
+            is.read(reinterpret_cast<char*>(row.data()), sizeof(T) * row.size());
+            if (is.fail())
+              throw(std::runtime_error("Grid read error"));
+            for (int i=0; i<grid.dims.x(); ++i)
+              if (row[i] != T(0))
+                grid(k, j, i) = row[i];
+          }
+
+        return(is);
+      }
+
+
+    private:
+      typedef std::vector< std::unique_ptr<T[]> > TileList;
+
+      void init() {
+        dimabc = static_cast<long>(dims[0]) * dims[1] * dims[2];
+        for (int i=0; i<3; i++) {
+          delta[i] = (dims[i] - 1)/ (_gridmax[i] - _gridmin[i]);
+          tdims[i] = (dims[i] + TILE_EDGE - 1) / TILE_EDGE;
+        }
+        ntiles = static_cast<long>(tdims[0]) * tdims[1] * tdims[2];
+        TileList(ntiles).swap(tiles);
+      }
+
+      void checkCompatible(const TiledDensityGrid<T>& g) const {
+        if (g.dims != dims)
+          throw(std::logic_error("Tiled grids must have the same dimensions"));
+      }
+
+      long tileIndex(const int k, const int j, const int i) const {
+        return((static_cast<long>(k / TILE_EDGE) * tdims[1] + j / TILE_EDGE) * tdims[0] + i / TILE_EDGE);
+      }
+
+      static long voxelIndex(const int k, const int j, const int i) {
+        return(((k % TILE_EDGE) * TILE_EDGE + (j % TILE_EDGE)) * TILE_EDGE + (i % TILE_EDGE));
+      }
+
+      T* tile(const long t) {
+        if (!tiles[t]) {
+          tiles[t].reset(new T[TILE_VOXELS]);
+          std::fill(tiles[t].get(), tiles[t].get() + TILE_VOXELS, T(0));
+        }
+        return(tiles[t].get());
+      }
+
+      // Copies one x-row of the grid into dst, filling absent tiles with zero
+      void fetchRow(const int k, const int j, T* dst) const {
+        for (int ti=0; ti<tdims[0]; ++ti) {
+          int i0 = ti * TILE_EDGE;
+          int n = std::min(TILE_EDGE, dims[0] - i0);
+          const T* src = tiles[tileIndex(k, j, i0)].get();
+          if (src)
+            memcpy(dst + i0, src + voxelIndex(k, j, 0), n * sizeof(T));
+          else
+            std::fill(dst + i0, dst + i0 + n, T(0));
+        }
+      }
+
+    private:
+      loos::GCoord _gridmin, _gridmax, delta;
+      DensityGridpoint dims, tdims;
+      long dimabc, ntiles;
+      TileList tiles;
+
+      SimpleMeta meta_;
+    };
+
+    template<class T> const int TiledDensityGrid<T>::TILE_EDGE;
+    template<class T> const long TiledDensityGrid<T>::TILE_VOXELS;
+
+
+
+    //! Accumulates into per-thread private tiled grids and merges them
+    /**
+     * Each worker thread writes only to its own TiledDensityGrid, so no
+     * locks or atomics are needed while binning.  Because the private
+     * grids are sparse, keeping one per thread costs only the tiles each
+     * thread actually touches.  Call merge() once all workers have
+     * joined.
+     */
+    template<class T>
+    class GridAccumulator {
+    public:
+      GridAccumulator(const TiledDensityGrid<T>& shape, const uint nthreads) :
+        grids_(nthreads), out_of_bounds_(nthreads, 0)
+      {
+        for (uint i=0; i<nthreads; ++i)
+          grids_[i].resize(shape.minCoord(), shape.maxCoord(), shape.gridDims());
+      }
+
+      uint threads() const { return(grids_.size()); }
+
+      //! Bins \a val at real-space coords \a c into the grid private to \a thread
+      void add(const uint thread, const loos::GCoord& c, const T val) {
+        TiledDensityGrid<T>& g = grids_[thread];
+        DensityGridpoint p = g.gridpoint(c);
+        if (!g.inRange(p))
+          ++out_of_bounds_[thread];
+        else
+          g(p) += val;
+      }
+
+      TiledDensityGrid<T>& grid(const uint thread) { return(grids_[thread]); }
+
+      //! Merges all private grids into \a dest, emptying them
+      void merge(TiledDensityGrid<T>& dest) {
+        for (uint i=0; i<grids_.size(); ++i)
+          dest.mergeFrom(grids_[i]);
+      }
+
+      long outOfBounds() const {
+        long n = 0;
+        for (uint i=0; i<out_of_bounds_.size(); ++i)
+          n += out_of_bounds_[i];
+        return(n);
+      }
+
+    private:
+      std::vector< TiledDensityGrid<T> > grids_;
+      std::vector<long> out_of_bounds_;
+    };
+
+
+  };
+
+};
+
+#endif
@@ -35,6 +35,7 @@
 #include <limits>
 
 #include <DensityGrid.hpp>
+#include <GridUtils.hpp>
 
 using namespace std;
 using namespace loos;
@@ -43,57 +44,6 @@ using namespace loos::DensityTools;
 
 
 
-int countBlobs(const DensityGrid<int>& grid) {
-  DensityGridpoint dims = grid.gridDims();
-  long k = dims[0] * dims[1] * dims[2];
-  int n = 0;
-
-  for (long i=0; i<k; i++)
-    if (grid(i) > n)
-      n = grid(i);
-
-  return(n);
-}
-
-
-vector<int> sizeBlobs(const DensityGrid<int>& grid) {
-
-  int n = countBlobs(grid);
-  vector<int> sizes(n+1, 0);
-
-  DensityGridpoint dims = grid.gridDims();
-  long k = dims[0] * dims[1] * dims[2];
-  
-  for (long i=0; i<k; i++)
-    sizes[grid(i)] += 1;
-  
-  return(sizes);
-}
-
-
-vector<GCoord> blobCentroids(const int n, const DensityGrid<int>& grid) {
-  vector<GCoord> centers(n+1, GCoord(0,0,0));
-  vector<int> counts(n+1, 0);
-
-  DensityGridpoint dims = grid.gridDims();
-  for (int k=0; k<dims[2]; k++)
-    for (int j=0; j<dims[1]; j++)
-      for (int i=0; i<dims[0]; i++) {
-	DensityGridpoint point(i,j,k);
-	GCoord u = grid.gridToWorld(point);
-	int id = grid(point);
-
-	centers[id] += u;
-	counts[id] += 1;
-      }
-
-  for (int i=0; i<= n; i++)
-    centers[i] /= counts[i];
-
-  return(centers);
-}
-
-
 int main(int argc, char *argv[]) {
   DensityGrid<int> grid;
 
@@ -112,9 +62,7 @@ int main(int argc, char *argv[]) {
   GCoord range = grid.maxCoord() - grid.minCoord();
   cout << "Grid range is " << range << endl;
 
-  vector<int> sizes = sizeBlobs(grid);
-  int n = sizes.size();
-  vector<GCoord> centers = blobCentroids(n, grid);
+  vector<BlobInfo> blobs = blobStatistics(grid);
 
   GCoord delta = grid.gridDelta();
   double voxel_volume = 1.0 / delta[0];
@@ -135,9 +83,9 @@ int main(int argc, char *argv[]) {
 
 
 
-  for (uint i = 0; i < sizes.size(); ++i) {
-    cout << boost::format("%6d %12d %12.6g\t") % i % sizes[i] % (sizes[i] * voxel_volume);
-    cout << centers[i] << endl;
+  for (uint i = 0; i < blobs.size(); ++i) {
+    cout << boost::format("%6d %12d %12.6g\t") % i % blobs[i].voxels % (blobs[i].voxels * voxel_volume);
+    cout << blobs[i].centroid << endl;
   }
 
 }
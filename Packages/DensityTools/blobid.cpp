@@ -45,6 +45,8 @@ using namespace loos;
 using namespace loos::DensityTools;
 
 double lower, upper;
+double sigma;
+uint nthreads;
 
 // @cond TOOLS_INTERNAL
 
@@ -60,7 +62,7 @@ string fullHelpMessage(void) {
     "\n"
     "\tblobid identifies blobs by density values either in a range or above a threshold.\n"
     "An edm grid (see for example water-hist) is expected for input.\n"
-    "Blobid then uses a flood-fill to determine how many separate blobs\n"
+    "Blobid then labels the connected voxels to determine how many separate blobs\n"
     "meet the threshold/range criteria.  A new grid is then written out\n"
     "which identifies the separate blobs.\n"
     "\nEXAMPLES\n"
@@ -71,6 +73,9 @@ string fullHelpMessage(void) {
     "\twater-hist --radius=15 --bulk=25 --scale=1 b2ar.pdb b2ar.dcd |\\\n"
     "\t  grid2gauss 4 2 > foo_grid\n"
     "The resulting blobs are then written to the grid \"foo_id\"\n"
+    "\n\tblobid --threshold 1 --smooth 2 <foo.grid >foo_id.grid\n"
+    "This smooths the grid with a gaussian (sigma = 2 Angstroms) before\n"
+    "identifying blobs, so no separate smoothing step is needed.\n"
     "\n\n";
 
   return(msg);
@@ -82,7 +87,9 @@ class ToolOptions : public opts::OptionsPackage {
     o.add_options()
       ("lower", po::value<double>(), "Sets the lower threshold for segmenting the grid")
       ("upper", po::value<double>(), "Sets the upper threshold for segmenting the grid")
-      ("threshold", po::value<double>(), "Sets the threshold for segmenting the grid.");
+      ("threshold", po::value<double>(), "Sets the threshold for segmenting the grid.")
+      ("smooth", po::value<double>(&sigma)->default_value(0.0), "Smooth the grid with a gaussian of this width (in Angstroms) first")
+      ("threads", po::value<uint>(&nthreads)->default_value(0), "Number of threads to use (0 = all available)");
   }
 
   bool postConditions(po::variables_map& vm) {
@@ -104,7 +111,7 @@ class ToolOptions : public opts::OptionsPackage {
   string print() const {
     ostringstream oss;
 
-    oss << boost::format("lower=%f, upper=%f") % lower % upper;
+    oss << boost::format("lower=%f, upper=%f, smooth=%f, threads=%d") % lower % upper % sigma % nthreads;
     return(oss.str());
   }
 
@@ -114,37 +121,25 @@ class ToolOptions : public opts::OptionsPackage {
 
 
 
-int fill(const DensityGridpoint seed, const int val, DensityGrid<double>& data_grid, DensityGrid<int>& blob_grid, const double low, const double high) {
-  vector<DensityGridpoint> blob = floodFill(seed, data_grid, val, blob_grid, ThresholdRange<double>(low, high));
-  return(blob.size());
-}
-
-
 boost::tuple<int, int, int, double> findBlobs(DensityGrid<double>& data_grid, DensityGrid<int>& blob_grid, const double low, const double high) {
-  DensityGridpoint dims = data_grid.gridDims();
+  vector<BlobInfo> info = labelBlobs(data_grid, blob_grid, ThresholdRange<double>(low, high), nthreads);
 
-  int id = 1;
+  int n = info.size() - 1;
   int min = numeric_limits<int>::max();
   int max = numeric_limits<int>::min();
   double avg = 0.0;
 
-  for (int k=0; k<dims[2]; k++) {
-    for (int j=0; j<dims[1]; j++)
-      for (int i=0; i<dims[0]; i++) {
-	DensityGridpoint point(i,j,k);
-	if (blob_grid(point) == 0 && (data_grid(point) >= low && data_grid(point) <= high)) {
-	  int n = fill(point, id++, data_grid, blob_grid, low, high);
-	  if (n < min)
-	    min = n;
-	  if (n > max)
-	    max = n;
-	  avg += n;
-	}
-      }
+  for (int i=1; i<=n; ++i) {
+    int size = info[i].voxels;
+    if (size < min)
+      min = size;
+    if (size > max)
+      max = size;
+    avg += size;
   }
 
-  avg /= (id-1);
-  boost::tuple<int, int, int, double> res(id-1, min, max, avg);
+  avg /= n;
+  boost::tuple<int, int, int, double> res(n, min, max, avg);
   return(res);
 }
 
@@ -167,6 +162,9 @@ int main(int argc, char *argv[]) {
 
   cerr << "Read in grid with size " << data.gridDims() << endl;
 
+  if (sigma > 0.0)
+    gridGaussianSmooth(data, sigma, nthreads);
+
   DensityGrid<int> blobs(data.minCoord(), data.maxCoord(), data.gridDims());
   boost::tuple<int, int, int, double> stats = findBlobs(data, blobs, lower, upper);
   cerr << boost::format("Found %d blobs in range %6.4g to %6.4g\n") % boost::get<0>(stats) % lower % upper;
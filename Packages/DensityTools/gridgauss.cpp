@@ -39,15 +39,17 @@ using namespace loos::DensityTools;
 
 int main(int argc, char *argv[]) {
 
-  if (argc != 5) {
+  if (argc != 5 && argc != 6) {
     cerr << 
       "DESCRIPTION\n\tApply a gaussian kernel convolution with a grid\n"
-      "\nUSAGE\n\tgridgauss width size scaling sigma <grid >output\n"
+      "\nUSAGE\n\tgridgauss width size scaling sigma [threads] <grid >output\n"
       "Width controls the size (in grid units) of the kernel.  Size\n"
       "determines how the gaussian is mapped onto the kernel, i.e.\n"
       "-size <= x < size.  The gaussian is f(x) = exp(-0.5*(x/sigma)^2)\n"
       "and is normalized so the sum of f(x) is one, then multiplied by\n"
-      "the scaling factor.\n"
+      "the scaling factor.  The kernel is applied separably along each\n"
+      "axis, split across the given number of threads (default is to use\n"
+      "all available cores).\n"
       "\nEXAMPLES\n\tgridgauss 10 3 1 1 <foo.grid >foo_smoothed.grid\n"
       "This convolves the grid with a 10x10 kernel with sigma=1, and is a good\n"
       "starting point for smoothing out water density grid.\n";
@@ -61,6 +63,7 @@ int main(int argc, char *argv[]) {
   double scaling = strtod(argv[k++], 0);
   double normalization = strtod(argv[k++], 0);
   double sigma = strtod(argv[k++], 0);
+  uint nthreads = (argc == 6) ? strtoul(argv[k++], 0, 10) : 0;
 
 
   vector<double> kernel;
@@ -85,7 +88,7 @@ int main(int argc, char *argv[]) {
 
   DensityGrid<double> grid;
   cin >> grid;
-  gridConvolve(grid, kernel);
+  gridConvolve(grid, kernel, nthreads);
 
   grid.addMetadata(hdr);
   cout << grid;
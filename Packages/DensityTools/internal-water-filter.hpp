@@ -60,6 +60,15 @@ namespace loos {
       //! Just states the name of the filter/picker
       virtual std::string name(void) const =0;
 
+      //! Returns an independent copy of the filter (caller owns it)
+      /**
+       * filter() caches per-call state (e.g. the bounding box), so
+       * concurrent workers each need their own copy.  Filters that
+       * cannot be copied return 0, in which case callers fall back to
+       * using the filter from a single thread.
+       */
+      virtual WaterFilterBase* clone(void) const { return(0); }
+
     protected:
       std::vector<loos::GCoord> bdd_;
     };
@@ -77,6 +86,7 @@ namespace loos {
     public:
       WaterFilterBox(const double pad) : pad_(pad) { }
       virtual ~WaterFilterBox() { }
+      virtual WaterFilterBox* clone(void) const { return(new WaterFilterBox(*this)); }
 
       virtual std::vector<int> filter(const loos::AtomicGroup&, const loos::AtomicGroup&);
       virtual std::vector<loos::GCoord> boundingBox(const loos::AtomicGroup&);
@@ -101,6 +111,7 @@ namespace loos {
     public:
       WaterFilterRadius(const double radius) : radius_(radius) { }
       virtual ~WaterFilterRadius() { }
+      virtual WaterFilterRadius* clone(void) const { return(new WaterFilterRadius(*this)); }
 
       virtual std::vector<int> filter(const loos::AtomicGroup&, const loos::AtomicGroup&);
       virtual std::vector<loos::GCoord> boundingBox(const loos::AtomicGroup&);
@@ -123,6 +134,7 @@ namespace loos {
     public:
       WaterFilterContacts(const double radius, const uint mincontacts) : radius_(radius), threshold_(mincontacts) { }
       virtual ~WaterFilterContacts() { }
+      virtual WaterFilterContacts* clone(void) const { return(new WaterFilterContacts(*this)); }
 
       virtual std::vector<int> filter(const loos::AtomicGroup&, const loos::AtomicGroup&);
       virtual std::vector<loos::GCoord> boundingBox(const loos::AtomicGroup&);
@@ -151,6 +163,7 @@ namespace loos {
     public:
       WaterFilterAxis(const double radius) : radius_(radius*radius) { }
       virtual ~WaterFilterAxis() { }
+      virtual WaterFilterAxis* clone(void) const { return(new WaterFilterAxis(*this)); }
 
       virtual std::string name(void) const;
       virtual double volume(void);
@@ -179,6 +192,7 @@ namespace loos {
     public:
       WaterFilterCore(const double radius) : radius_(radius*radius) { }
       virtual ~WaterFilterCore() { }
+      virtual WaterFilterCore* clone(void) const { return(new WaterFilterCore(*this)); }
 
       virtual std::string name(void) const;
       virtual double volume(void);
@@ -210,6 +224,7 @@ namespace loos {
     public:
       WaterFilterBlob(const DensityGrid<int>& blob) : blob_(blob), bdd_set(false), vol(-1.0) { }
       virtual ~WaterFilterBlob() { }
+      virtual WaterFilterBlob* clone(void) const { return(new WaterFilterBlob(*this)); }
 
       virtual std::string name(void) const;
       virtual double volume(void);
@@ -229,8 +244,9 @@ namespace loos {
     //! Decorator base class for "decorating" the core water filters...
     class WaterFilterDecorator : public WaterFilterBase {
     public:
-      WaterFilterDecorator(WaterFilterBase* p) : base(p) { }
-      virtual ~WaterFilterDecorator() { }
+      WaterFilterDecorator(WaterFilterBase* p) : base(p), owns_base(false) { }
+      WaterFilterDecorator(const WaterFilterDecorator& d) : WaterFilterBase(d), base(d.base->clone()), owns_base(true) { }
+      virtual ~WaterFilterDecorator() { if (owns_base) delete base; }
 
       virtual std::string name(void) const { return(base->name()); }
       virtual double volume(void) { return(base->volume()); }
@@ -243,8 +259,14 @@ namespace loos {
         return(base->boundingBox(prot));
       }
 
+      //! True if the decorated filter could be copied along with this one
+      bool cloneable(void) const { return(base != 0); }
+
     private:
+      WaterFilterDecorator& operator=(const WaterFilterDecorator&);
+
       WaterFilterBase *base;
+      bool owns_base;
     };
 
 
@@ -254,6 +276,14 @@ namespace loos {
       ZClippedWaterFilter(WaterFilterBase* p, const double zmin, const double zmax) : WaterFilterDecorator(p),
                                                                                       zmin_(zmin), zmax_(zmax) { }
       virtual ~ZClippedWaterFilter() { }
+      virtual ZClippedWaterFilter* clone(void) const {
+        ZClippedWaterFilter* p = new ZClippedWaterFilter(*this);
+        if (!p->cloneable()) {
+          delete p;
+          return(0);
+        }
+        return(p);
+      }
 
       std::string name(void) const;
       std::vector<int> filter(const loos::AtomicGroup&, const loos::AtomicGroup&);
@@ -286,6 +316,14 @@ namespace loos {
                                                                                                       pad_(pad),
                                                                                                       zmin_(zmin), zmax_(zmax) { }
       virtual ~BulkedWaterFilter() { }
+      virtual BulkedWaterFilter* clone(void) const {
+        BulkedWaterFilter* p = new BulkedWaterFilter(*this);
+        if (!p->cloneable()) {
+          delete p;
+          return(0);
+        }
+        return(p);
+      }
 
       std::string name(void) const;
       std::vector<int> filter(const loos::AtomicGroup&, const loos::AtomicGroup&);
@@ -39,9 +39,9 @@ using namespace loos::DensityTools;
 
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
+  if (argc != 2 && argc != 3) {
     cerr <<
-      "Usage- peakify threshold <foo.grid >peaks.pdb\n"
+      "Usage- peakify threshold [sigma] <foo.grid >peaks.pdb\n"
       "\n"
       "Given a double-precision floating point grid of density values\n"
       "and a threshold, this tool writes out a PDB representing the density\n"
@@ -49,11 +49,14 @@ int main(int argc, char *argv[]) {
       "unique blobs of density.  For each blob, the center of mass becomes a\n"
       "pseudo-atom in the output PDB (with atom name \"UNK\" and residue name \"GRD\").\n"
       "Note that these are really blob centers, as opposed to the point of maximum\n"
-      "density within a blob.\n";
+      "density within a blob.\n"
+      "If sigma is given, the grid is first smoothed with a gaussian of that\n"
+      "width (in Angstroms) before searching for peaks.\n";
     exit(-1);
   }
 
   double thresh = strtod(argv[1], 0);
+  double sigma = (argc == 3) ? strtod(argv[2], 0) : 0.0;
 
   string hdr = invocationHeader(argc, argv);
   DensityGrid<double> grid;
@@ -61,6 +64,9 @@ int main(int argc, char *argv[]) {
 
   cerr << "Read in grid " << grid.gridDims() << "\n";
 
+  if (sigma > 0.0)
+    gridGaussianSmooth(grid, sigma);
+
   DensityGrid<int> blobs(grid.minCoord(), grid.maxCoord(), grid.gridDims());
 
   PDB pdb;
@@ -152,21 +152,6 @@ public:
 };
 
 
-void zapGrid(DensityGrid<int>& grid, const vector<int>& vals) {
-  DensityGridpoint dims = grid.gridDims();
-
-  for (int k=0; k<dims[2]; k++)
-    for (int j=0; j<dims[1]; j++)
-      for (int i=0; i<dims[0]; i++) {
-	DensityGridpoint point(i,j,k);
-	int val = grid(point);
-	vector<int>::const_iterator ci = find(vals.begin(), vals.end(), val);
-	if (ci == vals.end())
-	  grid(point) = 0;
-      }
-}
-
-
 int maxBlobId(const DensityGrid<int>& grid) {
   DensityGridpoint dims = grid.gridDims();
   long k = dims[0] * dims[1] * dims[2];
@@ -180,6 +165,23 @@ int maxBlobId(const DensityGrid<int>& grid) {
 }
 
 
+// Zero out every voxel whose id is not in vals, using a lookup table
+// rather than searching vals at each voxel
+void zapGrid(DensityGrid<int>& grid, const vector<int>& vals) {
+  int maxid = maxBlobId(grid);
+  vector<bool> keep(maxid+1, false);
+  for (vector<int>::const_iterator ci = vals.begin(); ci != vals.end(); ++ci)
+    if (*ci >= 0 && *ci <= maxid)
+      keep[*ci] = true;
+
+  for (long i=0; i<grid.size(); i++) {
+    int val = grid(i);
+    if (val < 0 || !keep[val])
+      grid(i) = 0;
+  }
+}
+
+
 vector<Blob> pickBlob(const DensityGrid<int>& grid, const vector<GCoord>& points) {
   vector<DensityGridpoint> gridded;
   vector<GCoord>::const_iterator ci;
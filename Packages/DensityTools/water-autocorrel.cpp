@@ -52,7 +52,11 @@ int main(int argc, char *argv[]) {
 
   cerr << boost::format("Water matrix is %d x %d\n") % m % n;
   cerr << "Processing- ";
-  vector< TimeSeries<double> > waters;
+  // Waters are correlated in batches so the whole matrix never has to
+  // be held as doubles
+  const uint batch_size = 64;
+  vector< vector<double> > waters;
+  vector< vector<double> > series;
   for (uint j=0; j<m; ++j) {
     if (j % 250 == 0)
       cerr << '.';
@@ -64,9 +68,13 @@ int main(int argc, char *argv[]) {
       if (tmp[i])
 	flag = true;
     }
-    if (flag) {
-      TimeSeries<double> wtmp(tmp);
-      waters.push_back(wtmp.correl(max_t));
+    if (flag)
+      series.push_back(tmp);
+
+    if (series.size() == batch_size || (j == m-1 && !series.empty())) {
+      vector< vector<double> > corr = autoCorrelations(series, max_t);
+      waters.insert(waters.end(), corr.begin(), corr.end());
+      series.clear();
     }
   }
 
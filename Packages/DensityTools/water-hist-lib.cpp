@@ -27,10 +27,27 @@
 
 #include <water-hist-lib.hpp>
 
+#include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#include <exception>
+
 
 namespace loos {
   namespace DensityTools {
 
+    namespace {
+      void snapshotCoords(const AtomicGroup& grp, std::vector<GCoord>& coords) {
+        coords.resize(grp.size());
+        for (uint i=0; i<grp.size(); ++i)
+          coords[i] = grp[i]->coords();
+      }
+
+      void restoreCoords(AtomicGroup& grp, const std::vector<GCoord>& coords) {
+        for (uint i=0; i<grp.size(); ++i)
+          grp[i]->coords(coords[i]);
+      }
+    }
+
 
     void ZClipEstimator::reinitialize(pTraj& traj, const std::vector<uint>& frames) {
         std::vector<GCoord> bdd = getBounds(traj, water_, frames);
@@ -182,11 +199,12 @@ namespace loos {
         for (uint i = 0; i<picks.size(); ++i)
           if (picks[i]) {
             GCoord c = water_[i]->coords();
+            DensityGridpoint p = grid_.gridpoint(c);
 
-            if (!grid_.inRange(grid_.gridpoint(c)))
+            if (!grid_.inRange(p))
               ++out_of_bounds;
             else
-              grid_(c) += density;
+              grid_(p) += density;
           }
         (*estimator_)(density);
       }
@@ -194,6 +212,11 @@ namespace loos {
       void WaterHistogrammer::accumulate(pTraj& traj, const std::vector<uint>& frames) {
         estimator_->reinitialize(traj, frames);
         double density = 1.0 / frames.size();
+        if (nthreads_ > 1) {
+          accumulateThreaded(traj, frames, density);
+          return;
+        }
+
         for (std::vector<uint>::const_iterator i = frames.begin(); i != frames.end(); ++i) {
           traj->readFrame(*i);
           traj->updateGroupCoords(protein_);
@@ -203,5 +226,112 @@ namespace loos {
         }
       }
 
+
+      void WaterHistogrammer::accumulateThreaded(pTraj& traj, const std::vector<uint>& frames, const double density) {
+        // Each worker gets its own filter, and its own copies of the atoms
+        // so the coordinates of different frames can be in flight at once
+        std::vector< boost::shared_ptr<WaterFilterBase> > filters;
+        for (uint t=0; t<nthreads_; ++t) {
+          WaterFilterBase* f = the_filter->clone();
+          if (!f)
+            break;
+          filters.push_back(boost::shared_ptr<WaterFilterBase>(f));
+        }
+        if (filters.size() != nthreads_) {
+          for (std::vector<uint>::const_iterator i = frames.begin(); i != frames.end(); ++i) {
+            traj->readFrame(*i);
+            traj->updateGroupCoords(protein_);
+            traj->updateGroupCoords(water_);
+            accumulate(density);
+          }
+          return;
+        }
+
+        std::vector<AtomicGroup> proteins, waters;
+        for (uint t=0; t<nthreads_; ++t) {
+          proteins.push_back(protein_.copy());
+          waters.push_back(water_.copy());
+        }
+
+        GridAccumulator<double> accumulator(grid_, nthreads_);
+
+        // Frames are read into one of two batches of coordinate snapshots
+        // by this thread while the workers filter and bin the other one.
+        // The workers and this thread meet at a barrier each time a batch
+        // is handed over, and an empty batch tells the workers to stop.
+        const uint batch_size = nthreads_ * 4;
+        std::vector< std::vector<GCoord> > prot_coords[2], wat_coords[2];
+        uint batch_n[2] = {0, 0};
+        for (uint k=0; k<2; ++k) {
+          prot_coords[k].resize(batch_size);
+          wat_coords[k].resize(batch_size);
+        }
+
+        uint next = 0;
+        std::exception_ptr failure;
+        auto readBatch = [&](const uint k) {
+          batch_n[k] = 0;
+          if (failure)
+            return;
+          try {
+            uint n = std::min(batch_size, static_cast<uint>(frames.size() - next));
+            for (uint b=0; b<n; ++b) {
+              traj->readFrame(frames[next + b]);
+              traj->updateGroupCoords(protein_);
+              traj->updateGroupCoords(water_);
+              (*estimator_)(density);
+
+              snapshotCoords(protein_, prot_coords[k][b]);
+              snapshotCoords(water_, wat_coords[k][b]);
+            }
+            next += n;
+            batch_n[k] = n;
+          }
+          catch (...) {
+            failure = std::current_exception();
+          }
+        };
+
+        uint current = 0;
+        boost::barrier handoff(nthreads_ + 1);
+        boost::thread_group workers;
+        for (uint t=0; t<nthreads_; ++t)
+          workers.create_thread([&, t]() {
+              while (true) {
+                handoff.wait();
+                const uint k = current;
+                const uint n = batch_n[k];
+                if (n == 0)
+                  break;
+                for (uint b=t; b<n; b += nthreads_) {
+                  restoreCoords(proteins[t], prot_coords[k][b]);
+                  restoreCoords(waters[t], wat_coords[k][b]);
+                  std::vector<int> picks = filters[t]->filter(waters[t], proteins[t]);
+                  for (uint i=0; i<picks.size(); ++i)
+                    if (picks[i])
+                      accumulator.add(t, wat_coords[k][b][i], density);
+                }
+                handoff.wait();
+              }
+            });
+
+        readBatch(current);
+        while (true) {
+          handoff.wait();
+          if (batch_n[current] == 0)
+            break;
+          readBatch(1 - current);
+          handoff.wait();
+          current = 1 - current;
+        }
+        workers.join_all();
+
+        if (failure)
+          std::rethrow_exception(failure);
+
+        accumulator.merge(grid_);
+        out_of_bounds += accumulator.outOfBounds();
+      }
+
     };
 };
@@ -32,6 +32,7 @@
 #include <iostream>
 
 #include <DensityGrid.hpp>
+#include <TiledDensityGrid.hpp>
 #include <GridUtils.hpp>
 #include <water-lib.hpp>
 #include <internal-water-filter.hpp>
@@ -138,29 +139,52 @@ namespace loos {
 
 
 
+    //! Histograms the waters picked by a WaterFilter over a trajectory
+    /**
+     * The histogram is stored as a sparse TiledDensityGrid, so only the
+     * regions where waters are found take up memory.  With more than one
+     * thread, the main thread reads the next batch of frames (and updates
+     * the bulk estimator) while a fixed set of worker threads runs their
+     * own copies of the filter on the previous batch, binning into
+     * private grids that are merged at the end.  Filters that cannot be
+     * cloned are run serially.
+     */
     class WaterHistogrammer {
     public:
       WaterHistogrammer(const AtomicGroup& protein, const AtomicGroup& water, BulkEstimator* est, WaterFilterBase* filter) :
-        protein_(protein), water_(water), estimator_(est), the_filter(filter), out_of_bounds(0) { }
+        protein_(protein), water_(water), estimator_(est), the_filter(filter), out_of_bounds(0) { threads(0); }
 
       void clear() { grid_.clear(); out_of_bounds = 0; }
 
       void setGrid(const GCoord& min, const GCoord& max, const double resolution);
       void setGrid(pTraj& traj, const std::vector<uint>& frames, const double resolution, const double pad = 0.0);
 
+      //! Number of worker threads used by accumulate(traj, frames) (0 = all cores, the default)
+      void threads(const uint n) { nthreads_ = (n == 0 ? std::max(1u, boost::thread::hardware_concurrency()) : n); }
+      uint threads() const { return(nthreads_); }
+
       void accumulate(const double density);
       void accumulate(pTraj& traj, const std::vector<uint>& frames);
-      DensityGrid<double> grid() const { return(grid_); }
+
+      //! The histogram expanded into a dense grid
+      DensityGrid<double> grid() const { return(grid_.dense()); }
+      //! The histogram as stored (sparse)
+      const TiledDensityGrid<double>& tiledGrid() const { return(grid_); }
+      //! The histogram as stored, for rescaling or annotating in place
+      TiledDensityGrid<double>& tiledGrid() { return(grid_); }
       long outOfBounds() const { return(out_of_bounds); }
 
 
 
     private:
+      void accumulateThreaded(pTraj& traj, const std::vector<uint>& frames, const double density);
+
       AtomicGroup protein_, water_;
       BulkEstimator* estimator_;
       WaterFilterBase* the_filter;
       long out_of_bounds;
-      DensityGrid<double> grid_;
+      uint nthreads_;
+      TiledDensityGrid<double> grid_;
     };
 
 
@@ -28,9 +28,11 @@
 
 #include <boost/format.hpp>
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <loos.hpp>
 #include <DensityGrid.hpp>
+#include <TiledDensityGrid.hpp>
 #include <water-hist-lib.hpp>
 #include <DensityTools.hpp>
 #include <DensityOptions.hpp>
@@ -76,6 +78,12 @@ string fullHelpMessage(void) {
     "the density by using the --scale=1 option, otherwise the estimated bulk\n"
     "solvent density will be printed only.\n"
     "\n"
+    "The histogram is only stored for regions of the grid where waters are\n"
+    "found.  With --threads, frames are filtered and binned by several\n"
+    "worker threads, each into its own private grid, and these are merged\n"
+    "at the end.  For very large, fine grids, --sparse=1 avoids ever expanding\n"
+    "the grid in memory; it is written out a row at a time instead.\n"
+    "\n"
     "For visualization purposes, it you are using a membrane-protein system\n"
     "and the axis mode for filtering out waters, you may end up with a plug\n"
     "of bulk water at the protein/solvent interface.  To make it more clear\n"
@@ -151,7 +159,9 @@ public:
     count_empty_voxels(false),
     rescale_density(false),
     bulk_zclip(0.0),
-    bulk_zmin(0.0), bulk_zmax(0.0)
+    bulk_zmin(0.0), bulk_zmax(0.0),
+    nthreads(1),
+    sparse(false)
   { }
 
   void addGeneric(po::options_description& opts) {
@@ -161,7 +171,9 @@ public:
       ("bulk", po::value<double>(&bulk_zclip)->default_value(bulk_zclip), "Bulk water is defined as |Z| >= k")
       ("brange", po::value<string>(), "Bulk water (--brange a,b) is defined as a <= z < b")
       ("scale", po::value<bool>(&rescale_density)->default_value(rescale_density), "Scale density by bulk estimate")
-      ("clamp", po::value<string>(), "Clamp the bounding box [(x,y,z),(x,y,z)]");
+      ("clamp", po::value<string>(), "Clamp the bounding box [(x,y,z),(x,y,z)]")
+      ("threads", po::value<uint>(&nthreads)->default_value(nthreads), "Number of threads to use (0=all available)")
+      ("sparse", po::value<bool>(&sparse)->default_value(sparse), "Never expand the grid in memory (for large, mostly empty grids)");
   }
 
 
@@ -208,18 +220,24 @@ public:
       }
       
     }
+
+    if (nthreads == 0)
+      nthreads = boost::thread::hardware_concurrency();
+
     return(true);
   }    
 
   string print() const {
     ostringstream oss;
-    oss << boost::format("gridres=%f, empty=%d, bulk_zclip=%d, scale=%d, bulk_zmin=%d, bulk_zmax=%d")
+    oss << boost::format("gridres=%f, empty=%d, bulk_zclip=%d, scale=%d, bulk_zmin=%d, bulk_zmax=%d, threads=%d, sparse=%d")
       % grid_resolution
       % count_empty_voxels
       % bulk_zclip
       % rescale_density
       % bulk_zmin
-      % bulk_zmax;
+      % bulk_zmax
+      % nthreads
+      % sparse;
 
     if (!clamped_box.empty())
       oss << boost::format(", clamp=[%s,%s]")
@@ -235,6 +253,8 @@ public:
   bool rescale_density;
   double bulk_zclip;
   double bulk_zmin, bulk_zmax;
+  uint nthreads;
+  bool sparse;
   vector<GCoord> clamped_box;
 };
 
@@ -246,6 +266,32 @@ public:
 
 
 
+// Scales (if requested) and writes either a dense or a sparse grid
+template<class Grid>
+void writeGrid(Grid& grid, BulkEstimator* est, const WaterHistogramOptions* xopts,
+               const string& hdr, opts::AggregateOptions& options) {
+  cerr << boost::format("Grid = %s x %s @ %s\n") % grid.minCoord() % grid.maxCoord() % grid.gridDims();
+
+  if (xopts->rescale_density) {
+    double d = est->bulkDensity();
+    double s = est->stdDev(d);
+    cerr << boost::format("Bulk density estimate = %f, std = %f\n") % d % s;
+    if (xopts->rescale_density) {
+      cerr << "Rescaling grid by bulk estimate...\n";
+      grid.scale(1.0 / d);
+      stringstream ss;
+      ss << boost::format("water-hist: bulk density estimate = %f, std = %f") % d % s;
+      grid.addMetadata(ss.str());
+    }
+  }
+
+  grid.addMetadata(hdr);
+  grid.addMetadata(vectorAsStringWithCommas(options.print()));
+  cout << grid;
+}
+
+
+
 int main(int argc, char *argv[]) {
   string hdr = invocationHeader(argc, argv);
 
@@ -303,32 +349,21 @@ int main(int argc, char *argv[]) {
   } else
     wh.setGrid(traj, indices, xopts->grid_resolution, watopts->pad);
 
+  wh.threads(xopts->nthreads);
   wh.accumulate(traj, indices);
 
   long ob = wh.outOfBounds();
   if (ob)
     cerr << "***WARNING***  There were " << ob << " out of bounds waters\n";
   
-  DensityGrid<double> grid = wh.grid();
-  cerr << boost::format("Grid = %s x %s @ %s\n") % grid.minCoord() % grid.maxCoord() % grid.gridDims();
-
-  if (xopts->rescale_density) {
-    double d = est->bulkDensity();
-    double s = est->stdDev(d);
-    cerr << boost::format("Bulk density estimate = %f, std = %f\n") % d % s;
-    if (xopts->rescale_density) {
-      cerr << "Rescaling grid by bulk estimate...\n";
-      grid.scale(1.0 / d);
-      stringstream ss;
-      ss << boost::format("water-hist: bulk density estimate = %f, std = %f") % d % s;
-      grid.addMetadata(ss.str());
-    }
+  if (xopts->sparse) {
+    TiledDensityGrid<double>& grid = wh.tiledGrid();
+    if (basopts->verbosity >= 1)
+      cerr << boost::format("Sparse grid uses %d of %d tiles\n") % grid.allocatedTiles()
+        % ((grid.size() + TiledDensityGrid<double>::TILE_VOXELS - 1) / TiledDensityGrid<double>::TILE_VOXELS);
+    writeGrid(grid, est, xopts, hdr, options);
+  } else {
+    DensityGrid<double> grid = wh.grid();
+    writeGrid(grid, est, xopts, hdr, options);
   }
-
-  grid.addMetadata(hdr);
-  grid.addMetadata(vectorAsStringWithCommas(options.print()));
-  cout << grid;
 }
-
-
-
@@ -23,11 +23,24 @@ int main(int argc, char *argv[]) {
   if (k != argc)
     max_t = strtoul(argv[k++], 0, 10);
   
-  Math::Matrix<int> M;
-  cerr << "Reading matrix...\n";
-  readAsciiMatrix(matname, M);
-  uint m = M.rows();
-  uint n = M.cols();
+  // Only whether a water is inside matters, so the matrix is packed
+  // into one bit per water per frame
+  ContactHistory inside_history;
+  {
+    Math::Matrix<int> M;
+    cerr << "Reading matrix...\n";
+    readAsciiMatrix(matname, M);
+
+    inside_history = ContactHistory(M.rows(), M.cols());
+    for (uint t=0; t<M.cols(); ++t) {
+      inside_history.newFrame();
+      for (uint j=0; j<M.rows(); ++j)
+        if (M(j, t))
+          inside_history.mark(j);
+    }
+  }
+  uint m = inside_history.entities();
+  uint n = inside_history.frames();
 
   if (max_t == 0)
     max_t = n/10;
@@ -46,16 +59,8 @@ int main(int argc, char *argv[]) {
       cerr << '.';
     
     for (uint j=0; j<m; ++j) {
-      uint inside = 0;
-      uint pairs = 0;
-      
-      for (uint t=0; t<n-tau-1; ++t)
-	if (M(j, t))
-	{
-	  ++pairs;
-	  if (M(j, t+tau))
-	    ++inside;
-	}
+      ulong pairs = inside_history.occupied(j, 0, n-tau-1);
+      ulong inside = inside_history.survived(j, tau, n-tau-1);
       if (pairs)
 	survivals.push_back(static_cast<double>(inside) / (pairs));
     }
@@ -139,20 +139,13 @@ for frame in traj:
     else:
         box = default_box
 
-    # compute residue-residue contacts and store
-    index = 0
-    for i in range(num_residues - 1):
-        r1 = residues[i]
-        for j in range(i+1, num_residues):
-            contact = r1.logisticContact(residues[j],
-                                         args.radius,
-                                         args.sigma,
-                                         box)
-            # High contact -> low distance
-            # However, since we're taking distances between structures, you
-            # get pretty much the same answer either way.
-            contacts[frame_number, index] = 1. - contact
-            index += 1
+    # compute residue-residue contacts and store.  logisticContacts()
+    # returns the pairs in the same i < j order used here.
+    # High contact -> low distance
+    # However, since we're taking distances between structures, you
+    # get pretty much the same answer either way.
+    contact = loos.logisticContacts(residues, args.radius, args.sigma, box)
+    contacts[frame_number, :] = 1. - numpy.array(contact)
     frame_number += 1
 
 
@@ -172,10 +172,7 @@ scores = numpy.zeros([len(residues), len(probes), len(vtraj)], float)
 frame_index = 0
 for frame in vtraj:
     box = frame.periodicBox()
-    for r in range(len(residues)):
-        for p in range(len(probes)):
-            s = residues[r].packingScore(probes[p], box, False)
-            scores[r, p, frame_index] += s
+    scores[:, :, frame_index] = loos.packingScores(residues, probes, box, False)
     frame_index += 1
 
 print("finished calculating packing scores")
@@ -64,6 +64,12 @@ def fullhelp():
         --skip: skip this number of frames from the front of the trajectory,
                 default=0
         --stride: step through the trajectory by this number, default=1
+        --histogram: bin the pair distances into a histogram before the
+                sum over pairs is evaluated, rather than using every pair
+                distance as is. Much faster for large selections, at the
+                cost of a small error set by --bin_width.
+        --bin_width: width of the pair distance histogram bins (in
+                Angstroms) used with --histogram. Default=0.01
 
     Output: The resulting data file is field-delimited text. The first column
         is the q value. Second is I(q)/I(0), the normalized intensity. Third
@@ -75,7 +81,7 @@ def fullhelp():
     loop over all pairs of atoms (including self), times the number of q values,
     for each frame. Think carefully about what you want to include in the
     calculation, since this will probably be pretty slow for an explicit atom
-    system.
+    system. With --histogram, the cost of the q values becomes small.
 
     Also, this program treats each atom essentially independently, and makes
     no effort to account for solvent structure unless the water is explicitly
@@ -84,8 +90,8 @@ def fullhelp():
 
     For more information on the implementation on the atomic form factors, see
     FormFactor.cpp and FormFactor.hpp in the loos distribution. The actual
-    scattering calculation is done in the scattering() method to AtomicGroup,
-    implemented in AG_numerical.cpp
+    scattering calculation is done by the DebyeScattering class, implemented
+    in DebyeScattering.cpp
           """)
 
 class FullHelp(argparse.Action):
@@ -158,6 +164,10 @@ if __name__ == '__main__':
     parser.add_argument('--stride', help='Do every nth frame',
                         type=int,
                         default=1)
+    parser.add_argument('--histogram', action="store_true",
+                        help="Bin pair distances instead of using them exactly")
+    parser.add_argument('--bin_width', default=0.01, type=float,
+                        help="Width of pair distance histogram bins")
 
 
     args = parser.parse_args()
@@ -177,13 +187,16 @@ if __name__ == '__main__':
         deduceAtomicNumber(subset)
 
     formFactors = loos.FormFactorSet()
+    mode = loos.DebyeScattering.HISTOGRAM if args.histogram \
+        else loos.DebyeScattering.EXACT
+    debye = loos.DebyeScattering(subset, q_min, q_max, num_qvals, formFactors,
+                                 mode, args.bin_width)
 
     total = np.zeros([num_qvals])
     q_vals = np.arange(q_min, q_max, (q_max - q_min)/num_qvals)
     rgyr = 0.0
     for frame in traj:
-        total += np.asarray(subset.scattering(q_min, q_max, num_qvals,
-                                              formFactors))
+        total += np.asarray(debye.compute(subset))
         rgyr += subset.radiusOfGyration()
 
     total /= total[0]  # output I/I(0)
@@ -37,6 +37,30 @@ namespace opts = loos::OptionsFramework;
 namespace po = loos::OptionsFramework::po;
 
 
+// @cond TOOLS_INTERNAL
+class ToolOptions : public opts::OptionsPackage
+{
+public:
+  ToolOptions() : nthreads(1) { }
+
+  void addGeneric(po::options_description& o)
+  {
+    o.add_options()
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)");
+  }
+
+  string print() const
+  {
+    ostringstream oss;
+    oss << boost::format("threads=%d") % nthreads;
+    return(oss.str());
+  }
+
+  uint nthreads;
+};
+// @endcond
+
+
 
 void Usage()
     {
@@ -79,7 +103,10 @@ string fullHelpMessage(void)
     "As with the other rdf tools (rdf, xy_rdf), histogram-min, histogram-max,\n"
     "and histogram-bins control the range over which the rdf is computed, and\n"
     "the number of bins used, in this case from 0 to 20 Angstroms, with 0.5\n"
-    "angstrom bins.\n";
+    "angstrom bins.\n"
+    "\n"
+    "The --threads option sets how many threads bin the distances each frame\n"
+    "(0 uses all available cores).\n";
     return(s);
     }
 
@@ -90,6 +117,7 @@ int main (int argc, char *argv[])
 opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
 opts::TrajectoryWithFrameIndices* tropts = new opts::TrajectoryWithFrameIndices;
 opts::RequiredArguments* ropts = new opts::RequiredArguments;
+ToolOptions* topts = new ToolOptions;
 
 // These are required command-line arguments (non-optional options)
 ropts->addArgument("selection1", "selection1");
@@ -99,7 +127,7 @@ ropts->addArgument("max", "max radius");
 ropts->addArgument("num_bins", "number of bins");
 
 opts::AggregateOptions options;
-options.add(bopts).add(tropts).add(ropts);
+options.add(bopts).add(tropts).add(topts).add(ropts);
 if (!options.parse(argc, argv))
   exit(-1);
 
@@ -144,19 +172,21 @@ if (group2.empty())
     exit(-1);
     }
 
-// Create the histogram and zero it out
-vector<double> hist;
-hist.reserve(num_bins);
-hist.insert(hist.begin(), num_bins, 0.0);
+// Create the histogram.  Only pairs closer than hist_max are binned, so
+// the histogram uses a cell list rather than looking at every pair.
+PairHistogram hist(hist_min, hist_max, num_bins, false, topts->nthreads);
 
-double min2 = hist_min*hist_min;
-double max2 = hist_max*hist_max;
+// Label the atoms so that an atom in both selections is not paired
+// with itself
+vector<uint> labels1, labels2;
+PairHistogram::labelAtoms(group1, group2, labels1, labels2);
 
 // loop over the frames of the trajectory
 vector<uint> framelist = tropts->frameList();
 uint framecnt = framelist.size();
 double volume = 0.0;
 unsigned long unique_pairs=0;
+vector<GCoord> crds1(group1.size()), crds2(group2.size());
 for (uint index = 0; index<framecnt; ++index)
     {
     traj->readFrame(framelist[index]);
@@ -166,32 +196,13 @@ for (uint index = 0; index<framecnt; ++index)
     GCoord box = system.periodicBox(); 
     volume += box.x() * box.y() * box.z();
 
-    unique_pairs = 0;
     // compute the distribution of g2 around g1 
     for (uint j = 0; j < group1.size(); j++)
-        {
-        pAtom a1 = group1[j];
-        GCoord p1 = a1->coords();
-        for (uint k = 0; k < group2.size(); k++)
-            {
-            pAtom a2 = group2[k];
-            // skip "self" pairs 
-            if (a1 == a2)
-                {
-                continue;
-                }
-            unique_pairs++;
-            GCoord p2 = a2->coords();
-            // Compute the distance squared, taking periodicity into account
-            double d2 = p1.distance2(p2, box);
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist[bin]++;
-                }
-            }
-        }
+        crds1[j] = group1[j]->coords();
+    for (uint k = 0; k < group2.size(); k++)
+        crds2[k] = group2[k]->coords();
+
+    unique_pairs = hist.accumulate(crds1, labels1, crds2, labels2, box);
     }
 
 volume /= framecnt;
@@ -199,6 +210,7 @@ volume /= framecnt;
 
 
 double expected = framecnt * unique_pairs / volume;
+const vector<double>& counts = hist.histogram();
 double cum1 = 0.0;
 double cum2 = 0.0;
 
@@ -213,9 +225,9 @@ for (int i = 0; i < num_bins; i++)
     double norm = 4.0/3.0 * M_PI*(d_outer*d_outer*d_outer 
                                 - d_inner*d_inner*d_inner);
 
-    double total = hist[i]/ (norm*expected);
-    cum1 += hist[i] / (framecnt*group1.size());
-    cum2 += hist[i] / (framecnt*group2.size());
+    double total = counts[i]/ (norm*expected);
+    cum1 += counts[i] / (framecnt*group1.size());
+    cum2 += counts[i] / (framecnt*group2.size());
 
     cout << d << "\t" << total << "\t" 
          << cum1 << "\t" << cum2 << endl;
@@ -161,21 +161,12 @@ RealMatrix extractCoordinates(pTraj& traj, AtomicGroup& grp, const vector<uint>&
   RealMatrix A(m, n);
   vector<double> avg(m, 0.0);
 
-  for (uint i=0; i<n; ++i) {
-    traj->readFrame(indices[i]);
-    traj->updateGroupCoords(grp);
-    for (uint j=0; j<static_cast<uint>(grp.size()); ++j) {
-      GCoord c = grp[j]->coords();
-      A(3*j, i) = c.x();
-      avg[3*j] += c.x();
-
-      A(3*j+1, i) = c.y();
-      avg[3*j+1] += c.y();
-
-      A(3*j+2, i) = c.z();
-      avg[3*j+2] += c.z();
-    }
-  }
+  readFramesInBatches(traj, grp, indices, [&](const uint i, const double* crds, const GCoord* box) {
+      for (uint j=0; j<m; ++j) {
+        A(j, i) = crds[j];
+        avg[j] += crds[j];
+      }
+    });
 
   for (uint j=0; j<m; ++j)
     avg[j] /= n;
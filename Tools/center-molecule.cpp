@@ -198,14 +198,8 @@ int main(int argc, char *argv[]) {
     (*atom)->coords() += offset;
 
   if (topts->reimage && model.isPeriodic()) {
-    vGroup molecules = model.splitByMolecule();
-    vGroup segments = model.splitByUniqueSegid();
-      
-    for (vGroup::iterator seg = segments.begin(); seg != segments.end(); ++seg)
-      seg->reimage();
-
-    for (vGroup::iterator mol =molecules.begin(); mol != molecules.end(); ++mol)
-      mol->reimage();
+    Reimager(model, model.segidPartition()).reimage();
+    Reimager(model, model.moleculePartition()).reimage();
   }
 
   AtomicGroup write_mol = selectAtoms(model, topts->write_sel);
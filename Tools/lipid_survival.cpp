@@ -122,6 +122,7 @@ public:
       ("maxdt,m", po::value<uint>(&maxdt)->default_value(1000), "Maximum dt to compute")
       ("reimage,r", po::value<bool>(&reimage)->default_value(false), "Perform contact calculations considering periodicity")
       ("threshold", po::value<uint>(&threshold)->default_value(1), "Number of pairs required to establish contact")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)")
       ;
         }
 
@@ -130,6 +131,7 @@ public:
     double cutoff;
     uint maxdt;
     uint threshold;
+    uint nthreads;
     bool reimage;
 };
 
@@ -158,23 +160,16 @@ int main(int argc, char *argv[]) {
   vGroup lipids = lipid.splitByMolecule();
 
 
-  vector < vector <double> > contacts;
-  // initialize vector of timeseries to store 
-  for (unsigned int i = 0; i < lipids.size(); i++)
-      {
+  // one packed contact bit per lipid per frame
+  ContactHistory contacts(lipids.size(), traj->nframes());
 
-        vector <double> tmp (traj->nframes(), 0.0);
-        contacts.push_back(tmp);
-
-      }
-
-int frame_count = 0;
 while (traj->readFrame()) 
     {
     traj->updateGroupCoords(model);
     GCoord box = model.periodicBox();
+    contacts.newFrame();
     
-    for (uint j=0; j < contacts.size(); j++)
+    for (uint j=0; j < lipids.size(); j++)
         {
         bool contact = false;
         if (topts->reimage) 
@@ -188,51 +183,20 @@ while (traj->readFrame())
     
         if (contact)
             {
-            contacts[j][frame_count] = 1.0;
+            contacts.mark(j);
             }
         }
-      frame_count++;
       }
 
 /* Probability Calculations
  */
 
-// loop over dt
-//
+vector <double> survival = contacts.survivalProbability(topts->maxdt, topts->nthreads);
+
 cout << "0\t1.00" << endl;
 for (unsigned int t = 1; t < topts->maxdt; t++)
     {
-
-    double bound_tmp = 0.0;
-    double total_tmp = 0.0;
-    // loop over lipids
-    for (unsigned int i = 0; i < contacts.size(); i++)
-        {
-
-        // loop through values for that lipid's contacts
-        for (unsigned int j = 0; j < (contacts[i].size() - t); j++)
-            {
-            
-            // if current value is 1
-            if (contacts[i][j] == 1)
-                {
-                    if ((contacts[i][j+t]) == 1)
-                        {
-
-                        bound_tmp++;
-
-                        }
-
-                        total_tmp++;
-                }
-
-            }
-
-        }
-
-    double prob_tmp = bound_tmp/total_tmp;
-
-    cout << t << "\t" << prob_tmp << endl;
+    cout << t << "\t" << survival[t] << endl;
     }
 } 
 
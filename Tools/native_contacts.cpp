@@ -48,6 +48,7 @@ class ToolOptions : public opts::OptionsPackage
         bool use_reference;
         bool do_per_residue;
         bool exclude_consecutive;
+        uint nthreads;
 
         void addGeneric(po::options_description& o)
             {
@@ -58,6 +59,7 @@ class ToolOptions : public opts::OptionsPackage
      ("reference", po::value<string>(&reference), "Coordinate file to use as reference structure")
      ("per-residue", po::value<string>(&per_residue_filename), "Output per-residue native contact frequency to this file")
      ("exclude-consecutive", "Exclude consecutive residues")
+     ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)")
             ;
             }
 
@@ -219,7 +221,6 @@ AtomicGroup system = tropts->model;
 pTraj traj = tropts->trajectory;
 
 double cutoff = parseStringAs<double>(ropts->value("cut"));
-double cut2 = cutoff*cutoff;
 
 
 AtomicGroup sel = selectAtoms(system,  sopts->selection);
@@ -287,57 +288,35 @@ if (topts->use_periodicity && !system.isPeriodic())
     cerr << "but _will_ be used for the trajectory frames." << endl;
     }
 
-// Compute the centers of mass of the selections
 uint num_residues = residues.size();
-vector<GCoord> centers_of_mass(num_residues);
-for (uint i=0; i<num_residues; i++)
-    {
-    centers_of_mass[i] = residues[i].centerOfMass();
-    }
-
-vector<vector<uint> > contacts;
 vector<uint>total_contacts_per_residue(num_residues);
 vector<uint>contacts_per_residue(num_residues);
 
-GCoord box = system.periodicBox();
-
 int step = 1;
 if (topts->exclude_consecutive)
     {
     step = 2;
     }
 // Find contacts within the threshold distance
-for (uint i=0; i<num_residues-step; i++)
+NativeContacts contacts(residues, cutoff, step, use_periodicity_for_reference);
+for (uint k=0; k<contacts.size(); k++)
     {
-    for (uint j=i+step; j< num_residues; j++)
+    uint i = contacts.pair(k).first;
+    uint j = contacts.pair(k).second;
+    cout << "# " << (residues[i][0])->resid() << "\t"
+                 << (residues[j][0])->resid() << endl;
+    if (topts->do_output)
         {
-        GCoord diff = centers_of_mass[j] - centers_of_mass[i];
-        if (use_periodicity_for_reference)
-            {
-            diff.reimage(box);
-            }
-        if (diff.length2() <= cut2)
-            {
-            vector<uint> v(2);
-            v[0] = i;
-            v[1] = j;
-            contacts.push_back(v);
-            cout << "# " << (residues[i][0])->resid() << "\t"
-                         << (residues[j][0])->resid() << endl;
-            if (topts->do_output)
-                {
-                output << "# " << (residues[i][0])->resid() << "\t"
-                               << (residues[j][0])->resid() << endl;
+        output << "# " << (residues[i][0])->resid() << "\t"
+                       << (residues[j][0])->resid() << endl;
 
-                }
+        }
 
-            // Store the total number of contacts for each residue
-            if (topts->do_per_residue)
-                {
-                total_contacts_per_residue[i] += 1;
-                total_contacts_per_residue[j] += 1;
-                }
-            }
+    // Store the total number of contacts for each residue
+    if (topts->do_per_residue)
+        {
+        total_contacts_per_residue[i] += 1;
+        total_contacts_per_residue[j] += 1;
         }
     }
 
@@ -346,7 +325,7 @@ for (uint i=0; i<num_residues-step; i++)
 float num_native_contacts = (float) contacts.size();
 cout << "# Total native contacts: " << num_native_contacts << endl;
 
-bool is_periodic;
+bool is_periodic = false;
 if (topts->use_periodicity && traj->hasPeriodicBox())
     {
     is_periodic = true;
@@ -357,36 +336,36 @@ else if (topts->use_periodicity && !(traj->hasPeriodicBox()))
     cerr << "The calculation will proceed _ignoring_ periodicity." << endl;
     is_periodic = false;
     }
+contacts.periodic(is_periodic);
+
+// The rest of the trajectory, starting from the next frame the
+// iterator would read, is evaluated in blocks of frames
+vector<uint> frames;
+if (traj->readFrame())
+    {
+    for (uint i=traj->currentFrame(); i<traj->nframes(); i++)
+        {
+        frames.push_back(i);
+        }
+    }
 
 // Loop over structures in the trajectory
-vector<vector<uint> >::iterator p;
+double cut2 = cutoff*cutoff;
 int frame = 0;
-while (traj->readFrame())
+contacts.scan(traj, frames, [&](const uint j, const double* d2)
     {
-    traj->updateGroupCoords(system);
-    box = system.periodicBox();
-
     // Loop over contacts from the native structure
     int num_contacts = 0;
-    for (p=contacts.begin(); p!= contacts.end(); p++)
+    for (uint k=0; k<contacts.size(); k++)
         {
-        uint r1 = p->at(0);
-        uint r2 = p->at(1);
-        GCoord c1 = residues[r1].centerOfMass();
-        GCoord c2 = residues[r2].centerOfMass();
-        GCoord diff = c2 - c1;
-        if (is_periodic)
-            {
-            diff.reimage(box);
-            }
-        if (diff.length2() <= cut2)
+        if (d2[k] <= cut2)
             {
             num_contacts++;
             if (topts->do_output) output << "1\t";
             if (topts->do_per_residue)
                 {
-                contacts_per_residue[r1]++;
-                contacts_per_residue[r2]++;
+                contacts_per_residue[contacts.pair(k).first]++;
+                contacts_per_residue[contacts.pair(k).second]++;
                 }
             }
         else
@@ -398,7 +377,7 @@ while (traj->readFrame())
     cout << frame << "\t" << fraction << endl;
     if (topts->do_output) output << endl;
     frame++;
-    }
+    }, topts->nthreads);
 
 // Output total contacts per residue
 if (topts->do_per_residue)
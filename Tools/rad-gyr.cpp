@@ -174,23 +174,23 @@ inline void histogram_rgyr(vector<greal> &hist, const greal rgyr,
   }
 }
 inline void histogram_molecules_rgyr(vector<greal> &hist,
-                                     vector<AtomicGroup> &molecules,
+                                     vector<AtomicGroupView> &molecules,
                                      const greal min_dist, const greal max_dist,
                                      const greal bin_width, int &count,
                                      const int frame, ofstream &outfile) {
-  for (auto molecule : molecules) {
+  for (const auto &molecule : molecules) {
     histogram_rgyr(hist, molecule.radiusOfGyration(), min_dist, max_dist,
                    bin_width, count, outfile);
   }
 }
 // or in the case when not.
-inline void ts_hist_rgyr(vector<greal> &hist, vector<AtomicGroup> &molecules,
+inline void ts_hist_rgyr(vector<greal> &hist, vector<AtomicGroupView> &molecules,
                          const greal min_dist, const greal max_dist,
                          const greal bin_width, int &count, const int frame,
                          ofstream &outfile) {
   greal rgyr;
   outfile << frame;
-  for (auto molecule : molecules) {
+  for (const auto &molecule : molecules) {
     rgyr = molecule.radiusOfGyration();
     outfile << "\t" << rgyr;
     histogram_rgyr(hist, rgyr, min_dist, max_dist, bin_width, count, outfile);
@@ -215,19 +215,31 @@ int main(int argc, char *argv[]) {
   cout << "# " << header << "\n";
   ofstream tsf(topts->timeseries);
   // make a function pointer with a signature matching the
-  void (*frameOperator)(vector<greal> & hist, vector<AtomicGroup> & molecules,
+  void (*frameOperator)(vector<greal> & hist, vector<AtomicGroupView> & molecules,
                         const greal min_dist, const greal max_dist,
                         const greal bin_width, int &count, const int frame,
                         ofstream &outfile);
 
   // establish system, and molecular subsystems
-  vector<AtomicGroup> molecules;
+  vector<AtomicGroup> groups;
   if (topts->by_molecule)
-    molecules = mtopts->model.splitByMolecule(sopts->selection);
+    groups = mtopts->model.splitByMolecule(sopts->selection);
   else if(topts->by_fragment)
-    molecules = selectAtoms(mtopts->model, sopts->selection).splitByMolecule();
+    groups = selectAtoms(mtopts->model, sopts->selection).splitByMolecule();
   else
-    molecules.push_back(selectAtoms(mtopts->model, sopts->selection));
+    groups.push_back(selectAtoms(mtopts->model, sopts->selection));
+
+  // Lay the subsystems end to end in one group and use views of it, so
+  // no groups are copied while looping over frames
+  AtomicGroup subsystems;
+  vector<AtomicGroupView> molecules;
+  vector<uint> offsets(1, 0);
+  for (const auto &group : groups) {
+    subsystems.append(group);
+    offsets.push_back(subsystems.size());
+  }
+  for (uint i = 0; i < groups.size(); ++i)
+    molecules.push_back(AtomicGroupView(subsystems, offsets[i], offsets[i + 1] - offsets[i]));
 
   // pick which operation to perform per frame using function pointer
   if (topts->timeseries.empty())
@@ -237,9 +249,9 @@ int main(int argc, char *argv[]) {
         << "# frame";
     // Label each column with the starting and ending index for the 'molecule'
     // as a stand in for the case where molecule's chainids are inaccurate.
-    for (auto molecule : molecules) {
-      int first = molecule[0]->index();
-      int last = (*(molecule.end() - 1))->index();
+    for (const auto &molecule : molecules) {
+      int first = molecule.getAtom(0)->index();
+      int last = molecule.getAtom(molecule.size() - 1)->index();
       tsf << "\tatoms" << first << "-" << last;
     }
     tsf << "\n";
@@ -45,6 +45,7 @@ string split_by, split_by2;
 double hist_min, hist_max;
 int num_bins;
 int skip;
+uint nthreads;
 
 // @cond TOOLS_INTERNAL
 class ToolOptions : public opts::OptionsPackage
@@ -56,6 +57,7 @@ public:
     o.add_options()
       ("split-mode",po::value<string>(&split_by)->default_value("by-molecule"), "how to split the selections (by-residue, molecule, segment, none)")
       ("split-mode2",po::value<string>(&split_by2)->default_value("by-molecule"), "how to split the second selection (by-residue, molecule, segment, none)")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)")
       ;
   }
 
@@ -93,14 +95,15 @@ public:
   string print() const
   {
     ostringstream oss;
-    oss << boost::format("split-mode='%s', sel1='%s', sel2='%s', hist-min=%f, hist-max=%f, num-bins=%f, split-mode2='%'")
+    oss << boost::format("split-mode='%s', sel1='%s', sel2='%s', hist-min=%f, hist-max=%f, num-bins=%f, split-mode2='%s', threads=%d")
       % split_by
       % selection1
       % selection2
       % hist_min
       % hist_max
       % num_bins
-      % split_by2;
+      % split_by2
+      % nthreads;
     return(oss.str());
   }
 };
@@ -152,6 +155,9 @@ string s =
     "the tryptophan residues.  The program would use the center of mass of the\n"
     "carbon atoms to as the point from which to compute the RDF.\n"
     "\n"
+    "The --threads option sets how many threads bin the distances each frame\n"
+    "(0 uses all available cores).\n"
+    "\n"
     "See also atomic-rdf and xy_rdf.\n"
     ;
 
@@ -292,79 +298,49 @@ vector<uint> framelist = tropts->frameList();
 traj->readFrame(framelist[0]);
 traj->updateGroupCoords(system);
 
-// Create the histogram and zero it out
-vector<double> hist;
-hist.reserve(num_bins);
-hist.insert(hist.begin(), num_bins, 0.0);
-
-double min2 = hist_min*hist_min;
-double max2 = hist_max*hist_max;
-
-// Precompute the overlap between the two groups (this can be an
-// expensive operation, so it's better to have it outside the
-// while-loop)
-
-unsigned long unique_pairs = 0;
-Math::Matrix<int, Math::RowMajor> group_overlap(g1_mols.size(), g2_mols.size());
-
-for (uint j=0; j<g1_mols.size(); ++j)
-    {
-    for (uint i=0; i<g2_mols.size(); ++i)
-      {
-      bool b = (g1_mols[j] == g2_mols[i]);
-      group_overlap(j, i) = b;
-      if ( !b )
-        {
-          ++unique_pairs;
-        }
-      }
-    }
+// Create the histogram.  Only pairs closer than hist_max are binned, so
+// the histogram uses a cell list rather than looking at every pair.
+PairHistogram hist(hist_min, hist_max, num_bins, false, nthreads);
 
+// Label the groups so that a group appearing in both selections is
+// not paired with itself (this is done outside the while-loop, since
+// comparing groups can be expensive)
+vector<uint> labels1, labels2;
+PairHistogram::labelGroups(g1_mols, g2_mols, labels1, labels2);
 
 // loop over the frames of the trajectory
 uint framecount = framelist.size();
 double volume = 0.0;
+unsigned long unique_pairs = 0;
+vector<GCoord> centers1(g1_mols.size()), centers2(g2_mols.size());
 for (uint index = 0; index<framecount; ++index)
     {
     traj->readFrame(framelist[index]);
+
     // update coordinates and periodic box
     traj->updateGroupCoords(system);
+
     // if no frame weights file provided, defaults to 1.0 
     const double weight = wopts->pWeights->get();
     wopts->pWeights->accumulate();
 
-
     GCoord box = system.periodicBox();
     volume += weight*(box.x() * box.y() * box.z());
 
     // compute the distribution of g2 around g1
     for (unsigned int j = 0; j < g1_mols.size(); j++)
-        {
-        GCoord p1 = g1_mols[j].centerOfMass();
-        for (unsigned int k = 0; k < g2_mols.size(); k++)
-            {
-            // skip "self" pairs -- in case selection1 and selection2 overlap
-            if (group_overlap(j, k))
-                {
-                continue;
-                }
-            GCoord p2 = g2_mols[k].centerOfMass();
-
-            // Compute the distance squared, taking periodicity into account
-            double d2 = p1.distance2(p2, box);
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist[bin]+=weight;
-                }
-            }
-        }
+        centers1[j] = g1_mols[j].centerOfMass();
+    for (unsigned int k = 0; k < g2_mols.size(); k++)
+        centers2[k] = g2_mols[k].centerOfMass();
+
+    unique_pairs = hist.accumulate(centers1, labels1, centers2, labels2, box, weight);
     }
+
 // totalWeight() defaults to frameCount() if no weights file provided
 const double expected = wopts->pWeights->totalWeight() * wopts->pWeights->totalWeight() 
                         * unique_pairs / volume;
 
+const vector<double>& counts = hist.histogram();
 double cum1 = 0.0;
 double cum2 = 0.0;
 
@@ -379,9 +355,9 @@ for (int i = 0; i < num_bins; i++)
     double norm = 4.0/3.0 * M_PI*(d_outer*d_outer*d_outer
                                 - d_inner*d_inner*d_inner);
 
-    double total = hist[i]/ (norm*expected);
-    cum1 += hist[i] / (wopts->pWeights->totalWeight()*g1_mols.size());
-    cum2 += hist[i] / (wopts->pWeights->totalWeight()*g2_mols.size());
+    double total = counts[i]/ (norm*expected);
+    cum1 += counts[i] / (wopts->pWeights->totalWeight()*g1_mols.size());
+    cum2 += counts[i] / (wopts->pWeights->totalWeight()*g2_mols.size());
 
     cout << d << "\t" << total << "\t"
          << cum1 << "\t" << cum2 << endl;
@@ -73,6 +73,33 @@ string fullHelpMessage(void)
     return(s);
     }
 
+// Same arithmetic as AtomicGroup::translate() on a flat frame
+void translateFrame(double *frame, const uint natoms, const GCoord& v)
+    {
+    for (uint i=0; i<natoms; i++)
+        {
+        frame[3*i] += v[0];
+        frame[3*i+1] += v[1];
+        frame[3*i+2] += v[2];
+        }
+    }
+
+// Same arithmetic as AtomicGroup::centroid() on a flat frame
+GCoord frameCentroid(const double *frame, const vector<uint>& atoms)
+    {
+    GCoord c(0,0,0);
+    for (uint i=0; i<atoms.size(); i++)
+        {
+        const double *x = frame + 3 * atoms[i];
+        c += GCoord(x[0], x[1], x[2]);
+        }
+    if (atoms.size() > 1)
+        {
+        c /= atoms.size();
+        }
+    return(c);
+    }
+
 string helpMessage()
     {
     string s = string("Usage: recenter-trj model-file trajectory-file selection-string [Z|XY|A] dcd-name");
@@ -124,58 +151,104 @@ if (!model.hasBonds())
     exit(-1);
     }
 
-vector<AtomicGroup> molecules= model.splitByMolecule();
-vector<AtomicGroup>::iterator m;
+// Without a box in the trajectory, the model's box is used for every frame
+const bool model_box = !traj->hasPeriodicBox();
+if (model_box && !model.isPeriodic())
+    {
+    cerr << "Error: neither the trajectory nor the model has periodic box information." << endl;
+    exit(-1);
+    }
+
+if (center.empty())
+    {
+    cerr << "Error: the centering selection is empty." << endl;
+    exit(-1);
+    }
+
+Reimager by_molecule(model, model.moleculePartition());
 
-while (traj->readFrame())
+// Positions of the centering atoms within the model
+map<uint, uint> model_position;
+for (uint i=0; i<model.size(); i++)
+    {
+    model_position[model[i]->index()] = i;
+    }
+vector<uint> center_atoms;
+for (uint i=0; i<center.size(); i++)
     {
-    traj->updateGroupCoords(model); 
+    center_atoms.push_back(model_position[center[i]->index()]);
+    }
 
-    // Simple approach won't work if the centering selection is split
-    // across the periodic image.  In that case, the centroid may be near the 
-    // middle even if none of the atoms are near there.
+// Frames are read in blocks and recentered in place as flat arrays
+vector<uint> frames;
+for (uint i=0; i<traj->nframes(); i++)
+    {
+    frames.push_back(i);
+    }
 
-    // pick a single atom in the selection, and center based on it.
-    // This will make sure the selection is now _not_ split acrosst the 
-    // periodic image
-    GCoord centroid = center[0]->coords();
-    if (just_z)
-        {
-        centroid.x() = 0.0;
-        centroid.y() = 0.0;
-        }
-    else if (just_xy)
-        {
-        centroid.z() = 0.0;
-        }
+const uint frame_values = 3 * model.size();
+const uint batch = max<uint>(1, (16 << 20) / (max<uint>(1, frame_values) * sizeof(double)));
+vector<double> crds;
+vector<GCoord> boxes;
 
-    model.translate(-centroid);
-    for (m=molecules.begin(); m!=molecules.end(); m++)
-        {
-        m->reimage();
-        }
-    
-    // now, center as we did in the original algorithm:
-    // Move the whole system such that selected region is at the origin and
-    // reimage
-    centroid = center.centroid();
-    if (just_z)
-        {
-        centroid.x() = 0.0;
-        centroid.y() = 0.0;
-        }
-    else if (just_xy)
+for (uint first=0; first<frames.size(); first += batch)
+    {
+    vector<uint> block(frames.begin() + first, frames.begin() + min<size_t>(first + batch, frames.size()));
+    crds.resize(block.size() * frame_values);
+    boxes.resize(block.size());
+    traj->readFrames(block, model, crds.data(), boxes.data());
+    if (model_box)
         {
-        centroid.z() = 0.0;
+        fill(boxes.begin(), boxes.end(), model.periodicBox());
         }
 
-    model.translate(-centroid);
-    for (m=molecules.begin(); m!=molecules.end(); m++)
+    for (uint j=0; j<block.size(); j++)
         {
-        m->reimage();
+        double *frame = crds.data() + j * frame_values;
+
+        // Simple approach won't work if the centering selection is split
+        // across the periodic image.  In that case, the centroid may be near the 
+        // middle even if none of the atoms are near there.
+
+        // pick a single atom in the selection, and center based on it.
+        // This will make sure the selection is now _not_ split acrosst the 
+        // periodic image
+        double *ref = frame + 3 * center_atoms[0];
+        GCoord centroid(ref[0], ref[1], ref[2]);
+        if (just_z)
+            {
+            centroid.x() = 0.0;
+            centroid.y() = 0.0;
+            }
+        else if (just_xy)
+            {
+            centroid.z() = 0.0;
+            }
+
+        translateFrame(frame, model.size(), -centroid);
+        by_molecule.reimage(frame, boxes[j]);
+
+        // now, center as we did in the original algorithm:
+        // Move the whole system such that selected region is at the origin and
+        // reimage
+        centroid = frameCentroid(frame, center_atoms);
+        if (just_z)
+            {
+            centroid.x() = 0.0;
+            centroid.y() = 0.0;
+            }
+        else if (just_xy)
+            {
+            centroid.z() = 0.0;
+            }
+
+        translateFrame(frame, model.size(), -centroid);
+        by_molecule.reimage(frame, boxes[j]);
+
+        model.setCoords(frame, model.size(), 3);
+        model.periodicBox(boxes[j]);
+        traj_out->writeFrame(model);
         }
-    
-    traj_out->writeFrame(model);
     }
 
 }
@@ -157,42 +157,55 @@ int main(int argc, char *argv[])
   traj_out->setComments(hdr);
 
   // split the system by molecule
-  vector<AtomicGroup> molecules = model.splitByMolecule();
+  const GroupPartition& molecules = model.moleculePartition();
   cerr << "Found " << molecules.size() << " molecules.\n";
 
   // split the system by segid
-  vector<AtomicGroup> segments = model.splitByUniqueSegid();
+  const GroupPartition& segments = model.segidPartition();
   cerr << "Found " << segments.size() << " segments.\n";
 
   cerr << "Trajectory has " << traj->nframes() << " total frames.\n";
 
 
-  // Loop over the frames of the dcd and reimage each molecule
-  vector<AtomicGroup>::iterator m;
+  // Reimage blocks of frames at once, segments first and then molecules
+  Reimager by_segment(model, segments);
+  Reimager by_molecule(model, molecules);
+
+  vector<uint> frames;
+  for (uint i=0; i<traj->nframes(); ++i)
+    frames.push_back(i);
+
+  const uint frame_values = 3 * model.size();
+  const uint batch = max<uint>(1, (16 << 20) / (max<uint>(1, frame_values) * sizeof(double)));
+  vector<double> crds;
+  vector<GCoord> boxes;
+
   int frame_no = 0;
   cerr << "Frames processed - ";
-  while (traj->readFrame())
+  for (uint first=0; first<frames.size(); first += batch)
     {
-      if (++frame_no % update_frequency == 0)
-        {
-          cerr << frame_no << " ";
-        }
-
-      traj->updateGroupCoords(model);
+      vector<uint> block(frames.begin() + first, frames.begin() + min<size_t>(first + batch, frames.size()));
+      crds.resize(block.size() * frame_values);
+      boxes.resize(block.size());
+      traj->readFrames(block, model, crds.data(), boxes.data());
 
       if (box_override)
-        model.periodicBox(newbox);
+        fill(boxes.begin(), boxes.end(), newbox);
 
-      for (m = segments.begin(); m != segments.end(); m++)
-        {
-          m->reimage();
-        }
-      for (m = molecules.begin(); m != molecules.end(); m++)
+      by_segment.reimage(crds.data(), boxes.data(), block.size());
+      by_molecule.reimage(crds.data(), boxes.data(), block.size());
+
+      for (uint j=0; j<block.size(); ++j)
         {
-          m->reimage();
+          if (++frame_no % update_frequency == 0)
+            {
+              cerr << frame_no << " ";
+            }
+
+          model.setCoords(crds.data() + j * frame_values, model.size(), 3);
+          model.periodicBox(boxes[j]);
+          traj_out->writeFrame(model);
         }
-
-      traj_out->writeFrame(model);
     }
 
   cerr << " - done\n";
@@ -91,65 +91,25 @@ public:
 
   void addGeneric(po::options_description& o) {
     o.add_options()
-      ("centers", po::value<bool>(&use_centers)->default_value(false), "Use center of mass of residues for distance");
+      ("centers", po::value<bool>(&use_centers)->default_value(false), "Use center of mass of residues for distance")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)");
   }
 
   string print() const {
     ostringstream oss;
 
-    oss << "centers=" << use_centers;
+    oss << "centers=" << use_centers << ",threads=" << nthreads;
     return(oss.str());
   }
 
   bool use_centers;
+  uint nthreads;
 };
 // @endcond
 
 
 
 
-void accumulateFrameUsingCenters(DoubleMatrix& M, const vGroup& residues, const double threshold) {
-  
-  for (uint j=1; j<residues.size(); ++j) {
-    GCoord v(residues[j].centerOfMass());
-
-    for (uint i=0; i<j; ++i)
-      if (v.distance2(residues[i].centerOfMass()) <= threshold) {
-        M(j, i) += 1;
-        M(i, j) += 1;
-      }
-  }
-
-  for (uint i=0; i<residues.size(); ++i)
-    M(i, i) += 1;
-}
-
-
-void accumulateFrameUsingAllAtoms(DoubleMatrix& M, const vGroup& residues, const double threshold) {
-  
-  for (uint j=1; j<residues.size(); ++j) {
-    
-    for (uint i=0; i<j; ++i) {
-      bool flag = true;
-      for (AtomicGroup::const_iterator a = residues[j].begin(); a != residues[j].end() && flag; ++a)
-        for (AtomicGroup::const_iterator b = residues[i].begin(); b != residues[i].end(); ++b)
-          if ((*a)->coords().distance2((*b)->coords()) <= threshold) {
-            flag = false;
-            break;
-          }
-      if (!flag) {
-        M(j, i) += 1;
-        M(i, j) += 1;
-      }
-    }
-  }
-
-  for (uint i=0; i<residues.size(); ++i)
-    M(i, i) += 1;
-}
-
-
-
 int main(int argc, char *argv[]) {
   string hdr = invocationHeader(argc, argv);
 
@@ -169,23 +129,17 @@ int main(int argc, char *argv[]) {
   vector<uint> indices = tropts->frameList();
 
   double thresh = parseStringAs<double>(ropts->value("threshold"));
-  thresh *= thresh;
 
   AtomicGroup subset = selectAtoms(model, sopts->selection);
   vGroup residues = subset.splitByResidue();
 
-  DoubleMatrix M(residues.size(), residues.size());
-  for (vector<uint>::iterator i = indices.begin(); i != indices.end(); ++i) {
-    traj->readFrame(*i);
-    traj->updateGroupCoords(model);
-    if (topts->use_centers)
-      accumulateFrameUsingCenters(M, residues, thresh);
-    else
-      accumulateFrameUsingAllAtoms(M, residues, thresh);
-  }
+  ContactMap contacts(residues, thresh, topts->use_centers, topts->nthreads);
+  contacts.accumulate(traj, indices);
 
-  for (ulong i=0; i<residues.size() * residues.size(); ++i)
-    M[i] /= indices.size();
+  DoubleMatrix M(residues.size(), residues.size());
+  for (uint j=0; j<residues.size(); ++j)
+    for (uint i=0; i<residues.size(); ++i)
+      M(j, i) = static_cast<double>(contacts.count(j, i)) / indices.size();
 
   writeAsciiMatrix(cout, M, hdr);
 }
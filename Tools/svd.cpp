@@ -272,23 +272,19 @@ Matrix extractCoords(const AtomicGroup& subset, const vector<XForm>& xforms, pTr
   writeAverage(avg);
 
   uint natoms = subset.size();
-  AtomicGroup frame = subset.copy();
   uint n = indices.size();
   uint m = natoms * 3;
   Matrix M(m, n);
 
-  for (uint i=0; i<n; ++i) {
-    traj->readFrame(indices[i]);
-    traj->updateGroupCoords(frame);
-    frame.applyTransform(xforms[i]);
-
-    for (uint j=0; j<natoms; j++) {
-      GCoord c = frame[j]->coords() - avg[j]->coords();
-      M(j*3,i) = c.x();
-      M(j*3+1,i) = c.y();
-      M(j*3+2,i) = c.z();
-    }
-  }
+  readFramesInBatches(traj, subset, indices, [&](const uint i, const double* crds, const GCoord* box) {
+      GMatrix W = xforms[i].current();
+      for (uint j=0; j<natoms; j++, crds += 3) {
+        GCoord c = W * GCoord(crds[0], crds[1], crds[2]) - avg[j]->coords();
+        M(j*3,i) = c.x();
+        M(j*3+1,i) = c.y();
+        M(j*3+2,i) = c.z();
+      }
+    });
 
   return(M);
 }
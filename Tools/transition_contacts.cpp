@@ -45,7 +45,8 @@ public:
       ("sink-selection", po::value<string>(&sink_sel)->default_value(""), "Selection specific to sink model")
       ("timeseries", po::value<string>(&timeseries)->default_value(""), "Report contacts as a timeseries")
       ("include-heavy", po::value<bool>(&leave_heavy)->default_value(false), "Include backbone and hydrogen atoms")
-      ("smoothed-transition", po::value<bool>(&smoothed_transition)->default_value(true), "Use tanh smoothing of the transition ");
+      ("smoothed-transition", po::value<bool>(&smoothed_transition)->default_value(true), "Use tanh smoothing of the transition ")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)");
   }
 
   void addHidden(po::options_description& o) {
@@ -62,13 +63,14 @@ public:
   string help() const { return("source-model sink-model"); }
   string print() const {
     ostringstream oss;
-    oss << boost::format("sink-sel='%s', source-sel='%s', timeseries=%s")
+    oss << boost::format("cutoff=%f, smoothed-transition=%d, sink-sel='%s', source-sel='%s', timeseries=%s, include-heavy=%d, threads=%d")
       % cutoff
       % smoothed_transition
       % sink_sel
       % source_sel
       % timeseries
-      % leave_heavy;
+      % leave_heavy
+      % nthreads;
     return(oss.str());
   }
 
@@ -91,6 +93,7 @@ public:
   string sink_sel, source_sel;
   string timeseries;
   bool leave_heavy, smoothed_transition;
+  uint nthreads;
 };
 
 // @endcond
@@ -261,38 +264,29 @@ int main (int argc, char *argv[]){
   //######################################################################
   //### Build the master list of unique contacts
   //######################################################################
-  vector<AtomicGroup> reslist;
-  vector<pair<uint, uint> > formed_connection_list;
-  vector<pair<uint, uint> > broken_connection_list;
+  // Centers of mass of the source and sink residues are only needed once
+  vector<GCoord> start_centers, final_centers;
+  for (uint i = 0; i < residues.size(); ++i){
+    start_centers.push_back(start_residues[i].centerOfMass());
+    final_centers.push_back(final_residues[i].centerOfMass());
+  }
+
+  vector<NativeContacts::Pair> formed_connection_list;
+  vector<NativeContacts::Pair> broken_connection_list;
 
   for (uint j = 0; j < residues.size()-1; ++j) {
-    uint jk;
-    bool any_connection_flag = false;
-    GCoord cj = start_residues[j].centerOfMass();
+    GCoord cj = start_centers[j];
     for (uint i = j+1; i < residues.size(); ++i) {
-      GCoord ci = start_residues[i].centerOfMass();
+      GCoord ci = start_centers[i];
       GCoord start_diff = cj - ci;
+      GCoord final_diff = final_centers[j] - final_centers[i];
 
       // If formed in starting structure...
       if (start_diff.length2() <= cut2){
-        GCoord fci = final_residues[i].centerOfMass();
-        GCoord fcj = final_residues[j].centerOfMass();
-        GCoord final_diff = fcj - fci;
         // ...and if broken in ending structure
         if (final_diff.length2() > cut2){
-          // Check if residue[j]'s first connection
-          // (we only want [j] listed once)
-          if (!any_connection_flag){
-            jk = reslist.size();
-            reslist.push_back(residues[j]);
-            any_connection_flag = true;
-          }
-          uint ik = reslist.size();
-          reslist.push_back(residues[i]);
-
-          pair<uint,uint> conn_ptr(jk, ik);
           // Add these to the broken pair list
-          broken_connection_list.push_back(conn_ptr);
+          broken_connection_list.push_back(NativeContacts::Pair(j, i));
           // Document the residues in the broken list
           ofs << "# broken: " << final_residues[j].getAtom(0)->resid() << " "   
               << final_residues[i].getAtom(0)->resid() << endl;
@@ -301,22 +295,10 @@ int main (int argc, char *argv[]){
 
       // If broken in starting structure...
       if (start_diff.length2() > cut2){
-        GCoord fci = final_residues[i].centerOfMass();
-        GCoord fcj = final_residues[j].centerOfMass();
-        GCoord final_diff = fcj - fci;
         // ...and if formed in ending structure
         if (final_diff.length2() <= cut2){
-          if (!any_connection_flag){
-            jk = reslist.size();
-            reslist.push_back(residues[j]);
-            any_connection_flag = true;
-          }
-          uint ik = reslist.size();
-          reslist.push_back(residues[i]);
-          
-          pair<uint,uint> conn_ptr(jk, ik);
           // Add to the formed pair master list
-          formed_connection_list.push_back(conn_ptr);
+          formed_connection_list.push_back(NativeContacts::Pair(j, i));
           // Document the residues in the formed list
           ofs << "# formed: " << final_residues[j].getAtom(0)->resid() << " "   
               << final_residues[i].getAtom(0)->resid() << endl;
@@ -339,33 +321,31 @@ int main (int argc, char *argv[]){
   cout << "# Frame \t broken \t formed \t total \n";
   cout << "#-------------------------------------------\n";
 
+  // Both lists are tracked together, broken pairs first
+  vector<NativeContacts::Pair> connection_list(broken_connection_list);
+  connection_list.insert(connection_list.end(), formed_connection_list.begin(), formed_connection_list.end());
+  NativeContacts transitions(residues, connection_list, cutoff);
+
 
   //######################################################################
   //### Iterate over trajectory frames 
   //### Calc the number of unique contacts broken/formed
   //######################################################################
+  vector<uint> frames;
+  if (traj->readFrame())
+    for (uint i = traj->currentFrame(); i < traj->nframes(); ++i)
+      frames.push_back(i);
+
   int frame = tropts->skip;
-  while (traj->readFrame()){
-    traj->updateGroupCoords(system);
+  transitions.scan(traj, frames, [&](const uint, const double* d2) {
     double number_broken = 0.0;
     double number_formed = 0.0;
-    
-    // Build a GCoord vector of CoM's 
-    // with indices corresponding to reslist
-    vector<GCoord> centers;
-    for (uint gi = 0; gi < reslist.size(); ++gi){
-      GCoord temp_com = reslist[gi].centerOfMass();
-      centers.push_back(temp_com);
-    }
 
     // Do the actual calculation
     // For broken list
-    for (uint i = 0; i < broken_connection_list.size(); ++i){
-
-      GCoord first_current  = centers[broken_connection_list[i].first];
-      GCoord second_current = centers[broken_connection_list[i].second]; 
-      bool broken = first_current.distance2(second_current) > cut2;
-      double current_dist = sqrt(first_current.distance2(second_current));
+    for (uint i = 0; i < total_broken_contacts; ++i){
+      bool broken = d2[i] > cut2;
+      double current_dist = sqrt(d2[i]);
       
       if (smoothed_transition){
         double value = 0.5 * tanh(current_dist-cutoff)+0.5;
@@ -381,11 +361,10 @@ int main (int argc, char *argv[]){
     }
 
     // For formed list
-    for (uint i = 0; i < formed_connection_list.size(); ++i){
-      GCoord first_current  = centers[formed_connection_list[i].first];
-      GCoord second_current = centers[formed_connection_list[i].second]; 
-      bool formed = first_current.distance2(second_current) < cut2;
-      double current_dist = sqrt(first_current.distance2(second_current));
+    for (uint i = 0; i < total_formed_contacts; ++i){
+      double dist2 = d2[total_broken_contacts + i];
+      bool formed = dist2 < cut2;
+      double current_dist = sqrt(dist2);
     
       if (smoothed_transition){
         double value = 0.5 * tanh(current_dist-cutoff)+0.5;
@@ -410,5 +389,5 @@ int main (int argc, char *argv[]){
     float percent_formed = number_formed / total_formed_contacts;
     cout << frame << "\t" << percent_broken << "\t" << percent_formed << "\t" << num_transition << endl;
     frame++;
-  }
+  }, topts->nthreads);
 }
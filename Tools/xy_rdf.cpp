@@ -43,6 +43,7 @@ int timeseries_interval;
 string output_directory;
 bool sel1_spans, sel2_spans;
 bool reselect_leaflet = false;
+uint nthreads;
 
 
 // @cond TOOLS_INTERNAL
@@ -59,6 +60,7 @@ public:
       ("sel1-spans", "Selection 1 appears in both leaflets")
       ("sel2-spans", "Selection 2 appears in both leaflets")
       ("reselect", "Recompute leaflet location for each frame")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)")
        ;
 
   }
@@ -125,7 +127,7 @@ public:
   string print() const
   {
     ostringstream oss;
-    oss << boost::format("split-mode='%s', sel1='%s', sel2='%s', hist-min=%f, hist-max=%f, num-bins=%f, timeseries=%d, timeseries-directory='%s', sel1-spans=%d, sel2-spans=%d reselect=%d")
+    oss << boost::format("split-mode='%s', sel1='%s', sel2='%s', hist-min=%f, hist-max=%f, num-bins=%f, timeseries=%d, timeseries-directory='%s', sel1-spans=%d, sel2-spans=%d reselect=%d, threads=%d")
       % split_by
       % selection1
       % selection2
@@ -136,7 +138,8 @@ public:
       % output_directory
       % sel1_spans
       % sel2_spans
-      % reselect_leaflet;
+      % reselect_leaflet
+      % nthreads;
     return(oss.str());
   }
 
@@ -222,6 +225,9 @@ string s =
     "overhead, but is necessary if you're dealing with molecules that \n"
     "can flip from one leaflet to the other.\n"
     "\n"
+    "The --threads option sets how many threads bin the distances each frame\n"
+    "(0 uses all available cores).\n"
+    "\n"
     "EXAMPLE\n"
     "\n"
     "To look at the distribution of PE lipid headgroups in a lipid\n"
@@ -287,6 +293,27 @@ void assign_leaflet(vector<AtomicGroup> &molecules,
         }
     }
 
+// Bin the xy distances between the centers of mass of two lists of
+// groups, returning the number of pairs of distinct groups
+unsigned long accumulatePairs(PairHistogram &hist,
+                              const vector<AtomicGroup> &g1,
+                              const vector<uint> &labels1,
+                              const vector<AtomicGroup> &g2,
+                              const vector<uint> &labels2,
+                              const GCoord &box, const double weight)
+    {
+    vector<GCoord> c1(g1.size()), c2(g2.size());
+    for (unsigned int j = 0; j < g1.size(); j++)
+        {
+        c1[j] = g1[j].centerOfMass();
+        }
+    for (unsigned int k = 0; k < g2.size(); k++)
+        {
+        c2[k] = g2[k].centerOfMass();
+        }
+    return(hist.accumulate(c1, labels1, c2, labels2, box, weight));
+    }
+
 int main (int argc, char *argv[])
 {
 
@@ -374,23 +401,26 @@ assign_leaflet(g1_mols, g1_upper, g1_lower, sel1_spans);
 assign_leaflet(g2_mols, g2_upper, g2_lower, sel2_spans);
 
 
+// Label the groups in each leaflet so that a group is never paired
+// with itself
+vector<uint> l1_upper, l1_lower, l2_upper, l2_lower;
+PairHistogram::labelGroups(g1_upper, g2_upper, l1_upper, l2_upper);
+PairHistogram::labelGroups(g1_lower, g2_lower, l1_lower, l2_lower);
+
 // Create 2 histograms -- one for top, one for bottom
 // Also create 2 histograms to store the total
-vector<double> hist_lower, hist_upper;
+// Only pairs closer than hist_max are binned, so the histograms use
+// cell lists rather than looking at every pair.
+PairHistogram lower_pairs(hist_min, hist_max, num_bins, true, nthreads);
+PairHistogram upper_pairs(hist_min, hist_max, num_bins, true, nthreads);
+const vector<double> &hist_lower = lower_pairs.histogram();
+const vector<double> &hist_upper = upper_pairs.histogram();
 vector<double> hist_lower_total, hist_upper_total;
-hist_lower.reserve(num_bins);
-hist_upper.reserve(num_bins);
 hist_lower_total.reserve(num_bins);
 hist_upper_total.reserve(num_bins);
-hist_lower.insert(hist_lower.begin(), num_bins, 0.0);
-hist_upper.insert(hist_upper.begin(), num_bins, 0.0);
 hist_lower_total.insert(hist_lower_total.begin(), num_bins, 0.0);
 hist_upper_total.insert(hist_upper_total.begin(), num_bins, 0.0);
 
-
-double min2 = hist_min*hist_min;
-double max2 = hist_max*hist_max;
-
 // loop over the frames of the traj file
 double area = 0.0;
 double interval_area = 0.0;
@@ -426,63 +456,25 @@ for (uint index = 0; index<framecnt; ++index)
         {
         assign_leaflet(g1_mols, g1_upper, g1_lower, sel1_spans);
         assign_leaflet(g2_mols, g2_upper, g2_lower, sel2_spans);
+        PairHistogram::labelGroups(g1_upper, g2_upper, l1_upper, l2_upper);
+        PairHistogram::labelGroups(g1_lower, g2_lower, l1_lower, l2_lower);
         }
 
     // compute the distribution of g2 around g1 for the lower leaflet
-    for (unsigned int j = 0; j < g1_lower.size(); j++)
-        {
-        GCoord p1 = g1_lower[j].centerOfMass();
-        for (unsigned int k = 0; k < g2_lower.size(); k++)
-            {
-            // skip "self" pairs
-            if (g1_lower[j] == g2_lower[k])
-                {
-                continue;
-                }
-
-            cum_lower_pairs+=weight;
-            interval_lower_pairs+=weight;
-
-            GCoord p2 = g2_lower[k].centerOfMass();
-            GCoord displ = (p2 - p1);
-            displ.reimage(box);
-            double d2 = (displ.x() * displ.x()) + (displ.y() * displ.y());
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist_lower[bin]+=weight;
-                }
-            }
-        }
+    double lower_pairs_seen = weight * accumulatePairs(lower_pairs,
+                                                       g1_lower, l1_lower,
+                                                       g2_lower, l2_lower,
+                                                       box, weight);
+    cum_lower_pairs += lower_pairs_seen;
+    interval_lower_pairs += lower_pairs_seen;
 
     // compute the distribution of g2 around g1 for the upper leaflet
-    for (unsigned int j = 0; j < g1_upper.size(); j++)
-        {
-        GCoord p1 = g1_upper[j].centerOfMass();
-        for (unsigned int k = 0; k < g2_upper.size(); k++)
-            {
-            // skip "self" pairs
-            if (g1_upper[j] == g2_upper[k])
-                {
-                continue;
-                }
-
-            cum_upper_pairs+=weight;
-            interval_lower_pairs+=weight;
-
-            GCoord p2 = g2_upper[k].centerOfMass();
-            GCoord displ = (p2 - p1);
-            displ.reimage(box);
-            double d2 = (displ.x() * displ.x()) + (displ.y() * displ.y());
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist_upper[bin]+=weight;
-                }
-            }
-        }
+    double upper_pairs_seen = weight * accumulatePairs(upper_pairs,
+                                                       g1_upper, l1_upper,
+                                                       g2_upper, l2_upper,
+                                                       box, weight);
+    cum_upper_pairs += upper_pairs_seen;
+    interval_upper_pairs += upper_pairs_seen;
 
 
     // if requested, write out timeseries as well
@@ -547,8 +539,8 @@ for (uint index = 0; index<framecnt; ++index)
             }
 
         // rezero the histograms
-        hist_upper.assign(num_bins, 0.0);
-        hist_lower.assign(num_bins, 0.0);
+        upper_pairs.clear();
+        lower_pairs.clear();
 
         // zero out the area
         interval_area = 0.0;
@@ -127,14 +127,20 @@ for (unsigned int i = 0; i < g2_mols.size(); i++)
 
 
 // Create 2 histograms -- one for top, one for bottom
-vector<double> hist_lower, hist_upper;
-hist_lower.reserve(num_bins);
-hist_upper.reserve(num_bins);
-hist_lower.insert(hist_lower.begin(), num_bins, 0.0);
-hist_upper.insert(hist_upper.begin(), num_bins, 0.0);
-
-double min2 = hist_min*hist_min;
-double max2 = hist_max*hist_max;
+// Only pairs closer than hist_max are binned, so the histograms use
+// cell lists rather than looking at every pair.
+PairHistogram lower_pairs(hist_min, hist_max, num_bins, true, 1);
+PairHistogram upper_pairs(hist_min, hist_max, num_bins, true, 1);
+const vector<double> &hist_lower = lower_pairs.histogram();
+const vector<double> &hist_upper = upper_pairs.histogram();
+
+// Label the groups in each leaflet so that a group is never paired
+// with itself
+vector<uint> l1_upper, l1_lower, l2_upper, l2_lower;
+PairHistogram::labelGroups(g1_upper, g2_upper, l1_upper, l2_upper);
+PairHistogram::labelGroups(g1_lower, g2_lower, l1_lower, l2_lower);
+vector<GCoord> c1_upper(g1_upper.size()), c1_lower(g1_lower.size());
+vector<GCoord> c2_upper(g2_upper.size()), c2_lower(g2_lower.size());
 
 // Set up the normalization
 uint num_upper, num_lower;
@@ -168,51 +174,17 @@ while (traj->readFrame())
 
     // compute the distribution of g2 around g1 for the lower leaflet
     for (unsigned int j = 0; j < g1_lower.size(); j++)
-        {
-        GCoord p1 = g1_lower[j].centerOfMass();
-        for (unsigned int k = 0; k < g2_lower.size(); k++)
-            {
-            // skip "self" pairs
-            if (g1_lower[j] == g2_lower[k])
-                {
-                continue;
-                }
-            GCoord p2 = g2_lower[k].centerOfMass();
-            GCoord displ = (p2 - p1);
-            displ.reimage(box);
-            double d2 = (displ.x() * displ.x()) + (displ.y() * displ.y());
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist_lower[bin]++;
-                }
-            }
-        }
+        c1_lower[j] = g1_lower[j].centerOfMass();
+    for (unsigned int k = 0; k < g2_lower.size(); k++)
+        c2_lower[k] = g2_lower[k].centerOfMass();
+    lower_pairs.accumulate(c1_lower, l1_lower, c2_lower, l2_lower, box);
 
     // compute the distribution of g2 around g1 for the upper leaflet
     for (unsigned int j = 0; j < g1_upper.size(); j++)
-        {
-        GCoord p1 = g1_upper[j].centerOfMass();
-        for (unsigned int k = 0; k < g2_upper.size(); k++)
-            {
-            // skip "self" pairs
-            if (g1_upper[j] == g2_upper[k])
-                {
-                continue;
-                }
-            GCoord p2 = g2_upper[k].centerOfMass();
-            GCoord displ = (p2 - p1);
-            displ.reimage(box);
-            double d2 = (displ.x() * displ.x()) + (displ.y() * displ.y());
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist_upper[bin]++;
-                }
-            }
-        }
+        c1_upper[j] = g1_upper[j].centerOfMass();
+    for (unsigned int k = 0; k < g2_upper.size(); k++)
+        c2_upper[k] = g2_upper[k].centerOfMass();
+    upper_pairs.accumulate(c1_upper, l1_upper, c2_upper, l2_upper, box);
 
     frame++;
 
@@ -257,8 +229,8 @@ while (traj->readFrame())
         out << endl; // blank line for gnuplot
         out.close();
         // rezero the histograms
-        hist_upper.assign(num_bins, 0.0);
-        hist_lower.assign(num_bins, 0.0);
+        upper_pairs.clear();
+        lower_pairs.clear();
 
         // zero out the area
         area = 0;
@@ -39,6 +39,8 @@
 #include <boost/random.hpp>
 
 #include <AtomicGroup.hpp>
+#include <DebyeScattering.hpp>
+#include <ContactKernels.hpp>
 #include <utils.hpp>
 
 
@@ -182,17 +184,46 @@ namespace loos {
     return(radius);
   }
 
+  // The other group's coordinates are gathered once and the box is
+  // hoisted out of the loop, so the inner loop is plain arithmetic on
+  // flat arrays.  The minimum image is the same arithmetic as
+  // GCoord::reimage() (and ContactKernels) and the pairs are summed in
+  // the same order as before, so the score is unchanged.
   double AtomicGroup::packingScore(const AtomicGroup& other,
                                     const GCoord &box,
                                     bool norm = false) const {
+      uint n = other.size();
+      std::vector<double> x(n), y(n), z(n);
+      for (uint j=0; j<n; ++j) {
+          const GCoord& c = other.atoms[j]->coords();
+          x[j] = c[0];
+          y[j] = c[1];
+          z[j] = c[2];
+      }
+
+      const double bx = box[0];
+      const double by = box[1];
+      const double bz = box[2];
+
       double score = 0.0;
       for (const_iterator a1 = atoms.begin();
                           a1 != atoms.end();
                           a1++) {
-          for (const_iterator a2 = other.atoms.begin();
-                              a2 != other.atoms.end();
-                              a2++) {
-              double d2 = ((*a1)->coords()).distance2((*a2)->coords(), box);
+          const GCoord& c = (*a1)->coords();
+          const double cx = c[0];
+          const double cy = c[1];
+          const double cz = c[2];
+          for (uint j=0; j<n; ++j) {
+              double dx = x[j] - cx;
+              double dy = y[j] - cy;
+              double dz = z[j] - cz;
+              int nx = (int)(fabs(dx) / bx + 0.5);
+              int ny = (int)(fabs(dy) / by + 0.5);
+              int nz = (int)(fabs(dz) / bz + 0.5);
+              dx = (dx >= 0) ? dx - nx * bx : dx + nx * bx;
+              dy = (dy >= 0) ? dy - ny * by : dy + ny * by;
+              dz = (dz >= 0) ? dz - nz * bz : dz + nz * bz;
+              double d2 = dx*dx + dy*dy + dz*dz;
               score += 1./(d2 * d2 * d2);
           }
       }
@@ -203,6 +234,14 @@ namespace loos {
       return(score);
   }
 
+  double AtomicGroup::logisticFunc(const GCoord &cent, const GCoord &other,
+                                   double radius, int sigma,
+                                   const GCoord &box) const {
+      if (sigma <= 0)
+          throw(LOOSError("Logistic contacts need a positive sigma"));
+      return(internal::logistic(cent.distance2(other, box), radius, sigma));
+  }
+
   double AtomicGroup::logisticContact(const AtomicGroup& group,
                                       double radius,
                                       int sigma,
@@ -513,55 +552,8 @@ namespace loos {
   std::vector<double> AtomicGroup::scattering(const double qmin, const double qmax,
                                    const uint numValues,
                                    loos::FormFactorSet &formFactors) {
-    const double qstep = (qmax - qmin) / numValues;
-    std::vector<double> values(numValues);
-
-    // Try pre-computing the f values to move it out of the inner loop
-    // Loop over each atom, and if it's a new element, compute and store
-    // the q values
-    std::map<uint, std::vector<double> > f_values;
-    for (uint i=0; i < size(); i++) {
-        if (f_values.count(i) == 0) {
-          std::vector<double> vals(numValues);
-          for (uint qindex=0; qindex < numValues; qindex++) {
-            double q = qmin + qindex*qstep;
-            double f1 = formFactors.get(atoms[i]->atomic_number(), q);
-            vals[qindex] = f1;
-          }
-        f_values[i] = vals;
-        }
-    }
-
-    for (uint i = 0; i < size(); i++) {
-        GCoord c1 = atoms[i]->coords();
-        for (uint j = i; j < size(); j++) {
-            if (i == j) {
-              for (uint qindex=0; qindex < numValues; qindex++) {
-                //double q = qmin + qindex*qstep;
-                //double f1 = formFactors.get(atoms[i]->atomic_number(), q);
-                double f1 = f_values[i][qindex];
-                values[qindex] += f1*f1;
-              }
-            } else {
-              GCoord diff = c1 - atoms[j]->coords();
-              double length = diff.length();
-              for (uint qindex=0; qindex < numValues; qindex++) {
-                  double q = qmin + qindex*qstep;
-                  double qd = q * length;
-                  //double f1 = formFactors.get(atoms[i]->atomic_number(), q);
-                  //double f2 = formFactors.get(atoms[j]->atomic_number(), q);
-                  double f1 = f_values[i][qindex];
-                  double f2 = f_values[j][qindex];
-                  if (qd < 1e-7) {  // trap q=0, sin(x)/x -> 1
-                    values[qindex] += f1*f2;
-                  } else {
-                    values[qindex] += f1*f2*sin(qd)/qd;
-                  }
-              }
-            }
-        }
-    }
-  return values;
+    DebyeScattering debye(*this, qmin, qmax, numValues, formFactors, DebyeScattering::EXACT);
+    return(debye.compute(*this));
   }
 
 
@@ -50,26 +50,26 @@ namespace loos {
     setPropertyBit(anumbit);
   }
 
-  std::string Atom::name(void) const { return(_name); }
-  void Atom::name(const std::string s) { _name = s; }
+  std::string Atom::name(void) const { return(*_name); }
+  void Atom::name(const std::string s) { _name = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::altLoc(void) const { return(_altloc); }
-  void Atom::altLoc(const std::string s) { _altloc = s; }
+  std::string Atom::altLoc(void) const { return(*_altloc); }
+  void Atom::altLoc(const std::string s) { _altloc = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::chainId(void) const { return(_chainid); }
-  void Atom::chainId(const std::string s) { _chainid = s; }
+  std::string Atom::chainId(void) const { return(*_chainid); }
+  void Atom::chainId(const std::string s) { _chainid = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::resname(void) const { return(_resname); }
-  void Atom::resname(const std::string s) { _resname = s; }
+  std::string Atom::resname(void) const { return(*_resname); }
+  void Atom::resname(const std::string s) { _resname = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::segid(void) const { return(_segid); }
-  void Atom::segid(const std::string s) { _segid = s; }
+  std::string Atom::segid(void) const { return(*_segid); }
+  void Atom::segid(const std::string s) { _segid = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::iCode(void) const { return(_icode); }
-  void Atom::iCode(const std::string s) { _icode = s; }
+  std::string Atom::iCode(void) const { return(*_icode); }
+  void Atom::iCode(const std::string s) { _icode = UniqueStrings::atomProperties().add(s); }
 
-  std::string Atom::PDBelement(void) const { return(_pdbelement); }
-  void Atom::PDBelement(const std::string s) { _pdbelement = s; }
+  std::string Atom::PDBelement(void) const { return(*_pdbelement); }
+  void Atom::PDBelement(const std::string s) { _pdbelement = UniqueStrings::atomProperties().add(s); }
 
   const GCoord& Atom::coords(void) const { return(_coords); }
   GCoord& Atom::coords(void) { setPropertyBit(coordsbit); return(_coords); }
@@ -102,8 +102,8 @@ namespace loos {
     //! Recordname imported from the PDB for this Atom
     //! This is mainly for atoms that come from a PDB, i.e. whether or
     //! not they were an ATOM or a HETATM
-  std::string Atom::recordName(void) const { return(_record); }
-  void Atom::recordName(const std::string s) { _record = s; }
+  std::string Atom::recordName(void) const { return(*_record); }
+  void Atom::recordName(const std::string s) { _record = UniqueStrings::atomProperties().add(s); }
 
     //! Clear all stored bonds
   void Atom::clearBonds(void) { bonds.clear(); clearPropertyBit(bondsbit); }
@@ -186,7 +186,31 @@ namespace loos {
   }
 
 
+  namespace {
+    // Interned once, since every new Atom starts with these
+    struct DefaultStrings {
+      DefaultStrings() {
+        UniqueStrings& table = UniqueStrings::atomProperties();
+        blank1 = table.add(" ");
+        blank3 = table.add("   ");
+        blank4 = table.add("    ");
+        empty = table.add("");
+        atom = table.add("ATOM");
+      }
+
+      UniqueStrings::Handle blank1, blank3, blank4, empty, atom;
+    };
+
+    const DefaultStrings& defaultStrings() {
+      static DefaultStrings defaults;
+      return(defaults);
+    }
+  }
+
+
   void Atom::init() {
+    const DefaultStrings& defaults = defaultStrings();
+
     _id = 1;
     _index = 0;
     _resid = 1;
@@ -195,13 +219,14 @@ namespace loos {
     _q = 1.0;
     _charge = 0.0;
     _mass = 1.0;
-    _name = "    ";
-    _altloc = " ";
-    _resname = "   ";
-    _chainid = " ";
-    _segid = "    ";
-    _pdbelement = "";
-    _record = "ATOM";
+    _name = defaults.blank4;
+    _altloc = defaults.blank1;
+    _resname = defaults.blank3;
+    _chainid = defaults.blank1;
+    _segid = defaults.blank4;
+    _icode = defaults.empty;
+    _pdbelement = defaults.empty;
+    _record = defaults.atom;
     _atom_type = -1;
     mask = nullbit;   // Nullbit means nothing was set...
   }
@@ -212,11 +237,11 @@ namespace loos {
 
 
   std::ostream& operator<<(std::ostream& os, const loos::Atom& a) {
-    os << "<ATOM INDEX='" << a._index << "' ID='" << a._id << "' NAME='" << a._name << "' ";
-    os << "RESID='" << a._resid << "' RESNAME='" << a._resname << "' ";
+    os << "<ATOM INDEX='" << a._index << "' ID='" << a._id << "' NAME='" << *a._name << "' ";
+    os << "RESID='" << a._resid << "' RESNAME='" << *a._resname << "' ";
     os << "COORDS='" << a._coords << "' ";
     os << "VELOCITIES='" << a._velocities << "' ";
-    os << "ALTLOC='" << a._altloc << "' CHAINID='" << a._chainid << "' ICODE='" << a._icode << "' SEGID='" << a._segid << "' ";
+    os << "ALTLOC='" << *a._altloc << "' CHAINID='" << *a._chainid << "' ICODE='" << *a._icode << "' SEGID='" << *a._segid << "' ";
     os << "B='" << a._b << "' Q='" << a._q << "' CHARGE='" << a._charge << "' MASS='" << a._mass << "'";
     os << " ATOMICNUMBER='" << a._atomic_number <<"'";
     os << " MASK='" << boost::format("%x") % a.mask << "'";
@@ -241,19 +266,19 @@ namespace loos {
   }
   
   bool AtomEquals::operator()(const pAtom& a, const pAtom& b) const {
-    return(a->name() == b->name()
+    return(a->nameHandle() == b->nameHandle()
            && a->id() == b->id()
-           && a->resname() == b->resname()
+           && a->resnameHandle() == b->resnameHandle()
            && a->resid() == b->resid()
-           && a->segid() == b->segid());
+           && a->segidHandle() == b->segidHandle());
   }
 
   bool AtomCoordsEquals::operator()(const pAtom& a, const pAtom& b) const {
-    bool bb = (a->name() == b->name()
+    bool bb = (a->nameHandle() == b->nameHandle()
                && a->id() == b->id()
-               && a->resname() == b->resname()
+               && a->resnameHandle() == b->resnameHandle()
                && a->resid() == b->resid()
-               && a->segid() == b->segid());
+               && a->segidHandle() == b->segidHandle());
     if (!bb)
       return(false);
 
@@ -32,6 +32,7 @@
 #include <loos_defs.hpp>
 #include <exceptions.hpp>
 #include <Coord.hpp>
+#include <UniqueStrings.hpp>
 
 namespace loos {
 
@@ -44,6 +45,9 @@ namespace loos {
    * Most properties are derived from the PDB file specification.
    * Exceptions are noted below.  Accessors for each property are
    * provided and should be self-explanatory...
+   *
+   * String properties are interned in a table shared by all atoms
+   * (see UniqueStrings), so each atom only holds a handle for each.
    */
 
   
@@ -91,7 +95,7 @@ namespace loos {
       init();
       _index = 0;
       _id = i;
-      _name = s;
+      name(s);
       _coords = c;
     }
 
@@ -132,6 +136,20 @@ namespace loos {
     std::string PDBelement(void) const;
     void PDBelement(const std::string);
 
+#if !defined(SWIG)
+    //! Interned handles for the name, resname, and segid
+    /**
+     * Two atoms have the same name exactly when their name handles are
+     * equal, so these allow string properties to be compared without
+     * comparing (or copying) the strings.  Use
+     * UniqueStrings::atomProperties().add() to get the handle for a
+     * string to compare against.
+     */
+    UniqueStrings::Handle nameHandle(void) const { return(_name); }
+    UniqueStrings::Handle resnameHandle(void) const { return(_resname); }
+    UniqueStrings::Handle segidHandle(void) const { return(_segid); }
+#endif // !defined(SWIG)
+
 
 #if !defined(SWIG)
     //! Returns a const ref to internally stored coordinates.
@@ -254,6 +272,9 @@ namespace loos {
     std::string asString() const;
 
   private:
+    //! Snapshots read and write the interned handles directly
+    friend class TopologyCache;
+
     void init(void);
     //! Internal function for setting a bitflag
     void setPropertyBit(const bits);
@@ -265,12 +286,12 @@ namespace loos {
   private:
     int _id;
     uint _index;
-    std::string _record, _name, _altloc, _resname, _chainid;
+    UniqueStrings::Handle _record, _name, _altloc, _resname, _chainid;
     int _resid;
     int _atomic_number;
-    std::string _icode;
+    UniqueStrings::Handle _icode;
     double _b, _q, _charge, _mass;
-    std::string _segid, _pdbelement;
+    UniqueStrings::Handle _segid, _pdbelement;
     int _atom_type;
     GCoord _coords;
     GCoord _velocities;
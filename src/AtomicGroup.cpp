@@ -111,6 +111,7 @@ namespace loos {
 
     atoms.erase(iter);
     _sorted = false;
+    invalidatePartitions();
   }
 
 
@@ -122,6 +123,7 @@ namespace loos {
       atoms.push_back(*i);
 
     _sorted = false;
+    invalidatePartitions();
     return(*this);
   }
 
@@ -154,9 +156,10 @@ namespace loos {
   AtomicGroup& AtomicGroup::remove(const AtomicGroup& grp) {
 
 
-    if (&grp == this)
+    if (&grp == this) {
       atoms.clear();      // Assume caller meant to clean out AtomicGroup
-    else {
+      invalidatePartitions();
+    } else {
       std::vector<pAtom>::const_iterator i;
 
       for (i=grp.atoms.begin(); i != grp.atoms.end(); i++)
@@ -179,6 +182,7 @@ namespace loos {
   AtomicGroup& AtomicGroup::operator+=(const pAtom& rhs) {
     atoms.push_back(rhs);
     _sorted = false;
+    invalidatePartitions();
     return(*this);
   }
 
@@ -261,6 +265,7 @@ namespace loos {
 
     for (ci = atoms.begin(); ci != atoms.end(); ++ci)
       (*ci)->clearBonds();
+    invalidatePartitions();
   }
 
 
@@ -278,8 +283,10 @@ namespace loos {
   void AtomicGroup::sort(void) {
     CmpById comp;
 
-    if (! _sorted)
+    if (! _sorted) {
       std::sort(atoms.begin(), atoms.end(), comp);
+      invalidatePartitions();
+    }
 
     _sorted = true;
   }
@@ -330,6 +337,7 @@ namespace loos {
     atoms.erase(boost::get<0>(iters), boost::get<1>(iters));
 
     _sorted = false;
+    invalidatePartitions();
 
     res.box = box;
     return(res);
@@ -353,31 +361,10 @@ namespace loos {
 
   // Split up a group into a vector of groups based on unique segids...
   std::vector<AtomicGroup> AtomicGroup::splitByUniqueSegid(void) const {
-    const_iterator i;
-    std::list<std::string> segids;
-
-    for (i = atoms.begin(); i != atoms.end(); i++)
-      if (find(segids.begin(), segids.end(), (*i)->segid()) == segids.end())
-        segids.push_front((*i)->segid());
-
-    // Reverse the order so that the chunks are in the same order they appear
-    // in the file...
-    uint n = segids.size();
-    std::vector<AtomicGroup> results(n);
-    uint j = n-1;
-    for (std::list<std::string>::const_iterator i = segids.begin(); i != segids.end(); ++i) {
-      SegidSelector segid(*i);
-      results[j--] = select(segid);
-    }
-
-    std::vector<AtomicGroup>::iterator g;
-    for (g=results.begin(); g!=results.end(); g++) {
-      g->box = box;
-    }
-
-    return(results);
+    return(split(GroupPartition::byUniqueSegid(*this)));
   }
 
+
   std::map<std::string, AtomicGroup> AtomicGroup::splitByName(void) const {
     const_iterator i;
     std::map<std::string, AtomicGroup> groups;
@@ -402,133 +389,68 @@ namespace loos {
     return(groups);
   }
 
-  /** The idea is that we iterate over the list of contained atoms.  For
-   * each atom, we recurse through the list of bonded atoms.  Each time
-   * we visit an atom, we mark it as having been seen via the hash_set.
-   * In the recursive function, every time we find a new unseen atom, we
-   * append it to the current group and mark it as seen, then recurse
-   * through all of its bonded atoms.
-   *
-   * Since splitByMolecule() recurses through the connectivity list,
-   * the ordering of the atoms returned will not necessarily be the
-   * same as the input group.  We therefore sort each group returned
-   * to hopefully maintain correct relative ordering.
-   *
-   * If we find a bond that goes to an atom that does not exist in the
-   * current group, a std::runtime_error is thrown.
-   *
-   * Note that for efficiency of atom lookup, the group gets sorted.
-   * This is why the public function splitByMolecule() makes a copy of
-   * itself and calls sortingSplitByMolecule() on that...
-   */
-
-  std::vector<AtomicGroup> AtomicGroup::sortingSplitByMolecule(void) {
-    std::vector<AtomicGroup> molecules;
-
-    // If no connectivity, just return the entire group...
-    if (!hasBonds()) {
-      sort();
-      molecules.push_back(*this);
-    } else {
-      HashInt seen;                      // Track what atoms we've already processed
-      AtomicGroup current;               // The molecule we're currently building...
-      AtomicGroup working(*this);        // Copy, so we can sort without mucking up original order
-      working.sort();
-
-      int n = size();
-      for (int i=0; i<n; i++) {
-        HashInt::iterator it = seen.find(working.atoms[i]->id());
-        if (it != seen.end())
-          continue;
-
-        walkBonds(current, seen, working, working.atoms[i]);
-        if (current.size() != 0) {       // Just in case...
-          current.sort();
-          molecules.push_back(current);
-          current = AtomicGroup();
-        }
+  // Molecules come from GroupPartition::byMolecule(); the selection
+  // is applied to each one after splitting
+  std::vector<AtomicGroup> AtomicGroup::splitByMolecule(const std::string& selection) const {
+    Parser parser(selection);
+    KernelSelector parsed_sel(parser.kernel());
 
-      }
-    }
-    
+    std::vector<AtomicGroup> molecules = splitByMolecule();
+    for (std::vector<AtomicGroup>::iterator m = molecules.begin(); m != molecules.end(); ++m)
+      *m = m->select(parsed_sel);
 
-    // copy the box over
-    std::vector<AtomicGroup>::iterator m;
-    for (m=molecules.begin(); m!=molecules.end(); m++) {
-      m->box = box;
-    }
     return(molecules);
   }
 
-  std::vector<AtomicGroup> AtomicGroup::sortingSplitByMolecule(const std::string& selection) {
-    std::vector<AtomicGroup> molecules;
-    Parser parser(selection);
-    KernelSelector parsed_sel(parser.kernel());
 
+  std::vector<AtomicGroup> AtomicGroup::split(const GroupPartition& partition) const {
+    const std::vector<uint>& offsets = partition.offsets();
+    const std::vector<uint>& positions = partition.positions();
 
-    // If no connectivity, just return the entire group...
-    if (!hasBonds()) {
-      sort();
-      molecules.push_back(this->select(parsed_sel));
-    } else {
-      HashInt seen;                      // Track what atoms we've already processed
-      AtomicGroup current;               // The molecule we're currently building...
-      AtomicGroup working(*this);        // Copy, so we can sort without mucking up original order
-      working.sort();
-
-      int n = size();
-      for (int i=0; i<n; i++) {
-        HashInt::iterator it = seen.find(working.atoms[i]->id());
-        if (it != seen.end())
-          continue;
-
-        walkBonds(current, seen, working, working.atoms[i]);
-        if (current.size() != 0) {       // Just in case...
-          current.sort();
-          molecules.push_back(current.select(parsed_sel));
-          current = AtomicGroup();
-        }
-
-      }
-    }
-    
-
-    // copy the box over
-    std::vector<AtomicGroup>::iterator m;
-    for (m=molecules.begin(); m!=molecules.end(); m++) {
-      m->box = box;
+    std::vector<AtomicGroup> parts(partition.size());
+    for (uint g=0; g<partition.size(); ++g) {
+      AtomicGroup& part = parts[g];
+      part.atoms.reserve(offsets[g+1] - offsets[g]);
+      for (uint i=offsets[g]; i<offsets[g+1]; ++i)
+        part.atoms.push_back(atoms[positions[i]]);
+      part._sorted = partition.sortedById();
+      part.box = box;
     }
-    return(molecules);
-  } 
 
+    return(parts);
+  }
 
-  void AtomicGroup::walkBonds(AtomicGroup& current, HashInt& seen, AtomicGroup& working, pAtom& moi) {
-    int myid = moi->id();
-    HashInt::iterator it = seen.find(myid);
 
-    // If we've touched this atom before, stop recursing and return.
-    if (it != seen.end())
-      return;
+  const GroupPartition& AtomicGroup::moleculePartition() const {
+    if (!_partitions)
+      _partitions = boost::shared_ptr<PartitionCache>(new PartitionCache);
+    if (!_partitions->have_molecules) {
+      _partitions->molecules = GroupPartition::byMolecule(*this);
+      _partitions->have_molecules = true;
+    }
+    return(_partitions->molecules);
+  }
 
-    // This is a novel atom, so append it into the group we're currently building.
-    seen.insert(myid);
-    current.addAtom(moi);
 
-    // Just in case it's a solo-atom...  This probably should indicate
-    // some kind of error...?
-    if (!(moi->hasBonds()))
-      return;
+  const GroupPartition& AtomicGroup::residuePartition() const {
+    if (!_partitions)
+      _partitions = boost::shared_ptr<PartitionCache>(new PartitionCache);
+    if (!_partitions->have_residues) {
+      _partitions->residues = GroupPartition::byResidue(*this);
+      _partitions->have_residues = true;
+    }
+    return(_partitions->residues);
+  }
 
-    // Now find atoms that are bound to the current atom and recurse
-    // through them...
 
-    std::vector<int> bonds = moi->getBonds();
-    std::vector<int>::const_iterator citer;
-    for (citer = bonds.begin(); citer != bonds.end(); citer++) {
-      pAtom toi = working.findById(*citer);
-      if (toi != 0)
-        walkBonds(current, seen, working, toi);
+  const GroupPartition& AtomicGroup::segidPartition() const {
+    if (!_partitions)
+      _partitions = boost::shared_ptr<PartitionCache>(new PartitionCache);
+    if (!_partitions->have_segids) {
+      _partitions->segids = GroupPartition::byUniqueSegid(*this);
+      _partitions->have_segids = true;
     }
+    return(_partitions->segids);
   }
 
 
@@ -538,35 +460,7 @@ namespace loos {
    * segid.
    */
   std::vector<AtomicGroup> AtomicGroup::splitByResidue(void) const {
-    std::vector<AtomicGroup> residues;
-
-    if (size() == 0) {
-      return(residues);
-    }
-    int curr_resid = atoms[0]->resid();
-    std::string curr_segid = atoms[0]->segid();
-
-    AtomicGroup residue;
-    AtomicGroup::const_iterator ci;
-    for (ci = atoms.begin(); ci != atoms.end(); ++ci) {
-      if (curr_resid != (*ci)->resid() || (*ci)->segid() != curr_segid) {
-        residues.push_back(residue);
-        residue = AtomicGroup();
-        curr_resid = (*ci)->resid();
-        curr_segid = (*ci)->segid();
-      }
-      residue.append(*ci);
-    }
-
-    if (residue.size() != 0)
-      residues.push_back(residue);
-
-
-    // Copy the box information
-    for (std::vector<AtomicGroup>::iterator i = residues.begin(); i != residues.end(); ++i)
-      i->box = box;
-
-    return(residues);
+    return(split(GroupPartition::byResidue(*this)));
   }
 
 
@@ -723,6 +617,7 @@ namespace loos {
       renumberWithBonds(*this, start, stride);
     else
       renumberWithoutBonds(*this, start, stride);
+    invalidatePartitions();
   }
 
   // Get the min and max atomid's...
@@ -993,6 +888,7 @@ namespace loos {
             pruned_bonds.push_back(*i);
         (*j)->setBonds(pruned_bonds);
       }
+    invalidatePartitions();
   }
 
 
@@ -1150,6 +1046,7 @@ namespace loos {
   void AtomicGroup::setGroupConnectivity() {
     for (AtomicGroup::iterator i = atoms.begin(); i != atoms.end(); ++i)
       (*i)->setProperty(Atom::bondsbit);
+    invalidatePartitions();
   }
 
 
@@ -1177,27 +1074,25 @@ namespace loos {
   }
 
   AtomicGroup AtomicGroup::centrifyByMolecule() const {
-    std::vector<AtomicGroup> mols = splitByMolecule();
-    AtomicGroup centers;
-    for (std::vector<AtomicGroup>::const_iterator i = mols.begin(); i != mols.end(); ++i) {
-      pAtom orig = (*i)[0];
-      pAtom atom(new Atom(*orig));
-      atom->name("CEN");
-      atom->coords((*i).centerOfMass());
-      centers.append(atom);
-    }
-    centers.box = box;
-    return(centers);
+    return(centrify(GroupPartition::byMolecule(*this)));
   }
 
   AtomicGroup AtomicGroup::centrifyByResidue() const {
-    std::vector<AtomicGroup> residues = splitByResidue();
+    return(centrify(GroupPartition::byResidue(*this)));
+  }
+
+  // One atom per part, a copy of the part's first atom placed at the
+  // part's center of mass
+  AtomicGroup AtomicGroup::centrify(const GroupPartition& partition) const {
+    std::vector<GCoord> coms = partition.centersOfMass(*this);
     AtomicGroup centers;
-    for (std::vector<AtomicGroup>::const_iterator i = residues.begin(); i != residues.end(); ++i) {
-      pAtom orig = (*i)[0];
+    for (uint g=0; g<partition.size(); ++g) {
+      if (partition.size(g) == 0)
+        throw(std::out_of_range("Bad index for an atom"));
+      pAtom orig = atoms[partition.positions()[partition.offsets()[g]]];
       pAtom atom(new Atom(*orig));
       atom->name("CEN");
-      atom->coords((*i).centerOfMass());
+      atom->coords(coms[g]);
       centers.append(atom);
     }
     centers.box = box;
@@ -1206,4 +1101,5 @@ namespace loos {
 
 
 
+
 }
@@ -42,6 +42,7 @@
 #include <Matrix.hpp>
 #include <FormFactor.hpp>
 #include <FormFactorSet.hpp>
+#include <GroupPartition.hpp>
 
 #include <exceptions.hpp>
 
@@ -133,13 +134,24 @@ namespace loos
       }
     }
 
-    //! Copy constructor (atoms and box shared)
+    //! Copy constructor (atoms and box shared, cached partitions are not)
     AtomicGroup(const AtomicGroup &g) : _sorted(g._sorted),
+                                        _partitions(),
                                         atoms(g.atoms),
                                         box(g.box)
     {
     }
 
+    //! Assignment (atoms and box shared, cached partitions are not)
+    AtomicGroup& operator=(const AtomicGroup &g)
+    {
+      _sorted = g._sorted;
+      _partitions.reset();
+      atoms = g.atoms;
+      box = g.box;
+      return(*this);
+    }
+
     virtual ~AtomicGroup() {}
 
     //! Creates a deep copy of this group
@@ -177,6 +189,7 @@ namespace loos
     {
       atoms.push_back(pa);
       _sorted = false;
+      invalidatePartitions();
       return (*this);
     }
     //! Append a vector of atoms
@@ -352,17 +365,12 @@ namespace loos
     //! Returns a vector of AtomicGroups split based on bond connectivity
     std::vector<AtomicGroup> splitByMolecule(void) const
     {
-      AtomicGroup sortable = *this;
-      return (sortable.sortingSplitByMolecule());
+      return (split(GroupPartition::byMolecule(*this)));
     }
 
     //! Takes selection string as argument to be applied to each group after splitting.
     //! Returns a vector of AtomicGroups split based on bond connectivity;
-    std::vector<AtomicGroup> splitByMolecule(const std::string &selection) const
-    {
-      AtomicGroup sortable = *this;
-      return (sortable.sortingSplitByMolecule(selection));
-    }
+    std::vector<AtomicGroup> splitByMolecule(const std::string &selection) const;
 
     //! Returns a vector of AtomicGroups, each comprising a single residue
     std::vector<AtomicGroup> splitByResidue(void) const;
@@ -370,6 +378,32 @@ namespace loos
     //! Returns a vector of AtomicGroups, each containing atoms with the same name
     std::map<std::string, AtomicGroup> splitByName(void) const;
 
+    //! Returns the parts of a partition of this group as AtomicGroups
+    std::vector<AtomicGroup> split(const GroupPartition &partition) const;
+
+    //! The molecules of this group (see splitByMolecule()), computed once and cached
+    /**
+     * The cached partitions are dropped whenever atoms are added to,
+     * removed from or reordered in this group, or its bonds are changed
+     * through the group (findBonds(), pruneBonds(), clearBonds(),
+     * renumber()...).  Changes made directly to the atoms (e.g. via
+     * Atom::setBonds() or Atom::resid()), through another group
+     * sharing them, or by assigning a different atom through the
+     * non-const operator[] or iterators (e.g. g[i] = pAtom(...)), are
+     * not seen, so call invalidatePartitions() after those.  The returned reference is good until the cache is
+     * dropped.  Filling the cache is not thread-safe.
+     */
+    const GroupPartition &moleculePartition() const;
+
+    //! The residues of this group (see splitByResidue()), computed once and cached
+    const GroupPartition &residuePartition() const;
+
+    //! The segments of this group (see splitByUniqueSegid()), computed once and cached
+    const GroupPartition &segidPartition() const;
+
+    //! Drops the cached partitions
+    void invalidatePartitions() const { _partitions.reset(); }
+
     //! Replace a group with the center of masses of contained molecules
     /**
      * The AtomicGroup is split into molecules.  A new group is constructed
@@ -404,6 +438,7 @@ namespace loos
 
     //! Output the group in pseudo-XML format...
     friend std::ostream &operator<<(std::ostream &os, const AtomicGroup &grp);
+    friend class AtomicGroupView;
 
     std::string asString() const;
 
@@ -889,6 +924,8 @@ namespace loos
         and the centroid of another AG, using a smooth logistic
         function
         S = 1/(1 + dist/radius)**sigma
+
+        sigma must be positive, otherwise a LOOSError is thrown.
      */
     double logisticContact(const AtomicGroup &group, double radius,
                            int sigma, const GCoord &box) const;
@@ -940,6 +977,9 @@ namespace loos
 
         Form factors are from Szaloki, X-ray Spectrometry (1996), V25, 21-28
 
+        This evaluates every pair exactly.  To compute scattering for many
+        frames, or with binned pair distances for large groups, use
+        DebyeScattering directly.
      */
     std::vector<double> scattering(const double qmin, const double max,
                                    const uint numValues,
@@ -972,35 +1012,7 @@ namespace loos
 
     // This function is to to remove code duplication in
     // logisticContacts() and logisticContacts2D().
-    // Handle even and odd powers separately -- even can
-    // avoid the sqrt
-    // Sigh, this doesnt' seem to make it much faster...
-    double logisticFunc(const GCoord &cent, const GCoord &other, double radius, int sigma, const GCoord &box) const
-    {
-      double prod;
-      if (sigma % 2 == 0)
-      {
-        double distance2 = cent.distance2(other, box);
-        double ratio = distance2 / (radius * radius);
-        prod = ratio;
-        for (int j = 0; j < (sigma / 2) - 1; ++j)
-        {
-          prod *= ratio;
-        }
-      }
-      else
-      {
-        double distance = cent.distance(other, box);
-        double ratio = distance / radius;
-        prod = ratio;
-        for (int j = 0; j < sigma - 1; ++j)
-        {
-          prod *= ratio;
-        }
-      }
-      double sum = 1. / (1. + prod);
-      return (sum);
-    }
+    double logisticFunc(const GCoord &cent, const GCoord &other, double radius, int sigma, const GCoord &box) const;
 
     // Find all atoms in the current group that are within dist
     // angstroms of any atom in the passed group.  The distance
@@ -1083,11 +1095,9 @@ namespace loos
           }
         }
       }
+      invalidatePartitions();
     }
 
-    std::vector<AtomicGroup> sortingSplitByMolecule();
-    std::vector<AtomicGroup> sortingSplitByMolecule(const std::string &selection);
-
     // *** Internal routines ***  See the .cpp file for details...
     void sorted(bool b) { _sorted = b; }
 
@@ -1100,6 +1110,7 @@ namespace loos
     {
       atoms.push_back(pa);
       _sorted = false;
+      invalidatePartitions();
     }
     void deleteAtom(pAtom pa);
 
@@ -1123,15 +1134,22 @@ namespace loos
       int id;
     };
 
-    typedef boost::unordered_set<int> HashInt;
-
-    void walkBonds(AtomicGroup &mygroup, HashInt &seen, AtomicGroup &working, pAtom &moi);
+    AtomicGroup centrify(const GroupPartition &partition) const;
 
     double *coordsAsArray(void) const;
     double *transformedCoordsAsArray(const XForm &) const;
 
     bool _sorted;
 
+    // Partitions cached by moleculePartition() and friends
+    struct PartitionCache
+    {
+      GroupPartition molecules, residues, segids;
+      bool have_molecules, have_residues, have_segids;
+      PartitionCache() : have_molecules(false), have_residues(false), have_segids(false) {}
+    };
+    mutable boost::shared_ptr<PartitionCache> _partitions;
+
   protected:
     void setGroupConnectivity();
 
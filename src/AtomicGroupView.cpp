@@ -0,0 +1,210 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#include <AtomicGroupView.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+
+namespace loos {
+
+  AtomicGroupView::AtomicGroupView(const AtomicGroup& parent, const uint offset, const uint len)
+    : parent_(&parent), positions_(0), first_(offset), size_(len)
+  {
+    if (offset > parent.size() || len > parent.size() - offset)
+      throw(std::range_error("Indices out of bounds for an AtomicGroupView"));
+  }
+
+
+  AtomicGroupView::AtomicGroupView(const AtomicGroup& parent, const GroupPartition& partition, const uint i)
+    : parent_(&parent), positions_(0), first_(0), size_(0)
+  {
+    if (i >= partition.size())
+      throw(std::range_error("Bad part index for an AtomicGroupView"));
+    size_ = partition.size(i);
+    if (size_ > 0)
+      positions_ = &partition.positions()[partition.offsets()[i]];
+  }
+
+
+  AtomicGroupView::AtomicGroupView(const AtomicGroup& parent, const std::vector<uint>& positions)
+    : parent_(&parent), positions_(positions.empty() ? 0 : &positions[0]), first_(0), size_(positions.size())
+  {
+    for (std::vector<uint>::const_iterator i = positions.begin(); i != positions.end(); ++i)
+      if (*i >= parent.size())
+        throw(std::range_error("Indices out of bounds for an AtomicGroupView"));
+  }
+
+
+  std::vector<AtomicGroupView> AtomicGroupView::split(const AtomicGroup& parent, const GroupPartition& partition) {
+    std::vector<AtomicGroupView> views;
+    views.reserve(partition.size());
+    for (uint i=0; i<partition.size(); ++i)
+      views.push_back(AtomicGroupView(parent, partition, i));
+    return(views);
+  }
+
+
+  pAtom AtomicGroupView::getAtom(const uint i) const {
+    if (i >= size_)
+      throw(std::out_of_range("Bad index for an atom"));
+    return((*this)[i]);
+  }
+
+
+  AtomicGroup AtomicGroupView::group() const {
+    AtomicGroup res;
+    res.atoms.reserve(size_);
+    for (uint i=0; i<size_; ++i)
+      res.atoms.push_back((*this)[i]);
+    res.box = parent_->box;
+    return(res);
+  }
+
+
+  void AtomicGroupView::periodicBox(const GCoord& c) const {
+    SharedPeriodicBox box = parent_->box;
+    box.box(c);
+  }
+
+
+  std::vector<GCoord> AtomicGroupView::boundingBox() const {
+    std::vector<GCoord> res(2);
+    GCoord c;
+
+    if (size_ == 0) {
+      res[0] = c;
+      res[1] = c;
+      return(res);
+    }
+
+    greal min[3], max[3];
+    const GCoord& x0 = (*this)[0]->coords();
+    for (uint k=0; k<3; ++k)
+      min[k] = max[k] = x0[k];
+
+    for (uint i=1; i<size_; ++i) {
+      const GCoord& x = (*this)[i]->coords();
+      for (uint k=0; k<3; ++k) {
+        if (max[k] < x[k])
+          max[k] = x[k];
+        if (min[k] > x[k])
+          min[k] = x[k];
+      }
+    }
+
+    c.set(min[0], min[1], min[2]);
+    res[0] = c;
+    c.set(max[0], max[1], max[2]);
+    res[1] = c;
+    return(res);
+  }
+
+
+  GCoord AtomicGroupView::centroid() const {
+    if (size_ == 1)
+      return((*this)[0]->coords());
+
+    GCoord c(0,0,0);
+    for (uint i=0; i<size_; ++i)
+      c += (*this)[i]->coords();
+    c /= size_;
+    return(c);
+  }
+
+
+  GCoord AtomicGroupView::centerOfMass() const {
+    if (size_ == 1)
+      return((*this)[0]->coords());
+
+    GCoord c(0,0,0);
+    for (uint i=0; i<size_; ++i) {
+      const pAtom& atom = (*this)[i];
+      c += atom->mass() * atom->coords();
+    }
+    c /= totalMass();
+    return(c);
+  }
+
+
+  greal AtomicGroupView::totalMass() const {
+    greal mass = 0.0;
+    for (uint i=0; i<size_; ++i)
+      mass += (*this)[i]->mass();
+    return(mass);
+  }
+
+
+  greal AtomicGroupView::radius(const bool use_atom_as_reference) const {
+    GCoord c = use_atom_as_reference ? getAtom(0)->coords() : centroid();
+    greal radius = 0.0;
+    for (uint i=0; i<size_; ++i) {
+      greal d = c.distance2((*this)[i]->coords());
+      if (d > radius)
+        radius = d;
+    }
+    return(sqrt(radius));
+  }
+
+
+  greal AtomicGroupView::radiusOfGyration() const {
+    GCoord c = centerOfMass();
+    greal radius = 0;
+    for (uint i=0; i<size_; ++i)
+      radius += c.distance2((*this)[i]->coords());
+    return(sqrt(radius / size_));
+  }
+
+
+  std::vector<uint> AtomicGroupView::atomIndices() const {
+    std::vector<uint> indices(size_);
+    for (uint i=0; i<size_; ++i) {
+      const pAtom& atom = (*this)[i];
+      if (!atom->checkProperty(Atom::indexbit))
+        throw(LOOSError(*atom, "Atom has an unset index property and cannot be used to read a trajectory."));
+      indices[i] = atom->index();
+    }
+    return(indices);
+  }
+
+
+  void AtomicGroupView::getCoords(double* crds) const {
+    for (uint i=0; i<size_; ++i) {
+      const GCoord& x = (*this)[i]->coords();
+      crds[3*i] = x[0];
+      crds[3*i+1] = x[1];
+      crds[3*i+2] = x[2];
+    }
+  }
+
+
+  void AtomicGroupView::setCoords(const double* crds) const {
+    for (uint i=0; i<size_; ++i)
+      (*this)[i]->coords(GCoord(crds[3*i], crds[3*i+1], crds[3*i+2]));
+  }
+
+}
@@ -0,0 +1,147 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#if !defined(LOOS_ATOMICGROUPVIEW_HPP)
+#define LOOS_ATOMICGROUPVIEW_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <GroupPartition.hpp>
+
+
+namespace loos {
+
+  //! A read-only, non-owning view of some of the atoms of an AtomicGroup
+  /**
+   * A view refers to its parent group and either a contiguous range of
+   * the parent's atoms or a list of positions in the parent (such as
+   * one part of a GroupPartition).  Making or copying a view does not
+   * allocate or touch any atom reference counts, so thousands of
+   * per-residue views can be made and thrown away every frame.
+   *
+   * The numerical methods give exactly what the same methods of an
+   * AtomicGroup holding the same atoms, in the same order, would give.
+   * Since the atoms are shared with the parent, reading a frame into
+   * the parent (or calling setCoords() on the view) updates the view.
+   * When the parent has a periodic box, the view uses it.
+   *
+   * The parent, and the position list or partition a view was made
+   * from, must outlive the view and must not change while it is in use.
+   * Making a view of a temporary is therefore a compile error.  Use
+   * group() to get an ordinary AtomicGroup with the same atoms.
+   */
+  class AtomicGroupView {
+  public:
+    //! All of parent
+    explicit AtomicGroupView(const AtomicGroup& parent)
+      : parent_(&parent), positions_(0), first_(0), size_(parent.size()) { }
+
+    //! len atoms of parent starting at offset
+    AtomicGroupView(const AtomicGroup& parent, const uint offset, const uint len);
+
+    //! Part i of a partition of parent
+    AtomicGroupView(const AtomicGroup& parent, const GroupPartition& partition, const uint i);
+
+    //! The atoms at the given positions in parent, which are not copied
+    AtomicGroupView(const AtomicGroup& parent, const std::vector<uint>& positions);
+
+#if !defined(SWIG)
+    // The view would outlive these
+    explicit AtomicGroupView(AtomicGroup&&) = delete;
+    AtomicGroupView(AtomicGroup&&, const uint, const uint) = delete;
+    AtomicGroupView(const AtomicGroup&, GroupPartition&&, const uint) = delete;
+    AtomicGroupView(const AtomicGroup&, std::vector<uint>&&) = delete;
+
+    //! A view of each part of a partition of parent
+    static std::vector<AtomicGroupView> split(const AtomicGroup& parent, const GroupPartition& partition);
+#endif
+
+    uint size() const { return(size_); }
+    bool empty() const { return(size_ == 0); }
+
+    //! The group this is a view of
+    const AtomicGroup& parent() const { return(*parent_); }
+
+    //! Position in the parent of the ith atom of the view
+    uint position(const uint i) const { return(positions_ ? positions_[i] : first_ + i); }
+
+#if !defined(SWIG)
+    //! The ith atom of the view (no range check)
+    const pAtom& operator[](const uint i) const { return(parent_->begin()[position(i)]); }
+#endif
+
+    //! The ith atom of the view
+    pAtom getAtom(const uint i) const;
+
+    //! Copies the view into a new AtomicGroup sharing the atoms and box
+    AtomicGroup group() const;
+
+    bool isPeriodic() const { return(parent_->isPeriodic()); }
+    GCoord periodicBox() const { return(parent_->periodicBox()); }
+
+    //! Sets the periodic box, which is shared with the parent
+    void periodicBox(const GCoord& c) const;
+
+    //! Bounding box of the atoms (see AtomicGroup::boundingBox())
+    std::vector<GCoord> boundingBox() const;
+
+    //! Centroid of the atoms (see AtomicGroup::centroid())
+    GCoord centroid() const;
+
+    //! Center of mass of the atoms (see AtomicGroup::centerOfMass())
+    GCoord centerOfMass() const;
+
+    //! Total mass of the atoms
+    greal totalMass() const;
+
+    //! Maximum distance from the centroid (see AtomicGroup::radius())
+    greal radius(const bool use_atom_as_reference = false) const;
+
+    //! Radius of gyration (see AtomicGroup::radiusOfGyration())
+    greal radiusOfGyration() const;
+
+    //! Trajectory indices of the atoms, as used by Trajectory::readFrames()
+    std::vector<uint> atomIndices() const;
+
+#if !defined(SWIG)
+    //! Copies the coordinates out as x, y, z per atom
+    void getCoords(double* crds) const;
+
+    //! Sets the coordinates of the atoms from x, y, z per atom
+    void setCoords(const double* crds) const;
+#endif
+
+  private:
+    const AtomicGroup* parent_;
+    const uint* positions_;
+    uint first_, size_;
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,207 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include <ContactHistory.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <algorithm>
+
+
+namespace loos {
+
+  namespace {
+
+    inline uint popcount(const uint64_t x) {
+#if defined(__GNUC__)
+      return(__builtin_popcountll(x));
+#else
+      uint64_t v = x - ((x >> 1) & 0x5555555555555555ULL);
+      v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+      v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+      return((v * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // Mask keeping the low n bits (n <= 64)
+    inline uint64_t lowBits(const uint n) {
+      return(n >= 64 ? ~static_cast<uint64_t>(0) : ((static_cast<uint64_t>(1) << n) - 1));
+    }
+
+  }
+
+
+  ContactHistory::ContactHistory(const uint num_entities, const uint frame_hint)
+    : bits_(num_entities), nframes_(0)
+  {
+    if (frame_hint > 0)
+      for (uint i=0; i<num_entities; ++i)
+        bits_[i].reserve((frame_hint + 63) / 64);
+  }
+
+
+  void ContactHistory::newFrame() {
+    if (nframes_ % 64 == 0)
+      for (uint i=0; i<bits_.size(); ++i)
+        bits_[i].push_back(0);
+    ++nframes_;
+  }
+
+
+  void ContactHistory::mark(const uint entity) {
+    if (nframes_ == 0)
+      throw(LOOSError("ContactHistory::mark() called before any frames were added"));
+    if (entity >= bits_.size())
+      throw(LOOSError("Entity index out of range in ContactHistory"));
+
+    uint f = nframes_ - 1;
+    bits_[entity][f / 64] |= static_cast<Word>(1) << (f % 64);
+  }
+
+
+  void ContactHistory::addFrame(const std::vector<bool>& present) {
+    if (present.size() != bits_.size())
+      throw(LOOSError("Frame size does not match the number of entities in ContactHistory"));
+
+    newFrame();
+    for (uint i=0; i<present.size(); ++i)
+      if (present[i])
+        mark(i);
+  }
+
+
+  bool ContactHistory::present(const uint entity, const uint frame) const {
+    if (entity >= bits_.size() || frame >= nframes_)
+      throw(LOOSError("Index out of range in ContactHistory"));
+    return((bits_[entity][frame / 64] >> (frame % 64)) & 1);
+  }
+
+
+  ContactHistory::Word ContactHistory::shiftedWord(const std::vector<Word>& w, const uint k, const uint offset) const {
+    uint q = k + offset / 64;
+    uint r = offset % 64;
+    Word lo = q < w.size() ? w[q] : 0;
+    if (r == 0)
+      return(lo);
+    Word hi = q + 1 < w.size() ? w[q+1] : 0;
+    return((lo >> r) | (hi << (64 - r)));
+  }
+
+
+  ulong ContactHistory::occupied(const uint entity, const uint first, const uint last) const {
+    if (entity >= bits_.size())
+      throw(LOOSError("Entity index out of range in ContactHistory"));
+
+    uint end = std::min(last, nframes_);
+    if (first >= end)
+      return(0);
+
+    const std::vector<Word>& w = bits_[entity];
+    uint n = end - first;
+    ulong count = 0;
+    uint k = 0;
+    for (; 64 * (k + 1) <= n; ++k)
+      count += popcount(shiftedWord(w, k, first));
+    if (64 * k < n)
+      count += popcount(shiftedWord(w, k, first) & lowBits(n - 64 * k));
+
+    return(count);
+  }
+
+
+  ulong ContactHistory::survived(const uint entity, const uint lag, const uint nstarts) const {
+    if (entity >= bits_.size())
+      throw(LOOSError("Entity index out of range in ContactHistory"));
+
+    if (lag >= nframes_)
+      return(0);
+    uint n = std::min(nstarts, nframes_ - lag);
+
+    const std::vector<Word>& w = bits_[entity];
+    ulong count = 0;
+    uint k = 0;
+    for (; 64 * (k + 1) <= n; ++k)
+      count += popcount(w[k] & shiftedWord(w, k, lag));
+    if (64 * k < n)
+      count += popcount(w[k] & shiftedWord(w, k, lag) & lowBits(n - 64 * k));
+
+    return(count);
+  }
+
+
+  std::vector<double> ContactHistory::survivalProbability(const uint max_lag, const uint nthreads) const {
+    const uint nchunks = std::max(1u, std::min(static_cast<uint>(bits_.size()),
+                                               nthreads == 0 ? 64u : nthreads));
+    std::vector< std::vector<ulong> > both(nchunks, std::vector<ulong>(max_lag, 0));
+    std::vector< std::vector<ulong> > starts(nchunks, std::vector<ulong>(max_lag, 0));
+
+    internal::parallelFor(nchunks, nthreads, [&](uint chunk) {
+        std::vector<ulong>& b = both[chunk];
+        std::vector<ulong>& s = starts[chunk];
+        for (uint i=chunk; i<bits_.size(); i += nchunks)
+          for (uint t=0; t<max_lag && t<nframes_; ++t) {
+            b[t] += survived(i, t, nframes_ - t);
+            s[t] += occupied(i, 0, nframes_ - t);
+          }
+      });
+
+    std::vector<double> prob(max_lag);
+    for (uint t=0; t<max_lag; ++t) {
+      ulong b = 0, s = 0;
+      for (uint c=0; c<nchunks; ++c) {
+        b += both[c][t];
+        s += starts[c][t];
+      }
+      prob[t] = static_cast<double>(b) / s;
+    }
+
+    return(prob);
+  }
+
+
+  std::vector<uint> ContactHistory::residenceTimes(const uint entity) const {
+    std::vector<uint> times;
+    uint run = 0;
+    for (uint f=0; f<nframes_; ++f) {
+      if (present(entity, f))
+        ++run;
+      else if (run) {
+        times.push_back(run);
+        run = 0;
+      }
+    }
+    if (run)
+      times.push_back(run);
+
+    return(times);
+  }
+
+
+  void ContactHistory::clear() {
+    for (uint i=0; i<bits_.size(); ++i)
+      bits_[i].clear();
+    nframes_ = 0;
+  }
+
+}
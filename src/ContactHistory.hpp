@@ -0,0 +1,110 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_CONTACTHISTORY_HPP)
+#define LOOS_CONTACTHISTORY_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  //! Per-frame presence/absence of a set of entities, packed one bit per frame
+  /**
+   * Holds, for each entity (e.g. a lipid or a water), whether it was
+   * "in contact" in each frame.  Frames are streamed in one at a time
+   * with newFrame() and mark() (or addFrame()), and each entity's
+   * history is stored as a bitset, so 10^4 entities over 10^5 frames
+   * take about 125MB rather than the gigabytes a matrix of ints or
+   * doubles needs.
+   *
+   * Lagged queries work a 64-bit word at a time with popcounts.
+   * The survival probability at lag t is the fraction of frames where
+   * an entity was present that it is also present t frames later.
+   */
+  class ContactHistory {
+  public:
+    //! Track num_entities entities, reserving room for frame_hint frames
+    explicit ContactHistory(const uint num_entities = 0, const uint frame_hint = 0);
+
+    //! Number of entities tracked
+    uint entities() const { return(bits_.size()); }
+
+    //! Number of frames streamed in so far
+    uint frames() const { return(nframes_); }
+
+    //! Start a new frame with every entity absent
+    void newFrame();
+
+    //! Mark entity as present in the most recent frame
+    void mark(const uint entity);
+
+    //! Append a frame, where present[i] says if the i'th entity is present
+    void addFrame(const std::vector<bool>& present);
+
+    //! Was entity present in the given frame?
+    bool present(const uint entity, const uint frame) const;
+
+    //! Number of frames in [first, last) where entity is present
+    ulong occupied(const uint entity, const uint first, const uint last) const;
+
+    //! Number of frames t in [0, nstarts) where entity is present at t and at t+lag
+    /**
+     * nstarts is clipped to frames() - lag, so starting points that
+     * would look past the last frame are not counted.
+     */
+    ulong survived(const uint entity, const uint lag, const uint nstarts) const;
+
+    //! Survival probability pooled over all entities, for lags [0, max_lag)
+    /**
+     * The value at lag t is the number of (entity, frame) pairs present
+     * at both frame and frame+t, divided by the number present at frame,
+     * counting frames with frame+t inside the trajectory.  Entities are
+     * divided among nthreads threads (0 = all cores).
+     */
+    std::vector<double> survivalProbability(const uint max_lag, const uint nthreads = 0) const;
+
+    //! Lengths of each unbroken stretch of frames where entity is present
+    std::vector<uint> residenceTimes(const uint entity) const;
+
+    //! Forget all frames (the number of entities is kept)
+    void clear();
+
+  private:
+    typedef uint64_t Word;
+
+    // Bits of entity's history starting at frame 64*k + offset
+    Word shiftedWord(const std::vector<Word>& w, const uint k, const uint offset) const;
+
+    std::vector< std::vector<Word> > bits_;
+    uint nframes_;
+  };
+
+}
+
+
+#endif
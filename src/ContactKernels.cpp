@@ -0,0 +1,296 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include <ContactKernels.hpp>
+#include <AtomicGroup.hpp>
+#include <exceptions.hpp>
+
+#include <algorithm>
+
+
+namespace loos {
+
+  namespace {
+
+    // Same arithmetic as GCoord::reimage() for one component
+    inline double minImage(const double d, const double box) {
+      int n = (int)(fabs(d) / box + 0.5);
+      return((d >= 0) ? d - n * box : d + n * box);
+    }
+
+
+    // Cell list over a set of points in a periodic box.  Cells are at
+    // least cutoff wide, so every point within cutoff of p (minimum
+    // image) is in one of the 27 cells around p's cell (9 if planar).
+    // When the box holds fewer than 3 cells along a side, the grid is
+    // not usable and callers fall back to checking every pair.
+    class CellGrid {
+    public:
+      CellGrid(const std::vector<double>& pts, const GCoord& box, const double cutoff, const bool planar)
+        : planar_(planar), box_(box)
+      {
+        uint n = pts.size() / 3;
+        uint cap = std::max(3, static_cast<int>(2.0 * cbrt(static_cast<double>(std::max(1u, n)))));
+        usable_ = cutoff > 0.0;
+        for (uint k=0; k<3; ++k) {
+          if (planar_ && k == 2) {
+            dims_[k] = 1;
+            continue;
+          }
+          double m = floor(box[k] / cutoff);
+          if (!(m >= 3.0))
+            usable_ = false;
+          dims_[k] = static_cast<uint>(std::min(static_cast<double>(cap), std::max(1.0, m)));
+        }
+        if (!usable_)
+          return;
+
+        std::vector<uint> cell(n);
+        for (uint i=0; i<n; ++i)
+          cell[i] = cellOf(&pts[3*i]);
+
+        uint ncells = dims_[0] * dims_[1] * dims_[2];
+        start_.assign(ncells + 1, 0);
+        for (uint i=0; i<n; ++i)
+          ++start_[cell[i] + 1];
+        for (uint c=0; c<ncells; ++c)
+          start_[c+1] += start_[c];
+        members_.resize(n);
+        std::vector<uint> fill(start_.begin(), start_.end() - 1);
+        for (uint i=0; i<n; ++i)
+          members_[fill[cell[i]]++] = i;
+      }
+
+      bool usable() const { return(usable_); }
+
+      // Calls f(j) for every point in the cells around p
+      template<typename F>
+      void forNeighbors(const double* p, F f) const {
+        uint c = cellOf(p);
+        int ci[3] = { static_cast<int>(c % dims_[0]), static_cast<int>((c / dims_[0]) % dims_[1]), static_cast<int>(c / (dims_[0] * dims_[1])) };
+        int zr = planar_ ? 0 : 1;
+        for (int dz=-zr; dz<=zr; ++dz) {
+          uint z = wrap(ci[2] + dz, dims_[2]);
+          for (int dy=-1; dy<=1; ++dy) {
+            uint y = wrap(ci[1] + dy, dims_[1]);
+            for (int dx=-1; dx<=1; ++dx) {
+              uint x = wrap(ci[0] + dx, dims_[0]);
+              uint nc = (z * dims_[1] + y) * dims_[0] + x;
+              for (uint m=start_[nc]; m<start_[nc+1]; ++m)
+                f(members_[m]);
+            }
+          }
+        }
+      }
+
+    private:
+      static uint wrap(const int i, const uint n) {
+        return(i < 0 ? i + n : (i >= static_cast<int>(n) ? i - n : i));
+      }
+
+      uint cellOf(const double* p) const {
+        uint c[3] = {0, 0, 0};
+        for (uint k=0; k<3; ++k) {
+          if (dims_[k] == 1)
+            continue;
+          double x = p[k] - box_[k] * floor(p[k] / box_[k]);
+          c[k] = std::min(dims_[k] - 1, static_cast<uint>(x * dims_[k] / box_[k]));
+        }
+        return((c[2] * dims_[1] + c[1]) * dims_[0] + c[0]);
+      }
+
+      bool planar_, usable_;
+      GCoord box_;
+      uint dims_[3];
+      std::vector<uint> start_, members_;
+    };
+
+
+    std::vector<double> centroids(const std::vector<AtomicGroup>& groups, const bool planar) {
+      std::vector<double> c(3 * groups.size());
+      for (uint i=0; i<groups.size(); ++i) {
+        GCoord x = groups[i].centroid();
+        if (planar)
+          x.z() = 0.;
+        c[3*i] = x[0];
+        c[3*i+1] = x[1];
+        c[3*i+2] = x[2];
+      }
+      return(c);
+    }
+
+
+    // Index of (i, j), i < j, in the (0,1), (0,2), ..., (1,2), ... order
+    inline ulong packedIndex(const ulong i, const ulong j, const ulong n) {
+      return(i * n - (i * (i + 1)) / 2 + (j - i - 1));
+    }
+
+
+    inline double distance2(const double* a, const double* b, const GCoord& box) {
+      double dx = minImage(b[0] - a[0], box[0]);
+      double dy = minImage(b[1] - a[1], box[1]);
+      double dz = minImage(b[2] - a[2], box[2]);
+      return(dx*dx + dy*dy + dz*dz);
+    }
+
+
+    // Calls f(i, j, d2) for every pair i < j of centroids within cutoff
+    // (every pair if cutoff is not positive or the grid can't be used)
+    template<typename F>
+    void centroidPairs(const std::vector<double>& c, const GCoord& box, const double cutoff,
+                       const bool planar, F f) {
+      uint n = c.size() / 3;
+      CellGrid grid(c, box, cutoff, planar);
+
+      if (!grid.usable()) {
+        for (uint i=0; i<n; ++i)
+          for (uint j=i+1; j<n; ++j)
+            f(i, j, distance2(&c[3*i], &c[3*j], box));
+        return;
+      }
+
+      double cut2 = cutoff * cutoff;
+      for (uint i=0; i<n; ++i)
+        grid.forNeighbors(&c[3*i], [&](const uint j) {
+            if (j <= i)
+              return;
+            double d2 = distance2(&c[3*i], &c[3*j], box);
+            if (d2 <= cut2)
+              f(i, j, d2);
+          });
+    }
+
+  }
+
+
+
+  std::vector< std::vector<double> > packingScores(const std::vector<AtomicGroup>& groups,
+                                                   const std::vector<AtomicGroup>& probes,
+                                                   const GCoord& box,
+                                                   const bool norm,
+                                                   const double cutoff) {
+    std::vector< std::vector<double> > scores(groups.size(), std::vector<double>(probes.size(), 0.0));
+
+    // Probe atoms, flattened, with the probe each belongs to
+    std::vector<double> pts;
+    std::vector<uint> offsets(1, 0), owner;
+    for (uint p=0; p<probes.size(); ++p) {
+      for (AtomicGroup::const_iterator a = probes[p].begin(); a != probes[p].end(); ++a) {
+        const GCoord& x = (*a)->coords();
+        pts.push_back(x[0]);
+        pts.push_back(x[1]);
+        pts.push_back(x[2]);
+        owner.push_back(p);
+      }
+      offsets.push_back(owner.size());
+    }
+
+    CellGrid grid(pts, box, cutoff, false);
+
+    if (cutoff > 0.0 && grid.usable()) {
+      double cut2 = cutoff * cutoff;
+      for (uint g=0; g<groups.size(); ++g) {
+        std::vector<double>& row = scores[g];
+        for (AtomicGroup::const_iterator a = groups[g].begin(); a != groups[g].end(); ++a) {
+          const GCoord& x = (*a)->coords();
+          double u[3] = { x[0], x[1], x[2] };
+          grid.forNeighbors(u, [&](const uint j) {
+              double d2 = distance2(u, &pts[3*j], box);
+              if (d2 < cut2)
+                row[owner[j]] += 1./(d2 * d2 * d2);
+            });
+        }
+      }
+
+    } else {
+      double cut2 = cutoff > 0.0 ? cutoff * cutoff : 0.0;
+      for (uint g=0; g<groups.size(); ++g)
+        for (uint p=0; p<probes.size(); ++p) {
+          double score = 0.0;
+          for (AtomicGroup::const_iterator a = groups[g].begin(); a != groups[g].end(); ++a) {
+            const GCoord& x = (*a)->coords();
+            double u[3] = { x[0], x[1], x[2] };
+            for (uint j=offsets[p]; j<offsets[p+1]; ++j) {
+              double d2 = distance2(u, &pts[3*j], box);
+              if (cut2 == 0.0 || d2 < cut2)
+                score += 1./(d2 * d2 * d2);
+            }
+          }
+          scores[g][p] = score;
+        }
+    }
+
+    if (norm)
+      for (uint g=0; g<groups.size(); ++g)
+        for (uint p=0; p<probes.size(); ++p)
+          scores[g][p] /= groups[g].size() * probes[p].size();
+
+    return(scores);
+  }
+
+
+  std::vector<double> logisticContacts(const std::vector<AtomicGroup>& groups,
+                                       const double radius, const int sigma,
+                                       const GCoord& box,
+                                       const bool planar,
+                                       const double tol) {
+    if (sigma <= 0)
+      throw(LOOSError("Logistic contacts need a positive sigma"));
+
+    ulong n = groups.size();
+    std::vector<double> result(n * (n - (n > 0)) / 2, 0.0);
+    std::vector<double> c = centroids(groups, planar);
+
+    // Beyond this distance the contact is below tol
+    double cutoff = 0.0;
+    if (tol > 0.0 && tol < 1.0) {
+      cutoff = radius * pow(1.0 / tol - 1.0, 1.0 / sigma);
+    }
+
+    centroidPairs(c, box, cutoff, planar, [&](const uint i, const uint j, const double d2) {
+        result[packedIndex(i, j, n)] = internal::logistic(d2, radius, sigma);
+      });
+
+    return(result);
+  }
+
+
+  std::vector<double> hardContacts(const std::vector<AtomicGroup>& groups,
+                                   const double radius,
+                                   const GCoord& box,
+                                   const bool planar) {
+    ulong n = groups.size();
+    std::vector<double> result(n * (n - (n > 0)) / 2, 0.0);
+    std::vector<double> c = centroids(groups, planar);
+
+    double r2 = radius * radius;
+    centroidPairs(c, box, radius, planar, [&](const uint i, const uint j, const double d2) {
+        if (d2 <= r2)
+          result[packedIndex(i, j, n)] = 1.;
+      });
+
+    return(result);
+  }
+
+}
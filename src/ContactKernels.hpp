@@ -0,0 +1,119 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_CONTACTKERNELS_HPP)
+#define LOOS_CONTACTKERNELS_HPP
+
+#include <vector>
+#include <cmath>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  class AtomicGroup;
+
+  //! Packing score between every group and every probe
+  /**
+   * result[i][j] is groups[i].packingScore(probes[j], box, norm), the
+   * sum of 1/r^6 over all atom pairs using the minimum image.  The
+   * probe coordinates are gathered once into flat arrays rather than
+   * being fetched for every pair.
+   *
+   * If cutoff is positive, only atom pairs closer than cutoff
+   * contribute.  They are found with a cell list over the probe atoms,
+   * so the cost no longer grows with the product of the group sizes.
+   * The part of the sum beyond the cutoff falls off as 1/cutoff^3.
+   */
+  std::vector< std::vector<double> > packingScores(const std::vector<AtomicGroup>& groups,
+                                                   const std::vector<AtomicGroup>& probes,
+                                                   const GCoord& box,
+                                                   const bool norm = false,
+                                                   const double cutoff = 0.0);
+
+  //! Logistic contact between the centroids of every pair of groups
+  /**
+   * Returns groups[i].logisticContact(groups[j], radius, sigma, box)
+   * (or logisticContact2D() if planar) for each i < j, in the order
+   * (0,1), (0,2), ..., (1,2), ...  Each centroid is only computed once.
+   *
+   * If tol is positive, pairs whose contact would be below tol are left
+   * at 0 without being evaluated.  The remaining pairs are found with a
+   * cell list over the centroids.
+   *
+   * Throws a LOOSError if sigma is not positive.
+   */
+  std::vector<double> logisticContacts(const std::vector<AtomicGroup>& groups,
+                                       const double radius, const int sigma,
+                                       const GCoord& box,
+                                       const bool planar = false,
+                                       const double tol = 0.0);
+
+  //! Hard contact between the centroids of every pair of groups
+  /**
+   * Same ordering as logisticContacts(): 1 for each pair i < j whose
+   * centroids are within radius (hardContact(), or hardContact2D() if
+   * planar), otherwise 0.
+   */
+  std::vector<double> hardContacts(const std::vector<AtomicGroup>& groups,
+                                   const double radius,
+                                   const GCoord& box,
+                                   const bool planar = false);
+
+
+#if !defined(SWIG)
+  namespace internal {
+
+    //! The logistic contact 1/(1 + (d/radius)^sigma) given d^2
+    /**
+     * Even powers work from d^2 and avoid the sqrt.  sigma must be
+     * positive; the public entry points reject anything else.
+     */
+    inline double logistic(const double d2, const double radius, const int sigma) {
+      double ratio;
+      int power;
+      if (sigma % 2 == 0) {
+        ratio = d2 / (radius * radius);
+        power = sigma / 2;
+      } else {
+        ratio = sqrt(d2) / radius;
+        power = sigma;
+      }
+
+      double prod = ratio;
+      for (int j = 0; j < power - 1; ++j)
+        prod *= ratio;
+
+      return(1. / (1. + prod));
+    }
+
+  }
+#endif
+
+}
+
+
+#endif
@@ -0,0 +1,334 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include <ContactMap.hpp>
+#include <Trajectory.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace loos {
+
+  namespace {
+
+    // Added to the bounding-sphere tests so round-off can never reject
+    // a pair that the atom-by-atom test would accept
+    const double sphere_slack = 1e-6;
+
+  }
+
+
+  ContactMap::ContactMap(const std::vector<AtomicGroup>& groups, const double cutoff,
+                         const bool use_centers, const uint nthreads)
+    : cutoff_(cutoff), use_centers_(use_centers), nthreads_(nthreads), nframes_(0)
+  {
+    offsets_.push_back(0);
+    for (std::vector<AtomicGroup>::const_iterator g = groups.begin(); g != groups.end(); ++g) {
+      if (g->empty())
+        throw(LOOSError("Cannot build a contact map with an empty group"));
+
+      double total = 0.0;
+      for (AtomicGroup::const_iterator i = g->begin(); i != g->end(); ++i) {
+        atoms_.append(*i);
+        masses_.push_back((*i)->mass());
+        total += (*i)->mass();
+      }
+      total_mass_.push_back(total);
+      offsets_.push_back(atoms_.size());
+    }
+
+    ulong n = groups.size();
+    counts_.assign(n * (n - (n > 0)) / 2, 0);
+  }
+
+
+  // Pairs (i, j), i < j, whose points lie in the same or adjacent cells
+  // of a grid at least width wide, i.e. every pair closer than width
+  // (and some further apart)
+  void ContactMap::cellPairs(const std::vector<double>& centers, const double width,
+                             std::vector<uint>& firsts, std::vector<uint>& seconds) const {
+    const uint n = centers.size() / 3;
+    if (n < 2)
+      return;
+
+    double lo[3], hi[3];
+    for (uint k=0; k<3; ++k)
+      lo[k] = hi[k] = centers[k];
+    for (uint i=1; i<n; ++i)
+      for (uint k=0; k<3; ++k) {
+        lo[k] = std::min(lo[k], centers[3*i+k]);
+        hi[k] = std::max(hi[k], centers[3*i+k]);
+      }
+
+    // Cap the grid so mostly-empty space doesn't cost more than the points
+    const uint cap = std::max(1, static_cast<int>(2.0 * cbrt(static_cast<double>(n))));
+    uint dims[3];
+    double scale[3];
+    for (uint k=0; k<3; ++k) {
+      double extent = hi[k] - lo[k];
+      uint m = width > 0.0 ? static_cast<uint>(std::min(static_cast<double>(cap), floor(extent / width))) : cap;
+      dims[k] = std::max(1u, m);
+      scale[k] = extent > 0.0 ? dims[k] / extent : 0.0;
+    }
+
+    std::vector<uint> cell(n);
+    for (uint i=0; i<n; ++i) {
+      uint c[3];
+      for (uint k=0; k<3; ++k)
+        c[k] = std::min(dims[k] - 1, static_cast<uint>((centers[3*i+k] - lo[k]) * scale[k]));
+      cell[i] = (c[2] * dims[1] + c[1]) * dims[0] + c[0];
+    }
+
+    const uint ncells = dims[0] * dims[1] * dims[2];
+    std::vector<uint> start(ncells + 1, 0);
+    for (uint i=0; i<n; ++i)
+      ++start[cell[i] + 1];
+    for (uint c=0; c<ncells; ++c)
+      start[c+1] += start[c];
+    std::vector<uint> members(n);
+    std::vector<uint> fill(start.begin(), start.end() - 1);
+    for (uint i=0; i<n; ++i)
+      members[fill[cell[i]]++] = i;
+
+    for (uint i=0; i<n; ++i) {
+      uint c[3] = { cell[i] % dims[0], (cell[i] / dims[0]) % dims[1], cell[i] / (dims[0] * dims[1]) };
+      for (int dz=-1; dz<=1; ++dz) {
+        int z = c[2] + dz;
+        if (z < 0 || z >= static_cast<int>(dims[2]))
+          continue;
+        for (int dy=-1; dy<=1; ++dy) {
+          int y = c[1] + dy;
+          if (y < 0 || y >= static_cast<int>(dims[1]))
+            continue;
+          for (int dx=-1; dx<=1; ++dx) {
+            int x = c[0] + dx;
+            if (x < 0 || x >= static_cast<int>(dims[0]))
+              continue;
+            uint nc = (z * dims[1] + y) * dims[0] + x;
+            for (uint m=start[nc]; m<start[nc+1]; ++m)
+              if (members[m] > i) {
+                firsts.push_back(i);
+                seconds.push_back(members[m]);
+              }
+          }
+        }
+      }
+    }
+  }
+
+
+  void ContactMap::centerContacts(const double* crds, std::vector<ulong>& found) const {
+    const uint n = size();
+    std::vector<double> c(3 * n);
+
+    // Same arithmetic as AtomicGroup::centerOfMass()
+    for (uint g=0; g<n; ++g) {
+      const double* x = crds + 3 * offsets_[g];
+      if (offsets_[g+1] - offsets_[g] == 1) {
+        std::copy(x, x + 3, &c[3*g]);
+        continue;
+      }
+      double cx = 0.0, cy = 0.0, cz = 0.0;
+      for (uint i=offsets_[g]; i<offsets_[g+1]; ++i, x += 3) {
+        cx += masses_[i] * x[0];
+        cy += masses_[i] * x[1];
+        cz += masses_[i] * x[2];
+      }
+      c[3*g] = cx / total_mass_[g];
+      c[3*g+1] = cy / total_mass_[g];
+      c[3*g+2] = cz / total_mass_[g];
+    }
+
+    std::vector<uint> firsts, seconds;
+    cellPairs(c, cutoff_, firsts, seconds);
+
+    const double cut2 = cutoff_ * cutoff_;
+    for (uint p=0; p<firsts.size(); ++p) {
+      const double* u = &c[3 * firsts[p]];
+      const double* v = &c[3 * seconds[p]];
+      double dx = u[0] - v[0];
+      double dy = u[1] - v[1];
+      double dz = u[2] - v[2];
+      if (dx*dx + dy*dy + dz*dz <= cut2)
+        found.push_back(packedIndex(firsts[p], seconds[p]));
+    }
+  }
+
+
+  void ContactMap::sphereContacts(const double* crds, std::vector<ulong>& found) const {
+    const uint n = size();
+    std::vector<double> c(3 * n, 0.0);
+    std::vector<double> r(n, 0.0);
+    double rmax = 0.0;
+
+    for (uint g=0; g<n; ++g) {
+      double* cg = &c[3*g];
+      uint na = offsets_[g+1] - offsets_[g];
+      const double* x = crds + 3 * offsets_[g];
+      for (uint i=0; i<na; ++i)
+        for (uint k=0; k<3; ++k)
+          cg[k] += x[3*i+k];
+      for (uint k=0; k<3; ++k)
+        cg[k] /= na;
+
+      double r2 = 0.0;
+      for (uint i=0; i<na; ++i) {
+        double dx = x[3*i] - cg[0];
+        double dy = x[3*i+1] - cg[1];
+        double dz = x[3*i+2] - cg[2];
+        r2 = std::max(r2, dx*dx + dy*dy + dz*dz);
+      }
+      r[g] = sqrt(r2);
+      rmax = std::max(rmax, r[g]);
+    }
+
+    std::vector<uint> firsts, seconds;
+    cellPairs(c, 2.0 * rmax + cutoff_ + sphere_slack, firsts, seconds);
+
+    const double cut2 = cutoff_ * cutoff_;
+    for (uint p=0; p<firsts.size(); ++p) {
+      const uint gi = firsts[p];
+      const uint gj = seconds[p];
+      const double* ci = &c[3*gi];
+      const double* cj = &c[3*gj];
+
+      double reach = r[gi] + r[gj] + cutoff_ + sphere_slack;
+      double dx = ci[0] - cj[0];
+      double dy = ci[1] - cj[1];
+      double dz = ci[2] - cj[2];
+      if (dx*dx + dy*dy + dz*dz > reach * reach)
+        continue;
+
+      // Atoms of i further than r_j + cutoff from j's centroid can't touch j
+      double reach_j = r[gj] + cutoff_ + sphere_slack;
+      reach_j *= reach_j;
+      bool contact = false;
+      for (uint a=offsets_[gi]; a<offsets_[gi+1] && !contact; ++a) {
+        const double* u = crds + 3 * a;
+        double ex = u[0] - cj[0];
+        double ey = u[1] - cj[1];
+        double ez = u[2] - cj[2];
+        if (ex*ex + ey*ey + ez*ez > reach_j)
+          continue;
+
+        for (uint b=offsets_[gj]; b<offsets_[gj+1]; ++b) {
+          const double* v = crds + 3 * b;
+          double fx = v[0] - u[0];
+          double fy = v[1] - u[1];
+          double fz = v[2] - u[2];
+          if (fx*fx + fy*fy + fz*fz <= cut2) {
+            contact = true;
+            break;
+          }
+        }
+      }
+
+      if (contact)
+        found.push_back(packedIndex(gi, gj));
+    }
+  }
+
+
+  void ContactMap::findContacts(const double* crds, std::vector<ulong>& found) const {
+    found.clear();
+    if (use_centers_)
+      centerContacts(crds, found);
+    else
+      sphereContacts(crds, found);
+  }
+
+
+  void ContactMap::add(const std::vector<ulong>& found) {
+    for (std::vector<ulong>::const_iterator i = found.begin(); i != found.end(); ++i)
+      ++counts_[*i];
+    ++nframes_;
+  }
+
+
+  void ContactMap::accumulate(const double* crds) {
+    std::vector<ulong> found;
+    findContacts(crds, found);
+    add(found);
+  }
+
+
+  void ContactMap::accumulate() {
+    std::vector<double> crds(3 * atoms_.size());
+    for (uint i=0; i<atoms_.size(); ++i) {
+      const GCoord& x = atoms_[i]->coords();
+      crds[3*i] = x[0];
+      crds[3*i+1] = x[1];
+      crds[3*i+2] = x[2];
+    }
+    accumulate(crds.data());
+  }
+
+
+  // Frames are read in blocks of about 16MB of coordinates.  Each
+  // frame's contacts are found in parallel as a list of packed indices,
+  // then added to the counts in order.
+  void ContactMap::accumulate(pTraj& traj, const std::vector<uint>& frames) {
+    const size_t frame_values = 3 * atoms_.size();
+    const size_t batch_bytes = 16 << 20;
+    uint batch = std::max<size_t>(1, batch_bytes / (std::max<size_t>(1, frame_values) * sizeof(double)));
+
+    std::vector<double> crds;
+    std::vector< std::vector<ulong> > found;
+    for (uint first=0; first<frames.size(); first += batch) {
+      std::vector<uint> block(frames.begin() + first, frames.begin() + std::min<size_t>(first + batch, frames.size()));
+      crds.resize(block.size() * frame_values);
+      found.resize(block.size());
+      traj->readFrames(block, atoms_, crds.data());
+
+      const uint nchunks = std::max(1u, std::min(static_cast<uint>(block.size()), nthreads_ == 0 ? 64u : nthreads_));
+      internal::parallelFor(nchunks, nthreads_, [&](uint chunk) {
+          for (uint j=chunk; j<block.size(); j += nchunks)
+            findContacts(crds.data() + j * frame_values, found[j]);
+        });
+
+      for (uint j=0; j<block.size(); ++j)
+        add(found[j]);
+    }
+  }
+
+
+  ulong ContactMap::count(const uint i, const uint j) const {
+    if (i >= size() || j >= size())
+      throw(LOOSError("Group index out of range in ContactMap"));
+
+    if (i == j)
+      return(nframes_);
+    return(i < j ? counts_[packedIndex(i, j)] : counts_[packedIndex(j, i)]);
+  }
+
+
+  void ContactMap::clear() {
+    counts_.assign(counts_.size(), 0);
+    nframes_ = 0;
+  }
+
+}
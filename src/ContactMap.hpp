@@ -0,0 +1,117 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_CONTACTMAP_HPP)
+#define LOOS_CONTACTMAP_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+  //! Frequency of contacts between every pair of groups (e.g. residues) over frames
+  /**
+   * Two groups are in contact in a frame if any atom of one is within
+   * the cutoff of any atom of the other or, when using centers, if
+   * their centers of mass are within the cutoff.  Every group is in
+   * contact with itself.  Distances are not reimaged.
+   *
+   * For the all-atom test, each group's centroid and radius (distance
+   * to its farthest atom) are found first, and only pairs whose spheres
+   * come within the cutoff are checked atom by atom.  Candidate pairs
+   * come from a cell list of the centroids, so the cost grows with the
+   * number of neighboring groups rather than the square of the number of
+   * groups.  Inside a candidate pair, only atoms within reach of the
+   * other group's sphere are compared, stopping at the first contact.
+   *
+   * Counts are kept for the upper triangle only.  When reading from a
+   * trajectory, blocks of frames are read with Trajectory::readFrames()
+   * and the frames of a block are divided among nthreads threads
+   * (0 = all cores).
+   */
+  class ContactMap {
+  public:
+    ContactMap(const std::vector<AtomicGroup>& groups, const double cutoff,
+               const bool use_centers = false, const uint nthreads = 0);
+
+    //! Number of groups
+    uint size() const { return(offsets_.size() - 1); }
+
+    //! Number of frames accumulated
+    uint frames() const { return(nframes_); }
+
+    //! All atoms of the groups, in the order the coordinates are read
+    const AtomicGroup& atoms() const { return(atoms_); }
+
+    //! Add the contacts in the groups' current coordinates
+    void accumulate();
+
+#if !defined(SWIG)
+    //! Add the contacts for coordinates laid out as atoms() (x, y, z per atom)
+    void accumulate(const double* crds);
+#endif
+
+    //! Add the contacts for each of the given frames of a trajectory
+    void accumulate(pTraj& traj, const std::vector<uint>& frames);
+
+    //! Number of frames in which groups i and j were in contact
+    ulong count(const uint i, const uint j) const;
+
+    //! Fraction of frames in which groups i and j were in contact
+    double frequency(const uint i, const uint j) const { return(static_cast<double>(count(i, j)) / nframes_); }
+
+    //! Forget all accumulated frames
+    void clear();
+
+  private:
+    // Index of (i, j), i < j, in the packed upper triangle
+    ulong packedIndex(const uint i, const uint j) const {
+      ulong n = size();
+      return(i * n - (static_cast<ulong>(i) * (i + 1)) / 2 + (j - i - 1));
+    }
+
+    void findContacts(const double* crds, std::vector<ulong>& found) const;
+    void sphereContacts(const double* crds, std::vector<ulong>& found) const;
+    void centerContacts(const double* crds, std::vector<ulong>& found) const;
+    void cellPairs(const std::vector<double>& centers, const double width,
+                   std::vector<uint>& firsts, std::vector<uint>& seconds) const;
+    void add(const std::vector<ulong>& found);
+
+    double cutoff_;
+    bool use_centers_;
+    uint nthreads_;
+    AtomicGroup atoms_;
+    std::vector<uint> offsets_;
+    std::vector<double> masses_, total_mass_;
+    std::vector<ulong> counts_;
+    uint nframes_;
+  };
+
+}
+
+
+#endif
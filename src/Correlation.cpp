@@ -0,0 +1,361 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include <Correlation.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+
+namespace loos {
+
+  namespace {
+
+    typedef std::complex<double> Complex;
+
+
+    uint paddedSize(const uint n) {
+      uint m = 1;
+      while (m < n)
+        m <<= 1;
+      return(m);
+    }
+
+
+    // Twiddle factors and bit-reversal permutation for one transform
+    // size, so a batch of same-length series only builds them once.
+    class FFTPlan {
+    public:
+      explicit FFTPlan(const uint n) : _n(n), _cos(n/2), _sin(n/2), _perm(n) {
+        if (n == 0 || (n & (n-1)) != 0)
+          throw(LOOSError("FFT size must be a power of 2"));
+
+        for (uint k=0; k<n/2; ++k) {
+          double theta = -2.0 * M_PI * k / n;
+          _cos[k] = cos(theta);
+          _sin[k] = sin(theta);
+        }
+
+        uint bits = 0;
+        while ((1u << bits) < n)
+          ++bits;
+        for (uint i=0; i<n; ++i) {
+          uint r = 0;
+          for (uint b=0; b<bits; ++b)
+            if (i & (1u << b))
+              r |= 1u << (bits - 1 - b);
+          _perm[i] = r;
+        }
+      }
+
+      uint size() const { return(_n); }
+
+      // Iterative radix-2 transform of n interleaved (re, im) values.
+      // The complex arithmetic is spelled out to avoid the library's
+      // NaN/inf handling in the inner loop.
+      void transform(Complex* data, const bool inverse) const {
+        double* x = reinterpret_cast<double*>(data);
+
+        for (uint i=0; i<_n; ++i)
+          if (i < _perm[i]) {
+            std::swap(x[2*i], x[2*_perm[i]]);
+            std::swap(x[2*i+1], x[2*_perm[i]+1]);
+          }
+
+        const double sgn = inverse ? -1.0 : 1.0;
+        for (uint len = 2; len <= _n; len <<= 1) {
+          uint half = len / 2;
+          uint step = _n / len;
+          for (uint i=0; i<_n; i += len)
+            for (uint j=0; j<half; ++j) {
+              double wr = _cos[j*step];
+              double wi = sgn * _sin[j*step];
+              double* u = x + 2*(i+j);
+              double* v = x + 2*(i+j+half);
+              double tr = v[0] * wr - v[1] * wi;
+              double ti = v[0] * wi + v[1] * wr;
+              v[0] = u[0] - tr;
+              v[1] = u[1] - ti;
+              u[0] += tr;
+              u[1] += ti;
+            }
+        }
+
+        if (inverse) {
+          double scale = 1.0 / _n;
+          for (uint i=0; i<2*_n; ++i)
+            x[i] *= scale;
+        }
+      }
+
+    private:
+      uint _n;
+      std::vector<double> _cos, _sin;
+      std::vector<uint> _perm;
+    };
+
+
+    // Rough operation counts: the FFT route costs two transforms of the
+    // padded length, the direct route one multiply-add per pair.
+    bool useDirectSum(const uint n, const uint max_lag) {
+      uint m = paddedSize(n + max_lag);
+      double logm = log2(static_cast<double>(m));
+      return(static_cast<double>(n) * max_lag <= 8.0 * m * logm);
+    }
+
+
+    void directSums(const std::vector<double>& a, const std::vector<double>& b,
+                    const uint max_lag, double* r) {
+      for (uint k=0; k<max_lag; ++k) {
+        double sum = 0.0;
+        if (k < b.size()) {
+          uint m = std::min(a.size(), b.size() - k);
+          for (uint j=0; j<m; ++j)
+            sum += a[j] * b[j+k];
+        }
+        r[k] = sum;
+      }
+    }
+
+
+    // Load a (real part) and b (imaginary part, if given) into the
+    // zero-padded work array and transform it.  The spectra of the two
+    // real series are then A[k] = (Z[k] + conj(Z[-k]))/2 and
+    // B[k] = (Z[k] - conj(Z[-k]))/2i.
+    void packAndTransform(const FFTPlan& plan, std::vector<Complex>& work,
+                          const std::vector<double>& a, const std::vector<double>* b) {
+      work.assign(plan.size(), Complex(0.0, 0.0));
+      double* w = reinterpret_cast<double*>(&work[0]);
+      for (uint j=0; j<a.size(); ++j)
+        w[2*j] = a[j];
+      if (b)
+        for (uint j=0; j<b->size(); ++j)
+          w[2*j+1] = (*b)[j];
+      plan.transform(&work[0], false);
+    }
+
+
+    // Autocorrelation sums of x and, if given, y using one forward and
+    // one inverse transform: |X|^2 + i|Y|^2 inverts to rx + i ry.
+    void fftAutoPair(const FFTPlan& plan, std::vector<Complex>& work,
+                     const std::vector<double>& x, const std::vector<double>* y,
+                     const uint max_lag, double* rx, double* ry) {
+      packAndTransform(plan, work, x, y);
+
+      uint m = plan.size();
+      std::vector<Complex> power(m);
+      for (uint k=0; k<m; ++k) {
+        Complex z = work[k];
+        Complex zc = std::conj(work[(m - k) & (m - 1)]);
+        double px = std::norm(z + zc) * 0.25;
+        double py = std::norm(z - zc) * 0.25;
+        power[k] = Complex(px, py);
+      }
+      plan.transform(&power[0], true);
+
+      for (uint k=0; k<max_lag; ++k) {
+        rx[k] = k < x.size() ? power[k].real() : 0.0;
+        if (y)
+          ry[k] = k < y->size() ? power[k].imag() : 0.0;
+      }
+    }
+
+  }
+
+
+
+  void fft(std::vector<Complex>& x, const bool inverse) {
+    if (x.empty())
+      return;
+    FFTPlan plan(x.size());
+    plan.transform(&x[0], inverse);
+  }
+
+
+  std::vector<double> autoCorrelationSums(const std::vector<double>& x, const uint max_lag) {
+    std::vector<double> r(max_lag, 0.0);
+    if (max_lag == 0 || x.empty())
+      return(r);
+
+    if (useDirectSum(x.size(), max_lag)) {
+      directSums(x, x, max_lag, &r[0]);
+      return(r);
+    }
+
+    FFTPlan plan(paddedSize(x.size() + max_lag));
+    std::vector<Complex> work;
+    fftAutoPair(plan, work, x, 0, max_lag, &r[0], 0);
+    return(r);
+  }
+
+
+  std::vector<double> crossCorrelationSums(const std::vector<double>& a,
+                                           const std::vector<double>& b,
+                                           const uint max_lag) {
+    std::vector<double> r(max_lag, 0.0);
+    if (max_lag == 0 || a.empty() || b.empty())
+      return(r);
+
+    uint n = std::max(a.size(), b.size());
+    if (useDirectSum(n, max_lag)) {
+      directSums(a, b, max_lag, &r[0]);
+      return(r);
+    }
+
+    // Both series go into one transform; conj(A) B inverts to the sums
+    FFTPlan plan(paddedSize(n + max_lag));
+    std::vector<Complex> work;
+    packAndTransform(plan, work, a, &b);
+
+    uint m = plan.size();
+    std::vector<Complex> prod(m);
+    for (uint k=0; k<m; ++k) {
+      Complex z = work[k];
+      Complex zc = std::conj(work[(m - k) & (m - 1)]);
+      Complex ak = (z + zc) * 0.5;
+      Complex bk = (z - zc) * Complex(0.0, -0.5);
+      prod[k] = std::conj(ak) * bk;
+    }
+    plan.transform(&prod[0], true);
+
+    for (uint k=0; k<max_lag && k<b.size(); ++k)
+      r[k] = prod[k].real();
+
+    return(r);
+  }
+
+
+  std::vector< std::vector<double> > autoCorrelationSums(const std::vector< std::vector<double> >& series,
+                                                         const uint max_lag,
+                                                         const uint nthreads) {
+    std::vector< std::vector<double> > result(series.size(), std::vector<double>(max_lag, 0.0));
+    if (max_lag == 0)
+      return(result);
+
+    // Sort by length so that the series paired in one transform waste
+    // as little padding as possible
+    std::vector<uint> order;
+    for (uint i=0; i<series.size(); ++i)
+      if (!series[i].empty())
+        order.push_back(i);
+    std::stable_sort(order.begin(), order.end(),
+                     [&series](const uint a, const uint b) { return(series[a].size() < series[b].size()); });
+
+    uint npairs = (order.size() + 1) / 2;
+    std::map<uint, FFTPlan> plans;
+    for (uint p=0; p<npairs; ++p) {
+      uint n = series[order[std::min(2*p+1, static_cast<uint>(order.size()-1))]].size();
+      if (useDirectSum(n, max_lag))
+        continue;
+      uint m = paddedSize(n + max_lag);
+      if (plans.find(m) == plans.end())
+        plans.insert(std::make_pair(m, FFTPlan(m)));
+    }
+
+    internal::parallelFor(npairs, nthreads, [&](uint pair) {
+        uint i = order[2*pair];
+        bool has_second = 2*pair + 1 < order.size();
+        const std::vector<double>& x = series[i];
+        const std::vector<double>* y = has_second ? &series[order[2*pair+1]] : 0;
+        uint n = std::max(x.size(), y ? y->size() : 0);
+
+        double* rx = &result[i][0];
+        double* ry = has_second ? &result[order[2*pair+1]][0] : 0;
+
+        if (useDirectSum(n, max_lag)) {
+          directSums(x, x, max_lag, rx);
+          if (y)
+            directSums(*y, *y, max_lag, ry);
+          return;
+        }
+
+        std::vector<Complex> work;
+        fftAutoPair(plans.find(paddedSize(n + max_lag))->second, work, x, y, max_lag, rx, ry);
+      });
+
+    return(result);
+  }
+
+
+  std::vector< std::vector<double> > autoCorrelations(const std::vector< std::vector<double> >& series,
+                                                      const uint max_lag,
+                                                      const bool normalize,
+                                                      const double tol,
+                                                      const uint nthreads) {
+    std::vector< std::vector<double> > data(series.size());
+    std::vector<bool> constant(series.size(), false);
+
+    for (uint i=0; i<series.size(); ++i) {
+      if (max_lag > series[i].size())
+        throw(LOOSError("Can't take correlation time longer than time series"));
+
+      data[i] = series[i];
+      if (!normalize)
+        continue;
+
+      // Same arithmetic as TimeSeries::average() and stdev()
+      std::vector<double>& x = data[i];
+      double ave = 0.0;
+      for (uint j=0; j<x.size(); ++j)
+        ave += x[j];
+      ave /= x.size();
+
+      double ave1 = 0.0, ave2 = 0.0;
+      for (uint j=0; j<x.size(); ++j) {
+        x[j] -= ave;
+        ave1 += x[j];
+        ave2 += x[j] * x[j];
+      }
+      ave1 /= x.size();
+      ave2 /= x.size();
+      double dev = sqrt(ave2 - ave1 * ave1);
+
+      if (dev < tol) {
+        constant[i] = true;
+        x.clear();
+        continue;
+      }
+      for (uint j=0; j<x.size(); ++j)
+        x[j] /= dev;
+    }
+
+    std::vector< std::vector<double> > result = autoCorrelationSums(data, max_lag, nthreads);
+
+    for (uint i=0; i<result.size(); ++i) {
+      if (constant[i]) {
+        result[i].assign(max_lag, 1.0);
+        continue;
+      }
+      uint n = series[i].size();
+      for (uint k=0; k<max_lag; ++k)
+        result[i][k] /= (n - k);
+    }
+
+    return(result);
+  }
+
+}
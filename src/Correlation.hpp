@@ -0,0 +1,96 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_CORRELATION_HPP)
+#define LOOS_CORRELATION_HPP
+
+#include <vector>
+#include <complex>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  //! Lagged product sums of a series with itself
+  /**
+   * Returns r where r[k] = sum_j x[j] * x[j+k] for k in [0, max_lag).
+   * Nothing is subtracted or divided out; lags past the end of the
+   * series are zero.  Long series with many lags are done with a
+   * zero-padded FFT (O(n log n)), short lag ranges by direct summation.
+   */
+  std::vector<double> autoCorrelationSums(const std::vector<double>& x, const uint max_lag);
+
+  //! Lagged product sums of two series
+  /**
+   * Returns r where r[k] = sum_j a[j] * b[j+k] for k in [0, max_lag),
+   * i.e. b is shifted forward in time relative to a.  The series may
+   * differ in length.
+   */
+  std::vector<double> crossCorrelationSums(const std::vector<double>& a,
+                                           const std::vector<double>& b,
+                                           const uint max_lag);
+
+  //! autoCorrelationSums() for many series at once
+  /**
+   * Each element of series is a separate series (they need not be the
+   * same length), and the i'th element of the result holds the sums for
+   * the i'th series.  Series are transformed two at a time by packing
+   * them into the real and imaginary parts of one complex FFT, and the
+   * pairs are divided among nthreads threads (0 = all cores).
+   */
+  std::vector< std::vector<double> > autoCorrelationSums(const std::vector< std::vector<double> >& series,
+                                                         const uint max_lag,
+                                                         const uint nthreads = 0);
+
+  //! Normalized autocorrelation of many series at once
+  /**
+   * Matches TimeSeries::correl() applied to each series in turn: if
+   * normalize is set, each series has its mean subtracted and is divided
+   * by its standard deviation (a constant series, with deviation below
+   * tol, gets a correlation of 1 at all lags), and each lag is divided
+   * by the number of pairs that contributed to it.  max_lag cannot be
+   * longer than the shortest series.  Work is spread over nthreads
+   * threads (0 = all cores).
+   */
+  std::vector< std::vector<double> > autoCorrelations(const std::vector< std::vector<double> >& series,
+                                                      const uint max_lag,
+                                                      const bool normalize = true,
+                                                      const double tol = 1.0e-8,
+                                                      const uint nthreads = 0);
+
+
+#if !defined(SWIG)
+  //! In-place complex FFT of x, whose size must be a power of 2
+  /**
+   * The forward transform uses exp(-2 pi i jk/n); the inverse transform
+   * is scaled by 1/n so that the two round-trip.
+   */
+  void fft(std::vector< std::complex<double> >& x, const bool inverse = false);
+#endif
+
+}
+
+
+#endif
@@ -0,0 +1,252 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <AtomicGroup.hpp>
+#include <DebyeScattering.hpp>
+#include <ParallelFor.hpp>
+
+#include <cmath>
+#include <map>
+#include <algorithm>
+
+#include <boost/thread/thread.hpp>
+
+
+namespace loos {
+
+
+  DebyeScattering::DebyeScattering(const AtomicGroup& group, const double qmin, const double qmax,
+                                   const uint numValues, FormFactorSet& formFactors,
+                                   const Mode mode, const double binWidth,
+                                   const uint nthreads)
+    : mode_(mode), bin_width_(binWidth), nthreads_(nthreads),
+      qstep_((qmax - qmin) / numValues), ntypes_(0), nbins_(0), hist_bins_(0)
+  {
+    if (mode_ == HISTOGRAM && !(bin_width_ > 0.0))
+      throw(LOOSError("Histogram bin width for scattering must be positive"));
+
+    for (uint k=0; k<numValues; ++k)
+      q_.push_back(qmin + k * qstep_);
+
+    // Each distinct atomic number becomes a type, with its form
+    // factors tabulated over q
+    std::map<uint, uint> type_of;
+    for (uint i=0; i<group.size(); ++i) {
+      uint z = group[i]->atomic_number();
+      std::map<uint, uint>::const_iterator t = type_of.find(z);
+      if (t == type_of.end()) {
+        t = type_of.insert(std::pair<uint, uint>(z, ntypes_++)).first;
+        type_counts_.push_back(0.0);
+        for (uint k=0; k<numValues; ++k)
+          form_factors_.push_back(formFactors.get(z, q_[k]));
+      }
+      types_.push_back(t->second);
+      type_counts_[t->second] += 1.0;
+    }
+  }
+
+
+  // Type pairs are unordered, so only a <= b is stored, row by row
+
+  uint DebyeScattering::pairIndex(const uint a, const uint b) const {
+    return(a <= b ? a * ntypes_ - a * (a - 1) / 2 + (b - a) : pairIndex(b, a));
+  }
+
+
+  // sin(q d) / (q d) for every q.  Since the q are evenly spaced, the
+  // sines come from the angle-addition recurrence rather than calls to
+  // sin().
+
+  void DebyeScattering::sincValues(const double d, double* out) const {
+    double s = sin(q_[0] * d);
+    double c = cos(q_[0] * d);
+    const double ds = sin(qstep_ * d);
+    const double dc = cos(qstep_ * d);
+
+    for (uint k=0; k<q_.size(); ++k) {
+      double qd = q_[k] * d;
+      out[k] = qd < 1e-7 ? 1.0 : s / qd;   // trap q=0, sin(x)/x -> 1
+
+      double sn = s * dc + c * ds;
+      c = c * dc - s * ds;
+      s = sn;
+    }
+  }
+
+
+  // Rows are dealt out to chunks round-robin so that every chunk gets a
+  // similar share of the triangle of pairs.  Each chunk accumulates the
+  // sum of sin(qd)/qd for each pair of types into its own array, and the
+  // arrays are added up at the end.
+
+  void DebyeScattering::exactSums(const std::vector<double>& crds, const uint nchunks, std::vector<double>& sums) const {
+    const uint n = types_.size();
+    const uint nq = q_.size();
+    std::vector< std::vector<double> > partial(nchunks, std::vector<double>(sums.size(), 0.0));
+
+    internal::parallelFor(nchunks, nchunks, [&](uint chunk) {
+        std::vector<double>& acc = partial[chunk];
+        std::vector<double> sinc(nq);
+        for (uint i=chunk; i<n; i += nchunks) {
+          const double* a = &crds[3 * i];
+          for (uint j=i+1; j<n; ++j) {
+            const double* b = &crds[3 * j];
+            double dx = a[0] - b[0];
+            double dy = a[1] - b[1];
+            double dz = a[2] - b[2];
+            sincValues(sqrt(dx*dx + dy*dy + dz*dz), &sinc[0]);
+
+            double* p = &acc[pairIndex(types_[i], types_[j]) * nq];
+            for (uint k=0; k<nq; ++k)
+              p[k] += sinc[k];
+          }
+        }
+      });
+
+    for (uint c=0; c<nchunks; ++c)
+      for (uint k=0; k<sums.size(); ++k)
+        sums[k] += partial[c][k];
+  }
+
+
+  // Same decomposition as exactSums(), but each chunk only bins the
+  // distances.  The sinc of each bin center is tabulated once and reused
+  // across frames.  The per-chunk histograms are also kept between
+  // frames; they are cleared as they are summed, so they only need to be
+  // reallocated when a frame needs more bins.
+
+  void DebyeScattering::histogramSums(const std::vector<double>& crds, const uint nchunks, std::vector<double>& sums) {
+    const uint n = types_.size();
+    const uint nq = q_.size();
+    const uint npairs = ntypes_ * (ntypes_ + 1) / 2;
+
+    // No distance can exceed the diagonal of the bounding box
+    GCoord lo(crds[0], crds[1], crds[2]);
+    GCoord hi(lo);
+    for (uint i=1; i<n; ++i)
+      for (uint d=0; d<3; ++d) {
+        lo[d] = std::min(lo[d], crds[3*i + d]);
+        hi[d] = std::max(hi[d], crds[3*i + d]);
+      }
+    const double inv_width = 1.0 / bin_width_;
+    const uint nbins = static_cast<uint>((hi - lo).length() * inv_width) + 2;
+
+    if (nbins > hist_bins_ || hists_.size() != nchunks) {
+      hist_bins_ = std::max(nbins, hist_bins_);
+      hists_.assign(nchunks, std::vector<ulong>(npairs * hist_bins_, 0));
+    }
+    const uint stride = hist_bins_;
+
+    internal::parallelFor(nchunks, nchunks, [&](uint chunk) {
+        std::vector<ulong>& hist = hists_[chunk];
+        for (uint i=chunk; i<n; i += nchunks) {
+          const double* a = &crds[3 * i];
+          for (uint j=i+1; j<n; ++j) {
+            const double* b = &crds[3 * j];
+            double dx = a[0] - b[0];
+            double dy = a[1] - b[1];
+            double dz = a[2] - b[2];
+            uint bin = std::min(static_cast<uint>(sqrt(dx*dx + dy*dy + dz*dz) * inv_width), nbins - 1);
+            ++hist[pairIndex(types_[i], types_[j]) * stride + bin];
+          }
+        }
+      });
+
+    tabulateSinc(nbins);
+
+    for (uint p=0; p<npairs; ++p)
+      for (uint bin=0; bin<nbins; ++bin) {
+        ulong count = 0;
+        for (uint c=0; c<nchunks; ++c) {
+          ulong& h = hists_[c][p * stride + bin];
+          count += h;
+          h = 0;
+        }
+        if (!count)
+          continue;
+
+        const double* sinc = &sinc_[bin * nq];
+        double* s = &sums[p * nq];
+        for (uint k=0; k<nq; ++k)
+          s[k] += count * sinc[k];
+      }
+  }
+
+
+  void DebyeScattering::tabulateSinc(const uint nbins) {
+    if (nbins <= nbins_)
+      return;
+
+    const uint nq = q_.size();
+    sinc_.resize(nbins * nq);
+    for (uint bin=nbins_; bin<nbins; ++bin)
+      sincValues((bin + 0.5) * bin_width_, &sinc_[bin * nq]);
+    nbins_ = nbins;
+  }
+
+
+  std::vector<double> DebyeScattering::compute(const AtomicGroup& group) {
+    const uint n = types_.size();
+    const uint nq = q_.size();
+
+    if (group.size() != n)
+      throw(LOOSError("Group passed to DebyeScattering::compute() does not match the one it was created with"));
+
+    std::vector<double> crds(3 * n);
+    for (uint i=0; i<n; ++i) {
+      const GCoord& c = group[i]->coords();
+      crds[3*i] = c.x();
+      crds[3*i+1] = c.y();
+      crds[3*i+2] = c.z();
+    }
+
+    // Sum of sin(qd)/qd over the atom pairs of each (unordered) pair of types
+    std::vector<double> sums(ntypes_ * (ntypes_ + 1) / 2 * nq, 0.0);
+    if (n > 1) {
+      uint nchunks = nthreads_ ? nthreads_ : boost::thread::hardware_concurrency();
+      nchunks = std::max(1u, std::min(nchunks, n));
+
+      if (mode_ == EXACT)
+        exactSums(crds, nchunks, sums);
+      else
+        histogramSums(crds, nchunks, sums);
+    }
+
+    std::vector<double> values(nq, 0.0);
+    for (uint a=0; a<ntypes_; ++a) {
+      const double* fa = &form_factors_[a * nq];
+      for (uint k=0; k<nq; ++k)
+        values[k] += type_counts_[a] * fa[k] * fa[k];
+
+      for (uint b=a; b<ntypes_; ++b) {
+        const double* fb = &form_factors_[b * nq];
+        const double* s = &sums[pairIndex(a, b) * nq];
+        for (uint k=0; k<nq; ++k)
+          values[k] += fa[k] * fb[k] * s[k];
+      }
+    }
+
+    return(values);
+  }
+
+}
@@ -0,0 +1,107 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_DEBYESCATTERING_HPP)
+#define LOOS_DEBYESCATTERING_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  class AtomicGroup;
+  class FormFactorSet;
+
+  //! Debye scattering intensities for a fixed set of atoms
+  /**
+   * Computes
+   *   I(q) = \sum_i F_i(q)^2 + \sum_(i<j) F_i(q) F_j(q) sin(q d_ij) / (q d_ij)
+   * (the same sum as AtomicGroup::scattering()) for numValues evenly
+   * spaced q values starting at qmin.  The element of each atom is taken
+   * from its atomic number when the object is created and the form factors
+   * are tabulated once per element, so one object can be reused for every
+   * frame of a trajectory.
+   *
+   * In EXACT mode (the default) every pair distance is used as is.  In
+   * HISTOGRAM mode the distances between each pair of elements are binned
+   * with a width of binWidth Angstroms, and the sum over atom pairs
+   * becomes a sum over bins evaluated at the bin centers.  The error from
+   * binning grows with q * binWidth, and is negligible at the default
+   * width for the q range covered by the form factors.
+   *
+   * The pair loop is split across nthreads threads (0 = all cores).
+   * Distances are not imaged.
+   */
+  class DebyeScattering {
+  public:
+    enum Mode { EXACT, HISTOGRAM };
+
+    DebyeScattering(const AtomicGroup& group, const double qmin, const double qmax,
+                    const uint numValues, FormFactorSet& formFactors,
+                    const Mode mode = EXACT, const double binWidth = 0.01,
+                    const uint nthreads = 0);
+
+    //! Intensity at each q value for the current coordinates of group
+    /**
+     * group must hold the same atoms, in the same order, as the group
+     * the object was created with (typically the same group, updated
+     * from a trajectory).
+     */
+    std::vector<double> compute(const AtomicGroup& group);
+
+    //! The q values that intensities are computed at
+    std::vector<double> qValues() const { return(q_); }
+
+    Mode mode() const { return(mode_); }
+    double binWidth() const { return(bin_width_); }
+
+  private:
+    void exactSums(const std::vector<double>& crds, const uint nchunks, std::vector<double>& sums) const;
+    void histogramSums(const std::vector<double>& crds, const uint nchunks, std::vector<double>& sums);
+    void sincValues(const double d, double* out) const;
+    void tabulateSinc(const uint nbins);
+    uint pairIndex(const uint a, const uint b) const;
+
+    Mode mode_;
+    double bin_width_;
+    uint nthreads_;
+    std::vector<double> q_;
+    double qstep_;
+
+    uint ntypes_;
+    std::vector<uint> types_;            // Element type of each atom
+    std::vector<double> type_counts_;    // Number of atoms of each type
+    std::vector<double> form_factors_;   // [type][q]
+
+    uint nbins_;                         // Bins covered by sinc_
+    std::vector<double> sinc_;           // [bin][q], at bin centers
+
+    uint hist_bins_;                     // Bins per type pair in hists_
+    std::vector< std::vector<ulong> > hists_;  // [chunk][type pair][bin], zero between frames
+  };
+
+}
+
+
+#endif
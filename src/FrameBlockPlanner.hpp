@@ -0,0 +1,138 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_FRAMEBLOCKPLANNER_HPP)
+#define LOOS_FRAMEBLOCKPLANNER_HPP
+
+#include <algorithm>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    //! Decides which frames a block-reading trajectory should fetch next
+    /**
+     * Formats backed by a library with hyperslab reads (NetCDF, HDF5)
+     * are much faster when many frames are fetched per call,
+     * particularly on parallel filesystems where small reads are
+     * expensive.  The planner tracks the frames being read so the
+     * reader can fetch a block of frames in one call:
+     *
+     * - Sequential reads, or reads with a constant stride (such as
+     *   the --skip/--stride frame lists used by most tools), fetch up
+     *   to capacity() frames at that stride in a single strided read.
+     * - Any other access fetches the file chunk holding the frame.
+     *
+     * The reader calls slot() for each frame.  On a miss it calls
+     * plan(), reads count() frames from start() every stride()
+     * frames into its block buffer, and calls slot() again.
+     */
+    class FrameBlockPlanner {
+    public:
+
+      //! Default size of a block of frames
+      static const size_t default_block_bytes = 16 << 20;
+
+      FrameBlockPlanner() : _nframes(0), _chunk(1), _capacity(1),
+                            _start(0), _stride(1), _count(0),
+                            _last(-1), _last_stride(0) { }
+
+      //! Sets up the planner for a trajectory
+      /**
+       * \arg \c nframes Frames in the trajectory
+       * \arg \c chunk_frames Frames per chunk in the file (1 if not chunked)
+       * \arg \c frame_bytes Size of one frame in the block buffer
+       * \arg \c block_bytes Target size of the block buffer
+       *
+       * The capacity is a whole number of chunks, and is at least one chunk.
+       */
+      void configure(const uint nframes, const uint chunk_frames, const size_t frame_bytes,
+                     const size_t block_bytes = default_block_bytes) {
+        _nframes = nframes;
+        _chunk = std::max(1u, chunk_frames);
+        uint n = std::max(static_cast<size_t>(1), block_bytes / std::max(static_cast<size_t>(1), frame_bytes));
+        _capacity = std::max(_chunk, n - n % _chunk);
+        _capacity = std::min(_capacity, std::max(1u, nframes));
+        _count = 0;
+        _last = -1;
+        _last_stride = 0;
+      }
+
+      //! Largest number of frames in a block
+      uint capacity() const { return(_capacity); }
+
+      //! Position of frame i in the current block, or -1 if it is not there
+      int slot(const uint i) {
+        if (_count == 0 || i < _start)
+          return(-1);
+        uint d = i - _start;
+        if (d % _stride)
+          return(-1);
+        d /= _stride;
+        if (d >= _count)
+          return(-1);
+
+        if (_last >= 0 && static_cast<long>(i) > _last)
+          _last_stride = i - _last;
+        _last = i;
+        return(d);
+      }
+
+      //! Plans a new block holding frame i
+      void plan(const uint i) {
+        long step = (_last >= 0 && static_cast<long>(i) > _last) ? i - _last : 0;
+
+        if (step == 1 || (step > 1 && step == _last_stride)) {
+          _start = i;
+          _stride = step;
+          _count = std::min(static_cast<long>(_capacity), (_nframes - 1 - i) / step + 1);
+        } else {
+          _start = i - i % _chunk;
+          _stride = 1;
+          _count = std::min(_chunk, _nframes - _start);
+        }
+      }
+
+      //! First frame of the current block
+      uint start() const { return(_start); }
+
+      //! Distance between frames in the current block
+      uint stride() const { return(_stride); }
+
+      //! Number of frames in the current block
+      uint count() const { return(_count); }
+
+    private:
+      uint _nframes, _chunk, _capacity;
+      uint _start, _stride, _count;
+      long _last, _last_stride;
+    };
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,350 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <FrameCache.hpp>
+#include <AtomicGroup.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+
+namespace loos {
+
+  const boost::uint32_t FrameCache::version = 1;
+  const char* FrameCache::environment_variable = "LOOS_FRAME_CACHE";
+
+
+  namespace {
+
+    const char magic[8] = { 'L', 'O', 'O', 'S', '-', 'L', 'F', 'C' };
+    const boost::uint32_t byte_order_mark = 0x01020304;
+
+    // The fixed part of the header.  Every field is naturally aligned.
+    struct CacheHeader {
+      char magic[8];
+      boost::uint32_t version;
+      boost::uint32_t byte_order_mark;
+      boost::int64_t source_size;
+      boost::int64_t source_mtime;
+      boost::uint32_t natoms;
+      boost::uint32_t nselected;
+      boost::uint64_t nframes;
+      double timestep;
+      boost::uint32_t periodic;
+      boost::uint32_t padding;
+    };
+
+    // Each frame is the box (3 doubles) then the selected coordinates
+    // (3 floats each), padded so the next box stays aligned
+    size_t frameStride(const size_t nselected) {
+      size_t n = 3 * sizeof(double) + nselected * 3 * sizeof(float);
+      return((n + 7) & ~static_cast<size_t>(7));
+    }
+
+    size_t framesOffset(const size_t nselected) {
+      size_t n = sizeof(CacheHeader) + nselected * sizeof(boost::uint32_t);
+      return((n + 7) & ~static_cast<size_t>(7));
+    }
+
+    bool sourceStats(const std::string& filename, boost::int64_t& size, boost::int64_t& mtime) {
+      struct stat st;
+      if (stat(filename.c_str(), &st) != 0)
+        return(false);
+      size = st.st_size;
+      mtime = st.st_mtime;
+      return(true);
+    }
+
+    // Sorted, unique atom indices of a group
+    std::vector<boost::uint32_t> atomIndices(const AtomicGroup& model) {
+      std::vector<boost::uint32_t> indices;
+      indices.reserve(model.size());
+      for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i)
+        indices.push_back((*i)->index());
+      std::sort(indices.begin(), indices.end());
+      indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+      return(indices);
+    }
+
+  }
+
+
+
+  std::string FrameCache::cacheName(const std::string& filename, const std::string& filetype, const AtomicGroup& model) {
+    const char* dir = getenv(environment_variable);
+    if (dir == 0 || *dir == '\0')
+      return(std::string());
+
+    boost::filesystem::path source;
+    try {
+      source = boost::filesystem::absolute(filename);
+    }
+    catch (boost::filesystem::filesystem_error& e) {
+      return(std::string());
+    }
+
+    std::vector<boost::uint32_t> indices = atomIndices(model);
+    std::string key = source.string() + '\n' + filetype + '\n';
+    key.append(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(boost::uint32_t));
+
+    std::ostringstream oss;
+    oss << source.filename().string() << '.' << filetype << '.'
+        << std::hex << std::hash<std::string>()(key) << ".lfc";
+
+    return((boost::filesystem::path(dir) / oss.str()).string());
+  }
+
+
+
+  bool FrameCache::build(const std::string& cachename, const std::string& filename, Trajectory& traj, const AtomicGroup& model) {
+    if (traj.hasVelocities())
+      return(false);
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byte_order_mark = byte_order_mark;
+    if (!sourceStats(filename, header.source_size, header.source_mtime))
+      return(false);
+
+    std::vector<boost::uint32_t> indices = atomIndices(model);
+    header.natoms = traj.natoms();
+    header.nselected = indices.size();
+    header.timestep = traj.timestep();
+    header.periodic = traj.hasPeriodicBox();
+
+    // Where each atom of the working copy goes in a frame
+    AtomicGroup work = model.copy();
+    std::vector<uint> positions(work.size());
+    for (uint i=0; i<work.size(); ++i)
+      positions[i] = std::lower_bound(indices.begin(), indices.end(), work[i]->index()) - indices.begin();
+
+    std::ostringstream tmpname;
+    tmpname << cachename << ".tmp." << getpid() << '.' << boost::this_thread::get_id();
+    std::ofstream ofs(tmpname.str().c_str(), std::ios::binary);
+    if (!ofs)
+      return(false);
+
+    std::vector<char> buffer(framesOffset(indices.size()), 0);
+    memcpy(&buffer[0] + sizeof(header), indices.data(), indices.size() * sizeof(boost::uint32_t));
+    ofs.write(&buffer[0], buffer.size());
+
+    buffer.assign(frameStride(indices.size()), 0);
+    double* box = reinterpret_cast<double*>(&buffer[0]);
+    float* crds = reinterpret_cast<float*>(&buffer[0] + 3 * sizeof(double));
+
+    // A trajectory that can't be read all the way through (e.g. a
+    // truncated file) is left to fail when it is read directly
+    try {
+      traj.rewind();
+      while (traj.readFrame()) {
+        traj.updateGroupCoords(work);
+        GCoord b = traj.hasPeriodicBox() ? traj.periodicBox() : GCoord(0, 0, 0);
+        for (uint k=0; k<3; ++k)
+          box[k] = b[k];
+        for (uint i=0; i<work.size(); ++i) {
+          const GCoord& c = work[i]->coords();
+          for (uint k=0; k<3; ++k)
+            crds[positions[i] * 3 + k] = c[k];
+        }
+        ofs.write(&buffer[0], buffer.size());
+        ++header.nframes;
+      }
+      traj.rewind();
+    }
+    catch (...) {
+      ofs.close();
+      remove(tmpname.str().c_str());
+      try {
+        traj.rewind();
+      }
+      catch (...) { }
+      return(false);
+    }
+
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.close();
+
+    if (ofs.fail() || rename(tmpname.str().c_str(), cachename.c_str()) != 0) {
+      remove(tmpname.str().c_str());
+      return(false);
+    }
+
+    return(true);
+  }
+
+
+
+  pTraj FrameCache::open(const std::string& cachename, const std::string& filename) {
+    FrameCache* cache = new FrameCache;
+    pTraj traj(cache);
+    if (!cache->map(cachename, filename))
+      return(pTraj());
+    return(traj);
+  }
+
+
+  // Maps the cache and checks that it matches the trajectory file
+  bool FrameCache::map(const std::string& cachename, const std::string& filename) {
+    _filename = filename;
+
+    boost::int64_t source_size, source_mtime;
+    if (!sourceStats(filename, source_size, source_mtime))
+      return(false);
+
+    int fd = ::open(cachename.c_str(), O_RDONLY);
+    if (fd < 0)
+      return(false);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader)) {
+      close(fd);
+      return(false);
+    }
+    _map_size = st.st_size;
+    _map = mmap(0, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_map == MAP_FAILED) {
+      _map = 0;
+      return(false);
+    }
+
+    const char* base = static_cast<const char*>(_map);
+    CacheHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0
+        || header.version != version
+        || header.byte_order_mark != byte_order_mark
+        || header.source_size != source_size
+        || header.source_mtime != source_mtime)
+      return(false);
+
+    _stride = frameStride(header.nselected);
+    size_t offset = framesOffset(header.nselected);
+    if (_map_size < offset || (_map_size - offset) / _stride < header.nframes)
+      return(false);
+
+    _natoms = header.natoms;
+    _nframes = header.nframes;
+    _timestep = header.timestep;
+    _periodic = header.periodic;
+    _indices.resize(header.nselected);
+    memcpy(_indices.data(), base + sizeof(header), header.nselected * sizeof(boost::uint32_t));
+    _position.assign(_natoms, -1);
+    for (uint i=0; i<_indices.size(); ++i) {
+      if (_indices[i] >= _natoms)
+        return(false);
+      _position[_indices[i]] = i;
+    }
+    _frames = base + offset;
+
+    parseFrame();
+    cached_first = true;
+    return(true);
+  }
+
+
+  FrameCache::~FrameCache() {
+    if (_map)
+      munmap(_map, _map_size);
+  }
+
+
+  bool FrameCache::parseFrame(void) {
+    if (_current_frame >= _nframes)
+      return(false);
+    _frame = _frames + _current_frame * _stride;
+    return(true);
+  }
+
+
+  // With no frames cached there is no current frame, so the box (and
+  // coords()) come back as zeros.
+  GCoord FrameCache::periodicBox(void) const {
+    if (!_frame)
+      return(GCoord(0, 0, 0));
+    const double* box = reinterpret_cast<const double*>(_frame);
+    return(GCoord(box[0], box[1], box[2]));
+  }
+
+
+  std::vector<GCoord> FrameCache::coords(void) const {
+    std::vector<GCoord> result(_natoms, GCoord(0, 0, 0));
+    if (!_frame)
+      return(result);
+    const float* crds = reinterpret_cast<const float*>(_frame + 3 * sizeof(double));
+    for (uint i=0; i<_indices.size(); ++i, crds += 3)
+      result[_indices[i]] = GCoord(crds[0], crds[1], crds[2]);
+    return(result);
+  }
+
+
+  void FrameCache::updateGroupCoordsImpl(AtomicGroup& g) {
+    if (!_frame)
+      throw(TrajectoryError("updating group coords", _filename, "No frames are cached"));
+    const float* crds = reinterpret_cast<const float*>(_frame + 3 * sizeof(double));
+    for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
+      uint idx = (*i)->index();
+      if (idx >= _natoms || _position[idx] < 0)
+        throw(TrajectoryError("updating group coords", _filename, "Atom is not in the cached frames (or its index is out of bounds)"));
+      const float* c = crds + 3 * _position[idx];
+      (*i)->coords(GCoord(c[0], c[1], c[2]));
+    }
+
+    if (_periodic)
+      g.periodicBox(periodicBox());
+  }
+
+
+  void FrameCache::updateViewCoordsImpl(const AtomicGroupView& view) {
+    if (!_frame)
+      throw(TrajectoryError("updating group coords", _filename, "No frames are cached"));
+    const float* crds = reinterpret_cast<const float*>(_frame + 3 * sizeof(double));
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= _natoms || _position[idx] < 0)
+        throw(TrajectoryError("updating group coords", _filename, "Atom is not in the cached frames (or its index is out of bounds)"));
+      const float* c = crds + 3 * _position[idx];
+      atom->coords(GCoord(c[0], c[1], c[2]));
+    }
+
+    if (_periodic)
+      view.periodicBox(periodicBox());
+  }
+
+}
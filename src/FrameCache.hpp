@@ -0,0 +1,136 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_FRAMECACHE_HPP)
+#define LOOS_FRAMECACHE_HPP
+
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+#include <Trajectory.hpp>
+
+
+namespace loos {
+
+  //! On-disk cache of decoded trajectory frames...
+  /**  Compressed trajectories (e.g. XTC) must be decoded every time
+   *   they are read, so running many tools over the same trajectory
+   *   pays for the decoding over and over.  The FrameCache stores the
+   *   decoded frames as raw floats with a fixed size per frame, and is
+   *   read back through a memory map, so later reads are little more
+   *   than page-cache copies.
+   *
+   *   createTrajectory() uses the cache transparently when the
+   *   LOOS_FRAME_CACHE environment variable names a writable
+   *   directory.  The first call for a trajectory decodes it once to
+   *   build the cache; later calls read the cache.  A cache is keyed
+   *   by the trajectory's path and format and by the set of atom
+   *   indices in the model passed to createTrajectory(), and only the
+   *   coordinates of those atoms are kept.  The cache is only used if
+   *   it records the same size and modification time as the
+   *   trajectory file.  Any problem with the cache silently falls back
+   *   to reading the trajectory itself.
+   *
+   *   Only coordinates and periodic boxes are cached, and coordinates
+   *   are stored in single precision, as in most trajectory formats.
+   *   Trajectories with velocities are never cached, so that
+   *   hasVelocities() is not silently lost.  Note that with caching on,
+   *   createTrajectory() returns a FrameCache rather than the
+   *   format-specific class, so code that casts the result to, e.g.,
+   *   DCD will not work, and double-precision coordinates are rounded
+   *   to float.
+   */
+  class FrameCache : public Trajectory {
+  public:
+
+    //! Current version of the file layout
+    static const boost::uint32_t version;
+
+    //! Name of the environment variable that enables the cache
+    static const char* environment_variable;
+
+    //! Name of the cache for a trajectory, or an empty string if caching is disabled
+    static std::string cacheName(const std::string& filename, const std::string& filetype, const AtomicGroup& model);
+
+    //! Opens the cache of filename, returning a null pointer if it is missing, stale, or unreadable
+    static pTraj open(const std::string& cachename, const std::string& filename);
+
+    //! Decodes every frame of traj into a new cache, returning false on failure
+    /** The trajectory is left rewound to its first frame.  Trajectories
+     * with velocities are not cached.  If a frame can't be read, the
+     * partial cache is removed and false is returned.
+     */
+    static bool build(const std::string& cachename, const std::string& filename, Trajectory& traj, const AtomicGroup& model);
+
+
+    ~FrameCache();
+
+    std::string description() const { return("Cached trajectory frames"); }
+
+    uint natoms(void) const { return(_natoms); }
+    float timestep(void) const { return(_timestep); }
+    uint nframes(void) const { return(_nframes); }
+
+    bool hasPeriodicBox(void) const { return(_periodic); }
+    GCoord periodicBox(void) const;
+
+    //! Coordinates of the current frame (atoms not in the cache are zero)
+    std::vector<GCoord> coords(void) const;
+
+    bool parseFrame(void);
+
+  private:
+    FrameCache() : _map(0), _map_size(0), _natoms(0), _nframes(0), _timestep(0.0),
+                   _periodic(false), _frames(0), _stride(0), _frame(0) { }
+
+    bool map(const std::string& cachename, const std::string& filename);
+
+    void seekNextFrameImpl(void) { }
+    void seekFrameImpl(const uint) { }
+    void rewindImpl(void) { }
+    void updateGroupCoordsImpl(AtomicGroup& g);
+    void updateViewCoordsImpl(const AtomicGroupView& view);
+
+  private:
+    void* _map;
+    size_t _map_size;
+
+    uint _natoms, _nframes;
+    float _timestep;
+    bool _periodic;
+    std::vector<int> _position;        // Position of each atom index in a frame (-1 if not cached)
+    std::vector<boost::uint32_t> _indices;
+
+    const char* _frames;
+    size_t _stride;
+    const char* _frame;
+  };
+
+}
+
+#endif
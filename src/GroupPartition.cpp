@@ -0,0 +1,222 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#include <GroupPartition.hpp>
+#include <AtomicGroup.hpp>
+
+#include <algorithm>
+#include <map>
+
+
+namespace loos {
+
+  namespace {
+
+    // Orders positions in a group by the id of the atom there
+    struct PositionById {
+      PositionById(const AtomicGroup& g) : group(g) { }
+      bool operator()(const uint a, const uint b) const { return(group[a]->id() < group[b]->id()); }
+      const AtomicGroup& group;
+    };
+
+  }
+
+
+  /**
+   * Molecules are found by a depth-first walk along the bonds, visiting
+   * atoms in id order.  Bonded atoms are looked up by binary search in
+   * the id-sorted positions, so the cost is O(n log n) with no per-atom
+   * allocation beyond the bond lists.  As in splitByMolecule(), bonds
+   * to atoms outside the group are ignored, molecules are ordered by
+   * their lowest atom id, and a group with no bonds at all is a single
+   * part.
+   */
+  GroupPartition GroupPartition::byMolecule(const AtomicGroup& group) {
+    GroupPartition p;
+    p.sorted_ = true;
+
+    const uint n = group.size();
+    std::vector<uint> by_id(n);
+    for (uint i=0; i<n; ++i)
+      by_id[i] = i;
+    std::stable_sort(by_id.begin(), by_id.end(), PositionById(group));
+
+    if (!group.hasBonds()) {
+      p.positions_ = by_id;
+      p.offsets_.push_back(n);
+      return(p);
+    }
+
+    std::vector<int> ids(n);
+    for (uint r=0; r<n; ++r)
+      ids[r] = group[by_id[r]]->id();
+
+    // Work in ranks (positions in by_id), so sorting a molecule's ranks
+    // puts its atoms in id order
+    std::vector<bool> seen(n, false);
+    std::vector<uint> stack, molecule;
+    p.positions_.reserve(n);
+    for (uint r=0; r<n; ++r) {
+      if (seen[r])
+        continue;
+
+      seen[r] = true;
+      stack.push_back(r);
+      molecule.clear();
+      while (!stack.empty()) {
+        uint k = stack.back();
+        stack.pop_back();
+        molecule.push_back(k);
+
+        const pAtom& atom = group[by_id[k]];
+        if (!atom->hasBonds())
+          continue;
+        std::vector<int> bonds = atom->getBonds();
+        for (std::vector<int>::const_iterator b = bonds.begin(); b != bonds.end(); ++b) {
+          std::vector<int>::const_iterator j = std::lower_bound(ids.begin(), ids.end(), *b);
+          if (j == ids.end() || *j != *b)
+            continue;
+          uint q = j - ids.begin();
+          if (!seen[q]) {
+            seen[q] = true;
+            stack.push_back(q);
+          }
+        }
+      }
+
+      std::sort(molecule.begin(), molecule.end());
+      for (std::vector<uint>::const_iterator k = molecule.begin(); k != molecule.end(); ++k)
+        p.positions_.push_back(by_id[*k]);
+      p.offsets_.push_back(p.positions_.size());
+    }
+
+    return(p);
+  }
+
+
+  GroupPartition GroupPartition::byResidue(const AtomicGroup& group) {
+    GroupPartition p;
+    const uint n = group.size();
+    if (n == 0)
+      return(p);
+
+    p.positions_.resize(n);
+    int curr_resid = group[0]->resid();
+    std::string curr_segid = group[0]->segid();
+    for (uint i=0; i<n; ++i) {
+      const pAtom& atom = group[i];
+      if (curr_resid != atom->resid() || atom->segid() != curr_segid) {
+        p.offsets_.push_back(i);
+        curr_resid = atom->resid();
+        curr_segid = atom->segid();
+      }
+      p.positions_[i] = i;
+    }
+    p.offsets_.push_back(n);
+
+    return(p);
+  }
+
+
+  GroupPartition GroupPartition::byUniqueSegid(const AtomicGroup& group) {
+    GroupPartition p;
+    const uint n = group.size();
+
+    // Label each atom with its segid's order of first appearance, then
+    // gather the atoms by label, keeping their order within the group
+    std::map<std::string, uint> labels;
+    std::vector<uint> label(n), counts;
+    for (uint i=0; i<n; ++i) {
+      std::map<std::string, uint>::iterator l = labels.find(group[i]->segid());
+      if (l == labels.end()) {
+        l = labels.insert(std::make_pair(group[i]->segid(), static_cast<uint>(counts.size()))).first;
+        counts.push_back(0);
+      }
+      label[i] = l->second;
+      ++counts[l->second];
+    }
+
+    for (uint k=0; k<counts.size(); ++k)
+      p.offsets_.push_back(p.offsets_.back() + counts[k]);
+
+    p.positions_.resize(n);
+    std::vector<uint> fill(p.offsets_.begin(), p.offsets_.end() - 1);
+    for (uint i=0; i<n; ++i)
+      p.positions_[fill[label[i]]++] = i;
+
+    return(p);
+  }
+
+
+  std::vector<GCoord> GroupPartition::centroids(const AtomicGroup& parent) const {
+    std::vector<GCoord> result(size());
+    for (uint g=0; g<size(); ++g) {
+      if (size(g) == 0) {
+        result[g] = GCoord(0,0,0);
+        continue;
+      }
+      if (size(g) == 1) {
+        result[g] = parent[positions_[offsets_[g]]]->coords();
+        continue;
+      }
+
+      GCoord c(0,0,0);
+      for (uint i=offsets_[g]; i<offsets_[g+1]; ++i)
+        c += parent[positions_[i]]->coords();
+      c /= size(g);
+      result[g] = c;
+    }
+
+    return(result);
+  }
+
+
+  std::vector<GCoord> GroupPartition::centersOfMass(const AtomicGroup& parent) const {
+    std::vector<GCoord> result(size());
+    for (uint g=0; g<size(); ++g) {
+      if (size(g) == 0) {
+        result[g] = GCoord(0,0,0);
+        continue;
+      }
+      if (size(g) == 1) {
+        result[g] = parent[positions_[offsets_[g]]]->coords();
+        continue;
+      }
+
+      GCoord c(0,0,0);
+      greal mass = 0.0;
+      for (uint i=offsets_[g]; i<offsets_[g+1]; ++i) {
+        const pAtom& atom = parent[positions_[i]];
+        c += atom->mass() * atom->coords();
+        mass += atom->mass();
+      }
+      c /= mass;
+      result[g] = c;
+    }
+
+    return(result);
+  }
+
+}
@@ -0,0 +1,103 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#if !defined(LOOS_GROUPPARTITION_HPP)
+#define LOOS_GROUPPARTITION_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  class AtomicGroup;
+
+  //! A division of an AtomicGroup into parts (molecules, residues, segments)
+  /**
+   * The parts are stored as offsets into a single list of positions
+   * within the parent group (CSR style): part i is made up of the atoms
+   * at positions positions()[offsets()[i]] through
+   * positions()[offsets()[i+1]-1] of the parent.  Nothing is copied
+   * out of the parent, so a partition is cheap to keep around and to
+   * walk, and the parts are only turned into AtomicGroups when asked
+   * for (see AtomicGroup::split()).
+   *
+   * byMolecule(), byResidue() and byUniqueSegid() give the same parts,
+   * in the same order and with the atoms in the same order, as
+   * AtomicGroup::splitByMolecule(), splitByResidue() and
+   * splitByUniqueSegid().  A partition is only meaningful for the group
+   * it was built from; AtomicGroup::moleculePartition() and friends
+   * cache them on the group.
+   */
+  class GroupPartition {
+  public:
+    GroupPartition() : offsets_(1, 0), sorted_(false) { }
+
+    //! Parts connected by bonds, each sorted by atom id
+    static GroupPartition byMolecule(const AtomicGroup& group);
+
+    //! Runs of atoms with the same resid and segid
+    static GroupPartition byResidue(const AtomicGroup& group);
+
+    //! Atoms with the same segid, in order of first appearance
+    static GroupPartition byUniqueSegid(const AtomicGroup& group);
+
+    //! Number of parts
+    uint size() const { return(offsets_.size() - 1); }
+
+    //! Number of atoms in part i
+    uint size(const uint i) const { return(offsets_[i+1] - offsets_[i]); }
+
+    //! Positions in the parent group of the atoms of part i
+    std::vector<uint> indices(const uint i) const {
+      return(std::vector<uint>(positions_.begin() + offsets_[i], positions_.begin() + offsets_[i+1]));
+    }
+
+    //! Start of each part in positions(), plus the total at the end
+    const std::vector<uint>& offsets() const { return(offsets_); }
+
+    //! Positions in the parent of the atoms of all parts, part by part
+    const std::vector<uint>& positions() const { return(positions_); }
+
+    //! True if the atoms of each part are in atom id order
+    bool sortedById() const { return(sorted_); }
+
+    //! Centroid of each part, as AtomicGroup::centroid() (the origin for an empty part)
+    std::vector<GCoord> centroids(const AtomicGroup& parent) const;
+
+    //! Center of mass of each part, as AtomicGroup::centerOfMass() (the origin for an empty part)
+    std::vector<GCoord> centersOfMass(const AtomicGroup& parent) const;
+
+  private:
+    std::vector<uint> offsets_, positions_;
+    bool sorted_;
+  };
+
+}
+
+
+#endif
@@ -22,9 +22,40 @@
 
 
 #include <MultiTraj.hpp>
+#include <utils.hpp>
+#include <ParallelFor.hpp>
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace loos {
 
+	namespace {
+
+		// The NetCDF and HDF5 libraries are not thread-safe, so
+		// trajectories that use them are opened and read one at a time
+		boost::mutex library_lock;
+
+		bool usesSharedLibrary(const std::string& filename) {
+			std::string suffix = boost::get<1>(splitFilename(filename));
+			boost::to_lower(suffix);
+			return(suffix == "nc" || suffix == "netcdf" || suffix == "crd" || suffix == "mdcrd" || suffix == "h5");
+		}
+
+	}
+
+
+	pTraj MultiTrajectory::openTrajectory(const std::string& filename, const AtomicGroup& model) {
+		if (usesSharedLibrary(filename)) {
+			boost::mutex::scoped_lock guard(library_lock);
+			return(createTrajectory(filename, model));
+		}
+		return(createTrajectory(filename, model));
+	}
+
 
 	void MultiTrajectory::findNextUsableTraj() {
 		for (; _curtraj < _trajectories.size(); ++_curtraj)
@@ -81,18 +112,118 @@ namespace loos {
 			_trajectories[_curtraj]->updateGroupCoords(g);
 	}
 
+	void MultiTrajectory::updateViewCoordsImpl(const AtomicGroupView& view) {
+		if (!eof())
+			_trajectories[_curtraj]->updateGroupCoords(view);
+	}
+
 	void MultiTrajectory::updateGroupVelocitiesImpl(AtomicGroup& g) {
 		if (!eof())
 			_trajectories[_curtraj]->updateGroupVelocities(g);
 	}
 
 
+	std::vector<MultiTrajectory::FrameRange> MultiTrajectory::frameRanges(const uint n) const {
+		uint usable = 0;
+		for (uint k=0; k<_trajectories.size(); ++k)
+			if (nframes(k) > 0)
+				++usable;
+
+		uint pieces = (usable == 0 || usable >= n) ? 1 : (n + usable - 1) / usable;
+
+		std::vector<FrameRange> ranges;
+		uint index = 0;
+		for (uint k=0; k<_trajectories.size(); ++k) {
+			uint m = nframes(k);
+			uint p = std::min(pieces, m);
+			uint local = 0;
+			for (uint j=0; j<p; ++j) {
+				// Spread the remainder over the first runs
+				uint count = m / p + (j < m % p ? 1 : 0);
+				FrameRange range = { k, index, _skip + local * _stride, count };
+				ranges.push_back(range);
+				index += count;
+				local += count;
+			}
+		}
+
+		return(ranges);
+	}
+
+
+	// Reads a run of frames, through the sub-trajectory itself if reuse
+	// is set or through a new handle otherwise
+	void MultiTrajectory::readRange(const FrameRange& range, const bool reuse, AtomicGroup& frame, const FrameFunction& f) {
+		const std::string& filename = _filenames[range.traj];
+		pTraj traj = reuse ? _trajectories[range.traj] : openTrajectory(filename, _model);
+		bool serialize = usesSharedLibrary(filename);
+
+		for (uint i=0; i<range.count; ++i) {
+			uint raw = range.frame + i * _stride;
+			bool ok;
+			if (serialize) {
+				boost::mutex::scoped_lock guard(library_lock);
+				ok = traj->readFrame(raw);
+				if (ok)
+					traj->updateGroupCoords(frame);
+			} else {
+				ok = traj->readFrame(raw);
+				if (ok)
+					traj->updateGroupCoords(frame);
+			}
+			if (!ok)
+				throw(FileReadError(filename, "Cannot read frame in MultiTrajectory"));
+
+			f(frame, range.index + i);
+		}
+	}
+
+
+	void MultiTrajectory::parallelFrames(const AtomicGroup& g, const FrameFunction& f, const uint nthreads) {
+		uint nt = nthreads ? nthreads : boost::thread::hardware_concurrency();
+		std::vector<FrameRange> ranges = frameRanges(nt);
+
+		// The first run of each sub-trajectory uses the existing handle
+		boost::mutex lock;
+		std::vector<AtomicGroup> frames;
+		internal::parallelFor(ranges.size(), nt, [&](uint r) {
+				AtomicGroup frame;
+				{
+					boost::mutex::scoped_lock guard(lock);
+					if (frames.empty())
+						frame = g.copy();
+					else {
+						frame = frames.back();
+						frames.pop_back();
+					}
+				}
+				readRange(ranges[r], r == 0 || ranges[r-1].traj != ranges[r].traj, frame, f);
+				boost::mutex::scoped_lock guard(lock);
+				frames.push_back(frame);
+			});
+
+		// Restore the current frame, in case its sub-trajectory was moved
+		if (!eof())
+			_trajectories[_curtraj]->readFrame(_curframe);
+	}
+
+
+	// Sub-trajectories are opened concurrently, since opening can mean
+	// scanning the whole file (e.g. XTC)
 	void MultiTrajectory::initWithList(const std::vector<std::string>& filenames, const AtomicGroup& model) {
+		std::vector<pTraj> trajs(filenames.size());
+		internal::parallelFor(filenames.size(), _nthreads, [&](uint i) { trajs[i] = openTrajectory(filenames[i], model); });
+
 		for (uint i=0; i<filenames.size(); ++i) {
-			pTraj traj = createTrajectory(filenames[i], model);
-			_trajectories.push_back(traj);
-			_nframes += nframes(i);
+			_trajectories.push_back(trajs[i]);
+			_filenames.push_back(filenames[i]);
+			_nframes += nframes(_trajectories.size() - 1);
 		}
+
+		// Make the first frame (with skip applied) current
+		findNextUsableTraj();
+		if (!eof())
+			_trajectories[_curtraj]->readFrame(_curframe);
 	}
 
 }
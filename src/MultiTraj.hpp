@@ -27,6 +27,7 @@
 #include <Trajectory.hpp>
 #include <sfactories.hpp>
 
+#include <boost/function.hpp>
 
 
 
@@ -38,29 +39,47 @@ namespace loos {
 	 * Note that the skip and stride settings are applied to each sub-trajectory (as opposed
 	 * to the composite trajectory).  They are also set ONLY at instantiation.
 	 *
+	 * When instantiated with a list of filenames, the sub-trajectories are
+	 * opened (and indexed, for formats like XTC that must be scanned)
+	 * concurrently, using nthreads threads (0 means use all cores).  The
+	 * composite trajectory can also be read in parallel with
+	 * parallelFrames() and parallelMap().
+	 *
 	 */
 	class MultiTrajectory : public Trajectory {
 	public:
 		typedef std::pair<uint, uint>   Location;
 
+		//! Function called by parallelFrames() with a frame and its composite index
+		typedef boost::function<void(AtomicGroup&, const uint)>   FrameFunction;
+
+		//! A run of consecutive frames from one sub-trajectory
+		struct FrameRange {
+			uint traj;      // Index of the sub-trajectory
+			uint index;     // Composite index of the first frame
+			uint frame;     // Raw index of the first frame in the sub-trajectory
+			uint count;     // Number of frames
+		};
+
+
 		MultiTrajectory()
-			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0)
+			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0), _nthreads(0)
 		{ cached_first = true; }
 
 		//! instantiate a new empty MultiTrajectory
 		MultiTrajectory(const AtomicGroup& model)
-			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0), _model(model)
+			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0), _nthreads(0), _model(model)
 		{ cached_first = true; }
 
 		MultiTrajectory(const AtomicGroup& model, const uint skip, const uint stride)
-			: _nframes(0), _skip(skip), _stride(stride), _curtraj(0), _curframe(0), _model(model)
+			: _nframes(0), _skip(skip), _stride(stride), _curtraj(0), _curframe(0), _nthreads(0), _model(model)
 		{ cached_first = true; }
 
 
 		//! Instantiate a new MultiTrajectory using the passed filenames
 		MultiTrajectory(const std::vector<std::string>& filenames,
 						const AtomicGroup& model)
-			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0), _model(model)
+			: _nframes(0), _skip(0), _stride(1), _curtraj(0), _curframe(0), _nthreads(0), _model(model)
 		{
 			cached_first = true;
 			initWithList(filenames, model);
@@ -70,8 +89,9 @@ namespace loos {
 		MultiTrajectory(const std::vector<std::string>& filenames,
 						const AtomicGroup& model,
 						const uint skip,
-						const uint stride)
-			: _nframes(0), _skip(skip), _stride(stride), _curtraj(0), _curframe(skip), _model(model)
+						const uint stride,
+						const uint nthreads = 0)
+			: _nframes(0), _skip(skip), _stride(stride), _curtraj(0), _curframe(skip), _nthreads(nthreads), _model(model)
 		{
 			cached_first = true;
 			initWithList(filenames, model);
@@ -80,10 +100,9 @@ namespace loos {
 
 		//! Add a trajectory (by filename)
 		void addTrajectory(const std::string& filename) {
-			pTraj traj = createTrajectory(filename, _model);
-			_trajectories.push_back(traj);
-			if (traj->nframes() > _skip)
-				_nframes += (traj->nframes() - _skip) / _stride;
+			_trajectories.push_back(openTrajectory(filename, _model));
+			_filenames.push_back(filename);
+			_nframes += nframes(_trajectories.size() - 1);
 		}
 
 
@@ -156,6 +175,43 @@ namespace loos {
 			return _curtraj >= _trajectories.size();
 		}
 
+
+		//! Split the composite trajectory into runs of frames for n workers
+		/**
+		 * Each usable sub-trajectory is one run, unless there are fewer of
+		 * them than workers, in which case each is split into roughly
+		 * equal runs so that every worker has something to do.  Runs are
+		 * in composite frame order.
+		 */
+		std::vector<FrameRange> frameRanges(const uint n) const;
+
+		//! Calls f for every frame of the composite trajectory, using multiple threads
+		/**
+		 * f is called as f(frame, i), where frame is a thread-private copy
+		 * of g holding the coordinates (and periodic box) of composite
+		 * frame i.  Threads take whole runs of frames (see frameRanges())
+		 * and read them through their own trajectory handles, so f is
+		 * called concurrently and in no particular order, and must be
+		 * thread-safe.  The first exception thrown by f is rethrown once
+		 * all threads are done.  The current frame of the
+		 * MultiTrajectory is unchanged.  nthreads of 0 means use all
+		 * cores.
+		 */
+		void parallelFrames(const AtomicGroup& g, const FrameFunction& f, const uint nthreads = 0);
+
+		//! Collects f(frame, i) for every frame, computed in parallel, in composite frame order
+		/**
+		 * See parallelFrames().  T must be default-constructible (and
+		 * should not be bool, as std::vector<bool> elements cannot be
+		 * written concurrently).
+		 */
+		template<typename T, class Function>
+		std::vector<T> parallelMap(const AtomicGroup& g, Function f, const uint nthreads = 0) {
+			std::vector<T> results(_nframes);
+			parallelFrames(g, [&results, &f](AtomicGroup& frame, const uint i) { results[i] = f(frame, i); }, nthreads);
+			return(results);
+		}
+
 	private:
 
 		virtual void rewindImpl();
@@ -163,9 +219,13 @@ namespace loos {
 		virtual void seekFrameImpl(const uint i);
 		virtual bool parseFrame();
 		virtual void updateGroupCoordsImpl(AtomicGroup& g);
+		virtual void updateViewCoordsImpl(const AtomicGroupView& view);
 		virtual void updateGroupVelocitiesImpl(AtomicGroup& g);
 
 		void findNextUsableTraj();
+		void readRange(const FrameRange& range, const bool reuse, AtomicGroup& frame, const FrameFunction& f);
+
+		static pTraj openTrajectory(const std::string& filename, const AtomicGroup& model);
 
 
 		// Make these private so you can't accidently try to use them...
@@ -178,8 +238,10 @@ namespace loos {
 		uint _nframes;
 		uint _skip, _stride;
 		uint _curtraj, _curframe;
+		uint _nthreads;
 		AtomicGroup _model;
 		std::vector<pTraj> _trajectories;
+		std::vector<std::string> _filenames;
 
 	};
 
@@ -0,0 +1,254 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include <NativeContacts.hpp>
+#include <Trajectory.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <algorithm>
+
+
+namespace loos {
+
+
+  NativeContacts::NativeContacts(const std::vector<AtomicGroup>& groups, const double cutoff,
+                                 const uint min_separation, const bool periodic)
+    : cutoff_(cutoff), periodic_(periodic)
+  {
+    setupGroups(groups);
+
+    std::vector<double> crds = currentCoords();
+    uint n = groups.size();
+    std::vector<double> c(3 * n);
+    centers(crds.data(), c.data());
+
+    GCoord box = atoms_.periodicBox();
+    double cut2 = cutoff * cutoff;
+    for (uint i=0; i+min_separation<n; ++i)
+      for (uint j=i+min_separation; j<n; ++j) {
+        GCoord diff(c[3*j] - c[3*i], c[3*j+1] - c[3*i+1], c[3*j+2] - c[3*i+2]);
+        if (periodic_)
+          diff.reimage(box);
+        if (diff.length2() <= cut2) {
+          first_.push_back(i);
+          second_.push_back(j);
+        }
+      }
+  }
+
+
+  NativeContacts::NativeContacts(const std::vector<AtomicGroup>& groups, const std::vector<Pair>& pairs,
+                                 const double cutoff, const bool periodic)
+    : cutoff_(cutoff), periodic_(periodic)
+  {
+    setupGroups(groups);
+
+    for (std::vector<Pair>::const_iterator i = pairs.begin(); i != pairs.end(); ++i) {
+      if (i->first >= groups.size() || i->second >= groups.size())
+        throw(LOOSError("Contact pair refers to a group that does not exist"));
+      first_.push_back(i->first);
+      second_.push_back(i->second);
+    }
+  }
+
+
+  // Atoms of all groups are concatenated, with offsets_ marking where
+  // each group starts.  atoms_ starts as a copy of the first group so
+  // that it shares that group's periodic box.  The weights are summed
+  // in the same order as AtomicGroup::centerOfMass() so the centers
+  // come out the same.
+  void NativeContacts::setupGroups(const std::vector<AtomicGroup>& groups) {
+    offsets_.push_back(0);
+    for (uint k=0; k<groups.size(); ++k) {
+      const AtomicGroup& g = groups[k];
+      if (g.empty())
+        throw(LOOSError("Cannot track contacts of an empty group"));
+
+      if (k == 0)
+        atoms_ = g;
+      else
+        atoms_.append(g);
+
+      double total = 0.0;
+      for (AtomicGroup::const_iterator i = g.begin(); i != g.end(); ++i) {
+        masses_.push_back((*i)->mass());
+        total += (*i)->mass();
+      }
+      total_mass_.push_back(total);
+      offsets_.push_back(atoms_.size());
+    }
+  }
+
+
+  std::vector<double> NativeContacts::currentCoords() const {
+    std::vector<double> crds(3 * atoms_.size());
+    for (uint i=0; i<atoms_.size(); ++i) {
+      const GCoord& x = atoms_[i]->coords();
+      crds[3*i] = x[0];
+      crds[3*i+1] = x[1];
+      crds[3*i+2] = x[2];
+    }
+    return(crds);
+  }
+
+
+  void NativeContacts::centers(const double* crds, double* c) const {
+    uint n = total_mass_.size();
+    for (uint g=0; g<n; ++g) {
+      uint begin = offsets_[g];
+      uint end = offsets_[g+1];
+      const double* x = crds + 3 * begin;
+
+      if (end - begin == 1) {
+        c[3*g] = x[0];
+        c[3*g+1] = x[1];
+        c[3*g+2] = x[2];
+        continue;
+      }
+
+      double cx = 0.0, cy = 0.0, cz = 0.0;
+      for (uint i=begin; i<end; ++i, x += 3) {
+        double m = masses_[i];
+        cx += m * x[0];
+        cy += m * x[1];
+        cz += m * x[2];
+      }
+      double total = total_mass_[g];
+      c[3*g] = cx / total;
+      c[3*g+1] = cy / total;
+      c[3*g+2] = cz / total;
+    }
+  }
+
+
+  void NativeContacts::pairDistances(const double* c, const GCoord& box, double* d2) const {
+    const uint n = first_.size();
+    const uint* a = first_.data();
+    const uint* b = second_.data();
+
+    if (!periodic_) {
+      for (uint k=0; k<n; ++k) {
+        const double* u = c + 3 * a[k];
+        const double* v = c + 3 * b[k];
+        double dx = v[0] - u[0];
+        double dy = v[1] - u[1];
+        double dz = v[2] - u[2];
+        d2[k] = dx*dx + dy*dy + dz*dz;
+      }
+      return;
+    }
+
+    for (uint k=0; k<n; ++k) {
+      GCoord diff(c[3*b[k]] - c[3*a[k]], c[3*b[k]+1] - c[3*a[k]+1], c[3*b[k]+2] - c[3*a[k]+2]);
+      diff.reimage(box);
+      d2[k] = diff.length2();
+    }
+  }
+
+
+  void NativeContacts::distances2(const double* crds, const GCoord& box, double* d2) const {
+    std::vector<double> c(3 * total_mass_.size());
+    centers(crds, c.data());
+    pairDistances(c.data(), box, d2);
+  }
+
+
+  std::vector<double> NativeContacts::distances2() const {
+    std::vector<double> crds = currentCoords();
+    std::vector<double> d2(first_.size());
+    distances2(crds.data(), atoms_.periodicBox(), d2.data());
+    return(d2);
+  }
+
+
+  double NativeContacts::fraction() const {
+    std::vector<double> d2 = distances2();
+    double cut2 = cutoff_ * cutoff_;
+    uint n = 0;
+    for (uint k=0; k<d2.size(); ++k)
+      if (d2[k] <= cut2)
+        ++n;
+    return(static_cast<double>(n) / d2.size());
+  }
+
+
+  // Frames are read in blocks of about 16MB of coordinates, the
+  // distances for a block are computed in parallel, and then handed
+  // to f in order.
+  void NativeContacts::scan(pTraj& traj, const std::vector<uint>& frames,
+                            const boost::function<void(const uint, const double*)>& f,
+                            const uint nthreads) const {
+    if (periodic_ && !traj->hasPeriodicBox())
+      throw(LOOSError("Periodic contacts requested, but the trajectory has no periodic box"));
+
+    const size_t frame_values = 3 * atoms_.size();
+    const size_t batch_bytes = 16 << 20;
+    uint batch = std::max<size_t>(1, batch_bytes / (std::max<size_t>(1, frame_values) * sizeof(double)));
+    const uint npairs = first_.size();
+    const uint ngroups = total_mass_.size();
+
+    std::vector<double> crds;
+    std::vector<GCoord> boxes;
+    std::vector<double> d2;
+    for (uint first=0; first<frames.size(); first += batch) {
+      std::vector<uint> block(frames.begin() + first, frames.begin() + std::min<size_t>(first + batch, frames.size()));
+      crds.resize(block.size() * frame_values);
+      boxes.assign(block.size(), GCoord(0,0,0));
+      d2.resize(block.size() * npairs);
+      traj->readFrames(block, atoms_, crds.data(), periodic_ ? boxes.data() : 0);
+
+      const uint nchunks = std::max(1u, std::min(static_cast<uint>(block.size()), nthreads == 0 ? 64u : nthreads));
+      internal::parallelFor(nchunks, nthreads, [&](uint chunk) {
+          std::vector<double> c(3 * ngroups);
+          for (uint j=chunk; j<block.size(); j += nchunks) {
+            centers(crds.data() + j * frame_values, c.data());
+            pairDistances(c.data(), boxes[j], d2.data() + j * npairs);
+          }
+        });
+
+      for (uint j=0; j<block.size(); ++j)
+        f(first + j, d2.data() + j * npairs);
+    }
+  }
+
+
+  std::vector<double> NativeContacts::fractions(pTraj& traj, const std::vector<uint>& frames,
+                                                const uint nthreads) const {
+    std::vector<double> q(frames.size());
+    const double cut2 = cutoff_ * cutoff_;
+    const uint npairs = first_.size();
+
+    scan(traj, frames, [&](const uint j, const double* d2) {
+        uint n = 0;
+        for (uint k=0; k<npairs; ++k)
+          if (d2[k] <= cut2)
+            ++n;
+        q[j] = static_cast<double>(n) / npairs;
+      }, nthreads);
+
+    return(q);
+  }
+
+}
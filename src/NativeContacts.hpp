@@ -0,0 +1,126 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_NATIVECONTACTS_HPP)
+#define LOOS_NATIVECONTACTS_HPP
+
+#include <vector>
+#include <utility>
+
+#include <boost/function.hpp>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+  //! Fixed list of contacts between the centers of mass of groups (e.g. residues)
+  /**
+   * The pairs of groups to track are picked once, either from the
+   * current coordinates of the groups (every pair closer than the
+   * cutoff, as for native contacts) or from an explicit list.  They are
+   * stored as flat index arrays, along with each group's atoms and mass
+   * weights, so evaluating a frame is one pass over the atoms to get
+   * the centers of mass followed by one pass over the pairs.
+   *
+   * scan() and fractions() read a trajectory in blocks of frames with
+   * Trajectory::readFrames() and evaluate the frames of each block on
+   * nthreads threads (0 = all cores).
+   */
+  class NativeContacts {
+  public:
+    typedef std::pair<uint, uint> Pair;
+
+    //! Track every pair (i, j), j >= i + min_separation, whose centers are within cutoff now
+    /**
+     * If periodic is set, the distances (both now and when evaluating
+     * frames) use the minimum image.
+     */
+    NativeContacts(const std::vector<AtomicGroup>& groups, const double cutoff,
+                   const uint min_separation = 1, const bool periodic = false);
+
+    //! Track the given pairs of indices into groups
+    NativeContacts(const std::vector<AtomicGroup>& groups, const std::vector<Pair>& pairs,
+                   const double cutoff, const bool periodic = false);
+
+    //! Number of pairs tracked
+    uint size() const { return(first_.size()); }
+
+    //! The i'th pair, as indices into the groups
+    Pair pair(const uint i) const { return(Pair(first_[i], second_[i])); }
+
+    double cutoff() const { return(cutoff_); }
+
+    //! Whether distances use the minimum image
+    bool periodic() const { return(periodic_); }
+    void periodic(const bool b) { periodic_ = b; }
+
+    //! All atoms of the groups, in the order the coordinates are read
+    const AtomicGroup& atoms() const { return(atoms_); }
+
+    //! Squared distance of each pair from the groups' current coordinates
+    std::vector<double> distances2() const;
+
+    //! Fraction of pairs within the cutoff from the groups' current coordinates
+    double fraction() const;
+
+#if !defined(SWIG)
+    //! Squared pair distances for coordinates laid out as atoms()
+    /**
+     * crds holds x, y, z for each atom of atoms() and d2 receives one
+     * value per pair.  box is only used if the contacts are periodic.
+     */
+    void distances2(const double* crds, const GCoord& box, double* d2) const;
+#endif
+
+#if !defined(SWIG)
+    //! Calls f(j, d2) with the squared pair distances for frames[j], in order
+    void scan(pTraj& traj, const std::vector<uint>& frames,
+              const boost::function<void(const uint, const double*)>& f,
+              const uint nthreads = 0) const;
+#endif
+
+    //! Fraction of pairs within the cutoff for each of the frames
+    std::vector<double> fractions(pTraj& traj, const std::vector<uint>& frames,
+                                  const uint nthreads = 0) const;
+
+  private:
+    void setupGroups(const std::vector<AtomicGroup>& groups);
+    void centers(const double* crds, double* c) const;
+    void pairDistances(const double* c, const GCoord& box, double* d2) const;
+    std::vector<double> currentCoords() const;
+
+    double cutoff_;
+    bool periodic_;
+    AtomicGroup atoms_;
+    std::vector<uint> offsets_;
+    std::vector<double> masses_, total_mass_;
+    std::vector<uint> first_, second_;
+  };
+
+}
+
+
+#endif
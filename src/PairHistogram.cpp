@@ -0,0 +1,263 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <PairHistogram.hpp>
+#include <AtomicGroup.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+#include <boost/thread/thread.hpp>
+
+
+namespace loos {
+
+
+  PairHistogram::PairHistogram(const double hist_min, const double hist_max, const uint num_bins,
+                               const bool planar, const uint nthreads)
+    : hist_min_(hist_min), hist_max_(hist_max),
+      min2_(hist_min * hist_min), max2_(hist_max * hist_max),
+      bin_width_((hist_max - hist_min) / num_bins),
+      planar_(planar), nthreads_(nthreads),
+      hist_(num_bins, 0.0)
+  {
+    if (num_bins == 0 || !(hist_max > hist_min) || hist_min < 0.0)
+      throw(LOOSError("PairHistogram needs at least one bin and 0 <= min < max"));
+  }
+
+
+  void PairHistogram::clear() {
+    hist_.assign(hist_.size(), 0.0);
+  }
+
+
+  // Uses the same minimum-image arithmetic as GCoord::distance2() so
+  // that results match the all-pairs loops the tools used to have
+
+  inline void PairHistogram::bin(const GCoord& p, const GCoord& q, const GCoord& box, Counts& counts) const {
+    GCoord d = q - p;
+    d.reimage(box);
+    double d2 = planar_ ? d.x() * d.x() + d.y() * d.y() : d.length2();
+    if (d2 < max2_ && d2 > min2_) {
+      uint k = static_cast<uint>((sqrt(d2) - hist_min_) / bin_width_);
+      ++counts[std::min(k, static_cast<uint>(counts.size()) - 1)];
+    }
+  }
+
+
+  void PairHistogram::bruteForce(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                                 const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                                 const GCoord& box, std::vector<Counts>& counts) const {
+    const uint nchunks = counts.size();
+    const bool labeled = !a_labels.empty();
+
+    internal::parallelFor(nchunks, nthreads_, [&](uint chunk) {
+        Counts& c = counts[chunk];
+        for (uint i=chunk; i<a.size(); i += nchunks)
+          for (uint j=0; j<b.size(); ++j) {
+            if (labeled && a_labels[i] == b_labels[j])
+              continue;
+            bin(a[i], b[j], box, c);
+          }
+      });
+  }
+
+
+  // The points of b are sorted by cell (CSR-style, with start giving the
+  // first point of each cell) so that each cell's points are contiguous.
+
+  void PairHistogram::cellList(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                               const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                               const GCoord& box, const uint* ncells, std::vector<Counts>& counts) const {
+    const uint dims = planar_ ? 2 : 3;
+    const uint ntotal = ncells[0] * ncells[1] * ncells[2];
+    const bool labeled = !a_labels.empty();
+
+    // Wraps each point into the box to find its cell
+    struct CellFinder {
+      const GCoord& box;
+      const uint* n;
+      uint dims;
+      CellFinder(const GCoord& bx, const uint* nc, const uint d) : box(bx), n(nc), dims(d) { }
+      void operator()(const GCoord& p, uint* c) const {
+        c[2] = 0;
+        for (uint d=0; d<dims; ++d) {
+          double f = p[d] / box[d];
+          f -= floor(f);
+          c[d] = std::min(static_cast<uint>(f * n[d]), n[d] - 1);
+        }
+      }
+    } cellOf(box, ncells, dims);
+
+    std::vector<uint> start(ntotal + 1, 0);
+    std::vector<uint> cell(b.size());
+    for (uint j=0; j<b.size(); ++j) {
+      uint c[3];
+      cellOf(b[j], c);
+      cell[j] = (c[0] * ncells[1] + c[1]) * ncells[2] + c[2];
+      ++start[cell[j] + 1];
+    }
+    for (uint k=0; k<ntotal; ++k)
+      start[k+1] += start[k];
+
+    std::vector<GCoord> sorted(b.size());
+    std::vector<uint> sorted_labels(labeled ? b.size() : 0);
+    std::vector<uint> fill(start.begin(), start.end() - 1);
+    for (uint j=0; j<b.size(); ++j) {
+      uint k = fill[cell[j]]++;
+      sorted[k] = b[j];
+      if (labeled)
+        sorted_labels[k] = b_labels[j];
+    }
+
+    const int zrange = planar_ ? 0 : 1;
+    const uint nchunks = counts.size();
+    internal::parallelFor(nchunks, nthreads_, [&](uint chunk) {
+        Counts& cnt = counts[chunk];
+        for (uint i=chunk; i<a.size(); i += nchunks) {
+          uint c[3];
+          cellOf(a[i], c);
+          for (int dx=-1; dx<=1; ++dx) {
+            uint x = (c[0] + ncells[0] + dx) % ncells[0];
+            for (int dy=-1; dy<=1; ++dy) {
+              uint y = (c[1] + ncells[1] + dy) % ncells[1];
+              for (int dz=-zrange; dz<=zrange; ++dz) {
+                uint z = (c[2] + ncells[2] + dz) % ncells[2];
+                uint k = (x * ncells[1] + y) * ncells[2] + z;
+                for (uint j=start[k]; j<start[k+1]; ++j) {
+                  if (labeled && a_labels[i] == sorted_labels[j])
+                    continue;
+                  bin(a[i], sorted[j], box, cnt);
+                }
+              }
+            }
+          }
+        }
+      });
+  }
+
+
+  ulong PairHistogram::accumulate(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                                  const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                                  const GCoord& box, const double weight) {
+    if (a_labels.size() != (a_labels.empty() ? 0 : a.size())
+        || b_labels.size() != (a_labels.empty() ? 0 : b.size()))
+      throw(LOOSError("PairHistogram labels must be given for every point of both sets, or not at all"));
+
+    // Count the pairs that will not be skipped
+    ulong npairs = static_cast<ulong>(a.size()) * b.size();
+    if (!a_labels.empty()) {
+      std::vector<uint> sorted(b_labels);
+      std::sort(sorted.begin(), sorted.end());
+      for (uint i=0; i<a_labels.size(); ++i) {
+        std::pair<std::vector<uint>::const_iterator, std::vector<uint>::const_iterator> r
+          = std::equal_range(sorted.begin(), sorted.end(), a_labels[i]);
+        npairs -= r.second - r.first;
+      }
+    }
+
+    if (a.empty() || b.empty())
+      return(npairs);
+
+    const uint dims = planar_ ? 2 : 3;
+    for (uint d=0; d<dims; ++d)
+      if (!(box[d] > 0.0))
+        throw(LOOSError("PairHistogram requires a periodic box"));
+
+    // Cells are at least hist_max wide (with a little slack for
+    // rounding when the points are wrapped).  Their number is also capped
+    // relative to the number of points, so a short range in a large box
+    // does not make a mostly empty grid.
+    uint ncells[3] = {1, 1, 1};
+    const uint cap = std::max(3u, static_cast<uint>(2.0 * pow(b.size(), 1.0 / dims)));
+    bool use_cells = true;
+    for (uint d=0; d<dims; ++d) {
+      ncells[d] = std::min(cap, static_cast<uint>(box[d] / (hist_max_ * 1.0001)));
+      if (ncells[d] < 3)
+        use_cells = false;
+    }
+
+    uint nt = nthreads_ ? nthreads_ : boost::thread::hardware_concurrency();
+    uint nchunks = std::max(1u, std::min(4 * nt, static_cast<uint>(a.size())));
+    std::vector<Counts> counts(nchunks, Counts(hist_.size(), 0));
+
+    if (use_cells)
+      cellList(a, a_labels, b, b_labels, box, ncells, counts);
+    else
+      bruteForce(a, a_labels, b, b_labels, box, counts);
+
+    for (uint c=0; c<nchunks; ++c)
+      for (uint k=0; k<hist_.size(); ++k)
+        hist_[k] += weight * counts[c][k];
+
+    return(npairs);
+  }
+
+
+  ulong PairHistogram::accumulate(const std::vector<GCoord>& a, const std::vector<GCoord>& b,
+                                  const GCoord& box, const double weight) {
+    return(accumulate(a, std::vector<uint>(), b, std::vector<uint>(), box, weight));
+  }
+
+
+
+  // Groups are equal when they hold the same atoms (see
+  // AtomicGroup::operator==()), so they are keyed by their sorted atoms
+
+  void PairHistogram::labelGroups(const std::vector<AtomicGroup>& a, const std::vector<AtomicGroup>& b,
+                                  std::vector<uint>& a_labels, std::vector<uint>& b_labels) {
+    typedef std::vector<const Atom*> Key;
+    std::map<Key, uint> labels;
+
+    for (uint pass=0; pass<2; ++pass) {
+      const std::vector<AtomicGroup>& groups = pass ? b : a;
+      std::vector<uint>& out = pass ? b_labels : a_labels;
+      out.resize(groups.size());
+      for (uint i=0; i<groups.size(); ++i) {
+        Key key;
+        for (AtomicGroup::const_iterator j = groups[i].begin(); j != groups[i].end(); ++j)
+          key.push_back(j->get());
+        std::sort(key.begin(), key.end());
+        out[i] = labels.insert(std::pair<Key, uint>(key, labels.size())).first->second;
+      }
+    }
+  }
+
+
+  void PairHistogram::labelAtoms(const AtomicGroup& a, const AtomicGroup& b,
+                                 std::vector<uint>& a_labels, std::vector<uint>& b_labels) {
+    std::map<const Atom*, uint> labels;
+
+    for (uint pass=0; pass<2; ++pass) {
+      const AtomicGroup& group = pass ? b : a;
+      std::vector<uint>& out = pass ? b_labels : a_labels;
+      out.resize(group.size());
+      for (uint i=0; i<group.size(); ++i)
+        out[i] = labels.insert(std::pair<const Atom*, uint>(group[i].get(), labels.size())).first->second;
+    }
+  }
+
+}
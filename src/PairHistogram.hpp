@@ -0,0 +1,115 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_PAIRHISTOGRAM_HPP)
+#define LOOS_PAIRHISTOGRAM_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  class AtomicGroup;
+
+  //! Histogram of periodic distances between two sets of points
+  /**
+   * Bins the minimum-image distance between every point of one set and
+   * every point of another, as the rdf tools do.  Only the range
+   * [hist_min, hist_max) is binned, so the second set is sorted into a
+   * cell list with cells at least hist_max wide and each point of the
+   * first set only visits its neighboring cells.  When the box is too
+   * small for that (fewer than 3 cells along a side), every pair is
+   * checked instead.
+   *
+   * A planar histogram uses the distance in the x-y plane only (e.g. for
+   * membranes), and the cell list is 2-D.
+   *
+   * The points of the first set are divided among nthreads threads
+   * (0 = all cores), each binning into its own histogram; these are
+   * added together at the end of accumulate().
+   */
+  class PairHistogram {
+  public:
+    PairHistogram(const double hist_min, const double hist_max, const uint num_bins,
+                  const bool planar = false, const uint nthreads = 0);
+
+    //! Bin the distances from every point in a to every point in b
+    /**
+     * Pairs are counted in both directions if the two sets share points.
+     * Pairs with the same label are skipped (e.g. a group paired with
+     * itself when the two selections overlap).  Empty label vectors skip
+     * nothing.  Each pair adds weight to its bin.
+     *
+     * Returns the number of pairs that were not skipped, whether or not
+     * they fell within the histogram.
+     */
+    ulong accumulate(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                     const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                     const GCoord& box, const double weight = 1.0);
+
+    //! Bin the distances from every point in a to every point in b
+    ulong accumulate(const std::vector<GCoord>& a, const std::vector<GCoord>& b,
+                     const GCoord& box, const double weight = 1.0);
+
+    //! The accumulated (weighted) counts in each bin
+    const std::vector<double>& histogram() const { return(hist_); }
+
+    //! Zero the histogram
+    void clear();
+
+    double binWidth() const { return(bin_width_); }
+    uint bins() const { return(hist_.size()); }
+
+    //! Labels two lists of groups, giving groups with the same atoms the same label
+    static void labelGroups(const std::vector<AtomicGroup>& a, const std::vector<AtomicGroup>& b,
+                            std::vector<uint>& a_labels, std::vector<uint>& b_labels);
+
+    //! Labels the atoms of two groups, giving each atom the same label in both
+    static void labelAtoms(const AtomicGroup& a, const AtomicGroup& b,
+                           std::vector<uint>& a_labels, std::vector<uint>& b_labels);
+
+  private:
+    typedef std::vector<ulong> Counts;
+
+    void bruteForce(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                    const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                    const GCoord& box, std::vector<Counts>& counts) const;
+    void cellList(const std::vector<GCoord>& a, const std::vector<uint>& a_labels,
+                  const std::vector<GCoord>& b, const std::vector<uint>& b_labels,
+                  const GCoord& box, const uint* ncells, std::vector<Counts>& counts) const;
+    void bin(const GCoord& p, const GCoord& q, const GCoord& box, Counts& counts) const;
+
+    double hist_min_, hist_max_;
+    double min2_, max2_;
+    double bin_width_;
+    bool planar_;
+    uint nthreads_;
+    std::vector<double> hist_;
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,79 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <ParallelFor.hpp>
+
+#include <algorithm>
+#include <exception>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    void parallelFor(const uint n, const uint nthreads, const boost::function<void(uint)>& f) {
+      uint nt = nthreads ? nthreads : boost::thread::hardware_concurrency();
+      nt = std::max(1u, std::min(nt, n));
+
+      if (nt == 1) {
+        for (uint i=0; i<n; ++i)
+          f(i);
+        return;
+      }
+
+      boost::mutex lock;
+      uint next = 0;
+      std::exception_ptr error;
+      boost::thread_group threads;
+      for (uint t=0; t<nt; ++t)
+        threads.create_thread([&]() {
+            try {
+              while (true) {
+                uint i;
+                {
+                  boost::mutex::scoped_lock guard(lock);
+                  if (next >= n || error)
+                    return;
+                  i = next++;
+                }
+                f(i);
+              }
+            }
+            catch (...) {
+              boost::mutex::scoped_lock guard(lock);
+              if (!error)
+                error = std::current_exception();
+            }
+          });
+      threads.join_all();
+
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+  }
+
+}
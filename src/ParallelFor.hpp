@@ -0,0 +1,51 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_PARALLELFOR_HPP)
+#define LOOS_PARALLELFOR_HPP
+
+#include <boost/function.hpp>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    //! Calls f(i) for i in [0, n) using up to nthreads threads (0 = all cores)
+    /**
+     * Indices are handed out in order as threads become free, so uneven
+     * amounts of work per index balance out.  The first exception thrown
+     * by f is rethrown in the calling thread once all threads are done
+     * (indices not yet started are skipped).
+     */
+    void parallelFor(const uint n, const uint nthreads, const boost::function<void(uint)>& f);
+
+  }
+
+}
+
+
+#endif
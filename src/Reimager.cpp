@@ -0,0 +1,171 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#include <Reimager.hpp>
+#include <ParallelFor.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // Same arithmetic as GCoord::reimage() for one component
+    inline double reimaged(const double x, const double box) {
+      int n = (int)(fabs(x) / box + 0.5);
+      return((x >= 0) ? x - n * box : x + n * box);
+    }
+
+  }
+
+
+  Reimager::Reimager(const AtomicGroup& system, const std::vector<AtomicGroup>& groups)
+    : system_(system)
+  {
+    boost::unordered_map<const Atom*, uint> position;
+    for (uint i=0; i<system_.size(); ++i)
+      position[system_[i].get()] = i;
+
+    offsets_.push_back(0);
+    for (std::vector<AtomicGroup>::const_iterator g = groups.begin(); g != groups.end(); ++g) {
+      for (AtomicGroup::const_iterator a = g->begin(); a != g->end(); ++a) {
+        boost::unordered_map<const Atom*, uint>::const_iterator p = position.find(a->get());
+        if (p == position.end())
+          throw(LOOSError(**a, "Atom is not in the system being reimaged"));
+        positions_.push_back(p->second);
+      }
+      offsets_.push_back(positions_.size());
+    }
+  }
+
+
+  void Reimager::getCoords(std::vector<double>& crds) const {
+    crds.resize(3 * system_.size());
+    for (uint i=0; i<system_.size(); ++i) {
+      const GCoord& x = system_[i]->coords();
+      crds[3*i] = x[0];
+      crds[3*i+1] = x[1];
+      crds[3*i+2] = x[2];
+    }
+  }
+
+
+  void Reimager::reimage() {
+    if (!system_.isPeriodic())
+      throw(LOOSError("trying to reimage a non-periodic group"));
+
+    std::vector<double> crds;
+    getCoords(crds);
+    reimage(crds.data(), system_.periodicBox());
+    system_.setCoords(crds.data(), system_.size(), 3);
+  }
+
+
+  void Reimager::mergeImages() {
+    if (!system_.isPeriodic())
+      throw(LOOSError("trying to reimage a non-periodic group"));
+
+    std::vector<double> crds;
+    getCoords(crds);
+    mergeImages(crds.data(), system_.periodicBox());
+    system_.setCoords(crds.data(), system_.size(), 3);
+  }
+
+
+  // The centroid is summed in group order and divided by the group
+  // size, exactly as AtomicGroup::centroid() does
+  void Reimager::reimage(double* crds, const GCoord& box) const {
+    for (uint g=0; g<size(); ++g) {
+      const uint first = offsets_[g], last = offsets_[g+1];
+      if (first == last)
+        continue;
+
+      double c[3] = {0.0, 0.0, 0.0};
+      for (uint i=first; i<last; ++i) {
+        const double* x = crds + 3 * positions_[i];
+        c[0] += x[0];
+        c[1] += x[1];
+        c[2] += x[2];
+      }
+      const double n = last - first;
+      double trans[3];
+      for (uint k=0; k<3; ++k) {
+        if (last - first > 1)
+          c[k] /= n;
+        trans[k] = reimaged(c[k], box[k]) - c[k];
+      }
+
+      for (uint i=first; i<last; ++i) {
+        double* x = crds + 3 * positions_[i];
+        x[0] += trans[0];
+        x[1] += trans[1];
+        x[2] += trans[2];
+      }
+    }
+  }
+
+
+  void Reimager::mergeImages(double* crds, const GCoord& box) const {
+    for (uint g=0; g<size(); ++g) {
+      const uint first = offsets_[g], last = offsets_[g+1];
+      if (first == last)
+        continue;
+
+      const double* r = crds + 3 * positions_[first];
+      const double ref[3] = { r[0], r[1], r[2] };
+      for (uint i=first; i<last; ++i) {
+        double* x = crds + 3 * positions_[i];
+        for (uint k=0; k<3; ++k)
+          x[k] = reimaged(x[k] - ref[k], box[k]) + ref[k];
+      }
+    }
+  }
+
+
+  void Reimager::forFrames(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads,
+                           void (Reimager::*op)(double*, const GCoord&) const) const {
+    const size_t frame_values = 3 * system_.size();
+    const uint nchunks = std::max(1u, std::min(nframes, nthreads == 0 ? 64u : nthreads));
+    internal::parallelFor(nchunks, nthreads, [&](uint chunk) {
+        for (uint j=chunk; j<nframes; j += nchunks)
+          (this->*op)(crds + j * frame_values, boxes[j]);
+      });
+  }
+
+
+  void Reimager::reimage(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads) const {
+    forFrames(crds, boxes, nframes, nthreads, &Reimager::reimage);
+  }
+
+
+  void Reimager::mergeImages(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads) const {
+    forFrames(crds, boxes, nframes, nthreads, &Reimager::mergeImages);
+  }
+
+}
@@ -0,0 +1,103 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#if !defined(LOOS_REIMAGER_HPP)
+#define LOOS_REIMAGER_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+  //! Reimages every group (e.g. molecule or segment) of a system at once
+  /**
+   * The groups are given once, as subsets of the system, and are stored
+   * as offsets into a flat list of atom positions within the system.
+   * Reimaging a frame is then a pass over a coordinate array laid out
+   * like the system (x, y, z per atom), without walking the atoms of
+   * each group or looking up its periodic box.
+   *
+   * reimage() does what AtomicGroup::reimage() does for each group in
+   * turn (translate the group so its centroid is in the primary cell),
+   * and mergeImages() does what AtomicGroup::mergeImage() does (bring
+   * each atom into the image nearest the group's first atom).  Results
+   * are identical to calling those on each group, in order.  Atoms that
+   * are in none of the groups are left alone.
+   *
+   * Periodic boxes in LOOS are rectangular, so only orthorhombic cells
+   * are handled.  When given several frames, the frames are divided
+   * among nthreads threads (0 = all cores).
+   */
+  class Reimager {
+  public:
+    //! Every atom in the groups must also be in system
+    Reimager(const AtomicGroup& system, const std::vector<AtomicGroup>& groups);
+
+    //! Uses the parts of a partition of system (e.g. system.moleculePartition())
+    Reimager(const AtomicGroup& system, const GroupPartition& partition)
+      : system_(system), offsets_(partition.offsets()), positions_(partition.positions()) { }
+
+    //! Number of groups
+    uint size() const { return(offsets_.size() - 1); }
+
+    //! The system the coordinates are laid out by
+    const AtomicGroup& system() const { return(system_); }
+
+    //! Reimages the groups in the system's current coordinates and box
+    void reimage();
+
+    //! Merges the images of the groups in the system's current coordinates and box
+    void mergeImages();
+
+#if !defined(SWIG)
+    //! Reimages the groups in one frame of coordinates laid out as system()
+    void reimage(double* crds, const GCoord& box) const;
+
+    //! Reimages nframes consecutive frames, each with its own box
+    void reimage(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads = 0) const;
+
+    //! Merges the images of the groups in one frame laid out as system()
+    void mergeImages(double* crds, const GCoord& box) const;
+
+    //! Merges the images of the groups in nframes consecutive frames
+    void mergeImages(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads = 0) const;
+#endif
+
+  private:
+    void getCoords(std::vector<double>& crds) const;
+    void forFrames(double* crds, const GCoord* boxes, const uint nframes, const uint nthreads,
+                   void (Reimager::*op)(double*, const GCoord&) const) const;
+
+    AtomicGroup system_;
+    std::vector<uint> offsets_, positions_;
+  };
+
+}
+
+
+#endif
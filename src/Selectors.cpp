@@ -30,7 +30,8 @@ namespace loos {
 
 
   bool CAlphaSelector::operator()(const pAtom& pa) const {
-    return(pa->name() == "CA");
+    static const UniqueStrings::Handle ca = UniqueStrings::atomProperties().add("CA");
+    return(pa->nameHandle() == ca);
   }
 
 
@@ -132,11 +133,11 @@ namespace loos {
   }
 
   bool SegidSelector::operator()(const pAtom& pa) const {
-    return(pa->segid() == str);
+    return(pa->segidHandle() == handle);
   }
 
   bool AtomNameSelector::operator()(const pAtom& pa) const {
-    return(pa->name() == str);
+    return(pa->nameHandle() == handle);
   }
 
   bool ResidRangeSelector::operator()(const pAtom& pa) const {
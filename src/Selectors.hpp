@@ -64,19 +64,21 @@ namespace loos {
 
   //! Predicate for selecting atoms based on the passed segid string
   struct SegidSelector : public AtomSelector {
-    explicit SegidSelector(const std::string s) : str(s) { }
+    explicit SegidSelector(const std::string s) : str(s), handle(UniqueStrings::atomProperties().add(s)) { }
     bool operator()(const pAtom&) const;
 
     std::string str;
+    UniqueStrings::Handle handle;
   };
 
 
   //! Predicate for selecting atoms based on explicit name matching
   struct AtomNameSelector : public AtomSelector {
-    explicit AtomNameSelector(const std::string& s) : str(s) { }
+    explicit AtomNameSelector(const std::string& s) : str(s), handle(UniqueStrings::atomProperties().add(s)) { }
     bool operator()(const pAtom&) const;
 
     std::string str;
+    UniqueStrings::Handle handle;
   };
 
 
@@ -33,6 +33,7 @@
 #include <sstream>
 
 #include <loos_defs.hpp>
+#include <Correlation.hpp>
 
 namespace loos {
 
@@ -498,6 +499,15 @@ public:
       return (block_ave2 - block_ave*block_ave)*ratio;
     }
 
+    //! Autocorrelation of the time series, out to max_time
+    /**
+     * Returns every interval'th lag below max_time, each divided by the
+     * number of pairs contributing to it.  If normalize is set, the
+     * series has its mean subtracted and is divided by its standard
+     * deviation first (a constant series returns all 1's).  The lagged
+     * sums come from autoCorrelationSums(), which uses an FFT for long
+     * series.
+     */
     TimeSeries<T> correl(const int max_time,
                          const int interval=1,
                          const bool normalize=true,
@@ -511,6 +521,8 @@ public:
 
       n /= interval;
       TimeSeries<T> c(n, 0.0);
+      if (n == 0)
+        return(c);
 
       // normalize the data
       if (normalize) {
@@ -526,22 +538,13 @@ public:
           data /= dev;
       }
 
-      std::vector<int> num_pairs(n);
-      num_pairs.assign(n, 0);
-      // TODO: This is the O(N^2) way -- there are much faster
-      // algorithms for long time series
-      for (int i = 0; i < max_time; i+=interval) {
-        int index = i / interval;
-        for (unsigned int j = 0; j < data.size() - i; j++) {
-          c[index] += data[j] * data[j+i];
-          num_pairs[index]++;
-        }
-
-      }
+      std::vector<double> x(data.begin(), data.end());
+      std::vector<double> sums = autoCorrelationSums(x, (n-1) * interval + 1);
 
       // Divide each value by the number of pairs used to generated it
       for (uint i = 0; i < n; i++) {
-        c[i] /= num_pairs[i];
+        uint lag = i * interval;
+        c[i] = sums[lag] / (data.size() - lag);
       }
 
       return(c);
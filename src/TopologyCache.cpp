@@ -0,0 +1,335 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <TopologyCache.hpp>
+#include <AtomicGroup.hpp>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+
+namespace loos {
+
+  const unsigned int TopologyCache::version = 1;
+  const char* TopologyCache::environment_variable = "LOOS_TOPOLOGY_CACHE";
+
+
+  namespace {
+
+    const char magic[8] = { 'L', 'O', 'O', 'S', 'T', 'O', 'P', 'O' };
+    const boost::uint32_t byte_order_mark = 0x01020304;
+
+    // Number of interned strings held by each Atom
+    const int nhandles = 8;
+
+    // Smallest possible atom record: 5 ints, the mask, 10 doubles,
+    // the string indices, and the bond count
+    const size_t min_atom_record = 5*4 + 8 + 10*8 + nhandles*4 + 4;
+
+
+    // Appends raw values to a byte buffer
+    class Packer {
+    public:
+      template<typename T> void put(const T x) {
+        buf.append(reinterpret_cast<const char*>(&x), sizeof(T));
+      }
+
+      void put(const std::string& s) {
+        put<boost::uint32_t>(s.size());
+        buf.append(s);
+      }
+
+      std::string buf;
+    };
+
+
+    // Pulls raw values back out of a byte buffer.  Reading past the end
+    // clears ok and returns zeros rather than throwing, so a truncated
+    // or corrupt snapshot is simply rejected.
+    class Unpacker {
+    public:
+      Unpacker(const char* p, const size_t n) : ptr(p), end(p + n), ok(true) { }
+
+      template<typename T> T get() {
+        T x = 0;
+        if (remaining() < sizeof(T)) {
+          ok = false;
+          return(x);
+        }
+        memcpy(&x, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return(x);
+      }
+
+      std::string getString() {
+        boost::uint32_t n = get<boost::uint32_t>();
+        if (remaining() < n) {
+          ok = false;
+          return(std::string());
+        }
+        std::string s(ptr, n);
+        ptr += n;
+        return(s);
+      }
+
+      size_t remaining() const { return(end - ptr); }
+
+      const char* ptr;
+      const char* end;
+      bool ok;
+    };
+
+
+    bool sourceStats(const std::string& filename, boost::int64_t& size, boost::int64_t& mtime) {
+      struct stat st;
+      if (stat(filename.c_str(), &st) != 0)
+        return(false);
+      size = st.st_size;
+      mtime = st.st_mtime;
+      return(true);
+    }
+
+  }
+
+
+
+  std::string TopologyCache::cacheName(const std::string& filename, const std::string& filetype) {
+    const char* dir = getenv(environment_variable);
+    if (dir == 0 || *dir == '\0')
+      return(std::string());
+
+    boost::filesystem::path source;
+    try {
+      source = boost::filesystem::absolute(filename);
+    }
+    catch (boost::filesystem::filesystem_error& e) {
+      return(std::string());
+    }
+
+    // The leaf name keeps the cache directory readable; the hash of the
+    // full path keeps same-named models in different directories apart.
+    std::ostringstream oss;
+    oss << source.filename().string() << '.' << filetype << '.'
+        << std::hex << std::hash<std::string>()(source.string() + '\n' + filetype)
+        << ".ltc";
+
+    return((boost::filesystem::path(dir) / oss.str()).string());
+  }
+
+
+
+  pAtomicGroup TopologyCache::read(const std::string& cachename, const std::string& filename) {
+    pAtomicGroup null;
+
+    boost::int64_t source_size, source_mtime;
+    if (!sourceStats(filename, source_size, source_mtime))
+      return(null);
+
+    struct stat st;
+    if (stat(cachename.c_str(), &st) != 0 || st.st_mtime < source_mtime)
+      return(null);
+
+    std::ifstream ifs(cachename.c_str(), std::ios::binary);
+    if (!ifs)
+      return(null);
+    std::vector<char> data(st.st_size);
+    if (!ifs.read(data.data(), data.size()))
+      return(null);
+
+    Unpacker u(data.data(), data.size());
+    if (u.remaining() < sizeof(magic) || memcmp(u.ptr, magic, sizeof(magic)) != 0)
+      return(null);
+    u.ptr += sizeof(magic);
+
+    if (u.get<boost::uint32_t>() != version || u.get<boost::uint32_t>() != byte_order_mark)
+      return(null);
+    if (u.get<boost::int64_t>() != source_size || u.get<boost::int64_t>() != source_mtime)
+      return(null);
+
+    boost::uint64_t natoms = u.get<boost::uint64_t>();
+    bool periodic = u.get<boost::uint8_t>();
+    GCoord box;
+    for (int i=0; i<3; ++i)
+      box[i] = u.get<double>();
+
+    boost::uint32_t nstrings = u.get<boost::uint32_t>();
+    if (!u.ok || nstrings > u.remaining() / sizeof(boost::uint32_t))
+      return(null);
+    UniqueStrings& table = UniqueStrings::atomProperties();
+    std::vector<UniqueStrings::Handle> strings(nstrings);
+    for (boost::uint32_t i=0; i<nstrings; ++i)
+      strings[i] = table.add(u.getString());
+
+    if (!u.ok || natoms > u.remaining() / min_atom_record)
+      return(null);
+
+    pAtomicGroup model(new AtomicGroup);
+    UniqueStrings::Handle* handles[nhandles];
+    for (boost::uint64_t i=0; i<natoms; ++i) {
+      pAtom pa(new Atom);
+      Atom& a = *pa;
+
+      a._id = u.get<boost::int32_t>();
+      a._index = u.get<boost::uint32_t>();
+      a._resid = u.get<boost::int32_t>();
+      a._atomic_number = u.get<boost::int32_t>();
+      a._atom_type = u.get<boost::int32_t>();
+      a.mask = u.get<boost::uint64_t>();
+      a._b = u.get<double>();
+      a._q = u.get<double>();
+      a._charge = u.get<double>();
+      a._mass = u.get<double>();
+      for (int j=0; j<3; ++j)
+        a._coords[j] = u.get<double>();
+      for (int j=0; j<3; ++j)
+        a._velocities[j] = u.get<double>();
+
+      handles[0] = &a._record;
+      handles[1] = &a._name;
+      handles[2] = &a._altloc;
+      handles[3] = &a._resname;
+      handles[4] = &a._chainid;
+      handles[5] = &a._icode;
+      handles[6] = &a._segid;
+      handles[7] = &a._pdbelement;
+      for (int j=0; j<nhandles; ++j) {
+        boost::uint32_t k = u.get<boost::uint32_t>();
+        if (k >= nstrings)
+          return(null);
+        *(handles[j]) = strings[k];
+      }
+
+      boost::uint32_t nbonds = u.get<boost::uint32_t>();
+      if (!u.ok || nbonds > u.remaining() / sizeof(boost::int32_t))
+        return(null);
+      a.bonds.resize(nbonds);
+      memcpy(a.bonds.data(), u.ptr, nbonds * sizeof(boost::int32_t));
+      u.ptr += nbonds * sizeof(boost::int32_t);
+
+      model->append(pa);
+    }
+
+    if (!u.ok || u.remaining() != 0)
+      return(null);
+
+    if (periodic)
+      model->periodicBox(box);
+
+    return(model);
+  }
+
+
+
+  bool TopologyCache::write(const std::string& cachename, const std::string& filename, const AtomicGroup& model) {
+    boost::int64_t source_size, source_mtime;
+    if (!sourceStats(filename, source_size, source_mtime))
+      return(false);
+
+    Packer p;
+    p.buf.append(magic, sizeof(magic));
+    p.put<boost::uint32_t>(version);
+    p.put<boost::uint32_t>(byte_order_mark);
+    p.put<boost::int64_t>(source_size);
+    p.put<boost::int64_t>(source_mtime);
+    p.put<boost::uint64_t>(model.size());
+    p.put<boost::uint8_t>(model.isPeriodic());
+    GCoord box = model.periodicBox();
+    for (int i=0; i<3; ++i)
+      p.put<double>(box[i]);
+
+    // Number the distinct strings in order of first appearance
+    std::unordered_map<UniqueStrings::Handle, boost::uint32_t> index_of;
+    std::vector<UniqueStrings::Handle> strings;
+    std::vector<boost::uint32_t> indices;
+    indices.reserve(model.size() * nhandles);
+    for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i) {
+      const Atom& a = **i;
+      UniqueStrings::Handle handles[nhandles] = { a._record, a._name, a._altloc, a._resname, a._chainid,
+                                                  a._icode, a._segid, a._pdbelement };
+      for (int j=0; j<nhandles; ++j) {
+        std::pair<std::unordered_map<UniqueStrings::Handle, boost::uint32_t>::iterator, bool> r =
+          index_of.insert(std::make_pair(handles[j], static_cast<boost::uint32_t>(strings.size())));
+        if (r.second)
+          strings.push_back(handles[j]);
+        indices.push_back(r.first->second);
+      }
+    }
+
+    p.put<boost::uint32_t>(strings.size());
+    for (std::vector<UniqueStrings::Handle>::const_iterator i = strings.begin(); i != strings.end(); ++i)
+      p.put(**i);
+
+    p.buf.reserve(p.buf.size() + model.size() * min_atom_record);
+    std::vector<boost::uint32_t>::const_iterator idx = indices.begin();
+    for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i) {
+      const Atom& a = **i;
+      p.put<boost::int32_t>(a._id);
+      p.put<boost::uint32_t>(a._index);
+      p.put<boost::int32_t>(a._resid);
+      p.put<boost::int32_t>(a._atomic_number);
+      p.put<boost::int32_t>(a._atom_type);
+      p.put<boost::uint64_t>(a.mask);
+      p.put<double>(a._b);
+      p.put<double>(a._q);
+      p.put<double>(a._charge);
+      p.put<double>(a._mass);
+      for (int j=0; j<3; ++j)
+        p.put<double>(a._coords[j]);
+      for (int j=0; j<3; ++j)
+        p.put<double>(a._velocities[j]);
+      for (int j=0; j<nhandles; ++j)
+        p.put<boost::uint32_t>(*idx++);
+
+      p.put<boost::uint32_t>(a.bonds.size());
+      for (std::vector<int>::const_iterator b = a.bonds.begin(); b != a.bonds.end(); ++b)
+        p.put<boost::int32_t>(*b);
+    }
+
+    std::ostringstream tmpname;
+    tmpname << cachename << ".tmp." << getpid();
+    std::ofstream ofs(tmpname.str().c_str(), std::ios::binary);
+    if (!ofs)
+      return(false);
+    ofs.write(p.buf.data(), p.buf.size());
+    ofs.close();
+
+    if (ofs.fail() || rename(tmpname.str().c_str(), cachename.c_str()) != 0) {
+      remove(tmpname.str().c_str());
+      return(false);
+    }
+
+    return(true);
+  }
+
+}
@@ -0,0 +1,81 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_TOPOLOGYCACHE_HPP)
+#define LOOS_TOPOLOGYCACHE_HPP
+
+
+#include <string>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  //! Binary snapshots of loaded models...
+  /**  Parsing a large PDB or PSF can take several seconds, and an
+   *   analysis job that runs many short tools over the same system pays
+   *   that cost every time.  The TopologyCache stores a fully-parsed
+   *   model (atoms and all of their properties, bonds, property bits,
+   *   and periodic box) as a versioned binary file that can be loaded
+   *   back with a single read.
+   *
+   *   createSystemPtr() uses the cache transparently when the
+   *   LOOS_TOPOLOGY_CACHE environment variable names a writable
+   *   directory.  A snapshot is only used when it is newer than the
+   *   model file and records the same size and modification time as
+   *   the model file, so editing the model invalidates the snapshot.
+   *   Any problem reading or writing the cache silently falls back to
+   *   parsing the model file.
+   *
+   *   Note that a cached model is returned as a plain AtomicGroup, not
+   *   as the format-specific subclass (PDB, PSF, etc).
+   */
+  class TopologyCache {
+  public:
+
+    //! Current version of the file layout (bump when the layout or Atom changes)
+    static const unsigned int version;
+
+    //! Name of the environment variable that enables the cache
+    static const char* environment_variable;
+
+    //! Name of the snapshot for a model file, or an empty string if caching is disabled
+    static std::string cacheName(const std::string& filename, const std::string& filetype);
+
+    //! Loads a snapshot of filename
+    /** Returns a null pointer if the snapshot does not exist, is stale
+     *  with respect to filename, or cannot be read.
+     */
+    static pAtomicGroup read(const std::string& cachename, const std::string& filename);
+
+    //! Writes a snapshot of model (read from filename), returning false on failure
+    /** The snapshot is written to a temporary file and renamed into
+     *  place, so concurrent jobs never see a partial snapshot.
+     */
+    static bool write(const std::string& cachename, const std::string& filename, const AtomicGroup& model);
+  };
+
+}
+
+#endif
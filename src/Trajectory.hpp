@@ -33,6 +33,7 @@
 
 #include <loos_defs.hpp>
 #include <AtomicGroup.hpp>
+#include <AtomicGroupView.hpp>
 
 #include <AtomicGroup.hpp>
 
@@ -173,6 +174,26 @@ namespace loos {
 			updateGroupCoordsImpl(g);
 		}
 
+		//! Update the coordinates of the atoms in a view (and the shared box)
+		/** The atoms are shared with the view's parent, so this also
+		 * updates those atoms in the parent.  No group is made, so
+		 * this is as cheap as updating a group of the same size.
+		 */
+		void updateGroupCoords(const AtomicGroupView& view)
+		{
+#if defined(DEBUG)
+			for (uint i=0; i<view.size(); ++i)
+				if (! view.getAtom(i)->checkProperty(Atom::indexbit))
+					throw(LOOSError("Atoms in AtomicGroupView have unset index properties and cannot be used to read a trajectory."));
+#else
+			if (! view.empty())
+				if (! view.getAtom(0)->checkProperty(Atom::indexbit))
+					throw(LOOSError("Atoms in AtomicGroupView have unset index properties and cannot be used to read a trajectory."));
+#endif
+
+			updateViewCoordsImpl(view);
+		}
+
 
 
 		//! Returns the current frame's velocities as a vector of GCoords
@@ -269,6 +290,57 @@ namespace loos {
 			return(b);
 		}
 
+#if !defined(SWIG)
+		//! Reads the coordinates of a set of atoms for several frames at once
+		/** Fills buffer with the coordinates of the atoms with the
+		 * given indices, for each of the given frames, laid out as
+		 * buffer[(frame * atoms.size() + atom) * 3 + k] in the order the
+		 * frames and atoms are listed.  The buffer must hold
+		 * frames.size() * atoms.size() * 3 values.  If boxes is not
+		 * null and the trajectory has periodic boxes, it receives the
+		 * box of each frame.
+		 *
+		 * Formats that can read frames in bulk (e.g. DCD, XTC, NetCDF)
+		 * override readFramesImpl(), avoiding the cost of reading one
+		 * frame at a time.  The current frame is unchanged.
+		 */
+		void readFrames(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes = 0) {
+			uint n = nframes();
+			for (std::vector<uint>::const_iterator i = frames.begin(); i != frames.end(); ++i)
+				if (*i >= n)
+					throw(TrajectoryError("reading frames", _filename, "Frame index is out of bounds"));
+			uint na = natoms();
+			for (std::vector<uint>::const_iterator i = atoms.begin(); i != atoms.end(); ++i)
+				if (*i >= na)
+					throw(TrajectoryError("reading frames", _filename, "Atom index into trajectory frame is out of bounds"));
+
+			if (!hasPeriodicBox())
+				boxes = 0;
+			if (!frames.empty() && (!atoms.empty() || boxes))
+				readFramesImpl(frames, atoms, buffer, boxes);
+		}
+
+		//! Reads the coordinates of the atoms in g for several frames at once
+		/** See readFrames() above.  Atoms are in the order of g. */
+		void readFrames(const std::vector<uint>& frames, const AtomicGroup& g, double* buffer, GCoord* boxes = 0) {
+			if (! g.empty())
+				if (! g[0]->checkProperty(Atom::indexbit))
+					throw(LOOSError("Atoms in AtomicGroup have unset index properties and cannot be used to read a trajectory."));
+
+			std::vector<uint> atoms;
+			atoms.reserve(g.size());
+			for (AtomicGroup::const_iterator i = g.begin(); i != g.end(); ++i)
+				atoms.push_back((*i)->index());
+			readFrames(frames, atoms, buffer, boxes);
+		}
+
+		//! Reads the coordinates of the atoms in a view for several frames at once
+		/** See readFrames() above.  Atoms are in the order of the view. */
+		void readFrames(const std::vector<uint>& frames, const AtomicGroupView& view, double* buffer, GCoord* boxes = 0) {
+			readFrames(frames, view.atomIndices(), buffer, boxes);
+		}
+#endif // !defined(SWIG)
+
 		bool atEnd() const {
 			return(_current_frame >= nframes());
 		}
@@ -328,12 +400,58 @@ namespace loos {
 		//! NVI implementation of updateGroupCoords() for derived classes to override
 		virtual void updateGroupCoordsImpl(AtomicGroup& g) =0;
 
+		//! NVI implementation of updateGroupCoords() for views
+		/** The default copies the view into a scratch group.  Formats
+		 * override this to write the current frame straight into the
+		 * atoms of the view.
+		 */
+		virtual void updateViewCoordsImpl(const AtomicGroupView& view) {
+			AtomicGroup g = view.group();
+			updateGroupCoordsImpl(g);
+		}
+
 		virtual void updateGroupVelocitiesImpl(AtomicGroup& g) {
 			throw(LOOSError("No velocity update implementation defined but trajectory supports it"));
 		}
 
 		virtual std::vector<GCoord> velocitiesImpl() const { return(std::vector<GCoord>()); }
 
+		//! NVI implementation of readFrames()
+		/** The default reads each frame in turn into a scratch group
+		 * holding the requested atoms, then returns to the current
+		 * frame.  Indices have already been checked.
+		 */
+		virtual void readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes) {
+			AtomicGroup g;
+			for (uint i=0; i<atoms.size(); ++i) {
+				pAtom atom(new Atom);
+				atom->index(atoms[i]);
+				g.append(atom);
+			}
+
+			uint current = _current_frame;
+			bool first = cached_first;
+
+			for (uint j=0; j<frames.size(); ++j) {
+				readFrame(frames[j]);
+				updateGroupCoords(g);
+				if (boxes)
+					boxes[j] = periodicBox();
+				for (uint i=0; i<atoms.size(); ++i, buffer += 3) {
+					const GCoord& c = g[i]->coords();
+					buffer[0] = c.x();
+					buffer[1] = c.y();
+					buffer[2] = c.z();
+				}
+			}
+
+			if (first)
+				rewind();
+			else if (current < nframes())
+				readFrame(current);
+			_current_frame = current;
+		}
+
 	};
 
 }
@@ -0,0 +1,61 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <UniqueStrings.hpp>
+
+namespace loos {
+
+  UniqueStrings::Handle UniqueStrings::add(const std::string& s) {
+    std::lock_guard<std::mutex> guard(lock);
+    return(&(*uniques.insert(s).first));
+  }
+
+
+  UniqueStrings::Handle UniqueStrings::find(const std::string& s) const {
+    std::lock_guard<std::mutex> guard(lock);
+    std::unordered_set<std::string>::const_iterator i = uniques.find(s);
+    if (i == uniques.end())
+      return(0);
+    return(&(*i));
+  }
+
+
+  int UniqueStrings::size(void) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return(uniques.size());
+  }
+
+
+  std::vector<std::string> UniqueStrings::strings(void) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return(std::vector<std::string>(uniques.begin(), uniques.end()));
+  }
+
+
+  // Never destroyed, so handles held by static Atoms stay valid
+  // through program exit
+  UniqueStrings& UniqueStrings::atomProperties() {
+    static UniqueStrings* table = new UniqueStrings;
+    return(*table);
+  }
+
+}
@@ -20,60 +20,59 @@
 */
 
 
-
-/*
-   ***WARNING******WARNING******WARNING******WARNING******WARNING******WARNING***
-
-   THIS CLASS IS NOW DEPRECATED AND WILL BE REMOVED IN A FUTURE RELEASE OF LOOS
-
-   ***WARNING******WARNING******WARNING******WARNING******WARNING******WARNING***
-*/
-
 #if !defined(LOOS_UNIQUESTRINGS_HPP)
 #define LOOS_UNIQUESTRINGS_HPP
 
 
 #include <string>
-#include <ext/slist>
+#include <vector>
+#include <mutex>
+#include <unordered_set>
 
 
 namespace loos {
 
-  //! Class for uniquifying strings...
-  /**  This class uses an slist and just does a linear search to see if
-   *   we've already encountered the passed string before.  This probably
-   *   should be updated to use a faster method in the future...
+  //! Class for uniquifying (interning) strings...
+  /**  Each distinct string is stored once, in a hashed set, and is
+   *   represented by a handle: a pointer to the stored copy.  Handles
+   *   stay valid for the life of the table (strings are never removed),
+   *   so two handles from the same table are equal exactly when their
+   *   strings are equal, and reading through a handle needs no locking.
+   *
+   *   Adding strings is thread-safe.
+   *
+   *   Atom properties (names, resnames, segids, etc) are interned in
+   *   the table returned by UniqueStrings::atomProperties(), so a
+   *   system with millions of atoms only stores each name once, and
+   *   comparing two atoms' names is a pointer comparison.
    */
   class UniqueStrings {
   public:
+    typedef const std::string*     Handle;
 
-    //! Adds a string to the unique string list
-    void add(const std::string& s) {
-      if (find(s) < 0)
-        uniques.push_front(s);
-    }
+    UniqueStrings() { }
+
+    //! Adds a string (if not already present), returning its handle
+    Handle add(const std::string& s);
+
+    //! Returns the handle for a string, or a null handle if it has never been added
+    Handle find(const std::string& s) const;
 
     //! Number of unique strings found...
-    int size(void) const { return(uniques.size()); }
-
-    //! Returns the raw slist of strings...
-    __gnu_cxx::slist<std::string> strings(void) const { return(uniques); }
-
-    //! Checks to see if we've encountered this string before...
-    /** Returns an index (a unique int) representing this string.
-     *  If the string is not found, returns -1.
-     */
-    int find(const std::string& s) {
-      int j = 0;
-      __gnu_cxx::slist<std::string>::const_iterator i;
-      for (i = uniques.begin(); i != uniques.end(); i++, j++)
-        if (*i == s)
-          return(j);
-      return(-1); 
-    }
+    int size(void) const;
+
+    //! Returns a copy of the unique strings (in no particular order)
+    std::vector<std::string> strings(void) const;
+
+    //! The table shared by all Atoms
+    static UniqueStrings& atomProperties();
 
   private:
-    __gnu_cxx::slist<std::string> uniques;
+    UniqueStrings(const UniqueStrings&);
+    UniqueStrings& operator=(const UniqueStrings&);
+
+    mutable std::mutex lock;
+    std::unordered_set<std::string> uniques;
   };
 
 }
@@ -379,17 +379,16 @@ namespace loos {
       for (uint j=0; j<avg.size(); ++j)
         avg[j]->coords() = GCoord(0,0,0);
 
-      for (int i=0; i<nf; ++i) {
+      readFramesInBatches(traj, g, frame_indices, [&](const uint i, const double* crds, const GCoord* box) {
+          for (uint j=0; j<frame.size(); ++j, crds += 3)
+            frame[j]->coords(GCoord(crds[0], crds[1], crds[2]));
 
-        traj->readFrame(frame_indices[i]);
-        traj->updateGroupCoords(frame);
+          GMatrix M = frame.alignOnto(target);
+          xforms[i].load(M);
 
-        GMatrix M = frame.alignOnto(target);
-        xforms[i].load(M);
-
-        for (uint j=0; j<avg.size(); ++j)
-          avg[j]->coords() += frame[j]->coords();
-      }
+          for (uint j=0; j<avg.size(); ++j)
+            avg[j]->coords() += frame[j]->coords();
+        });
 
       for (uint j=0; j<avg.size(); ++j)
         avg[j]->coords() /= nf;
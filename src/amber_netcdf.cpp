@@ -3,15 +3,25 @@
 #include <amber_netcdf.hpp>
 #include <AtomicGroup.hpp>
 
+#include <algorithm>
+
 namespace loos {
 
 
 	bool isFileNetCDF(const std::string& fname) {
 		std::ifstream ifs(fname.c_str());
 
-		char buf[4];
-		ifs.read(buf, 4);
-		return (buf[0] == 'C' && buf[1] == 'D' && buf[2] == 'F' && (buf[3] = 0x01 || buf[3] == 0x02));
+		char buf[8];
+		if (!ifs.read(buf, 8))
+			return(false);
+
+		// Classic and 64-bit offset formats
+		if (buf[0] == 'C' && buf[1] == 'D' && buf[2] == 'F' && (buf[3] == 0x01 || buf[3] == 0x02))
+			return(true);
+
+		// NetCDF-4 files are HDF5 files (as written by AmberNetcdfWriter)
+		static const char hdf5_signature[8] = { '\x89', 'H', 'D', 'F', '\r', '\n', '\x1a', '\n' };
+		return(std::equal(buf, buf + 8, hdf5_signature));
 	}
 
 
@@ -95,6 +105,16 @@ namespace loos {
 		}
 
 
+		// Blocks of frames follow the chunking of the coordinates, if any
+		int storage;
+		size_t chunks[3];
+		size_t chunk_frames = 1;
+		retval = nc_inq_var_chunking(_ncid, _coord_id, &storage, chunks);
+		if (!retval && storage == NC_CHUNKED)
+			chunk_frames = chunks[0];
+		size_t frame_bytes = _natoms * 3 * sizeof(GCoord::element_type) * (_velocities ? 2 : 1);
+		_planner.configure(_nframes, chunk_frames, frame_bytes);
+
 		// Now cache the first frame...
 		readRawFrame(0);
 		cached_first = true;
@@ -102,25 +122,50 @@ namespace loos {
 	}
 
 
-	// Given a frame number, read the coord data into the internal array
-	// and retrieve the corresponding periodic box (if present)
+	// Given a frame number, copy the coord data into the internal array
+	// and retrieve the corresponding periodic box (if present), reading
+	// a new block of frames from the file if necessary
 	void AmberNetcdf::readRawFrame(const uint frameno)  {
-		size_t start[3] = {0, 0, 0};
-		size_t count[3] = {1, 1, 3};
+		if (frameno >= _nframes)
+			throw(FileReadError(_filename, "Cannot read Amber netcdf frame (past end of trajectory)"));
+
+		int slot = _planner.slot(frameno);
+		if (slot < 0) {
+			_planner.plan(frameno);
+			readBlock();
+			slot = _planner.slot(frameno);
+		}
 
+		size_t n = _natoms * 3;
+		std::copy(_coord_block.begin() + slot * n, _coord_block.begin() + (slot + 1) * n, _coord_data);
+		if (_velocities)
+			std::copy(_velocity_block.begin() + slot * n, _velocity_block.begin() + (slot + 1) * n, _velocity_data);
+		if (_periodic)
+			std::copy(_box_block.begin() + slot * 3, _box_block.begin() + (slot + 1) * 3, _box_data);
+	}
 
-		// Read coordinates first...
-		start[0] = frameno;
-		count[1] = _natoms;
 
+	// Reads the block of frames chosen by the planner with a single
+	// (possibly strided) hyperslab read for each variable
+	void AmberNetcdf::readBlock() {
+		size_t start[3] = {_planner.start(), 0, 0};
+		size_t count[3] = {_planner.count(), _natoms, 3};
+		ptrdiff_t stride[3] = {static_cast<ptrdiff_t>(_planner.stride()), 1, 1};
+		bool strided = _planner.stride() > 1;
 
-		int retval = VarTypeDecider<GCoord::element_type>::read(_ncid, _coord_id, start, count, _coord_data);
+		_coord_block.resize(_planner.count() * _natoms * 3);
+		int retval = strided
+			? VarTypeDecider<GCoord::element_type>::read(_ncid, _coord_id, start, count, stride, &_coord_block[0])
+			: VarTypeDecider<GCoord::element_type>::read(_ncid, _coord_id, start, count, &_coord_block[0]);
 		if (retval)
 			throw(FileReadError(_filename, "Cannot read Amber netcdf frame (coords)", retval));
 
 		if (_velocities)
 		{
-			retval = VarTypeDecider<GCoord::element_type>::read(_ncid, _velocities_id, start, count, _velocity_data);
+			_velocity_block.resize(_coord_block.size());
+			retval = strided
+				? VarTypeDecider<GCoord::element_type>::read(_ncid, _velocities_id, start, count, stride, &_velocity_block[0])
+				: VarTypeDecider<GCoord::element_type>::read(_ncid, _velocities_id, start, count, &_velocity_block[0]);
 			if (retval)
 				throw(FileReadError(_filename, "Cannot read Amber netcdf frame (velocities)", retval));
 		}
@@ -128,16 +173,69 @@ namespace loos {
 
 		// Now get box if present...
 		if (_periodic) {
-			start[1] = 0;
 			count[1] = 3;
-
-			retval = VarTypeDecider<GCoord::element_type>::read(_ncid, _cell_lengths_id, start, count, _box_data);
+			_box_block.resize(_planner.count() * 3);
+			retval = strided
+				? VarTypeDecider<GCoord::element_type>::read(_ncid, _cell_lengths_id, start, count, stride, &_box_block[0])
+				: VarTypeDecider<GCoord::element_type>::read(_ncid, _cell_lengths_id, start, count, &_box_block[0]);
 			if (retval)
 				throw(FileReadError(_filename, "Cannot read Amber netcdf periodic box", retval));
 		}
 
 	}
 
+	// Each run of frames at a constant stride is read with one hyperslab
+	// spanning the requested atoms, limited to the size of a block of
+	// frames.  The frames held for readFrame() are not disturbed.
+	void AmberNetcdf::readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes) {
+		size_t first_atom = atoms.empty() ? 0 : *std::min_element(atoms.begin(), atoms.end());
+		size_t span = atoms.empty() ? 0 : *std::max_element(atoms.begin(), atoms.end()) - first_atom + 1;
+		size_t max_frames = std::max<size_t>(1, internal::FrameBlockPlanner::default_block_bytes / (std::max<size_t>(1, span) * 3 * sizeof(double)));
+
+		std::vector<double> block, cells;
+		for (uint j=0; j<frames.size(); ) {
+			uint k = j + 1;
+			ptrdiff_t stride = 1;
+			if (k < frames.size() && frames[k] > frames[j])
+				stride = frames[k] - frames[j];
+			while (k < frames.size() && k - j < max_frames && frames[k] == frames[k-1] + stride)
+				++k;
+
+			size_t start[3] = {frames[j], first_atom, 0};
+			size_t count[3] = {k - j, span, 3};
+			ptrdiff_t strides[3] = {stride, 1, 1};
+			int retval;
+			if (span) {
+				block.resize(count[0] * span * 3);
+				retval = stride > 1
+					? VarTypeDecider<double>::read(_ncid, _coord_id, start, count, strides, &block[0])
+					: VarTypeDecider<double>::read(_ncid, _coord_id, start, count, &block[0]);
+				if (retval)
+					throw(FileReadError(_filename, "Cannot read Amber netcdf frames (coords)", retval));
+			}
+
+			if (boxes) {
+				size_t cell_start[2] = {frames[j], 0};
+				size_t cell_count[2] = {count[0], 3};
+				cells.resize(count[0] * 3);
+				retval = stride > 1
+					? VarTypeDecider<double>::read(_ncid, _cell_lengths_id, cell_start, cell_count, strides, &cells[0])
+					: VarTypeDecider<double>::read(_ncid, _cell_lengths_id, cell_start, cell_count, &cells[0]);
+				if (retval)
+					throw(FileReadError(_filename, "Cannot read Amber netcdf periodic boxes", retval));
+				for (uint f=0; f<count[0]; ++f)
+					boxes[j + f] = GCoord(cells[f * 3], cells[f * 3 + 1], cells[f * 3 + 2]);
+			}
+
+			for (uint f=0; f<count[0]; ++f)
+				for (uint i=0; i<atoms.size(); ++i, buffer += 3)
+					std::copy(&block[(f * span + atoms[i] - first_atom) * 3], &block[(f * span + atoms[i] - first_atom) * 3] + 3, buffer);
+
+			j = k;
+		}
+	}
+
+
 	bool AmberNetcdf::parseFrame() {
 		if (_current_frame >= _nframes)
 			return(false);
@@ -162,6 +260,22 @@ namespace loos {
 	}
 
 
+	void AmberNetcdf::updateViewCoordsImpl(const AtomicGroupView& view) {
+
+		for (uint i=0; i<view.size(); ++i) {
+			const pAtom& atom = view[i];
+			uint idx = atom->index();
+			if (idx >= _natoms)
+				throw(TrajectoryError("updating group coords",_filename, "Atom index into trajectory frame is out of bounds"));
+			idx *= 3;
+			atom->coords(GCoord(_coord_data[idx], _coord_data[idx+1], _coord_data[idx+2]));
+		}
+
+		if (_periodic)
+			view.periodicBox(GCoord(_box_data[0], _box_data[1], _box_data[2]));
+	}
+
+
 	void AmberNetcdf::updateGroupVelocitiesImpl(AtomicGroup& g) {
 
 		for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
@@ -6,6 +6,7 @@
 
 #include <istream>
 #include <string>
+#include <vector>
 #include <netcdf.h>
 
 #include <loos_defs.hpp>
@@ -14,6 +15,7 @@
 #include <exceptions.hpp>
 
 #include <amber_traj.hpp>
+#include <FrameBlockPlanner.hpp>
 
 namespace loos {
 
@@ -37,6 +39,7 @@ namespace loos {
 
 			// This is private to keep arbitrary types from compiling
 			static int read(const int id, const int var, const size_t* st, const size_t *co, T* ip) { return(0); }
+			static int read(const int id, const int var, const size_t* st, const size_t *co, const ptrdiff_t* sd, T* ip) { return(0); }
 		};
 
 
@@ -49,6 +52,9 @@ namespace loos {
 			static int read(const int id, const int var, const size_t* st, const size_t* co, float* ip) {
 				return(nc_get_vara_float(id, var, st, co, ip));
 			}
+			static int read(const int id, const int var, const size_t* st, const size_t* co, const ptrdiff_t* sd, float* ip) {
+				return(nc_get_vars_float(id, var, st, co, sd, ip));
+			}
 		};
 
 		template<> class VarTypeDecider<double> {
@@ -56,6 +62,9 @@ namespace loos {
 			static int read(const int id, const int var, const size_t* st, const size_t* co, double* ip) {
 				return(nc_get_vara_double(id, var, st, co, ip));
 			}
+			static int read(const int id, const int var, const size_t* st, const size_t* co, const ptrdiff_t* sd, double* ip) {
+				return(nc_get_vars_double(id, var, st, co, sd, ip));
+			}
 		};
 
 
@@ -64,6 +73,11 @@ namespace loos {
 
 
 	//! Class for reading Amber Trajectories in NetCDF format
+	/**
+	 * Frames are read in blocks (see internal::FrameBlockPlanner) that
+	 * follow the chunking of the file, so sequential or strided reads
+	 * issue one nc_get_vars call per variable for many frames.
+	 */
 	class AmberNetcdf : public Trajectory {
 	public:
 
@@ -91,6 +105,7 @@ namespace loos {
 			nc_close(_ncid);
 
 			delete[] _coord_data;
+			delete[] _velocity_data;
 			delete[] _box_data;
 		}
 
@@ -130,9 +145,12 @@ namespace loos {
 		void readGlobalAttributes();
 		std::string readGlobalAttribute(const std::string& name);
 		void readRawFrame(const uint frameno);
+		void readBlock();
 
 		void updateGroupCoordsImpl(AtomicGroup& g);
+		void updateViewCoordsImpl(const AtomicGroupView& view);
 		void updateGroupVelocitiesImpl(AtomicGroup& g);
+		void readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes);
 		bool parseFrame();
 		void seekNextFrameImpl() { }
 		void seekFrameImpl(const uint frame) { }
@@ -156,6 +174,9 @@ namespace loos {
 		int _cell_lengths_id;
 		int _velocities_id;
 		std::string _title, _application, _program, _programVersion, _conventions, _conventionVersion;
+
+		internal::FrameBlockPlanner _planner;
+		std::vector<GCoord::element_type> _coord_block, _velocity_block, _box_block;
 	};
 
 
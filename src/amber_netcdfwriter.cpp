@@ -0,0 +1,357 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <amber_netcdfwriter.hpp>
+#include <exceptions.hpp>
+#include <version.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include <boost/cstdint.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // Target size of a chunk when the number of frames per chunk is
+    // chosen automatically
+    const size_t default_chunk_bytes = 4 << 20;
+
+
+    // Rounds a float to the nearest value that has only keep
+    // significant mantissa bits, leaving zeros that deflate compresses
+    // well.
+    inline float bitRound(const float x, const int keep) {
+      boost::uint32_t bits;
+      memcpy(&bits, &x, sizeof(bits));
+      const int drop = 23 - keep;
+      const boost::uint32_t half = 1u << (drop - 1);
+      const boost::uint32_t mask = ~((1u << drop) - 1);
+      bits = (bits + half) & mask;
+      float y;
+      memcpy(&y, &bits, sizeof(y));
+      return(y);
+    }
+
+  }
+
+
+  AmberNetcdfWriter::AmberNetcdfWriter(const std::string& fname, const bool append)
+    : TrajectoryWriter(fname, append, false),
+      frames_per_chunk_(0),
+      deflate_level_(0),
+      keep_bits_(0)
+  {
+    init(append);
+  }
+
+
+  AmberNetcdfWriter::AmberNetcdfWriter(const std::string& fname, const uint frames_per_chunk,
+                                       const int deflate_level, const int keep_bits,
+                                       const bool append)
+    : TrajectoryWriter(fname, append, false),
+      frames_per_chunk_(frames_per_chunk),
+      deflate_level_(deflate_level),
+      keep_bits_(keep_bits)
+  {
+    if (deflate_level < 0 || deflate_level > 9)
+      throw(LOOSError("AmberNetcdfWriter deflate level must be between 0 and 9"));
+    if (keep_bits < 0 || keep_bits > 23)
+      throw(LOOSError("AmberNetcdfWriter must keep between 1 and 23 mantissa bits (or 0 for lossless)"));
+
+    // Keeping all of the bits is lossless
+    if (keep_bits_ == 23)
+      keep_bits_ = 0;
+
+    init(append);
+  }
+
+
+  AmberNetcdfWriter::~AmberNetcdfWriter() {
+    // Don't throw from the destructor...
+    try {
+      flush();
+    }
+    catch (...) { }
+
+    nc_close(ncid_);
+  }
+
+
+  void AmberNetcdfWriter::init(const bool append) {
+    defined_ = false;
+    natoms_ = 0;
+    dt_ = 1.0;
+    periodic_ = velocities_ = false;
+    time_id_ = coords_id_ = velocities_id_ = lengths_id_ = angles_id_ = -1;
+    frames_ = buffered_ = 0;
+
+    struct stat statbuf;
+    if (append && !stat(_filename.c_str(), &statbuf) && statbuf.st_size > 0)
+      openForAppend();
+    else
+      check(nc_create(_filename.c_str(), NC_NETCDF4 | NC_CLOBBER, &ncid_), "Cannot create NetCDF file");
+  }
+
+
+  // Picks up the layout of an existing trajectory so new frames can be
+  // added to the end of it
+  void AmberNetcdfWriter::openForAppend() {
+    int retval = nc_open(_filename.c_str(), NC_WRITE, &ncid_);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot open NetCDF file for appending", retval));
+
+    int dimid;
+    size_t len;
+    check(nc_inq_dimid(ncid_, "atom", &dimid), "Cannot find atom dimension.  Is this really an Amber NetCDF trajectory?");
+    check(nc_inq_dimlen(ncid_, dimid, &len), "Cannot read atom dimension");
+    natoms_ = len;
+    check(nc_inq_dimid(ncid_, "frame", &dimid), "Cannot find frame dimension");
+    check(nc_inq_dimlen(ncid_, dimid, &len), "Cannot read frame dimension");
+    frames_ = len;
+
+    check(nc_inq_varid(ncid_, "coordinates", &coords_id_), "Cannot find coordinates");
+    check(nc_inq_varid(ncid_, "time", &time_id_), "Cannot find time");
+    periodic_ = !nc_inq_varid(ncid_, "cell_lengths", &lengths_id_)
+      && !nc_inq_varid(ncid_, "cell_angles", &angles_id_);
+    velocities_ = !nc_inq_varid(ncid_, "velocities", &velocities_id_);
+
+    // Keep writing whole chunks if the file is chunked
+    int storage;
+    size_t chunks[3];
+    if (!nc_inq_var_chunking(ncid_, coords_id_, &storage, chunks) && storage == NC_CHUNKED)
+      frames_per_chunk_ = chunks[0];
+    if (frames_per_chunk_ == 0)
+      frames_per_chunk_ = 1;
+
+    coords_.resize(frames_per_chunk_ * natoms_ * 3);
+    if (velocities_)
+      vels_.resize(coords_.size());
+    times_.resize(frames_per_chunk_);
+    lengths_.resize(frames_per_chunk_ * 3);
+
+    defined_ = true;
+    appending_ = true;
+  }
+
+
+  // The file layout is fixed by the first frame written
+  void AmberNetcdfWriter::defineFile(const AtomicGroup& model) {
+    natoms_ = model.size();
+    periodic_ = model.isPeriodic();
+    velocities_ = model.allHaveProperty(Atom::velbit);
+
+    if (frames_per_chunk_ == 0)
+      frames_per_chunk_ = natoms_ == 0 ? 1 : std::max(static_cast<size_t>(1), default_chunk_bytes / (natoms_ * 3 * sizeof(float)));
+
+    putAttribute(NC_GLOBAL, "title", title_);
+    putAttribute(NC_GLOBAL, "application", "LOOS");
+    putAttribute(NC_GLOBAL, "program", "LOOS");
+    putAttribute(NC_GLOBAL, "programVersion", LOOS_VERSION);
+    putAttribute(NC_GLOBAL, "Conventions", "AMBER");
+    putAttribute(NC_GLOBAL, "ConventionVersion", "1.0");
+
+    int frame_dim, spatial_dim, atom_dim, cell_spatial_dim, cell_angular_dim, label_dim;
+    check(nc_def_dim(ncid_, "frame", NC_UNLIMITED, &frame_dim), "Cannot define frame dimension");
+    check(nc_def_dim(ncid_, "spatial", 3, &spatial_dim), "Cannot define spatial dimension");
+    check(nc_def_dim(ncid_, "atom", natoms_, &atom_dim), "Cannot define atom dimension");
+
+    int spatial_id, cell_spatial_id = -1, cell_angular_id = -1;
+    int dims[3];
+
+    dims[0] = spatial_dim;
+    check(nc_def_var(ncid_, "spatial", NC_CHAR, 1, dims, &spatial_id), "Cannot define spatial");
+
+    dims[0] = frame_dim;
+    defineVariable("time", NC_FLOAT, 1, dims, false, &time_id_);
+    putAttribute(time_id_, "units", "picosecond");
+
+    dims[1] = atom_dim;
+    dims[2] = spatial_dim;
+    defineVariable("coordinates", NC_FLOAT, 3, dims, true, &coords_id_);
+    putAttribute(coords_id_, "units", "angstrom");
+
+    if (velocities_) {
+      defineVariable("velocities", NC_FLOAT, 3, dims, true, &velocities_id_);
+      putAttribute(velocities_id_, "units", "angstrom/picosecond");
+    }
+
+    if (periodic_) {
+      check(nc_def_dim(ncid_, "cell_spatial", 3, &cell_spatial_dim), "Cannot define cell_spatial dimension");
+      check(nc_def_dim(ncid_, "cell_angular", 3, &cell_angular_dim), "Cannot define cell_angular dimension");
+      check(nc_def_dim(ncid_, "label", 5, &label_dim), "Cannot define label dimension");
+
+      dims[0] = cell_spatial_dim;
+      check(nc_def_var(ncid_, "cell_spatial", NC_CHAR, 1, dims, &cell_spatial_id), "Cannot define cell_spatial");
+      dims[0] = cell_angular_dim;
+      dims[1] = label_dim;
+      check(nc_def_var(ncid_, "cell_angular", NC_CHAR, 2, dims, &cell_angular_id), "Cannot define cell_angular");
+
+      dims[0] = frame_dim;
+      dims[1] = cell_spatial_dim;
+      defineVariable("cell_lengths", NC_DOUBLE, 2, dims, false, &lengths_id_);
+      putAttribute(lengths_id_, "units", "angstrom");
+      dims[1] = cell_angular_dim;
+      defineVariable("cell_angles", NC_DOUBLE, 2, dims, false, &angles_id_);
+      putAttribute(angles_id_, "units", "degree");
+    }
+
+    check(nc_enddef(ncid_), "Cannot finish defining NetCDF file");
+
+    check(nc_put_var_text(ncid_, spatial_id, "xyz"), "Cannot write spatial labels");
+    if (periodic_) {
+      check(nc_put_var_text(ncid_, cell_spatial_id, "abc"), "Cannot write cell_spatial labels");
+      check(nc_put_var_text(ncid_, cell_angular_id, "alphabeta gamma"), "Cannot write cell_angular labels");
+    }
+
+    coords_.resize(frames_per_chunk_ * natoms_ * 3);
+    if (velocities_)
+      vels_.resize(coords_.size());
+    times_.resize(frames_per_chunk_);
+    lengths_.resize(frames_per_chunk_ * 3);
+
+    defined_ = true;
+  }
+
+
+  // Defines a per-frame variable whose chunks hold frames_per_chunk_
+  // whole frames, optionally compressing it
+  void AmberNetcdfWriter::defineVariable(const char* name, const nc_type type, const int ndims, const int* dims,
+                                         const bool compress, int* id) {
+    check(nc_def_var(ncid_, name, type, ndims, dims, id), std::string("Cannot define ") + name);
+
+    size_t chunks[3] = { frames_per_chunk_, natoms_, 3 };
+    if (ndims == 2)
+      chunks[1] = 3;
+    check(nc_def_var_chunking(ncid_, *id, NC_CHUNKED, chunks), std::string("Cannot set chunking for ") + name);
+
+    if (compress) {
+      if (deflate_level_ > 0)
+        check(nc_def_var_deflate(ncid_, *id, 1, 1, deflate_level_), std::string("Cannot set compression for ") + name);
+      if (keep_bits_ > 0)
+        check(nc_put_att_int(ncid_, *id, "_QuantizeBitRoundNumberOfSignificantBits", NC_INT, 1, &keep_bits_),
+              std::string("Cannot write quantization for ") + name);
+    }
+  }
+
+
+  void AmberNetcdfWriter::putAttribute(const int var, const char* name, const std::string& value) {
+    check(nc_put_att_text(ncid_, var, name, value.size(), value.c_str()), std::string("Cannot write attribute ") + name);
+  }
+
+
+  void AmberNetcdfWriter::check(const int retval, const std::string& msg) {
+    if (retval)
+      throw(FileWriteError(_filename, msg, retval));
+  }
+
+
+  void AmberNetcdfWriter::setComments(const std::vector<std::string>& comments) {
+    title_.clear();
+    for (std::vector<std::string>::const_iterator i = comments.begin(); i != comments.end(); ++i) {
+      if (i != comments.begin())
+        title_ += '\n';
+      title_ += *i;
+    }
+  }
+
+
+  void AmberNetcdfWriter::writeFrame(const AtomicGroup& model) {
+    writeFrame(model, 0, framesWritten() * dt_);
+  }
+
+
+  void AmberNetcdfWriter::writeFrame(const AtomicGroup& model, const uint step, const double time) {
+    if (!defined_)
+      defineFile(model);
+
+    if (model.size() != natoms_)
+      throw(FileWriteError(_filename, "Frame has a different number of atoms than the NetCDF trajectory"));
+
+    float* crds = &coords_[buffered_ * natoms_ * 3];
+    float* vels = velocities_ ? &vels_[buffered_ * natoms_ * 3] : 0;
+    for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i) {
+      const GCoord& c = (*i)->coords();
+      *crds++ = c[0];
+      *crds++ = c[1];
+      *crds++ = c[2];
+      if (vels) {
+        GCoord v = (*i)->velocities();
+        *vels++ = v[0];
+        *vels++ = v[1];
+        *vels++ = v[2];
+      }
+    }
+
+    if (keep_bits_ > 0) {
+      float* p = &coords_[buffered_ * natoms_ * 3];
+      for (uint j=0; j<natoms_ * 3; ++j)
+        p[j] = bitRound(p[j], keep_bits_);
+      if (velocities_) {
+        p = &vels_[buffered_ * natoms_ * 3];
+        for (uint j=0; j<natoms_ * 3; ++j)
+          p[j] = bitRound(p[j], keep_bits_);
+      }
+    }
+
+    times_[buffered_] = time;
+    if (periodic_) {
+      GCoord box = model.periodicBox();
+      for (uint j=0; j<3; ++j)
+        lengths_[buffered_ * 3 + j] = box[j];
+    }
+
+    if (++buffered_ == frames_per_chunk_)
+      flush();
+  }
+
+
+  // All buffered frames go out with one nc_put_vara call per variable
+  void AmberNetcdfWriter::flush() {
+    if (buffered_ == 0)
+      return;
+
+    size_t start[3] = { frames_, 0, 0 };
+    size_t count[3] = { buffered_, natoms_, 3 };
+
+    check(nc_put_vara_float(ncid_, coords_id_, start, count, &coords_[0]), "Cannot write coordinates");
+    if (velocities_)
+      check(nc_put_vara_float(ncid_, velocities_id_, start, count, &vels_[0]), "Cannot write velocities");
+    check(nc_put_vara_float(ncid_, time_id_, start, count, &times_[0]), "Cannot write time");
+
+    if (periodic_) {
+      count[1] = 3;
+      check(nc_put_vara_double(ncid_, lengths_id_, start, count, &lengths_[0]), "Cannot write periodic box");
+      std::vector<double> angles(buffered_ * 3, 90.0);
+      check(nc_put_vara_double(ncid_, angles_id_, start, count, &angles[0]), "Cannot write periodic box angles");
+    }
+
+    frames_ += buffered_;
+    buffered_ = 0;
+  }
+
+}
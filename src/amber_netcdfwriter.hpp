@@ -0,0 +1,152 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_AMBER_NETCDFWRITER_HPP)
+#define LOOS_AMBER_NETCDFWRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <trajwriter.hpp>
+
+namespace loos {
+
+  //! Class for writing Amber trajectories in NetCDF format
+  /**
+   * Frames are written following the AMBER NetCDF convention (version
+   * 1.0), so they can be read back by AmberNetcdf as well as by the
+   * Amber tools.  Coordinates, time, and (if the first frame written
+   * is periodic) the box are always written.  Velocities are written
+   * if every atom in the first frame has them.  Velocities are stored
+   * as-is in angstrom/picosecond, without a scale_factor attribute, so
+   * other readers use them unscaled and AmberNetcdf reads back the
+   * same values.
+   *
+   * The file is written as NetCDF-4 with chunks that hold a whole
+   * number of frames, so any frame can be read back with a single
+   * chunk lookup.  Frames are buffered in memory and written a chunk
+   * at a time.  Optionally, the per-atom variables can be compressed
+   * with deflate (lossless), and the coordinates can be quantized by
+   * rounding away low-order mantissa bits first, which is lossy but
+   * makes deflate much more effective.  Keeping 16 significant bits
+   * preserves coordinates to better than 1 part in 65536 (about
+   * 0.0015 Angstroms at 100 Angstroms from the origin).
+   *
+   * As with XTCWriter, frames are assumed to be evenly spaced and the
+   * time for each frame is taken from timePerStep() unless an
+   * explicit time is passed to writeFrame().
+   */
+  class AmberNetcdfWriter : public TrajectoryWriter {
+  public:
+
+    //! Class factory function
+    static pTrajectoryWriter create(const std::string& s, const bool append = false) {
+      return(pTrajectoryWriter(new AmberNetcdfWriter(s, append)));
+    }
+
+
+    //! Write a trajectory with default chunking and no compression
+    explicit AmberNetcdfWriter(const std::string& fname, const bool append = false);
+
+    //! Write a trajectory with explicit chunking and compression
+    /**
+     * \arg \c frames_per_chunk Number of frames buffered and stored per chunk
+     * \arg \c deflate_level Deflate compression level (0 = none, 1-9)
+     * \arg \c keep_bits Significant mantissa bits kept in coordinates and velocities (0 = lossless)
+     *
+     * When appending, the chunking and compression of the existing
+     * file are used instead.
+     */
+    AmberNetcdfWriter(const std::string& fname, const uint frames_per_chunk,
+                      const int deflate_level, const int keep_bits,
+                      const bool append = false);
+
+    //! Flushes any buffered frames and closes the file
+    ~AmberNetcdfWriter();
+
+
+    //! Get the time (in ps) between frames
+    double timePerStep() const { return(dt_); }
+
+    //! Set the time (in ps) between frames
+    void timePerStep(const double dt) { dt_ = dt; }
+
+    //! Sets the title (must be called before the first frame is written)
+    void setTitle(const std::string& s) { title_ = s; }
+
+    //! Comments are joined to form the title
+    void setComments(const std::vector<std::string>& comments);
+
+    //! Write a frame to the trajectory
+    void writeFrame(const AtomicGroup& model);
+
+    //! Write a frame to the trajectory with explicit time (in ps)
+    /**
+     * NetCDF trajectories do not store the step, so it is ignored.
+     */
+    void writeFrame(const AtomicGroup& model, const uint step, const double time);
+
+    //! Write any buffered frames to the file
+    void flush();
+
+    bool hasFrameTime() const { return(true); }
+    bool hasComments() const { return(true); }
+
+    uint framesWritten() const { return(frames_ + buffered_); }
+
+  private:
+    void init(const bool append);
+    void openForAppend();
+    void defineFile(const AtomicGroup& model);
+    void defineVariable(const char* name, const nc_type type, const int ndims, const int* dims,
+                        const bool compress, int* id);
+    void putAttribute(const int var, const char* name, const std::string& value);
+    void check(const int retval, const std::string& msg);
+
+  private:
+    int ncid_;
+    bool defined_;
+    uint natoms_;
+    uint frames_per_chunk_;
+    int deflate_level_;
+    int keep_bits_;
+    double dt_;
+    std::string title_;
+
+    bool periodic_, velocities_;
+    int time_id_, coords_id_, velocities_id_, lengths_id_, angles_id_;
+
+    uint frames_;       // Frames already in the file
+    uint buffered_;     // Frames waiting in the buffers
+    std::vector<float> coords_, vels_, times_;
+    std::vector<double> lengths_;
+  };
+
+
+}
+
+#endif
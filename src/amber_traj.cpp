@@ -143,4 +143,19 @@ namespace loos {
     if (periodic)
       g.periodicBox(box);
   }
+
+
+  void AmberTraj::updateViewCoordsImpl(const AtomicGroupView& view) {
+
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= _natoms)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      atom->coords(frame[idx]);
+    }
+
+    if (periodic)
+      view.periodicBox(box);
+  }
 }
@@ -86,6 +86,7 @@ namespace loos {
     virtual void seekNextFrameImpl(void) { }
     virtual void seekFrameImpl(const uint);
     virtual void updateGroupCoordsImpl(AtomicGroup&);
+    virtual void updateViewCoordsImpl(const AtomicGroupView&);
 
 
   private:
@@ -28,6 +28,7 @@
 #include <exception>
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
 
 #include <stdio.h>
 #include <string.h>
@@ -262,67 +263,51 @@ namespace loos {
 
 
 
-  // Read in and reorder the crystal parameters...
-  // NOTE: This is already double!
+  // Returns the F77 record length stored at p
 
+  uint DCD::recordLength(const char* p) const {
+    DataOverlay o;
+    memcpy(&o, p, sizeof(o));
+    return(swabbing ? swab(o.ui) : o.ui);
+  }
 
-  bool DCD::readCrystalParams(void) {
-    unsigned int len;
-    DataOverlay* o;
 
-    o = readF77Line(&len);
-    if (!o)
-      return(false);
+  // Read in and reorder the crystal parameters from the F77 record
+  // at p...
+  // NOTE: This is already double!
 
-    if (len != 48)
+  void DCD::readCrystalParams(const char* p) {
+    if (recordLength(p) != 48 || recordLength(p + 52) != 48)
       throw(FileReadError(_filename, "Cannot read crystal parameters"));
 
-    double* dp = reinterpret_cast<double*>(o);
-    
+    double dp[6];
+    memcpy(dp, p + sizeof(int), sizeof(dp));
+    if (swabbing)
+      swabArray(dp, 6);
+
     qcrys[0] = dp[0];
     qcrys[1] = dp[2];
     qcrys[2] = dp[5];
     qcrys[3] = dp[1];
     qcrys[4] = dp[3];
     qcrys[5] = dp[4];
-    
-    if (swabbing)
-        for (int i=0; i<6; ++i)
-            qcrys[i] = swab(qcrys[i]);
-
-    delete[] o;
-
-    return(true);
   }
 
 
 
-  // Read a line of coordinates into the specified vector.
-
-  bool DCD::readCoordLine(std::vector<dcd_real>& v) {
-    DataOverlay *op;
-    int n = _natoms * sizeof(dcd_real);
-    unsigned int len;
+  // Copy the F77 record of coordinates at p into the specified vector.
 
+  void DCD::readCoordLine(const char* p, std::vector<dcd_real>& v) {
+    uint n = _natoms * sizeof(dcd_real);
 
-    op = readF77Line(&len);
-    if (!op)
-      return(false);
-    
-    if (len != (unsigned int)n)
+    if (recordLength(p) != n)
       throw(FileReadError(_filename, "Size of coords stored in frame does not match model size"));
+    if (recordLength(p + sizeof(int) + n) != n)
+      throw(FileReadError(_filename, "Mismatch in record length while reading from DCD"));
 
-    // Recast the values as floats and store them...
-    uint i;
-    for (i=0; i<_natoms; i++)
-      if (swabbing)
-        v[i] = swab(op[i].f);
-      else
-        v[i] = op[i].f;
-
-    delete[] op;
-
-    return(true);
+    memcpy(&v[0], p + sizeof(int), n);
+    if (swabbing)
+      swabArray(&v[0], _natoms);
   }
 
 
@@ -355,18 +340,30 @@ namespace loos {
     if (ifs->eof())
       return(false);
 
-    if (hasCrystalParams())
-      if (!readCrystalParams())
-	return(false);
+    // Frames are a fixed size, so read the whole frame at once and
+    // pick the records out of the buffer.  A file that ends before the
+    // y record (e.g. one still being written) is treated as EOF, as
+    // before; ending inside the y or z record is an error.
+    const uint line_bytes = _natoms * sizeof(dcd_real) + 2 * sizeof(int);
+    const uint ycrds_pos = (hasCrystalParams() ? 56 : 0) + line_bytes;
 
-    if (!readCoordLine(xcrds))
+    frame_buffer.resize(frame_size);
+    ifs->read(&frame_buffer[0], frame_size);
+    if (static_cast<ulong>(ifs->gcount()) < ycrds_pos)
       return(false);
-    
-    if (!readCoordLine(ycrds))
-      throw(FileReadError(_filename, "Unexpected EOF reading Y-coordinates from DCD"));
-    if (!readCoordLine(zcrds))
-      throw(FileReadError(_filename, "Unexepcted EOF reading Z-coordinates from DCD"));
-  
+    if (ifs->fail())
+      throw(FileReadError(_filename, "Unexpected EOF reading frame from DCD"));
+
+    const char* p = &frame_buffer[0];
+    if (hasCrystalParams()) {
+      readCrystalParams(p);
+      p += 56;
+    }
+
+    readCoordLine(p, xcrds);
+    readCoordLine(p + line_bytes, ycrds);
+    readCoordLine(p + 2 * line_bytes, zcrds);
+
     return(true);
   }
 
@@ -425,6 +422,83 @@ namespace loos {
   }
 
 
+  void DCD::updateViewCoordsImpl(const AtomicGroupView& view) {
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= _natoms)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      atom->coords(GCoord(xcrds[idx], ycrds[idx], zcrds[idx]));
+    }
+
+    if (hasPeriodicBox())
+      view.periodicBox(periodicBox());
+  }
+
+
+
+  // Runs of consecutive frames are read from the file in one go, then
+  // the requested atoms are picked out of each frame in the buffer.
+  // readFrame() always seeks before parsing, so the stream position
+  // does not need to be restored afterwards.
+
+  void DCD::readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes) {
+    const size_t block_bytes = 16 << 20;
+    const uint block_frames = std::max<size_t>(1, block_bytes / frame_size);
+    const size_t line_bytes = _natoms * sizeof(dcd_real) + 2 * sizeof(int);
+    const size_t crystal_bytes = hasCrystalParams() ? frame_size - 3 * line_bytes : 0;
+
+    std::vector<char> block;
+    for (uint j=0; j<frames.size(); ) {
+      uint k = j + 1;
+      while (k < frames.size() && k - j < block_frames && frames[k] == frames[k-1] + 1)
+        ++k;
+
+      block.resize((k - j) * frame_size);
+      ifs->clear();
+      ifs->seekg(first_frame_pos + static_cast<std::streamoff>(frames[j]) * frame_size);
+      ifs->read(&block[0], block.size());
+      if (ifs->fail())
+        throw(FileReadError(_filename, "Cannot read DCD frames"));
+
+      for (uint f=0; f<k-j; ++f) {
+        char* frame = &block[0] + f * frame_size;
+
+        // The crystal record holds the lower triangle of the cell
+        // (see readCrystalParams())
+        if (boxes) {
+          double cell[6];
+          memcpy(cell, frame + sizeof(int), sizeof(cell));
+          if (swabbing)
+            swabArray(cell, 6);
+          boxes[j + f] = GCoord(cell[0], cell[2], cell[5]);
+        }
+
+        const char* lines[3];
+        for (uint d=0; d<3; ++d) {
+          char* p = frame + crystal_bytes + d * line_bytes;
+          if (recordLength(p) != _natoms * sizeof(dcd_real))
+            throw(FileReadError(_filename, "Size of coords stored in frame does not match model size"));
+          lines[d] = p + sizeof(int);
+          if (swabbing && !atoms.empty())
+            swabArray(reinterpret_cast<dcd_real*>(p + sizeof(int)), _natoms);
+        }
+
+        for (uint i=0; i<atoms.size(); ++i, buffer += 3)
+          for (uint d=0; d<3; ++d) {
+            dcd_real x;
+            memcpy(&x, lines[d] + atoms[i] * sizeof(dcd_real), sizeof(dcd_real));
+            buffer[d] = x;
+          }
+      }
+
+      j = k;
+    }
+
+    ifs->clear();
+  }
+
+
 
   void DCD::initTrajectory() {
         readHeader();
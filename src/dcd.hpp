@@ -169,12 +169,17 @@ namespace loos {
 
         //! Update an AtomicGroup coordinates with the currently-read frame.
         virtual void updateGroupCoordsImpl(AtomicGroup& g);
+        virtual void updateViewCoordsImpl(const AtomicGroupView& view);
+
+        //! Read many frames with as few reads as possible
+        virtual void readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes);
 
 
 
         void allocateSpace(const int n);
-        bool readCrystalParams(void);
-        bool readCoordLine(std::vector<float>& v);
+        uint recordLength(const char* p) const;
+        void readCrystalParams(const char* p);
+        void readCoordLine(const char* p, std::vector<dcd_real>& v);
 
         void endianMatch(pStream& fsw);
 
@@ -198,6 +203,7 @@ namespace loos {
         bool swabbing;            // DCD being read is not in native format...
 
         std::vector<dcd_real> xcrds, ycrds, zcrds;
+        std::vector<char> frame_buffer;     // Raw bytes of the last frame read
 
     };
 
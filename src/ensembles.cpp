@@ -29,6 +29,8 @@
 #include <Trajectory.hpp>
 #include <alignment.hpp>
 
+#include <algorithm>
+
 namespace loos {
 
   // Assume all groups are already sorted or matched...
@@ -90,7 +92,6 @@ namespace loos {
 
   AtomicGroup averageStructure(const AtomicGroup& g, const std::vector<XForm>& xforms, pTraj& traj, const std::vector<uint>& frame_indices) {
     AtomicGroup avg = g.copy();
-    AtomicGroup frame = g.copy();
     int n = avg.size();
     for (int i=0; i<n; i++)
       avg[i]->coords() = GCoord(0.0, 0.0, 0.0);
@@ -102,16 +103,15 @@ namespace loos {
     if (fn != xforms.size())
       throw(std::runtime_error("Mismatch in number of frames in the trajectory requested and passed transforms for loos::averageStructure()"));
     
-    for (uint j=0; j<fn; ++j) {
+    for (uint j=0; j<fn; ++j)
       if (frame_indices[j] >= tn)
         throw(std::runtime_error("Frame index exceeds trajectory size"));
-      
-      traj->readFrame(frame_indices[j]);
-      traj->updateGroupCoords(frame);
-      frame.applyTransform(xforms[j]);
-      for (int i=0; i<n; i++)
-        avg[i]->coords() += frame[i]->coords();
-    }
+
+    readFramesInBatches(traj, g, frame_indices, [&](const uint j, const double* crds, const GCoord* box) {
+        GMatrix W = xforms[j].current();
+        for (int i=0; i<n; i++, crds += 3)
+          avg[i]->coords() += W * GCoord(crds[0], crds[1], crds[2]);
+      });
     
     for (int i=0; i<n; i++)
       avg[i]->coords() /= fn;
@@ -148,29 +148,43 @@ namespace loos {
 
 
 
+  // The frame after the current one is read through the iterator to
+  // find where to start, then the rest are read in batches.  The
+  // iterator is left at the end, as though each frame had been read in
+  // turn.
   void readTrajectory(std::vector<AtomicGroup>& ensemble, const AtomicGroup& model, pTraj trajectory) {
     AtomicGroup clone = model.copy();
-    
-    while (trajectory->readFrame()) {
-      trajectory->updateGroupCoords(clone);
-      AtomicGroup frame = clone.copy();
-      ensemble.push_back(frame);
-    }
+
+    if (!trajectory->readFrame())
+      return;
+    trajectory->updateGroupCoords(clone);
+    ensemble.push_back(clone.copy());
+
+    std::vector<uint> frames;
+    for (uint i=trajectory->currentFrame()+1; i<trajectory->nframes(); ++i)
+      frames.push_back(i);
+    readTrajectory(ensemble, model, trajectory, frames);
+
+    if (!frames.empty())
+      trajectory->readFrame(frames.back());
+    trajectory->readFrame();
   }
 
 
   void readTrajectory(std::vector<AtomicGroup>& ensemble, const AtomicGroup& model, pTraj trajectory, std::vector<uint>& frames) {
-    AtomicGroup clone = model.copy();
-    
     std::vector<uint>::iterator i;
-    for (i = frames.begin(); i != frames.end(); ++i) {
+    for (i = frames.begin(); i != frames.end(); ++i)
       if (*i >= trajectory->nframes())
         throw(std::runtime_error("Frame index exceeds trajectory size in readTrajectory()"));
-      trajectory->readFrame(*i);
-      trajectory->updateGroupCoords(clone);
-      AtomicGroup frame = clone.copy();
-      ensemble.push_back(frame);
-    }
+
+    readFramesInBatches(trajectory, model, frames, [&](const uint j, const double* crds, const GCoord* box) {
+        AtomicGroup frame = model.copy();
+        for (uint k=0; k<frame.size(); ++k, crds += 3)
+          frame[k]->coords(GCoord(crds[0], crds[1], crds[2]));
+        if (box)
+          frame.periodicBox(*box);
+        ensemble.push_back(frame);
+      });
   }
 
 
@@ -267,18 +281,11 @@ namespace loos {
       slayer.start();
     }
   
-    for (uint j=0; j<l; ++j) {
-      traj->readFrame(indices[j]);
-      traj->updateGroupCoords(model);
-      if (updates)
-        slayer.update();
-      for (uint i=0; i<n; ++i) {
-        GCoord c = model[i]->coords();
-        M[j + offset][i*3] = c.x();
-        M[j + offset][i*3+1] = c.y();
-        M[j + offset][i*3+2] = c.z();
-      }
-    }
+    readFramesInBatches(traj, model, indices, [&](const uint j, const double* crds, const GCoord* box) {
+        if (updates)
+          slayer.update();
+        std::copy(crds, crds + 3*n, M[j + offset].begin());
+      });
     
     if (updates)
       slayer.finish();
@@ -288,6 +295,27 @@ namespace loos {
   
 
 
+  void readFramesInBatches(pTraj& traj, const AtomicGroup& g, const std::vector<uint>& indices,
+                           const boost::function<void(const uint, const double*, const GCoord*)>& f) {
+    const size_t batch_bytes = 16 << 20;
+    size_t frame_values = g.size() * 3;
+    uint batch = std::max<size_t>(1, batch_bytes / (std::max<size_t>(1, frame_values) * sizeof(double)));
+    bool periodic = traj->hasPeriodicBox();
+
+    std::vector<double> crds;
+    std::vector<GCoord> boxes;
+    for (uint first=0; first<indices.size(); first += batch) {
+      std::vector<uint> frames(indices.begin() + first, indices.begin() + std::min<size_t>(first + batch, indices.size()));
+      crds.resize(frames.size() * frame_values);
+      boxes.resize(frames.size());
+      traj->readFrames(frames, g, crds.data(), periodic ? boxes.data() : 0);
+      for (uint j=0; j<frames.size(); ++j)
+        f(first + j, crds.data() + j * frame_values, periodic ? &boxes[j] : 0);
+    }
+  }
+
+
+
   std::vector< std::vector<double> > readCoords(AtomicGroup& model, pTraj& traj, const std::vector<uint>& indices, const bool updates = false) {
     
     std::vector< std::vector<double> > M;
@@ -25,6 +25,7 @@
 #define LOOS_ENSEMBLES_HPP
 
 #include <vector>
+#include <boost/function.hpp>
 #include <boost/tuple/tuple.hpp>
 
 #include <loos_defs.hpp>
@@ -51,16 +52,16 @@ namespace loos {
 
   //! Compute the average structure from a trajectory reading only certain frames
   /**
-   * Note that the trajectory is NOT stored in memory.  Frames will be read as needed.
-   * The trajectory "iterator" will be left pointing to the next frame after the last
-   * frame index passed.
+   * Note that the trajectory is NOT stored in memory.  Frames will be read as needed
+   * (in batches, see readFramesInBatches()).  The trajectory "iterator" is left
+   * unchanged.
   */
   AtomicGroup averageStructure(const AtomicGroup&, const std::vector<XForm>&, pTraj& traj, const std::vector<uint>& indices);
 
   //! Compute the average structure using all frames in a trajectory
     /**
-     * This version only reads a frame at a time from the trajectory.  The trajectory
-     * iterator will be left pointing to the end of the trajectory.
+     * This version does not store the trajectory in memory.  The trajectory
+     * iterator is left unchanged.
     */
   AtomicGroup averageStructure(const AtomicGroup&, const std::vector<XForm>&, pTraj& traj);
 
@@ -80,6 +81,15 @@ namespace loos {
 
   void subtractAverage(RealMatrix& M);
 
+  //! Reads frames from a trajectory in batches, calling f(j, crds, box) for frame indices[j]
+  /**
+   * crds points to the x,y,z coordinates of the atoms of g (in order) and box to the
+   * periodic box (or is null if the trajectory has none).  Both are only valid during
+   * the call.  Frames are read with Trajectory::readFrames() in batches of about 16MB.
+   */
+  void readFramesInBatches(pTraj& traj, const AtomicGroup& g, const std::vector<uint>& indices,
+                           const boost::function<void(const uint, const double*, const GCoord*)>& f);
+
   //! Compute the SVD of an ensemble with optional alignment (note RSVs returned are transposed)
   /**
    * Returns the U, S, and V' of the SVD of the passed ensemble.  If align is true, then the ensemble
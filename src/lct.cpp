@@ -0,0 +1,150 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <lct.hpp>
+#include <exceptions.hpp>
+#include <ParallelFor.hpp>
+
+
+namespace loos {
+
+  void LCT::init(void) {
+    ifs->seekg(0);
+    if (!header_.read(*ifs))
+      throw(FileOpenError(_filename, "Not a LOOS compressed trajectory (or an unsupported version)"));
+
+    internal::lctFrameOffsets(*ifs, header_, offsets_, end_);
+    if (offsets_.empty())
+      throw(FileReadError(_filename, "LCT trajectory has no frames"));
+
+    codec_ = internal::LCTCodec(header_.precisions, header_.groups);
+    planner_.configure(offsets_.size(), 1, header_.natoms * sizeof(GCoord));
+
+    if (!parseFrame())
+      throw(FileReadError(_filename, "Unable to read in the first frame"));
+    periodic_ = block_headers_[slot_].periodic;
+    cached_first = true;
+  }
+
+
+  // Reads the block of frames chosen by the planner, with a single read
+  // if the frames are contiguous, and decodes them in parallel
+  void LCT::readBlock(void) {
+    const uint n = planner_.count();
+    std::vector<boost::uint64_t> starts(n), sizes(n);
+    for (uint j=0; j<n; ++j) {
+      uint i = planner_.start() + j * planner_.stride();
+      starts[j] = offsets_[i];
+      sizes[j] = (i + 1 < offsets_.size() ? offsets_[i+1] : end_) - offsets_[i];
+    }
+
+    ifs->clear();
+    if (planner_.stride() == 1) {
+      block_bytes_.resize(starts[n-1] + sizes[n-1] - starts[0]);
+      ifs->seekg(starts[0]);
+      if (!ifs->read(&block_bytes_[0], block_bytes_.size()))
+        throw(FileReadError(_filename, "Cannot read LCT frames"));
+      for (uint j=n; j-- > 0; )
+        starts[j] -= starts[0];
+    } else {
+      boost::uint64_t total = 0;
+      for (uint j=0; j<n; ++j)
+        total += sizes[j];
+      block_bytes_.resize(total);
+      total = 0;
+      for (uint j=0; j<n; ++j) {
+        ifs->seekg(starts[j]);
+        if (!ifs->read(&block_bytes_[total], sizes[j]))
+          throw(FileReadError(_filename, "Cannot read LCT frames"));
+        starts[j] = total;
+        total += sizes[j];
+      }
+    }
+
+    block_headers_.resize(n);
+    block_coords_.resize(static_cast<size_t>(n) * header_.natoms);
+    internal::parallelFor(n, nthreads_, [&](const uint j) {
+        const char* p = &block_bytes_[starts[j]];
+        internal::LCTFrameHeader& h = block_headers_[j];
+        h.unpack(p);
+        if (h.payload + internal::LCTFrameHeader::size > sizes[j]
+            || !codec_.decode(p + internal::LCTFrameHeader::size, h.payload, header_.natoms,
+                              &block_coords_[static_cast<size_t>(j) * header_.natoms]))
+          throw(FileReadError(_filename, "Corrupt frame in LCT trajectory"));
+      });
+  }
+
+
+  bool LCT::parseFrame(void) {
+    if (_current_frame >= offsets_.size())
+      return(false);
+
+    int slot = planner_.slot(_current_frame);
+    if (slot < 0) {
+      planner_.plan(_current_frame);
+      readBlock();
+      slot = planner_.slot(_current_frame);
+    }
+    slot_ = slot;
+
+    const internal::LCTFrameHeader& h = block_headers_[slot_];
+    box_ = GCoord(h.box[0], h.box[1], h.box[2]);
+    return(true);
+  }
+
+
+  std::vector<GCoord> LCT::coords(void) const {
+    std::vector<GCoord>::const_iterator first = block_coords_.begin() + static_cast<size_t>(slot_) * header_.natoms;
+    return(std::vector<GCoord>(first, first + header_.natoms));
+  }
+
+
+  void LCT::updateGroupCoordsImpl(AtomicGroup& g) {
+    const GCoord* frame = &block_coords_[static_cast<size_t>(slot_) * header_.natoms];
+    for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
+      uint idx = (*i)->index();
+      if (idx >= header_.natoms)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      (*i)->coords(frame[idx]);
+    }
+
+    if (periodic_)
+      g.periodicBox(box_);
+  }
+
+
+  void LCT::updateViewCoordsImpl(const AtomicGroupView& view) {
+    const GCoord* frame = &block_coords_[static_cast<size_t>(slot_) * header_.natoms];
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= header_.natoms)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      atom->coords(frame[idx]);
+    }
+
+    if (periodic_)
+      view.periodicBox(box_);
+  }
+
+}
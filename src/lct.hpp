@@ -0,0 +1,108 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_LCT_HPP)
+#define LOOS_LCT_HPP
+
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+#include <AtomicGroup.hpp>
+#include <Trajectory.hpp>
+#include <FrameBlockPlanner.hpp>
+#include <lctcodec.hpp>
+
+
+namespace loos {
+
+  //! Class for reading LOOS compressed trajectories (LCT)
+  /**
+   * See LCTWriter for a description of the format.  The frame index
+   * stored at the end of the file gives constant-time seeks.  Frames
+   * are read in blocks (see internal::FrameBlockPlanner), so a
+   * sequential or strided pass reads many frames per read call and
+   * decodes them in parallel.
+   */
+  class LCT : public Trajectory {
+  public:
+    //! Read an LCT file, decoding with up to nthreads threads (0 = all cores)
+    explicit LCT(const std::string& s, const uint nthreads = 0)
+      : Trajectory(s), nthreads_(nthreads), end_(0), periodic_(false), slot_(0)
+    {
+      init();
+    }
+
+    std::string description() const { return("LOOS compressed trajectory"); }
+    static pTraj create(const std::string& fname, const AtomicGroup& model) {
+      return(pTraj(new LCT(fname)));
+    }
+
+    uint natoms(void) const { return(header_.natoms); }
+    float timestep(void) const { return(header_.timestep * 1e-12); }
+    uint nframes(void) const { return(offsets_.size()); }
+
+    bool hasPeriodicBox(void) const { return(periodic_); }
+    GCoord periodicBox(void) const { return(box_); }
+
+    uint currentStep(void) const { return(block_headers_[slot_].step); }
+    double currentTime(void) const { return(block_headers_[slot_].time); }
+
+    std::vector<GCoord> coords(void) const;
+
+    //! Precision of the atoms in the default precision group
+    double precision(void) const { return(header_.precisions[0]); }
+
+    bool parseFrame(void);
+
+  private:
+    void init(void);
+    void readBlock(void);
+
+    void seekNextFrameImpl(void) { }
+    void seekFrameImpl(const uint) { }
+    void rewindImpl(void) { }
+    void updateGroupCoordsImpl(AtomicGroup& g);
+    void updateViewCoordsImpl(const AtomicGroupView& view);
+
+  private:
+    uint nthreads_;
+    internal::LCTHeader header_;
+    internal::LCTCodec codec_;
+    std::vector<boost::uint64_t> offsets_;
+    boost::uint64_t end_;
+
+    internal::FrameBlockPlanner planner_;
+    std::vector<internal::LCTFrameHeader> block_headers_;
+    std::vector<GCoord> block_coords_;
+    std::vector<char> block_bytes_;
+
+    bool periodic_;
+    GCoord box_;
+    uint slot_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,298 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <lctcodec.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <cstring>
+
+
+namespace loos {
+
+  namespace internal {
+
+    const char LCTHeader::magic[8] = { 'L', 'O', 'O', 'S', '-', 'L', 'C', 'T' };
+    const boost::uint32_t LCTHeader::version = 1;
+    const boost::uint32_t LCTHeader::byte_order_mark = 0x01020304;
+
+
+    namespace {
+
+      // Values per bit-packed block
+      const uint block_values = 32;
+
+      // Quantized coordinates must fit comfortably in 32 bits
+      const double quantized_limit = 2147483647.0;
+
+
+      template<typename T> void putRaw(std::ostream& os, const T& x) {
+        os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+      }
+
+      template<typename T> bool getRaw(std::istream& is, T& x) {
+        return(static_cast<bool>(is.read(reinterpret_cast<char*>(&x), sizeof(T))));
+      }
+
+      template<typename T> const char* unpackRaw(const char* p, T& x) {
+        memcpy(&x, p, sizeof(T));
+        return(p + sizeof(T));
+      }
+
+
+      inline boost::uint64_t zigzag(const boost::int64_t d) {
+        return((static_cast<boost::uint64_t>(d) << 1) ^ static_cast<boost::uint64_t>(d >> 63));
+      }
+
+      inline boost::int64_t unzigzag(const boost::uint64_t z) {
+        return(static_cast<boost::int64_t>(z >> 1) ^ -static_cast<boost::int64_t>(z & 1));
+      }
+
+      inline uint bitWidth(boost::uint64_t x) {
+        uint w = 0;
+        while (x) {
+          ++w;
+          x >>= 1;
+        }
+        return(w);
+      }
+
+    }
+
+
+
+    boost::uint64_t LCTHeader::size() const {
+      return(sizeof(magic) + 4*sizeof(boost::uint32_t) + sizeof(double) + 2*sizeof(boost::uint64_t)
+             + precisions.size() * sizeof(double) + groups.size());
+    }
+
+
+    void LCTHeader::write(std::ostream& os) const {
+      os.write(magic, sizeof(magic));
+      putRaw(os, version);
+      putRaw(os, byte_order_mark);
+      putRaw(os, natoms);
+      putRaw(os, static_cast<boost::uint32_t>(precisions.size()));
+      putRaw(os, timestep);
+      putRaw(os, nframes);
+      putRaw(os, index_offset);
+      for (std::vector<double>::const_iterator i = precisions.begin(); i != precisions.end(); ++i)
+        putRaw(os, *i);
+      if (!groups.empty())
+        os.write(reinterpret_cast<const char*>(&groups[0]), groups.size());
+    }
+
+
+    bool LCTHeader::read(std::istream& is) {
+      char buf[sizeof(magic)];
+      if (!is.read(buf, sizeof(magic)) || memcmp(buf, magic, sizeof(magic)) != 0)
+        return(false);
+
+      boost::uint32_t ver, bom, ngroups;
+      if (!getRaw(is, ver) || ver != version)
+        return(false);
+      if (!getRaw(is, bom) || bom != byte_order_mark)
+        return(false);
+      if (!(getRaw(is, natoms) && getRaw(is, ngroups) && getRaw(is, timestep)
+            && getRaw(is, nframes) && getRaw(is, index_offset)))
+        return(false);
+      if (ngroups == 0 || ngroups > 256)
+        return(false);
+
+      precisions.resize(ngroups);
+      for (boost::uint32_t i=0; i<ngroups; ++i)
+        if (!getRaw(is, precisions[i]) || !(precisions[i] > 0.0))
+          return(false);
+
+      groups.clear();
+      if (ngroups > 1) {
+        groups.resize(natoms);
+        if (!is.read(reinterpret_cast<char*>(&groups[0]), natoms))
+          return(false);
+        for (boost::uint32_t i=0; i<natoms; ++i)
+          if (groups[i] >= ngroups)
+            return(false);
+      }
+
+      return(true);
+    }
+
+
+
+    void LCTFrameHeader::write(std::ostream& os) const {
+      putRaw(os, payload);
+      putRaw(os, step);
+      putRaw(os, time);
+      putRaw(os, periodic);
+      for (int i=0; i<3; ++i)
+        putRaw(os, box[i]);
+    }
+
+
+    bool LCTFrameHeader::read(std::istream& is) {
+      char buf[size];
+      if (!is.read(buf, size))
+        return(false);
+      unpack(buf);
+      return(true);
+    }
+
+
+    void LCTFrameHeader::unpack(const char* p) {
+      p = unpackRaw(p, payload);
+      p = unpackRaw(p, step);
+      p = unpackRaw(p, time);
+      p = unpackRaw(p, periodic);
+      for (int i=0; i<3; ++i)
+        p = unpackRaw(p, box[i]);
+    }
+
+
+
+    void LCTCodec::encode(const double* xyz, const uint natoms, std::string& out) const {
+      const uint n = natoms * 3;
+      std::vector<boost::uint64_t> values(n);
+
+      boost::int64_t prev[3] = {0, 0, 0};
+      for (uint i=0; i<natoms; ++i) {
+        const double p = precision(i);
+        for (uint k=0; k<3; ++k) {
+          double v = xyz[i*3 + k] / p;
+          if (!(std::fabs(v) < quantized_limit))
+            throw(LOOSError("Coordinate cannot be stored in an LCT trajectory at the requested precision"));
+          boost::int64_t q = static_cast<boost::int64_t>(std::floor(v + 0.5));
+          values[i*3 + k] = zigzag(q - prev[k]);
+          prev[k] = q;
+        }
+      }
+
+      out.clear();
+      out.reserve(n * 2);
+      for (uint b=0; b<n; b += block_values) {
+        const uint e = std::min(n, b + block_values);
+        boost::uint64_t largest = 0;
+        for (uint j=b; j<e; ++j)
+          largest |= values[j];
+        const uint width = bitWidth(largest);
+        out.push_back(static_cast<char>(width));
+
+        // Width is at most 33 bits, so the accumulator never overflows
+        boost::uint64_t acc = 0;
+        uint nbits = 0;
+        for (uint j=b; j<e; ++j) {
+          acc |= values[j] << nbits;
+          nbits += width;
+          while (nbits >= 8) {
+            out.push_back(static_cast<char>(acc & 0xff));
+            acc >>= 8;
+            nbits -= 8;
+          }
+        }
+        if (nbits)
+          out.push_back(static_cast<char>(acc & 0xff));
+      }
+    }
+
+
+    bool LCTCodec::decode(const char* in, const size_t nbytes, const uint natoms, GCoord* out) const {
+      const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+      const unsigned char* end = p + nbytes;
+      const uint n = natoms * 3;
+
+      boost::int64_t prev[3] = {0, 0, 0};
+      for (uint b=0; b<n; b += block_values) {
+        if (p == end)
+          return(false);
+        const uint width = *p++;
+        if (width > 33)
+          return(false);
+        const uint e = std::min(n, b + block_values);
+        const boost::uint64_t mask = (static_cast<boost::uint64_t>(1) << width) - 1;
+
+        if (static_cast<size_t>(end - p) < ((e - b) * width + 7) / 8)
+          return(false);
+
+        boost::uint64_t acc = 0;
+        uint nbits = 0;
+        for (uint j=b; j<e; ++j) {
+          while (nbits < width) {
+            acc |= static_cast<boost::uint64_t>(*p++) << nbits;
+            nbits += 8;
+          }
+          const uint k = j % 3;
+          prev[k] += unzigzag(acc & mask);
+          acc >>= width;
+          nbits -= width;
+          out[j / 3][k] = prev[k] * precision(j / 3);
+        }
+      }
+
+      return(p == end);
+    }
+
+
+
+    void lctFrameOffsets(std::istream& is, const LCTHeader& header,
+                         std::vector<boost::uint64_t>& offsets, boost::uint64_t& end) {
+      is.clear();
+      is.seekg(0, std::ios_base::end);
+      const boost::uint64_t file_size = is.tellg();
+      const boost::uint64_t first = header.size();
+      offsets.clear();
+
+      if (header.index_offset != 0
+          && header.index_offset + header.nframes * sizeof(boost::uint64_t) <= file_size) {
+        offsets.resize(header.nframes);
+        is.seekg(header.index_offset);
+        if (header.nframes == 0
+            || is.read(reinterpret_cast<char*>(&offsets[0]), header.nframes * sizeof(boost::uint64_t))) {
+          bool valid = true;
+          for (boost::uint64_t i=0; i<header.nframes && valid; ++i)
+            valid = offsets[i] >= (i ? offsets[i-1] + LCTFrameHeader::size : first)
+              && offsets[i] + LCTFrameHeader::size <= header.index_offset;
+          if (valid) {
+            end = header.index_offset;
+            return;
+          }
+        }
+        offsets.clear();
+        is.clear();
+      }
+
+      // No usable index, so walk the frames
+      boost::uint64_t pos = first;
+      LCTFrameHeader frame;
+      while (pos + LCTFrameHeader::size <= file_size) {
+        is.seekg(pos);
+        if (!frame.read(is) || pos + LCTFrameHeader::size + frame.payload > file_size)
+          break;
+        offsets.push_back(pos);
+        pos += LCTFrameHeader::size + frame.payload;
+      }
+      end = pos;
+      is.clear();
+    }
+
+  }
+
+}
@@ -0,0 +1,147 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_LCTCODEC_HPP)
+#define LOOS_LCTCODEC_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    //! File header for LOOS compressed trajectories (LCT)
+    /**
+     * An LCT file is laid out as:
+     *
+     * - This header, followed by the precision of each precision
+     *   group and (if there is more than one group) the group of each
+     *   atom
+     * - The frames, each an LCTFrameHeader followed by the encoded
+     *   coordinates
+     * - The frame index (the file offset of every frame), which is
+     *   written when the writer is closed
+     *
+     * All values are stored in the byte order of the writing machine;
+     * the byte order mark lets a reader reject foreign files.  If the
+     * index is missing (e.g. the writer did not finish), readers
+     * rebuild it by scanning the frame headers.
+     */
+    struct LCTHeader {
+      static const char magic[8];
+      static const boost::uint32_t version;
+      static const boost::uint32_t byte_order_mark;
+
+      LCTHeader() : natoms(0), timestep(0.0), nframes(0), index_offset(0) { }
+
+      boost::uint32_t natoms;
+      double timestep;                       // ps per frame
+      boost::uint64_t nframes;               // Only valid when index_offset is set
+      boost::uint64_t index_offset;          // 0 if the index was never written
+      std::vector<double> precisions;        // Angstroms, one per group
+      std::vector<boost::uint8_t> groups;    // Group of each atom (empty if only one group)
+
+      //! Size of the header on disk (i.e. the offset of the first frame)
+      boost::uint64_t size() const;
+
+      void write(std::ostream& os) const;
+
+      //! Returns false if the stream does not hold a valid header
+      bool read(std::istream& is);
+    };
+
+
+    //! Header for each frame in an LCT file
+    struct LCTFrameHeader {
+      static const boost::uint64_t size = 44;
+
+      LCTFrameHeader() : payload(0), step(0), time(0.0), periodic(0) { }
+
+      boost::uint32_t payload;               // Bytes of encoded coordinates that follow
+      boost::uint32_t step;
+      double time;
+      boost::uint32_t periodic;
+      double box[3];
+
+      void write(std::ostream& os) const;
+      bool read(std::istream& is);
+      void unpack(const char* p);
+    };
+
+
+    //! Encodes and decodes the coordinates of a single LCT frame
+    /**
+     * Each coordinate is quantized to a multiple of the precision of
+     * its atom's group, then stored as the difference from the same
+     * coordinate of the preceding atom (atoms adjacent in a model are
+     * usually adjacent in space).  The differences are zig-zag encoded
+     * and bit-packed in blocks of 32 values, with each block using
+     * only as many bits as its largest value needs.  Frames are
+     * independent of each other, so they can be encoded or decoded
+     * in parallel and read in any order.
+     */
+    class LCTCodec {
+    public:
+      LCTCodec() { }
+      LCTCodec(const std::vector<double>& precisions, const std::vector<boost::uint8_t>& groups)
+        : _precisions(precisions), _groups(groups) { }
+
+      //! Encodes natoms*3 coordinates (x0, y0, z0, x1, ...) into out
+      void encode(const double* xyz, const uint natoms, std::string& out) const;
+
+      //! Decodes n bytes into natoms coordinates, returning false if the data are corrupt
+      bool decode(const char* in, const size_t n, const uint natoms, GCoord* out) const;
+
+    private:
+      double precision(const uint atom) const {
+        return(_precisions[_groups.empty() ? 0 : _groups[atom]]);
+      }
+
+      std::vector<double> _precisions;
+      std::vector<boost::uint8_t> _groups;
+    };
+
+
+    //! Finds the offset of every frame in an LCT file
+    /**
+     * Uses the index if the header has one, otherwise scans the frame
+     * headers (stopping at the first incomplete frame).  end is set to
+     * the offset just past the last frame.
+     */
+    void lctFrameOffsets(std::istream& is, const LCTHeader& header,
+                         std::vector<boost::uint64_t>& offsets, boost::uint64_t& end);
+
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <lctwriter.hpp>
+#include <exceptions.hpp>
+#include <ParallelFor.hpp>
+
+#include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+
+namespace loos {
+
+  const double LCTWriter::default_precision = 0.01;
+
+
+  LCTWriter::LCTWriter(const std::string& fname, const bool append)
+    : TrajectoryWriter(fname, append),
+      precision_(default_precision),
+      nthreads_(0),
+      dt_(1.0),
+      defined_(false),
+      end_(0)
+  {
+    batch_ = 2 * boost::thread::hardware_concurrency();
+    if (appending_)
+      prepareToAppend();
+  }
+
+
+  LCTWriter::LCTWriter(const std::string& fname, const double precision, const uint nthreads, const bool append)
+    : TrajectoryWriter(fname, append),
+      precision_(default_precision),
+      nthreads_(nthreads),
+      dt_(1.0),
+      defined_(false),
+      end_(0)
+  {
+    this->precision(precision);
+    batch_ = 2 * (nthreads ? nthreads : boost::thread::hardware_concurrency());
+    if (appending_)
+      prepareToAppend();
+  }
+
+
+  LCTWriter::~LCTWriter() {
+    // Don't throw from the destructor...
+    try {
+      finish();
+    }
+    catch (...) { }
+  }
+
+
+  void LCTWriter::checkNotStarted() const {
+    if (defined_)
+      throw(LOOSError("LCT precision cannot be changed once frames have been written (or when appending)"));
+  }
+
+
+  void LCTWriter::precision(const double p) {
+    checkNotStarted();
+    if (!(p > 0.0))
+      throw(LOOSError("LCT precision must be positive"));
+    precision_ = p;
+  }
+
+
+  void LCTWriter::precision(const AtomicGroup& subset, const double p) {
+    checkNotStarted();
+    if (!(p > 0.0))
+      throw(LOOSError("LCT precision must be positive"));
+    if (selections_.size() == 255)
+      throw(LOOSError("Too many LCT precision selections"));
+    selections_.push_back(std::pair<AtomicGroup, double>(subset, p));
+  }
+
+
+  // The layout (number of atoms and precision of each) is fixed by
+  // the first frame written.  The header is written right away with no
+  // index, so a trajectory that is never closed can still be read.
+  void LCTWriter::defineLayout(const AtomicGroup& model) {
+    header_.natoms = model.size();
+    header_.timestep = dt_;
+    header_.precisions.assign(1, precision_);
+    header_.groups.clear();
+
+    if (!selections_.empty()) {
+      boost::unordered_map<const Atom*, uint> positions;
+      for (uint i=0; i<model.size(); ++i)
+        positions[model[i].get()] = i;
+
+      header_.groups.assign(model.size(), 0);
+      for (uint s=0; s<selections_.size(); ++s) {
+        header_.precisions.push_back(selections_[s].second);
+        const AtomicGroup& subset = selections_[s].first;
+        for (AtomicGroup::const_iterator i = subset.begin(); i != subset.end(); ++i) {
+          boost::unordered_map<const Atom*, uint>::const_iterator j = positions.find(i->get());
+          if (j == positions.end())
+            throw(LOOSError(**i, "Atom in an LCT precision selection is not in the group being written"));
+          header_.groups[j->second] = s + 1;
+        }
+      }
+    }
+
+    codec_ = internal::LCTCodec(header_.precisions, header_.groups);
+
+    stream_->seekp(0);
+    header_.write(*stream_);
+    if (!stream_->good())
+      throw(FileWriteError(_filename, "Cannot write LCT header"));
+    end_ = header_.size();
+    defined_ = true;
+  }
+
+
+  void LCTWriter::prepareToAppend() {
+    stream_->seekg(0);
+    if (!header_.read(*stream_))
+      throw(FileOpenError(_filename, "Cannot append to a file that is not an LCT trajectory"));
+    internal::lctFrameOffsets(*stream_, header_, offsets_, end_);
+
+    codec_ = internal::LCTCodec(header_.precisions, header_.groups);
+    precision_ = header_.precisions[0];
+    dt_ = header_.timestep;
+    defined_ = true;
+
+    // New frames overwrite the index, so drop it from the header until
+    // the new index is written
+    header_.index_offset = 0;
+    stream_->clear();
+    stream_->seekp(0);
+    header_.write(*stream_);
+  }
+
+
+  void LCTWriter::writeFrame(const AtomicGroup& model) {
+    uint n = framesWritten();
+    writeFrame(model, n, n * dt_);
+  }
+
+
+  void LCTWriter::writeFrame(const AtomicGroup& model, const uint step, const double time) {
+    if (model.empty())
+      throw(FileWriteError(_filename, "Cannot write a frame with no atoms to an LCT trajectory"));
+    if (!defined_)
+      defineLayout(model);
+    if (model.size() != header_.natoms)
+      throw(FileWriteError(_filename, "Frame has a different number of atoms than the LCT trajectory"));
+
+    pending_.push_back(PendingFrame());
+    PendingFrame& frame = pending_.back();
+    frame.header.step = step;
+    frame.header.time = time;
+    frame.header.periodic = model.isPeriodic();
+    GCoord box = model.periodicBox();
+    for (uint k=0; k<3; ++k)
+      frame.header.box[k] = box[k];
+
+    frame.xyz.resize(model.size() * 3);
+    double* p = &frame.xyz[0];
+    for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i) {
+      const GCoord& c = (*i)->coords();
+      *p++ = c[0];
+      *p++ = c[1];
+      *p++ = c[2];
+    }
+
+    if (pending_.size() >= batch_)
+      flush();
+  }
+
+
+  void LCTWriter::flush() {
+    if (pending_.empty())
+      return;
+
+    internal::parallelFor(pending_.size(), nthreads_, [this](const uint i) {
+        codec_.encode(&pending_[i].xyz[0], header_.natoms, pending_[i].payload);
+      });
+
+    stream_->seekp(end_);
+    for (std::vector<PendingFrame>::iterator i = pending_.begin(); i != pending_.end(); ++i) {
+      i->header.payload = i->payload.size();
+      i->header.write(*stream_);
+      stream_->write(i->payload.data(), i->payload.size());
+      offsets_.push_back(end_);
+      end_ += internal::LCTFrameHeader::size + i->payload.size();
+    }
+    pending_.clear();
+
+    if (!stream_->good())
+      throw(FileWriteError(_filename, "Cannot write LCT frames"));
+  }
+
+
+  // Writes the frame index after the last frame and points the header
+  // at it.  The header is rewritten here, so it also picks up the
+  // current timePerStep().
+  void LCTWriter::finish() {
+    flush();
+    if (!defined_)
+      return;
+
+    stream_->seekp(end_);
+    if (!offsets_.empty())
+      stream_->write(reinterpret_cast<const char*>(&offsets_[0]), offsets_.size() * sizeof(boost::uint64_t));
+
+    header_.nframes = offsets_.size();
+    header_.timestep = dt_;
+    header_.index_offset = end_;
+    stream_->seekp(0);
+    header_.write(*stream_);
+    stream_->flush();
+  }
+
+}
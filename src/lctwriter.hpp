@@ -0,0 +1,141 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2014, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#if !defined(LOOS_LCTWRITER_HPP)
+#define LOOS_LCTWRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <trajwriter.hpp>
+#include <lctcodec.hpp>
+
+namespace loos {
+
+  //! Class for writing LOOS compressed trajectories (LCT)
+  /**
+   * LCT is a compact, LOOS-native trajectory format (see
+   * internal::LCTHeader and internal::LCTCodec).  Coordinates are
+   * stored to a fixed precision (by default 0.01 Angstroms, matching
+   * the default precision of XTCWriter), with every frame compressed
+   * independently and a frame index at the end of the file, so frames
+   * can be read in any order and decoded in parallel.
+   *
+   * Different parts of the system can be stored to different
+   * precisions, e.g. the protein to 0.001 Angstroms and the solvent to
+   * 0.1 Angstroms, by calling precision(subset, p) before writing the
+   * first frame.  The subset must be selected from the group that is
+   * written (so it shares its atoms).
+   *
+   * Frames are buffered and encoded in parallel, then written in
+   * order.  As with XTCWriter, the time of each frame is taken from
+   * timePerStep() unless an explicit step and time are given.
+   */
+  class LCTWriter : public TrajectoryWriter {
+  public:
+
+    //! Default precision (in Angstroms)
+    static const double default_precision;
+
+    //! Class factory function
+    static pTrajectoryWriter create(const std::string& s, const bool append = false) {
+      return(pTrajectoryWriter(new LCTWriter(s, append)));
+    }
+
+    //! Write a trajectory with the default precision and all cores
+    explicit LCTWriter(const std::string& fname, const bool append = false);
+
+    //! Write a trajectory with the given precision (in Angstroms) and number of threads (0 = all cores)
+    LCTWriter(const std::string& fname, const double precision, const uint nthreads, const bool append = false);
+
+    //! Writes any buffered frames and the frame index
+    ~LCTWriter();
+
+
+    //! Precision of atoms not in any selection (in Angstroms)
+    double precision() const { return(precision_); }
+
+    //! Sets the default precision (must be called before the first frame is written)
+    void precision(const double p);
+
+    //! Sets the precision of a subset of the atoms (must be called before the first frame is written)
+    void precision(const AtomicGroup& subset, const double p);
+
+    //! Get the time per frame (in ps)
+    double timePerStep() const { return(dt_); }
+
+    //! Set the time per frame (in ps)
+    /**
+     * Frames already written keep the time they were given, but the
+     * header records the value in effect when the trajectory is closed.
+     */
+    void timePerStep(const double dt) { dt_ = dt; }
+
+
+    //! Write a frame to the trajectory
+    void writeFrame(const AtomicGroup& model);
+
+    //! Write a frame to the trajectory with explicit step and time metadata
+    void writeFrame(const AtomicGroup& model, const uint step, const double time);
+
+    //! Encodes and writes any buffered frames
+    void flush();
+
+    bool hasFrameStep() const { return(true); }
+    bool hasFrameTime() const { return(true); }
+
+    uint framesWritten() const { return(offsets_.size() + pending_.size()); }
+
+  private:
+    struct PendingFrame {
+      internal::LCTFrameHeader header;
+      std::vector<double> xyz;
+      std::string payload;
+    };
+
+    void checkNotStarted() const;
+    void defineLayout(const AtomicGroup& model);
+    void prepareToAppend();
+    void finish();
+
+  private:
+    double precision_;
+    uint nthreads_;
+    uint batch_;
+    double dt_;
+    bool defined_;
+    std::vector< std::pair<AtomicGroup, double> > selections_;
+
+    internal::LCTHeader header_;
+    internal::LCTCodec codec_;
+    std::vector<boost::uint64_t> offsets_;
+    boost::uint64_t end_;
+    std::vector<PendingFrame> pending_;
+  };
+
+
+}
+
+#endif
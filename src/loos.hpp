@@ -82,6 +82,8 @@
 #include <trajwriter.hpp>
 #include <dcdwriter.hpp>
 #include <xtcwriter.hpp>
+#include <amber_netcdfwriter.hpp>
+#include <lctwriter.hpp>
 
 #include <amber_traj.hpp>
 #include <amber_netcdf.hpp>
@@ -91,6 +93,7 @@
 #include <pdbtraj.hpp>
 #include <tinker_arc.hpp>
 #include <xtc.hpp>
+#include <lct.hpp>
 #include <gro.hpp>
 #include <trr.hpp>
 #include <mdtrajtraj.hpp>
@@ -115,4 +118,14 @@
 
 #include <alignment.hpp>
 #include <RnaSuite.hpp>
+#include <DebyeScattering.hpp>
+#include <PairHistogram.hpp>
+#include <Correlation.hpp>
+#include <ContactHistory.hpp>
+#include <NativeContacts.hpp>
+#include <ContactMap.hpp>
+#include <ContactKernels.hpp>
+#include <Reimager.hpp>
+#include <GroupPartition.hpp>
+#include <AtomicGroupView.hpp>
 #endif
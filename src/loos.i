@@ -73,7 +73,9 @@ namespace loos {
 %include "Matrix44.i"
 %include "pdb_remarks.i"
 %include "XForm.i"
+%include "GroupPartition.i"
 %include "AtomicGroup.i"
+%include "AtomicGroupView.i"
 %include "Trajectory.i"
 %include "utils.i"
 %include "cryst.i"
@@ -86,6 +88,8 @@ namespace loos {
 %include "trajwriter.i"
 %include "dcdwriter.i"
 %include "xtcwriter.i"
+%include "amber_netcdfwriter.i"
+%include "lctwriter.i"
 %include "sfactories.i"
 %include "alignment.i"
 %include "gro.i"
@@ -95,3 +99,11 @@ namespace loos {
 %include "RnaSuite.i"
 %include "FormFactor.i"
 %include "FormFactorSet.i"
+%include "DebyeScattering.i"
+%include "PairHistogram.i"
+%include "Correlation.i"
+%include "ContactHistory.i"
+%include "NativeContacts.i"
+%include "ContactMap.i"
+%include "ContactKernels.i"
+%include "Reimager.i"
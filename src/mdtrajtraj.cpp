@@ -72,7 +72,16 @@ namespace loos {
 
     // Allocate space to store the coordinates
     frame.resize(_natoms);
-    one_frame = new float[_natoms][3];
+
+    // Blocks of frames follow the chunking of the coordinates, if any
+    hsize_t chunk_frames = 1;
+    H5::DSetCreatPropList plist = coords_dataset.getCreatePlist();
+    if (plist.getLayout() == H5D_CHUNKED) {
+      hsize_t chunk_dims[3];
+      plist.getChunk(3, chunk_dims);
+      chunk_frames = chunk_dims[0];
+    }
+    planner.configure(_nframes, chunk_frames, _natoms * 3 * sizeof(float));
 
     // Now cache the first frame...
 		readRawFrame(0);
@@ -88,37 +97,51 @@ namespace loos {
   }
 
   void MDTrajTraj::readRawFrame(const uint i) {
-    
-    // Read the periodic box
-    if (periodic) {
-      hsize_t offset[2] = {i, 0};
-      hsize_t count[2] = {1, 3};
-      hsize_t count_out[1] = {3};
-      float one_box[3];
-      H5::DataSpace memspace(1, count_out);        
-      box_dataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
-      box_dataset.read(one_box, box_datatype, memspace, box_dataspace);
-      // copy into periodic box and convert from nm to Angstroms
-      for (int j = 0; j < 3; ++j) {
-        box[j] = 10.0*one_box[j];
-      }
+    if (i >= _nframes)
+      throw(FileReadError(_filename, "Cannot read MDTraj frame (past end of trajectory)"));
+
+    int slot = planner.slot(i);
+    if (slot < 0) {
+      planner.plan(i);
+      readBlock();
+      slot = planner.slot(i);
     }
 
-    // Read the coordinates
+    // copy into periodic box and convert from nm to Angstroms
+    if (periodic)
+      for (int j = 0; j < 3; ++j)
+        box[j] = 10.0*box_block[slot*3 + j];
 
-    hsize_t offset_coord[3] = {i, 0, 0};
-    hsize_t count_coord[3] = {1, _natoms, 3};
-    hsize_t count_coord_out[2] = {_natoms, 3};
-    H5::DataSpace memspace_coord(2, count_coord_out);
-    coords_dataspace.selectHyperslab(H5S_SELECT_SET, count_coord, offset_coord);
-    coords_dataset.read(one_frame, coords_datatype, memspace_coord, coords_dataspace);
-    
     // copy coords into frame and convert from nm to Angstroms
-    for (int j=0; j < _natoms; ++j) {
-      for (int k=0; k < 3; ++k) {
-        frame[j][k] = 10.0*one_frame[j][k];
-      }
+    const float* p = &coord_block[static_cast<size_t>(slot) * _natoms * 3];
+    for (uint j=0; j < _natoms; ++j, p += 3)
+      for (int k=0; k < 3; ++k)
+        frame[j][k] = 10.0*p[k];
+  }
+
+
+  // Reads the block of frames chosen by the planner with a single
+  // (possibly strided) hyperslab selection for each dataset
+  void MDTrajTraj::readBlock() {
+    hsize_t n = planner.count();
+
+    if (periodic) {
+      hsize_t offset[2] = {planner.start(), 0};
+      hsize_t count[2] = {n, 3};
+      hsize_t stride[2] = {planner.stride(), 1};
+      box_block.resize(n * 3);
+      H5::DataSpace memspace(2, count);
+      box_dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, stride);
+      box_dataset.read(&box_block[0], H5::PredType::NATIVE_FLOAT, memspace, box_dataspace);
     }
+
+    hsize_t offset[3] = {planner.start(), 0, 0};
+    hsize_t count[3] = {n, _natoms, 3};
+    hsize_t stride[3] = {planner.stride(), 1, 1};
+    coord_block.resize(n * _natoms * 3);
+    H5::DataSpace memspace(3, count);
+    coords_dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, stride);
+    coords_dataset.read(&coord_block[0], H5::PredType::NATIVE_FLOAT, memspace, coords_dataspace);
   }
 
   void MDTrajTraj::seekFrameImpl(const uint i) {
@@ -140,4 +163,19 @@ namespace loos {
     if (periodic)
       g.periodicBox(box);
   }
+
+
+  void MDTrajTraj::updateViewCoordsImpl(const AtomicGroupView& view) {
+
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= _natoms)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      atom->coords(frame[idx]);
+    }
+
+    if (periodic)
+      view.periodicBox(box);
+  }
 }
@@ -24,10 +24,12 @@
 
 
 #include <string>
+#include <vector>
 
 #include <loos_defs.hpp>
 #include <Coord.hpp>
 #include <Trajectory.hpp>
+#include <FrameBlockPlanner.hpp>
 
 #include <H5Cpp.h>
 
@@ -35,7 +37,9 @@ namespace loos {
 
   //! Class for reading MDTraj HDF5 coordinate trajectories
   /*!
-   * 
+   * Frames are read in blocks (see internal::FrameBlockPlanner) that
+   * follow the chunking of the coordinates dataset, so sequential or
+   * strided reads select many frames with a single hyperslab.
    */
 
   class MDTrajTraj : public Trajectory {
@@ -82,7 +86,9 @@ namespace loos {
     virtual void seekNextFrameImpl(void) { _current_frame++; seekFrameImpl(_current_frame);}
     virtual void seekFrameImpl(const uint);
     virtual void updateGroupCoordsImpl(AtomicGroup&);
+    virtual void updateViewCoordsImpl(const AtomicGroupView&);
     void readRawFrame(const uint i);
+    void readBlock();
 
 
   private:
@@ -97,12 +103,12 @@ namespace loos {
     H5::DataSet box_dataset;
     H5::DataSpace box_dataspace;
     H5::DataType box_datatype;
-    H5::DataSpace box_memspace;
     H5::DataSet coords_dataset;
     H5::DataSpace coords_dataspace;
     H5::DataType coords_datatype;
-    H5::DataSpace coord_memspace;
-    float (*one_frame)[3];
+
+    internal::FrameBlockPlanner planner;
+    std::vector<float> coord_block, box_block;
   };
 
 
@@ -210,7 +210,7 @@ namespace loos {
   // Private function to search the map of atomid's -> pAtoms
   // Throws an error if the atom is not found
   pAtom PDB::findAtom(const int id) {
-    std::map<int, pAtom>::iterator i = _atomid_to_patom.find(id);
+    boost::unordered_map<int, pAtom>::iterator i = _atomid_to_patom.find(id);
     if (i == _atomid_to_patom.end()) {
       std::ostringstream oss;
       oss << "Cannot find atom corresponding to atomid " << id << " for making a bond.";
@@ -338,19 +338,19 @@ namespace loos {
 
     while (getline(is, input)) {
       try {
-	if (input.substr(0, 4) == "ATOM" || input.substr(0,6) == "HETATM")
+	if (input.compare(0, 4, "ATOM") == 0 || input.compare(0, 6, "HETATM") == 0)
 	  parseAtomRecord(input);
-	else if (input.substr(0, 6) == "REMARK")
+	else if (input.compare(0, 6, "REMARK") == 0)
 	  parseRemark(input);
-	else if (input.substr(0,6) == "CONECT") {
+	else if (input.compare(0, 6, "CONECT") == 0) {
 	  has_bonds = true;
 	  parseConectRecord(input);
-	} else if (input.substr(0, 6) == "CRYST1") {
+	} else if (input.compare(0, 6, "CRYST1") == 0) {
 	  parseCryst1Record(input);
 	  has_cryst = true;
-	} else if (input.substr(0,3) == "TER")
+	} else if (input.compare(0, 3, "TER") == 0)
 	  ;
-	else if (input.substr(0,3) == "END")
+	else if (input.compare(0, 3, "END") == 0)
 	  break;
 	else {
 	  int space = input.find_first_of(' ');
@@ -33,6 +33,7 @@
 #include <stdexcept>
 #include <vector>
 #include <map>
+#include <boost/unordered_map.hpp>
 
 #include <loos_defs.hpp>
 #include <AtomicGroup.hpp>
@@ -189,7 +190,7 @@ namespace loos {
         std::string _fname;
         Remarks _remarks;
         UnitCell cell;
-        std::map<int, pAtom> _atomid_to_patom;
+        boost::unordered_map<int, pAtom> _atomid_to_patom;
     };
 
 }
@@ -21,6 +21,7 @@
 
 #include <psf.hpp>
 #include <exceptions.hpp>
+#include <utils.hpp>
 
 
 namespace loos {
@@ -106,16 +107,21 @@ namespace loos {
     getline(is, input);
     while (input.size() > 1) { // end of the block is marked by a blank line
                                // Note: >1 to handle \r in files that came from windows...
-      int ind1, ind2;
-      std::string buf1, buf2;
-      std::stringstream s(input);
+      std::string::size_type pos = 0;
+      uint start1, len1, start2, len2;
 
-      while (s.good()) {
-        if (!(s >> buf1 >> buf2))
+      while (nextField(input, pos, start1, len1)) {
+        if (!nextField(input, pos, start2, len2))
           throw(FileReadError(_filename, "PSF error parsing bonds.\n> " + input));
 
-        ind1 = std::stoi(buf1);
-        ind2 = std::stoi(buf2);
+        int ind1, ind2;
+        try {
+          ind1 = parseStringAs<int>(input, start1, len1);
+          ind2 = parseStringAs<int>(input, start2, len2);
+        }
+        catch (ParseError&) {
+          throw(FileReadError(_filename, "PSF error parsing bonds.\n> " + input));
+        }
 
         if (ind1 > num_atoms || ind2 > num_atoms)
           throw(FileReadError(_filename, "PSF bond error: bound atomid exceeds number of atoms.\n> " + input));
@@ -127,10 +133,6 @@ namespace loos {
         pa1->addBond(pa2);
         pa2->addBond(pa1);
         bonds_found++;
-
-        // Catch returns in files that came from windows...
-        if (s.peek() == '\r')
-          break;
       }
       getline(is, input);
     }
@@ -144,66 +146,59 @@ namespace loos {
 
 
 
+  // Fields are located in place and converted without copying the
+  // line into a stringstream, since this is called for every atom.
   void PSF::parseAtomRecord(const std::string s) {
-    gint index;
-    std::string segname;
-    gint resid;
-    std::string resname;
-    std::string atomname;
-    std::string atomtype;
-    greal charge;
-    greal mass;
-    gint fixed;
-    std::string buf;
+    std::string::size_type pos = 0;
+    uint start, len;
 
     pAtom pa(new Atom);
     pa->index(_max_index++);
 
-    std::stringstream ss(s);
-
-    if (!(ss >> buf))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    index = std::stoi(buf);
-    pa->id(index);
-
-    if (!(ss >> segname))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    pa->segid(segname);
-
-
-    if (!(ss >> buf))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    resid = std::stoi(buf);
-    pa->resid(resid);
-
-    if (!(ss >> resname))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    pa->resname(resname);
-
-    if (!(ss >> atomname))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    pa->name(atomname);
-
-    // If this is a charmm psf, the atomtype will be an integer.
-    // NAMD/XPLOR psfs use the symbolic atomtype, which must start with a letter
-    // At the moment, the Atom class doesn't care about this value (it's mostly
-    // used in charmm and namd as a means to look up parameters), so we're going to
-    // discard it.  However, if we ever decide we're going to use this, we'll need
-    // to keep track of the distinction between charmm and namd usage.
-    if (!(ss >> atomtype))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-
-    if (!(ss >> charge))
-      throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    pa->charge(charge);
-
-    if (!(ss >> mass))
+    try {
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->id(parseStringAs<int>(s, start, len));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->segid(s.substr(start, len));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->resid(parseStringAs<int>(s, start, len));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->resname(s.substr(start, len));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->name(s.substr(start, len));
+
+      // If this is a charmm psf, the atomtype will be an integer.
+      // NAMD/XPLOR psfs use the symbolic atomtype, which must start with a letter
+      // At the moment, the Atom class doesn't care about this value (it's mostly
+      // used in charmm and namd as a means to look up parameters), so we're going to
+      // discard it.  However, if we ever decide we're going to use this, we'll need
+      // to keep track of the distinction between charmm and namd usage.
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->charge(parseStringAs<double>(s, start, len));
+
+      if (!nextField(s, pos, start, len))
+        throw(FileReadError(_filename, "PSF parse error.\n> " + s));
+      pa->mass(parseStringAs<double>(s, start, len));
+
+      // Is the atom fixed or mobile?
+      // for now, we're going to silently drop this
+    }
+    catch (ParseError&) {
       throw(FileReadError(_filename, "PSF parse error.\n> " + s));
-    pa->mass(mass);
-
-    // Is the atom fixed or mobile?
-    // for now, we're going to silently drop this
-    ss >> fixed;
+    }
 
     append(pa);
   }
@@ -47,13 +47,18 @@
 #include <tinker_arc.hpp>
 #include <gro.hpp>
 #include <xtc.hpp>
+#include <lct.hpp>
 #include <trr.hpp>
 #include <mmcif.hpp>
+#include <TopologyCache.hpp>
+#include <FrameCache.hpp>
 
 
 #include <trajwriter.hpp>
 #include <dcdwriter.hpp>
 #include <xtcwriter.hpp>
+#include <amber_netcdfwriter.hpp>
+#include <lctwriter.hpp>
 
 namespace loos {
 
@@ -94,8 +99,21 @@ namespace loos {
   pAtomicGroup createSystemPtr(const std::string& filename, const std::string& filetype) {
 
     for (internal::SystemNameBindingType* p = internal::system_name_bindings; p->creator != 0; ++p)
-      if (p->suffix == filetype)
-        return(*(p->creator))(filename);
+      if (p->suffix == filetype) {
+        // Reuse a binary snapshot of the model when caching is enabled
+        // (see TopologyCache)
+        std::string cachename = TopologyCache::cacheName(filename, filetype);
+        if (!cachename.empty()) {
+          pAtomicGroup cached = TopologyCache::read(cachename, filename);
+          if (cached)
+            return(cached);
+        }
+
+        pAtomicGroup model = (*(p->creator))(filename);
+        if (!cachename.empty())
+          TopologyCache::write(cachename, filename, *model);
+        return(model);
+      }
 
     throw(std::runtime_error("Error- unknown system file type '" + filetype + "' for file '" + filename + "'.  Try --help to see available types."));
   }
@@ -144,6 +162,7 @@ namespace loos {
       { "xtc", "Gromacs XTC", &XTC::create},
       { "arc", "Tinker ARC", &TinkerArc::create},
       { "h5", "MDTraj HDF5", &MDTrajTraj::create},
+      { "lct", "LOOS compressed trajectory", &LCT::create},
       { "", "", 0}
     };
 
@@ -171,7 +190,31 @@ namespace loos {
 
     for (internal::TrajectoryNameBindingType* p = internal::trajectory_name_bindings; p->creator != 0; ++p) {
       if (p->suffix == filetype) {
-        return((*(p->creator))(filename, g) );
+        // Read decoded frames from a cache when caching is enabled
+        // (see FrameCache)
+        std::string cachename = FrameCache::cacheName(filename, filetype, g);
+        if (!cachename.empty()) {
+          pTraj cached = FrameCache::open(cachename, filename);
+          if (cached)
+            return(cached);
+        }
+
+        pTraj traj = (*(p->creator))(filename, g);
+        if (!cachename.empty()) {
+          bool built = false;
+          try {
+            built = FrameCache::build(cachename, filename, *traj, g);
+          }
+          catch (...) {
+            traj->rewind();
+          }
+          if (built) {
+            pTraj cached = FrameCache::open(cachename, filename);
+            if (cached)
+              return(cached);
+          }
+        }
+        return(traj);
       }
     }
     throw(std::runtime_error("Error- unknown input trajectory file type '" + filetype + "' for file '" + filename + "'.  Try --help to see available types."));
@@ -201,6 +244,9 @@ namespace loos {
     OutputTrajectoryNameBindingType output_trajectory_name_bindings[] = {
       { "dcd", "NAMD DCD", &DCDWriter::create},
       { "xtc", "Gromacs XTC (compressed trajectory)", &XTCWriter::create},
+      { "nc", "Amber Traj (NetCDF)", &AmberNetcdfWriter::create},
+      { "netcdf", "Amber Traj (NetCDF)", &AmberNetcdfWriter::create},
+      { "lct", "LOOS compressed trajectory", &LCTWriter::create},
       { "", "", 0}
     };
 
@@ -123,6 +123,20 @@ namespace loos {
     bool isAppending() const { return(appending_); }
 
   protected:
+
+    //! For formats that do their own file handling (e.g. via a C library)
+    /**
+     * No stream is opened.  The derived class is responsible for
+     * setting appending_ if it appends to an existing file.
+     */
+    TrajectoryWriter(const std::string& fname, const bool append, const bool open_stream)
+      : stream_(0), _filename(fname), appending_(false), delete_(false) {
+      if (open_stream) {
+        struct stat statbuf;
+        openStream(fname, append && !stat(fname.c_str(), &statbuf));
+      }
+    }
+
     std::iostream* stream_;
     std::string _filename;
     bool appending_;
@@ -171,6 +171,20 @@ namespace loos {
 			g.periodicBox(box);
 	}
 
+	void TRR::updateViewCoordsImpl(const AtomicGroupView& view) {
+
+		for (uint i=0; i<view.size(); ++i) {
+			const pAtom& atom = view[i];
+			uint idx = atom->index();
+			if (idx >= natoms())
+				throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+			atom->coords(coords_[idx]);
+		}
+
+		if (hdr_.box_size)
+			view.periodicBox(box);
+	}
+
 	void TRR::updateGroupVelocitiesImpl(AtomicGroup& g) {
 
 		for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
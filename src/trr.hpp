@@ -174,32 +174,26 @@ namespace loos {
 
 		template<typename T>
 		void readBlock(std::vector<double>& v, const uint n, const std::string& msg) {
-			T buf[n];
-			uint i = xdr_file.read(buf, n);
-			if (i != n)
+			std::vector<T> buf(n);
+			if (n > 0 && xdr_file.read(&buf[0], n) != n)
 				throw(FileReadError(_filename, "Unable to read " + msg));
 
-			for (i=0; i<n; ++i)
-				v.push_back(buf[i]);
+			v.insert(v.end(), buf.begin(), buf.end());
 		}
 
 
 		// This assumes the block of data are triplets and converts them
 		// into GCoords, scaling from nm to Angstroms along the way...
+		// The whole block is read at once into a scratch buffer.
 		template<typename T>
 		void readBlock(std::vector<GCoord>& v, const uint n, const std::string& msg) {
-			T* buf = new T[n];
-			if (buf == 0)
-				throw(std::runtime_error("Out of memory"));
-
-			if (xdr_file.read(buf, n) != n) {
-				delete[] buf;
+			std::vector<T> buf(n);
+			if (n > 0 && xdr_file.read(&buf[0], n) != n)
 				throw(FileReadError(_filename, "Unable to read " + msg));
-			}
+
+			v.reserve(v.size() + n / DIM);
 			for (uint i=0; i<n; i += DIM)
 				v.push_back(GCoord(buf[i], buf[i+1], buf[i+2]) * 10.0);
-
-			delete[] buf;
 		}
 
 
@@ -243,6 +237,7 @@ namespace loos {
 		void seekNextFrameImpl(void) { }
 		void seekFrameImpl(uint);
 		void updateGroupCoordsImpl(AtomicGroup& g);
+		void updateViewCoordsImpl(const AtomicGroupView& view);
 		void updateGroupVelocitiesImpl(AtomicGroup& g);
 		std::vector<GCoord> velocitiesImpl() const { return(velo_); }
 
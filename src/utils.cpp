@@ -24,6 +24,10 @@
 #include <cmath>
 #include <ctime>
 #include <cstring>
+#include <stdint.h>
+#include <cctype>
+#include <cerrno>
+#include <limits>
 #include <unistd.h>
 #include <pwd.h>
 #include <glob.h>
@@ -44,6 +48,10 @@
 #include <utils.hpp>
 #include <version.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(__APPLE__)
 #include <sys/types.h>
 #include <sys/sysctl.h>
@@ -234,6 +242,8 @@ namespace loos
     if (pos + n > source.size())
       return (val);
 
+    val.reserve(n);
+
     for (uint i = pos; i < pos + n; ++i)
       if (source[i] != ' ')
         val += source[i];
@@ -241,6 +251,139 @@ namespace loos
     return (val);
   }
 
+  namespace
+  {
+    // Same messages as the generic parseStringAs<T>()
+    void throwMissingField(const std::string &source, const uint pos)
+    {
+      std::stringstream msg;
+      msg << "Missing Field at position " << pos << std::endl;
+      msg << "> " << source << std::endl;
+      throw(ParseError(msg.str()));
+    }
+
+    void throwFieldError(const std::string &source, const uint pos, const uint n)
+    {
+      std::stringstream msg;
+      msg << "PARSE ERROR\n"
+          << source << std::endl;
+      for (uint i = 0; i < pos; ++i)
+        msg << ' ';
+      msg << '^';
+      if (n > 1)
+        for (uint i = 1; i < n; ++i)
+          msg << '^';
+      msg << std::endl;
+      throw(ParseError(msg.str()));
+    }
+
+    // Fields are copied (minus any leading whitespace) into a small
+    // buffer on the stack so the conversion cannot run on into the
+    // next field.  Returns the field width used for error messages.
+    const uint field_buffer_size = 64;
+
+    uint copyField(const std::string &source, const uint pos, const uint nelem, char *buf)
+    {
+      if (pos >= source.size())
+        throwMissingField(source, pos);
+
+      uint n = !nelem ? source.size() - pos : nelem;
+      if (pos + n > source.size())
+        n = source.size() - pos + 1;
+
+      uint end = std::min(static_cast<uint>(source.size()), pos + n);
+      uint i = pos;
+      while (i < end && isspace(static_cast<unsigned char>(source[i])))
+        ++i;
+
+      uint k = 0;
+      while (i < end && k < field_buffer_size - 1)
+        buf[k++] = source[i++];
+      buf[k] = '\0';
+
+      return (n);
+    }
+
+    template <typename T>
+    T parseFieldAsInteger(const std::string &source, const uint pos, const uint nelem)
+    {
+      char buf[field_buffer_size];
+      uint n = copyField(source, pos, nelem, buf);
+
+      char *end;
+      errno = 0;
+      long val = strtol(buf, &end, 10);
+      if (end == buf || errno == ERANGE || val < std::numeric_limits<T>::min() || val > std::numeric_limits<T>::max())
+        throwFieldError(source, pos, n);
+
+      return (val);
+    }
+
+    // Unlike a stream, strtod() would also accept hex, inf and nan
+    bool looksLikeReal(const char *p)
+    {
+      if (*p == '-' || *p == '+')
+        ++p;
+      return (isdigit(static_cast<unsigned char>(*p)) || *p == '.');
+    }
+  }
+
+  template <>
+  int parseStringAs<int>(const std::string &source, const uint pos, const uint nelem)
+  {
+    return (parseFieldAsInteger<int>(source, pos, nelem));
+  }
+
+  template <>
+  long parseStringAs<long>(const std::string &source, const uint pos, const uint nelem)
+  {
+    return (parseFieldAsInteger<long>(source, pos, nelem));
+  }
+
+  template <>
+  float parseStringAs<float>(const std::string &source, const uint pos, const uint nelem)
+  {
+    char buf[field_buffer_size];
+    uint n = copyField(source, pos, nelem, buf);
+
+    char *end;
+    float val = strtof(buf, &end);
+    if (end == buf || !looksLikeReal(buf) || std::isinf(val))
+      throwFieldError(source, pos, n);
+
+    return (val);
+  }
+
+  template <>
+  double parseStringAs<double>(const std::string &source, const uint pos, const uint nelem)
+  {
+    char buf[field_buffer_size];
+    uint n = copyField(source, pos, nelem, buf);
+
+    char *end;
+    double val = strtod(buf, &end);
+    if (end == buf || !looksLikeReal(buf) || std::isinf(val))
+      throwFieldError(source, pos, n);
+
+    return (val);
+  }
+
+  bool nextField(const std::string &source, std::string::size_type &pos, uint &start, uint &len)
+  {
+    std::string::size_type n = source.size();
+    while (pos < n && isspace(static_cast<unsigned char>(source[pos])))
+      ++pos;
+    if (pos >= n)
+      return (false);
+
+    start = pos;
+    while (pos < n && !isspace(static_cast<unsigned char>(source[pos])))
+      ++pos;
+    len = pos - start;
+
+    return (true);
+  }
+
   template <>
   std::string fixedSizeFormat(const std::string &s, const uint n)
   {
@@ -428,6 +571,103 @@ namespace loos
     return (s);
   }
 
+  namespace
+  {
+    inline uint16_t swab16(const uint16_t u)
+    {
+      return ((u >> 8) | (u << 8));
+    }
+
+    inline uint32_t swab32(const uint32_t u)
+    {
+      return ((u >> 24) | ((u >> 8) & 0xff00u) | ((u << 8) & 0xff0000u) | (u << 24));
+    }
+
+    inline uint64_t swab64(const uint64_t u)
+    {
+      return ((static_cast<uint64_t>(swab32(static_cast<uint32_t>(u))) << 32) | swab32(static_cast<uint32_t>(u >> 32)));
+    }
+
+    // Scalar swap of elements [i, n) of type T, going through memcpy
+    // since the data need not be aligned for T
+    template <typename T, T (*op)(const T)>
+    void swabTail(unsigned char *p, size_t i, const size_t n)
+    {
+      for (; i < n; ++i)
+      {
+        T u;
+        memcpy(&u, p + i * sizeof(T), sizeof(T));
+        u = op(u);
+        memcpy(p + i * sizeof(T), &u, sizeof(T));
+      }
+    }
+
+#if defined(__SSE2__)
+    // Swaps the two bytes in each 16-bit lane
+    inline __m128i swabLanes16(const __m128i v)
+    {
+      return (_mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#endif
+  }
+
+  // The SSE2 paths swap bytes within each 16-bit lane, then reverse the
+  // order of the 16-bit lanes within each 32 or 64-bit element.
+  void swabArray(void *data, const size_t n, const size_t size)
+  {
+    unsigned char *p = static_cast<unsigned char *>(data);
+    size_t i = 0;
+
+    switch (size)
+    {
+    case 1:
+      break;
+
+    case 2:
+#if defined(__SSE2__)
+      for (; i + 8 <= n; i += 8)
+      {
+        __m128i *q = reinterpret_cast<__m128i *>(p + i * 2);
+        _mm_storeu_si128(q, swabLanes16(_mm_loadu_si128(q)));
+      }
+#endif
+      swabTail<uint16_t, swab16>(p, i, n);
+      break;
+
+    case 4:
+#if defined(__SSE2__)
+      for (; i + 4 <= n; i += 4)
+      {
+        __m128i *q = reinterpret_cast<__m128i *>(p + i * 4);
+        __m128i v = swabLanes16(_mm_loadu_si128(q));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(q, v);
+      }
+#endif
+      swabTail<uint32_t, swab32>(p, i, n);
+      break;
+
+    case 8:
+#if defined(__SSE2__)
+      for (; i + 2 <= n; i += 2)
+      {
+        __m128i *q = reinterpret_cast<__m128i *>(p + i * 8);
+        __m128i v = swabLanes16(_mm_loadu_si128(q));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_si128(q, v);
+      }
+#endif
+      swabTail<uint64_t, swab64>(p, i, n);
+      break;
+
+    default:
+      for (; i < n; ++i)
+        std::reverse(p + i * size, p + (i + 1) * size);
+    }
+  }
+
 #if defined(__linux__)
   // Should consider using _SC_AVPHYS_PAGES instead?
   long availableMemory()
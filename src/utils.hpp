@@ -317,6 +317,22 @@ namespace loos
     return (swabbed);
   }
 
+#if !defined(SWIG)
+  //! Byte-swaps, in place, an array of n elements that are each size bytes
+  /**
+   * Sizes of 2, 4 and 8 bytes use SSE2 when it is available, with a
+   * scalar fallback.  Other sizes are swapped bytewise.
+   */
+  void swabArray(void *data, const size_t n, const size_t size);
+
+  //! Byte-swaps, in place, an array of simple types (i.e. int, float, double)
+  template <typename T>
+  void swabArray(T *data, const size_t n)
+  {
+    swabArray(static_cast<void *>(data), n, sizeof(T));
+  }
+#endif
+
   //! Convert t (seconds) into a string, converting to hours and minutes as necessary
   std::string timeAsString(const double t, const uint precision = 0);
 
@@ -361,6 +377,31 @@ namespace loos
   template <>
   std::string parseStringAs<std::string>(const std::string &source, const uint pos, const uint nelem);
 
+  // Numeric fields are converted in place with strtol/strtod rather
+  // than through a stringstream, since these are called for every
+  // field of every atom when reading a model.  The behavior and error
+  // messages are the same as the generic version.
+  template <>
+  int parseStringAs<int>(const std::string &source, const uint pos, const uint nelem);
+
+  template <>
+  long parseStringAs<long>(const std::string &source, const uint pos, const uint nelem);
+
+  template <>
+  float parseStringAs<float>(const std::string &source, const uint pos, const uint nelem);
+
+  template <>
+  double parseStringAs<double>(const std::string &source, const uint pos, const uint nelem);
+
+  //! Finds the next whitespace-delimited field in a string
+  /**
+   * The search starts at pos.  If a field is found, its position and
+   * length are returned in start and len, and pos is moved past it, so
+   * the field can be handed straight to parseStringAs<>() without
+   * being copied.  Returns false if there are no more fields.
+   */
+  bool nextField(const std::string &source, std::string::size_type &pos, uint &start, uint &len);
+
   template <typename T>
   std::string fixedSizeFormat(const T t, const uint n)
   {
@@ -95,9 +95,30 @@ namespace loos {
 
 
       //! Read an n-array of data
+      /**
+       * Arrays of block-sized types are read with a single stream read
+       * and converted in bulk
+       */
       template<typename T> uint read(T* ary, const uint n) {
 	uint i;
-	for (i=0; i<n && read(ary+i); ++i) ;
+	if (sizeof(T) != sizeof(block_type)) {
+	  for (i=0; i<n && read(ary+i); ++i) ;
+	  return(i);
+	}
+
+	stream->read(reinterpret_cast<char*>(ary), static_cast<std::streamsize>(n) * sizeof(T));
+	i = stream->gcount() / sizeof(T);
+	if (need_to_swab)
+	  swabArray(ary, i);
+	return(i);
+      }
+
+      //! Overload for arrays of doubles
+      uint read(double* ary, const uint n) {
+	stream->read(reinterpret_cast<char*>(ary), static_cast<std::streamsize>(n) * sizeof(double));
+	uint i = stream->gcount() / sizeof(double);
+	if (need_to_swab)
+	  swabArray(ary, i);
 	return(i);
       }
 
@@ -105,7 +126,7 @@ namespace loos {
       //! Read in an opaque array of n-bytes (same as xdr_opaque)
       uint read(char* p, uint n) {
 	uint rndup;
-	static char buf[sizeof(block_type)];
+	char buf[sizeof(block_type)];
 
 	if (n == 0)
 	  return(1);
@@ -236,7 +257,7 @@ namespace loos {
       //! Writes an opaque array of n-bytes
       uint write(const char* p, const uint n) {
 	uint rndup;
-	static char buf[sizeof(block_type)];
+	char buf[sizeof(block_type)];
 	static bool init(false);
 
 	if (!init)
@@ -29,6 +29,12 @@
 
 
 #include <xtc.hpp>
+#include <ParallelFor.hpp>
+
+#include <algorithm>
+#include <streambuf>
+
+#include <boost/thread/thread.hpp>
 
 
 namespace loos {
@@ -56,7 +62,7 @@ namespace loos {
 
 
   // The following are largely from the xdrlib...
-  int XTC::sizeofint(int size) {
+  int XTC::sizeofint(int size) const {
     int n = 0;
     while ( size > 0 ) {
       size >>= 1;
@@ -66,7 +72,7 @@ namespace loos {
   }
 
   
-  int XTC::sizeofints(uint* data, const uint n) {
+  int XTC::sizeofints(uint* data, const uint n) const {
     uint nbytes = 1;
     uint bytes[32];
     uint nbits = 0;
@@ -98,7 +104,7 @@ namespace loos {
   }
 
   
-  int XTC::decodebits(int* buf, uint nbits) {
+  int XTC::decodebits(int* buf, uint nbits) const {
 
     int mask = (1 << nbits) -1;
 
@@ -131,7 +137,7 @@ namespace loos {
 
 
   void XTC::decodeints(int* buf, const int nints, int nbits,
-                       uint* sizes, int* nums) {
+                       uint* sizes, int* nums) const {
     int bytes[32];
     int i, j, num_of_bytes, p, num;
   
@@ -159,10 +165,10 @@ namespace loos {
 
 
 
-  // Coordinates are converted into GCoords and stored in the object's
-  // coords_ vector
+  // Coordinates are converted into GCoords and appended to crds.  Only
+  // the arguments are modified, so frames can be decoded concurrently.
 
-  bool XTC::readCompressedCoords(void)
+  bool XTC::readCompressedCoords(internal::XDRReader& xdr, std::vector<GCoord>& crds, double& file_precision) const
   {
     int minint[3], maxint[3], *lip;
     int smallidx;
@@ -174,7 +180,7 @@ namespace loos {
     unsigned int bitsize;
   
      
-    if (!xdr_file.read(lsize))
+    if (!xdr.read(lsize))
       return(false);
 
     size3 = lsize * 3;
@@ -182,24 +188,24 @@ namespace loos {
     /* Dont bother with compression for three atoms or less */
     if(lsize<=9) {
       float* tmp = new xtc_t[size3];
-      xdr_file.read(tmp, size3);
+      xdr.read(tmp, size3);
       for (uint i=0; i<size3; i += 3)
-        coords_.push_back(GCoord(tmp[i], tmp[i+1], tmp[i+2]) * 10.0);
+        crds.push_back(GCoord(tmp[i], tmp[i+1], tmp[i+2]) * 10.0);
       delete[] tmp;
       return(true);
     }
 
     /* Compression-time if we got here. Read precision first */
-    xdr_file.read(precision);
-    precision_ = precision;
+    xdr.read(precision);
+    file_precision = precision;
   
     int size3padded = static_cast<int>(size3 * 1.2);
     buf1 = new int[size3padded];
     buf2 = new int[size3padded];
     /* buf2[0-2] are special and do not contain actual data */
     buf2[0] = buf2[1] = buf2[2] = 0;
-    xdr_file.read(minint, 3);
-    xdr_file.read(maxint, 3);
+    xdr.read(minint, 3);
+    xdr.read(maxint, 3);
   
     sizeint[0] = maxint[0] - minint[0]+1;
     sizeint[1] = maxint[1] - minint[1]+1;
@@ -215,7 +221,7 @@ namespace loos {
       bitsize = sizeofints(sizeint, 3);
     }
 	
-    if (!xdr_file.read(smallidx)) {
+    if (!xdr.read(smallidx)) {
       delete[] buf1;
       delete[] buf2;
       return(false);
@@ -230,13 +236,13 @@ namespace loos {
 
     /* buf2[0] holds the length in bytes */
   
-    if (!xdr_file.read(buf2, 1)) {
+    if (!xdr.read(buf2, 1)) {
       delete[] buf1;
       delete[] buf2;
       return(false);
     }
 
-    if (!xdr_file.read(reinterpret_cast<char*>(&(buf2[3])), static_cast<uint>(buf2[0]))) {
+    if (!xdr.read(reinterpret_cast<char*>(&(buf2[3])), static_cast<uint>(buf2[0]))) {
       delete[] buf1;
       delete[] buf2;
       return(false);
@@ -294,7 +300,7 @@ namespace loos {
             tmp = thiscoord[2]; thiscoord[2] = prevcoord[2];
             prevcoord[2] = tmp;
 
-            coords_.push_back(GCoord(prevcoord[0] * inv_precision,
+            crds.push_back(GCoord(prevcoord[0] * inv_precision,
                                 prevcoord[1] * inv_precision,
                                 prevcoord[2] * inv_precision) * 10.0);
           } else {
@@ -302,12 +308,12 @@ namespace loos {
             prevcoord[1] = thiscoord[1];
             prevcoord[2] = thiscoord[2];
           }
-          coords_.push_back(GCoord(thiscoord[0] * inv_precision,
+          crds.push_back(GCoord(thiscoord[0] * inv_precision,
                               thiscoord[1] * inv_precision,
                               thiscoord[2] * inv_precision) * 10.0);
         }
       } else {
-        coords_.push_back(GCoord(thiscoord[0] * inv_precision,
+        crds.push_back(GCoord(thiscoord[0] * inv_precision,
                             thiscoord[1] * inv_precision,
                             thiscoord[2] * inv_precision) * 10.0);
       }
@@ -333,23 +339,23 @@ namespace loos {
 
 
 
-  bool XTC::readUncompressedCoords(void) 
+  bool XTC::readUncompressedCoords(internal::XDRReader& xdr, std::vector<GCoord>& crds) const
   {
       uint lsize;
       
-      if (!xdr_file.read(lsize))
+      if (!xdr.read(lsize))
 	  return(false);
       
       uint size3 = lsize * 3;
-      coords_ = std::vector<GCoord>(lsize);
+      crds = std::vector<GCoord>(lsize);
       float* tmp_coords = new float[size3];
-      uint n = xdr_file.read(tmp_coords, size3);
+      uint n = xdr.read(tmp_coords, size3);
       if (n != size3)
 	throw(FileReadError(_filename, "XTC Error: number of uncompressed coords read did not match number expected"));
       
       uint i = 0;
       for (uint j=0; j<lsize; ++j, i += 3)
-	  coords_[j] = GCoord(tmp_coords[i], tmp_coords[i+1], tmp_coords[i+2]) * 10.0;
+	  crds[j] = GCoord(tmp_coords[i], tmp_coords[i+1], tmp_coords[i+2]) * 10.0;
       
       delete[] tmp_coords;
       return(true);
@@ -371,6 +377,19 @@ namespace loos {
   }
 
 
+  void XTC::updateViewCoordsImpl(const AtomicGroupView& view) {
+    for (uint i=0; i<view.size(); ++i) {
+      const pAtom& atom = view[i];
+      uint idx = atom->index();
+      if (idx >= natoms_)
+        throw(TrajectoryError("updating group coords", _filename, "Atom index into trajectory frame is out of bounds"));
+      atom->coords(coords_[idx]);
+    }
+
+    view.periodicBox(box);
+  }
+
+
   bool XTC::parseFrame(void) {
     if (ifs->eof())
       return(false);
@@ -386,15 +405,20 @@ namespace loos {
 		 current_header_.box[4], 
 		 current_header_.box[8]) * 10.0; // Convert to Angstroms
     if (natoms_ <= min_compressed_system_size)
-	return(readUncompressedCoords());
+	return(readUncompressedCoords(xdr_file, coords_));
     else
-	return(readCompressedCoords());
+	return(readCompressedCoords(xdr_file, coords_, precision_));
   }
 
 
   bool XTC::readFrameHeader(XTC::Header& hdr) {
+    return(readFrameHeader(xdr_file, hdr));
+  }
+
+
+  bool XTC::readFrameHeader(internal::XDRReader& xdr, XTC::Header& hdr) const {
     int magic_no;
-    int ok = xdr_file.read(magic_no);
+    int ok = xdr.read(magic_no);
     if (!ok)
       return(false);
     if (magic_no != magic) {
@@ -404,11 +428,11 @@ namespace loos {
     }
 
     // Defer error-checks until the end...
-    xdr_file.read(hdr.natoms);
+    xdr.read(hdr.natoms);
 
-    xdr_file.read(hdr.step);
-    xdr_file.read(hdr.time);
-    ok = xdr_file.read(hdr.box, 9);
+    xdr.read(hdr.step);
+    xdr.read(hdr.time);
+    ok = xdr.read(hdr.box, 9);
     if (!ok)
       throw(FileReadError(_filename, "Problem reading XTC header"));
 
@@ -431,6 +455,7 @@ namespace loos {
 
       bool ok = readFrameHeader(h);
       if (!ok) {
+        frames_end_ = pos;
         rewindImpl();
         return;
       }
@@ -477,6 +502,74 @@ namespace loos {
   }
 
 
+  // Wraps a block of memory in a streambuf so that an XDRReader can
+  // decode a frame that has already been read from the file
+  namespace {
+    class MemoryBuffer : public std::streambuf {
+    public:
+      MemoryBuffer(char* p, const size_t n) { setg(p, p, p + n); }
+    };
+  }
+
+
+  // Batches of frames are read from the file, then decoded in parallel.
+  // readFrame() always seeks before parsing, so the stream position does
+  // not need to be restored afterwards.
+
+  void XTC::readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes) {
+    const uint nthreads = std::max(1u, boost::thread::hardware_concurrency());
+    const uint batch = 4 * nthreads;
+    const size_t frame_values = atoms.size() * 3;
+
+    std::vector< std::vector<char> > raw(std::min<size_t>(batch, frames.size()));
+    for (uint first=0; first<frames.size(); first += batch) {
+      uint n = std::min<size_t>(batch, frames.size() - first);
+
+      for (uint j=0; j<n; ++j) {
+        uint f = frames[first + j];
+        size_t begin = frame_indices[f];
+        size_t end = (f + 1 < frame_indices.size()) ? frame_indices[f + 1] : frames_end_;
+        raw[j].resize(end - begin);
+        ifs->clear();
+        ifs->seekg(begin);
+        ifs->read(&raw[j][0], raw[j].size());
+        if (ifs->fail())
+          throw(FileReadError(_filename, "Cannot read XTC frames"));
+      }
+
+      internal::parallelFor(n, nthreads, [&](const uint j) {
+          MemoryBuffer mem(&raw[j][0], raw[j].size());
+          std::istream is(&mem);
+          internal::XDRReader xdr(&is);
+
+          Header hdr;
+          std::vector<GCoord> crds;
+          crds.reserve(natoms_);
+          double precision;
+          bool ok = readFrameHeader(xdr, hdr)
+            && (natoms_ <= min_compressed_system_size
+                ? readUncompressedCoords(xdr, crds)
+                : readCompressedCoords(xdr, crds, precision));
+          if (!ok || crds.size() != natoms_)
+            throw(FileReadError(_filename, "Cannot decode XTC frame"));
+
+          if (boxes)
+            boxes[first + j] = GCoord(hdr.box[0], hdr.box[4], hdr.box[8]) * 10.0;
+
+          double* out = buffer + (first + j) * frame_values;
+          for (uint i=0; i<atoms.size(); ++i, out += 3) {
+            const GCoord& c = crds[atoms[i]];
+            out[0] = c.x();
+            out[1] = c.y();
+            out[2] = c.z();
+          }
+        });
+    }
+
+    ifs->clear();
+  }
+
+
   void XTC::seekFrameImpl(const uint i) {
     if (i >= frame_indices.size())
       throw(FileError(_filename, "Requested XTC frame is out of range"));
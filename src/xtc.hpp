@@ -82,11 +82,11 @@ namespace loos {
     typedef float    xtc_t;
 
   public:
-    explicit XTC(const std::string& s) : Trajectory(s), xdr_file(ifs.get()),natoms_(0) {
+    explicit XTC(const std::string& s) : Trajectory(s), xdr_file(ifs.get()), frames_end_(0), natoms_(0) {
       init();
     }
 
-    explicit XTC(std::istream& is) : Trajectory(is), xdr_file(ifs.get()), natoms_(0) {
+    explicit XTC(std::istream& is) : Trajectory(is), xdr_file(ifs.get()), frames_end_(0), natoms_(0) {
       init();
     }
 
@@ -122,6 +122,7 @@ namespace loos {
 
     internal::XDRReader xdr_file;
     std::vector<size_t> frame_indices;
+    size_t frames_end_;
     uint natoms_;
     GCoord box;
     double precision_;
@@ -133,19 +134,22 @@ namespace loos {
 
   private:
 
-    int sizeofint(int);
-    int sizeofints(uint*, const uint);
-    int decodebits(int*, uint);
-    void decodeints(int*, const int, int, uint*, int*);
+    int sizeofint(int) const;
+    int sizeofints(uint*, const uint) const;
+    int decodebits(int*, uint) const;
+    void decodeints(int*, const int, int, uint*, int*) const;
     bool readFrameHeader(Header&);
+    bool readFrameHeader(internal::XDRReader&, Header&) const;
     void scanFrames(void);
     
     void seekNextFrameImpl(void) { }
     void seekFrameImpl(uint);
     void rewindImpl(void) { ifs->clear(); ifs->seekg(0); }
     void updateGroupCoordsImpl(AtomicGroup& g);
-    bool readCompressedCoords(void);
-    bool readUncompressedCoords(void);
+    void updateViewCoordsImpl(const AtomicGroupView& view);
+    void readFramesImpl(const std::vector<uint>& frames, const std::vector<uint>& atoms, double* buffer, GCoord* boxes);
+    bool readCompressedCoords(internal::XDRReader&, std::vector<GCoord>&, double&) const;
+    bool readUncompressedCoords(internal::XDRReader&, std::vector<GCoord>&) const;
   };
 
 }